@@ -10,10 +10,24 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 // Custom project-specific headers
+#include "adc_functions.h"
+#include "commands.h"
+#include "config_store.h"
+#include "data_transfer_functions.h"
+#include "decimator.h"
+#include "sample_buffer.h"
+#include "sample_sink.h"
+#include "event_capture.h"
+#include "stats.h"
+#include "fir.h"
+#include "goertzel.h"
+#include "timebase.h"
 #include "uart_functions.h"
+#include "uartstdio.h"
 
 // Tiva C Series libraries
 #include "driverlib/adc.h"
@@ -34,7 +48,81 @@
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
 #include "inc/hw_udma.h"
-#include "utils/uartstdio.h"
+
+// Acquisition settings used by startADC1()
+tAcqConfig g_sAcqConfig =
+{
+    ADC_MODE_DMA,       // ui32Mode
+    1000,               // ui32SampleRate
+    1,                  // ui32NumChannels
+    { 0 },              // pui8Channels: AIN0 - AIN1
+    false,              // bDualADC
+    1,                  // ui32Oversample
+    1,                  // ui32Decimation
+    1,                  // ui32CICStages
+    0,                  // ui32LowPassHz
+    0,                  // ui32NotchHz
+    EVENT_MODE_OFF,     // ui32EventMode
+    100,                // ui32EventThreshold
+    2,                  // ui32EventPreBlocks
+    4,                  // ui32EventPostBlocks
+    1,                  // ui32SpectrumSeconds
+    SINK_UART_TEXT,     // ui32Sink
+    "adc_data.txt"      // pcFilePath
+};
+
+// Block currently being filled by the sequence 3 interrupt and its fill level
+static tSampleBlock *g_psFillBlock;
+static uint32_t g_ui32FillCount;
+
+// CIC decimator state per channel, used when g_sAcqConfig.ui32Decimation > 1
+static tDecimator g_psDecimators[ADC_MAX_CHANNELS];
+
+// FIR coefficients designed for the run's sample rate, shared by the
+// per-channel filters
+static tFIRCoeffs g_sLowPassCoeffs;
+static tFIRCoeffs g_sNotchCoeffs;
+static tFIRFilter g_psLowPass[ADC_MAX_CHANNELS];
+static tFIRFilter g_psNotch[ADC_MAX_CHANNELS];
+
+// GPIO port, pins, step channel select and console name of each
+// differential pair
+static const uint32_t g_pui32PairPort[ADC_MAX_CHANNELS] =
+{
+    GPIO_PORTE_BASE, GPIO_PORTE_BASE, GPIO_PORTD_BASE,
+    GPIO_PORTD_BASE, GPIO_PORTE_BASE, GPIO_PORTB_BASE
+};
+static const uint8_t g_pui8PairPins[ADC_MAX_CHANNELS] =
+{
+    GPIO_PIN_3 | GPIO_PIN_2, GPIO_PIN_1 | GPIO_PIN_0, GPIO_PIN_3 | GPIO_PIN_2,
+    GPIO_PIN_1 | GPIO_PIN_0, GPIO_PIN_5 | GPIO_PIN_4, GPIO_PIN_4 | GPIO_PIN_5
+};
+static const uint32_t g_pui32PairCtl[ADC_MAX_CHANNELS] =
+{
+    ADC_CTL_CH0, ADC_CTL_CH1, ADC_CTL_CH2, ADC_CTL_CH3, ADC_CTL_CH4, ADC_CTL_CH5
+};
+static const char * const g_ppcPairNames[ADC_MAX_CHANNELS] =
+{
+    "AIN0/PE3 - AIN1/PE2", "AIN2/PE1 - AIN3/PE0", "AIN4/PD3 - AIN5/PD2",
+    "AIN6/PD1 - AIN7/PD0", "AIN8/PE5 - AIN9/PE4", "AIN10/PB4 - AIN11/PB5"
+};
+
+// Number of channels sampled by ADC0 [0] and ADC1 [1]
+static uint32_t g_pui32ModuleChannels[2];
+
+// Sample sets (one sample of every channel) carried by each block
+static uint32_t g_ui32BlockSets = SAMPLE_BLOCK_SIZE;
+
+// Run state shared with the console commands that can be issued while
+// startADC1() is sampling
+static volatile bool g_bRunning;
+static volatile bool g_bStopRequested;
+static uint64_t g_ui64RunSamples;
+static uint64_t g_ui64RunStartTicks;
+
+// Longest time from a conversion trigger to the start of a sample interrupt
+// handler in this run, in system clock ticks
+static volatile uint32_t g_ui32MaxLatency;
 
 //*****************************************************************************/
 // Configure ADC0 for differential sampling, Trigger Timer - 1 kHz
@@ -42,6 +130,8 @@
 void
 configureADC1(void)
 {
+    uint32_t ui32Channel;
+
     // Set the clocking to run at 20 MHz (200 MHz / 10) using the PLL.  When
     // using the ADC, you must either use the PLL or supply a 16 MHz clock
     // source. System clock is set to use the PLL with a division factor of 10,
@@ -51,26 +141,20 @@ configureADC1(void)
     // Enable necessary peripherals
     SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);   // Enable the clock for Timer 0 peripheral.
     SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);     // The ADC0 peripheral must be enabled for use.
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);    // GPIO port E needs to be enabled so these pins can be used.
-
-    // Configure Timer 0 as a 16-bit periodic timer for ADC triggering at 1 kHz.
-    TimerConfigure(TIMER0_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PERIODIC);
-
-    // Set the timer load value for a 1 kHz sampling frequency.
-    TimerLoadSet(TIMER0_BASE, TIMER_A, (SysCtlClockGet()/1000) - 1);
-
-    // Enable the ADC trigger output for Timer A.
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC1);     // ADC1 takes half of the channel list when bDualADC is set.
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);    // GPIO ports B, D and E carry the analog inputs.
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
+
+    // Configure Timer 0 as a 32-bit periodic timer for ADC triggering.  The
+    // full-width timer allows sample rates below SysClk / 65536.
+    TimerConfigure(TIMER0_BASE, TIMER_CFG_PERIODIC);
+
+    // Enable the ADC trigger output for Timer A.  The load value and the
+    // timer itself are only set by startSampling() once the sample buffer is
+    // ready.
     TimerControlTrigger(TIMER0_BASE, TIMER_A, true);
 
-    // Enable processor interrupts.
-    IntMasterEnable();
-
-    // Enable Timer 0 to start ADC triggering.
-    TimerEnable(TIMER0_BASE, TIMER_A);
-
-    // Select the analog ADC function for AIN0(PE3) and AIN1(PE2).
-    GPIOPinTypeADC(GPIO_PORTE_BASE, GPIO_PIN_3 | GPIO_PIN_2);
-
     // Use ADC0 sequence 0 to sample channel 0 once for each timer period.
     //ADCClockConfigSet(ADC0_BASE, ADC_CLOCK_SRC_PIOSC | ADC_CLOCK_RATE_HALF, 1);
 
@@ -78,115 +162,714 @@ configureADC1(void)
     //uint32_t ui32Config, ui32ClockDiv;
     //ui32Config = ADCClockConfigGet(ADC0_BASE, &ui32ClockDiv);
 
-    // Enable sample sequence 3 with a processor signal trigger.  Sequence 3
-    // will do a single sample when the processor sends a signal to start the
-    // conversion.  Each ADC module has 4 programmable sequences, sequence 0
-    // to sequence 3. SS3: Number of Samples = 1, Depth of FIFO = 1
-    ADCSequenceConfigure(ADC0_BASE, 3, ADC_TRIGGER_PROCESSOR, 0);
-
-    // Enable Timer A as the trigger source for ADC sequence 3.
-    //ADCSequenceConfigure(ADC0_BASE, 3, ADC_TRIGGER_TIMER, 0);     // Change to this line for fs = 1kHz
-
-    // Configure step 0 on sequence 3.  Sample channel 0 (ADC_CTL_CH0) in
-    // differential mode (ADC_CTL_D) and configure the interrupt flag
-    // (ADC_CTL_IE) to be set when the sample is done.  Tell the ADC logic
-    // that this is the last conversion on sequence 3 (ADC_CTL_END).  Sequence
-    // 3 has only one programmable step.  Sequence 1 and 2 have 4 steps, and
-    // sequence 0 has 8 programmable steps.  Since we are only doing a single
-    // conversion using sequence 3 we will only configure step 0.   For more
-    // information on the ADC sequences and steps, refer to the datasheet.
-    ADCSequenceStepConfigure(ADC0_BASE, 3, 0, ADC_CTL_D | ADC_CTL_CH0 | ADC_CTL_IE | ADC_CTL_END);
-
-    // Since sample sequence 3 is now configured, it must be enabled
-    ADCSequenceEnable(ADC0_BASE, 3);
-
-    // Clear the interrupt status flag before starting the ADC sequence. This
-    // ensures that there are no stale or previous interrupt flags set that could
-    // interfere with the correct operation of the ADC
-    ADCIntClear(ADC0_BASE, 3);
+    // Sequence 0 of each module streams its part of the channel list through
+    // uDMA in ADC_MODE_DMA.  The sequencer steps follow the channel list and
+    // are programmed by configureChannels() at the start of every run.
+    configureADCDMA();
+
+    // Enable processor interrupts.
+    IntMasterEnable();
 
     // Display the setup on the console.
     UARTprintf("ADC ->\n");
     UARTprintf("    Type:           Differential\n");
-    UARTprintf("    Input Pins:     AIN0/PE3 - AIN1/PE2\n");
+    for (ui32Channel = 0; ui32Channel < g_sAcqConfig.ui32NumChannels; ui32Channel++)
+    {
+        UARTprintf("    %s  %s\n", ui32Channel ? "              " : "Input Pins:   ",
+                   g_ppcPairNames[g_sAcqConfig.pui8Channels[ui32Channel] % ADC_MAX_CHANNELS]);
+    }
     UARTprintf("    System Clock:   %d MHz\n", SysCtlClockGet() / 1000000);
+    UARTprintf("    Sample Rate:    %d Hz per channel, %d Hz aggregate\n", g_sAcqConfig.ui32SampleRate,
+               g_sAcqConfig.ui32SampleRate * g_sAcqConfig.ui32NumChannels);
+    UARTprintf("    Sequencers:     %s\n", g_sAcqConfig.bDualADC ? "ADC0 + ADC1 SS0, shared trigger" : "ADC0");
+    UARTprintf("    Transfer:       %s\n", g_sAcqConfig.ui32Mode == ADC_MODE_DMA ? "uDMA ping-pong" : "Interrupt");
+    UARTprintf("    Oversampling:   x%d hardware, /%d CIC (%d stage)\n", g_sAcqConfig.ui32Oversample, g_sAcqConfig.ui32Decimation, g_sAcqConfig.ui32CICStages);
+    UARTprintf("    FIR:            low-pass %d Hz, notch %d Hz (0 = off)\n", g_sAcqConfig.ui32LowPassHz, g_sAcqConfig.ui32NotchHz);
     //UARTprintf("    ADC Clock:      %d Hz\n\n", ui32Config);
 }
 
+//*****************************************************************************/
+// ADC0 sequence 3 interrupt handler.  Runs once per timer-triggered
+// conversion and appends the result to the current block; full blocks are
+// committed to the ring buffer for the consumer loop in startADC1().
+//*****************************************************************************/
+void
+ADC0SS3IntHandler(void)
+{
+    uint32_t ui32Value;
+
+    noteSampleLatency();
+
+    // Acknowledge the interrupt and read the single FIFO entry.
+    ADCIntClear(ADC0_BASE, 3);
+    ADCSequenceDataGet(ADC0_BASE, 3, &ui32Value);
+
+    g_psFillBlock->pui16Data[g_ui32FillCount++] = (uint16_t)ui32Value;
+
+    if (g_ui32FillCount == g_ui32BlockSets) {
+        g_psFillBlock->ui32Count = g_ui32BlockSets;
+        sampleBufferCommit(g_psFillBlock);
+        g_psFillBlock = sampleBufferReserve();
+        g_ui32FillCount = 0;
+    }
+}
+
+//*****************************************************************************/
+// Record the time since the last conversion trigger, from the trigger timer
+// count.  Called first thing by every sample interrupt handler, so the worst
+// case shows how long other interrupts (console, flash) held it off.  In
+// ADC_MODE_DMA it also includes converting the last sample set of the block.
+//*****************************************************************************/
+void
+noteSampleLatency(void)
+{
+    uint32_t ui32Ticks;
+
+    // Timer 0 counts down from the load value, reloading at each trigger
+    ui32Ticks = TimerLoadGet(TIMER0_BASE, TIMER_A) - TimerValueGet(TIMER0_BASE, TIMER_A);
+    if (ui32Ticks > g_ui32MaxLatency) {
+        g_ui32MaxLatency = ui32Ticks;
+    }
+}
+
+//*****************************************************************************/
+// Program the analog pins and sequencer steps for the channel list.  Must be
+// called with the sequencers stopped.
+//*****************************************************************************/
+static void
+configureChannels(void)
+{
+    uint32_t ui32Module;
+    uint32_t ui32Base;
+    uint32_t ui32Step;
+    uint32_t ui32Channel;
+    uint32_t ui32Ctl;
+
+    // Select the analog ADC function for both pins of every pair in use.
+    for (ui32Channel = 0; ui32Channel < g_sAcqConfig.ui32NumChannels; ui32Channel++)
+    {
+        GPIOPinTypeADC(g_pui32PairPort[g_sAcqConfig.pui8Channels[ui32Channel]],
+                       g_pui8PairPins[g_sAcqConfig.pui8Channels[ui32Channel]]);
+    }
+
+    if (g_sAcqConfig.ui32Mode == ADC_MODE_INTERRUPT) {
+        // Enable Timer A as the trigger source for ADC sequence 3.  Sequence 3
+        // will do a single sample on every timer period.  Each ADC module has 4
+        // programmable sequences, sequence 0 to sequence 3.
+        // SS3: Number of Samples = 1, Depth of FIFO = 1
+        ADCSequenceConfigure(ADC0_BASE, 3, ADC_TRIGGER_TIMER, 0);
+
+        // Configure step 0 on sequence 3.  Sample the first pair in
+        // differential mode (ADC_CTL_D) and configure the interrupt flag
+        // (ADC_CTL_IE) to be set when the sample is done.  Tell the ADC logic
+        // that this is the last conversion on sequence 3 (ADC_CTL_END).  Sequence
+        // 3 has only one programmable step.  Sequence 1 and 2 have 4 steps, and
+        // sequence 0 has 8 programmable steps.  Since we are only doing a single
+        // conversion using sequence 3 we will only configure step 0.   For more
+        // information on the ADC sequences and steps, refer to the datasheet.
+        ADCSequenceStepConfigure(ADC0_BASE, 3, 0, ADC_CTL_D | g_pui32PairCtl[g_sAcqConfig.pui8Channels[0]] | ADC_CTL_IE | ADC_CTL_END);
+    }
+    else {
+        // One step per channel on sequence 0, split between the modules.
+        // Both modules take Timer 0 as their trigger, so the two halves of
+        // the list start converting on the same clock edge.  Every step sets
+        // ADC_CTL_IE so that each conversion issues one uDMA request.
+        ui32Channel = 0;
+        for (ui32Module = 0; ui32Module < 2; ui32Module++)
+        {
+            if (g_pui32ModuleChannels[ui32Module] == 0) {
+                continue;
+            }
+
+            ui32Base = ui32Module ? ADC1_BASE : ADC0_BASE;
+            ADCSequenceConfigure(ui32Base, 0, ADC_TRIGGER_TIMER, 0);
+
+            for (ui32Step = 0; ui32Step < g_pui32ModuleChannels[ui32Module]; ui32Step++)
+            {
+                ui32Ctl = ADC_CTL_D | g_pui32PairCtl[g_sAcqConfig.pui8Channels[ui32Channel++]] | ADC_CTL_IE;
+                if (ui32Step == g_pui32ModuleChannels[ui32Module] - 1) {
+                    ui32Ctl |= ADC_CTL_END;
+                }
+                ADCSequenceStepConfigure(ui32Base, 0, ui32Step, ui32Ctl);
+            }
+        }
+    }
+
+    // Each trigger averages ui32Oversample conversions in hardware (a factor
+    // of 0 or 1 disables averaging).
+    ADCHardwareOversampleConfigure(ADC0_BASE, g_sAcqConfig.ui32Oversample > 1 ? g_sAcqConfig.ui32Oversample : 0);
+    if (g_pui32ModuleChannels[1]) {
+        ADCHardwareOversampleConfigure(ADC1_BASE, g_sAcqConfig.ui32Oversample > 1 ? g_sAcqConfig.ui32Oversample : 0);
+    }
+}
+
+//*****************************************************************************/
+// Arm the sequencer selected by g_sAcqConfig.ui32Mode and start the trigger
+// timer at the configured sample rate.
+//*****************************************************************************/
+static void
+startSampling(void)
+{
+    // Reset the ring buffer before the producer can run
+    sampleBufferInit();
+    g_ui32MaxLatency = 0;
+
+    TimerLoadSet(TIMER0_BASE, TIMER_A, (SysCtlClockGet() / g_sAcqConfig.ui32SampleRate) - 1);
+
+    configureChannels();
+
+    if (g_sAcqConfig.ui32Mode == ADC_MODE_DMA) {
+        startADCDMA(g_ui32BlockSets * g_pui32ModuleChannels[0], g_ui32BlockSets * g_pui32ModuleChannels[1]);
+    }
+    else {
+        // Hand the interrupt its first block
+        g_psFillBlock = sampleBufferReserve();
+        g_ui32FillCount = 0;
+
+        // Clear the interrupt status flag before starting the ADC sequence.
+        // This ensures that there are no stale or previous interrupt flags
+        // set that could interfere with the correct operation of the ADC.
+        // Each completed conversion then raises the sequence 3 interrupt,
+        // which moves the sample into the block ring buffer.
+        ADCIntClear(ADC0_BASE, 3);
+        ADCIntEnable(ADC0_BASE, 3);
+        IntEnable(INT_ADC0SS3);
+        ADCSequenceEnable(ADC0_BASE, 3);
+    }
+
+    // Enable Timer 0 to start ADC triggering.
+    TimerEnable(TIMER0_BASE, TIMER_A);
+}
+
+//*****************************************************************************/
+// Stop the trigger timer and disarm the active sequencer
+//*****************************************************************************/
+static void
+stopSampling(void)
+{
+    TimerDisable(TIMER0_BASE, TIMER_A);
+
+    if (g_sAcqConfig.ui32Mode == ADC_MODE_DMA) {
+        stopADCDMA();
+    }
+    else {
+        ADCSequenceDisable(ADC0_BASE, 3);
+        IntDisable(INT_ADC0SS3);
+        ADCIntDisable(ADC0_BASE, 3);
+    }
+}
+
+//*****************************************************************************/
+// Rate of the samples delivered to the sink, after decimation
+//*****************************************************************************/
+uint32_t
+getOutputRate(void)
+{
+    return g_sAcqConfig.ui32SampleRate / g_sAcqConfig.ui32Decimation;
+}
+
+//*****************************************************************************/
+// Number of sample sets (one sample per channel) in each block, before
+// decimation
+//*****************************************************************************/
+uint32_t
+getBlockSets(void)
+{
+    return g_ui32BlockSets;
+}
+
+//*****************************************************************************/
+// Channel list as a bit mask, bit n set = differential pair n present
+//*****************************************************************************/
+uint32_t
+getChannelMask(void)
+{
+    uint32_t ui32Mask = 0;
+    uint32_t ui32Channel;
+
+    for (ui32Channel = 0; ui32Channel < g_sAcqConfig.ui32NumChannels; ui32Channel++)
+    {
+        ui32Mask |= 1 << g_sAcqConfig.pui8Channels[ui32Channel];
+    }
+
+    return ui32Mask;
+}
+
+//*****************************************************************************/
+// Apply the saved settings from the configuration store over the defaults.
+// Keys that were never saved keep their current value; the result is checked
+// by preparePipeline() before each run.
+//*****************************************************************************/
+void
+loadAcqConfig(void)
+{
+    uint32_t ui32Value;
+    uint32_t ui32Channel;
+
+    if (configGet(CONFIG_KEY_MODE, &ui32Value)) {
+        g_sAcqConfig.ui32Mode = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_SAMPLE_RATE, &ui32Value)) {
+        g_sAcqConfig.ui32SampleRate = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_CHANNELS, &ui32Value) && ui32Value) {
+        g_sAcqConfig.ui32NumChannels = 0;
+        for (ui32Channel = 0; ui32Channel < ADC_MAX_CHANNELS; ui32Channel++)
+        {
+            if (ui32Value & (1 << ui32Channel)) {
+                g_sAcqConfig.pui8Channels[g_sAcqConfig.ui32NumChannels++] = ui32Channel;
+            }
+        }
+    }
+    if (configGet(CONFIG_KEY_DUAL_ADC, &ui32Value)) {
+        g_sAcqConfig.bDualADC = (ui32Value != 0);
+    }
+    if (configGet(CONFIG_KEY_OVERSAMPLE, &ui32Value)) {
+        g_sAcqConfig.ui32Oversample = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_DECIMATION, &ui32Value)) {
+        g_sAcqConfig.ui32Decimation = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_CIC_STAGES, &ui32Value)) {
+        g_sAcqConfig.ui32CICStages = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_SINK, &ui32Value)) {
+        g_sAcqConfig.ui32Sink = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_LOWPASS, &ui32Value)) {
+        g_sAcqConfig.ui32LowPassHz = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_NOTCH, &ui32Value)) {
+        g_sAcqConfig.ui32NotchHz = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_EVENT_MODE, &ui32Value)) {
+        g_sAcqConfig.ui32EventMode = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_EVENT_THRESHOLD, &ui32Value)) {
+        g_sAcqConfig.ui32EventThreshold = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_EVENT_PRE, &ui32Value)) {
+        g_sAcqConfig.ui32EventPreBlocks = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_EVENT_POST, &ui32Value)) {
+        g_sAcqConfig.ui32EventPostBlocks = ui32Value;
+    }
+    if (configGet(CONFIG_KEY_AVERAGE, &ui32Value)) {
+        g_sAcqConfig.ui32SpectrumSeconds = ui32Value;
+    }
+}
+
+//*****************************************************************************/
+// Time of the first sample set in a block, in microseconds since the start of
+// the run.  Blocks are contiguous at the timer rate, so the time follows from
+// the block sequence number (dropped blocks included).
+//*****************************************************************************/
+uint64_t
+getBlockTimestampUs(uint32_t ui32Seq)
+{
+    return ((uint64_t)ui32Seq * g_ui32BlockSets * 1000000) / g_sAcqConfig.ui32SampleRate;
+}
+
+//*****************************************************************************/
+// Check the front-end settings and reset the processing stages for a run
+//*****************************************************************************/
+static bool
+preparePipeline(void)
+{
+    uint32_t ui32NumChannels = g_sAcqConfig.ui32NumChannels;
+    uint32_t ui32Channel;
+
+    // The list must be ascending so that the frame channel mask describes
+    // the sample order.
+    if (ui32NumChannels == 0 || ui32NumChannels > ADC_MAX_CHANNELS) {
+        UARTprintf("Invalid channel count %d.\n", ui32NumChannels);
+        return false;
+    }
+    for (ui32Channel = 0; ui32Channel < ui32NumChannels; ui32Channel++)
+    {
+        if (g_sAcqConfig.pui8Channels[ui32Channel] >= ADC_MAX_CHANNELS ||
+            (ui32Channel && g_sAcqConfig.pui8Channels[ui32Channel] <= g_sAcqConfig.pui8Channels[ui32Channel - 1])) {
+            UARTprintf("Channel list must be ascending pairs 0-%d.\n", ADC_MAX_CHANNELS - 1);
+            return false;
+        }
+    }
+
+    if (g_sAcqConfig.ui32Mode == ADC_MODE_INTERRUPT) {
+        if (ui32NumChannels != 1) {
+            UARTprintf("Interrupt transfer supports one channel only.\n");
+            return false;
+        }
+        g_pui32ModuleChannels[0] = 1;
+        g_pui32ModuleChannels[1] = 0;
+    }
+    else {
+        g_pui32ModuleChannels[0] = g_sAcqConfig.bDualADC ? (ui32NumChannels + 1) / 2 : ui32NumChannels;
+        g_pui32ModuleChannels[1] = ui32NumChannels - g_pui32ModuleChannels[0];
+    }
+
+    // The busier module converts every one of its channels on each trigger
+    if (g_sAcqConfig.ui32SampleRate == 0 ||
+        g_sAcqConfig.ui32SampleRate * g_sAcqConfig.ui32Oversample * g_pui32ModuleChannels[0] > 1000000) {
+        UARTprintf("Sample rate x oversampling x channels exceeds 1 MSPS.\n");
+        return false;
+    }
+
+    // Fill each block with whole sample sets, rounded down to a multiple of
+    // the decimation factor so every block stays aligned to an output sample
+    // and block timestamps stay exact.
+    g_ui32BlockSets = SAMPLE_BLOCK_SIZE / ui32NumChannels;
+    g_ui32BlockSets -= g_ui32BlockSets % g_sAcqConfig.ui32Decimation;
+
+    if (g_ui32BlockSets == 0) {
+        UARTprintf("Unsupported decimation /%d with %d channels.\n", g_sAcqConfig.ui32Decimation, ui32NumChannels);
+        return false;
+    }
+
+    for (ui32Channel = 0; ui32Channel < ui32NumChannels; ui32Channel++)
+    {
+        if (!decimatorInit(&g_psDecimators[ui32Channel], g_sAcqConfig.ui32Decimation, g_sAcqConfig.ui32CICStages)) {
+            UARTprintf("Unsupported decimation /%d with %d stages.\n", g_sAcqConfig.ui32Decimation, g_sAcqConfig.ui32CICStages);
+            return false;
+        }
+    }
+
+    // Filters work on the raw samples, so their frequencies are relative to
+    // the per-channel sample rate
+    if (g_sAcqConfig.ui32LowPassHz &&
+        !firDesignLowPass(&g_sLowPassCoeffs, (float)g_sAcqConfig.ui32LowPassHz / g_sAcqConfig.ui32SampleRate)) {
+        UARTprintf("Low-pass cutoff %d Hz out of range for %d Hz sampling.\n", g_sAcqConfig.ui32LowPassHz, g_sAcqConfig.ui32SampleRate);
+        return false;
+    }
+    if (g_sAcqConfig.ui32NotchHz &&
+        !firDesignNotch(&g_sNotchCoeffs, (float)g_sAcqConfig.ui32NotchHz / g_sAcqConfig.ui32SampleRate)) {
+        UARTprintf("Notch at %d Hz out of range for %d Hz sampling.\n", g_sAcqConfig.ui32NotchHz, g_sAcqConfig.ui32SampleRate);
+        return false;
+    }
+    for (ui32Channel = 0; ui32Channel < ui32NumChannels; ui32Channel++)
+    {
+        firInit(&g_psLowPass[ui32Channel], &g_sLowPassCoeffs);
+        firInit(&g_psNotch[ui32Channel], &g_sNotchCoeffs);
+    }
+
+    if (g_sAcqConfig.ui32EventMode >= EVENT_MODE_COUNT) {
+        UARTprintf("Unknown event trigger mode %d.\n", g_sAcqConfig.ui32EventMode);
+        return false;
+    }
+    if (g_sAcqConfig.ui32EventPreBlocks > EVENT_MAX_PRE_BLOCKS) {
+        UARTprintf("Pre-trigger history must be 0 to %d blocks.\n", EVENT_MAX_PRE_BLOCKS);
+        return false;
+    }
+
+    // The Goertzel bank runs on the output, after decimation
+    if (!goertzelStart(getOutputRate(), (g_sAcqConfig.ui32Decimation > 1) ? 4 : 0)) {
+        UARTprintf("Tones must be %d to %d Hz with a %d-sample window at %d Hz output.\n",
+                   getOutputRate() / goertzelWindow(), getOutputRate() / 2 - getOutputRate() / goertzelWindow(),
+                   goertzelWindow(), getOutputRate());
+        return false;
+    }
+
+    if (g_sAcqConfig.ui32SpectrumSeconds == 0) {
+        UARTprintf("Spectrum averaging time must be at least 1 s.\n");
+        return false;
+    }
+
+    return true;
+}
+
+//*****************************************************************************/
+// Run the signal processing stages on a block in place.  On return the block
+// holds one plane of ui32Count / ui32NumChannels samples per channel.
+//*****************************************************************************/
+static void
+processBlock(tSampleBlock *psBlock)
+{
+    uint32_t ui32Sets = psBlock->ui32Count / g_sAcqConfig.ui32NumChannels;
+    uint32_t ui32OutSets = ui32Sets;
+    uint32_t ui32Channel;
+
+    if (g_sAcqConfig.ui32NumChannels > 1) {
+        sampleBlockPlanarize(psBlock, ui32Sets, g_pui32ModuleChannels[0], g_pui32ModuleChannels[1]);
+    }
+
+    // Condition each plane while it still holds 12-bit codes
+    for (ui32Channel = 0; ui32Channel < g_sAcqConfig.ui32NumChannels; ui32Channel++)
+    {
+        if (g_sAcqConfig.ui32NotchHz) {
+            firProcess(&g_psNotch[ui32Channel], psBlock->pui16Data + ui32Channel * ui32Sets, ui32Sets);
+        }
+        if (g_sAcqConfig.ui32LowPassHz) {
+            firProcess(&g_psLowPass[ui32Channel], psBlock->pui16Data + ui32Channel * ui32Sets, ui32Sets);
+        }
+    }
+
+    // Decimate each plane and pack the shorter planes back to back.  A
+    // plane's output never overtakes its unread input, so this works in place.
+    if (g_sAcqConfig.ui32Decimation > 1) {
+        for (ui32Channel = 0; ui32Channel < g_sAcqConfig.ui32NumChannels; ui32Channel++)
+        {
+            ui32OutSets = decimatorProcess(&g_psDecimators[ui32Channel],
+                                           psBlock->pui16Data + ui32Channel * ui32Sets, ui32Sets,
+                                           psBlock->pui16Data + ui32Channel * (ui32Sets / g_sAcqConfig.ui32Decimation));
+        }
+    }
+
+    // Track the chosen frequencies on the first channel's output
+    if (goertzelBins()) {
+        goertzelProcess(psBlock->pui16Data, ui32OutSets);
+    }
+
+    psBlock->ui32Count = ui32OutSets * g_sAcqConfig.ui32NumChannels;
+}
+
+//*****************************************************************************/
+// Print a sample count, switching to millions once it no longer fits the
+// 32-bit UARTprintf() arguments
+//*****************************************************************************/
+static void
+printSampleCount(uint64_t ui64Samples)
+{
+    if (ui64Samples >> 32) {
+        UARTprintf("%u million", (uint32_t)(ui64Samples / 1000000));
+    }
+    else {
+        UARTprintf("%u", (uint32_t)ui64Samples);
+    }
+}
+
+//*****************************************************************************/
+// Longest sample interrupt latency of the current or last run, in tenths of
+// a microsecond
+//*****************************************************************************/
+static uint32_t
+getMaxLatencyTenthsUs(void)
+{
+    return (g_ui32MaxLatency * 10) / (SysCtlClockGet() / 1000000);
+}
+
+//*****************************************************************************/
+// True while startADC1() is sampling
+//*****************************************************************************/
+bool
+acqIsRunning(void)
+{
+    return g_bRunning;
+}
+
+//*****************************************************************************/
+// Ask the running acquisition to stop after the block in hand
+//*****************************************************************************/
+void
+acqRequestStop(void)
+{
+    g_bStopRequested = true;
+}
+
+//*****************************************************************************/
+// One-line progress report for the status command
+//*****************************************************************************/
+void
+printAcqStatus(void)
+{
+    uint32_t ui32Latency;
+
+    if (!g_bRunning) {
+        UARTprintf("Idle, up %u s\n", (uint32_t)(timebaseTicksToUs(timebaseNow()) / 1000000));
+        return;
+    }
+
+    ui32Latency = getMaxLatencyTenthsUs();
+    UARTprintf("Sampling %u s: ", (uint32_t)(timebaseTicksToUs(timebaseNow() - g_ui64RunStartTicks) / 1000000));
+    printSampleCount(g_ui64RunSamples);
+    UARTprintf(" samples, %d dropped blocks, %d of %d blocks queued, ISR latency %d.%d us max\n",
+               sampleBufferDropped(), sampleBufferCount(), SAMPLE_BUFFER_BLOCKS, ui32Latency / 10, ui32Latency % 10);
+}
+
 //*****************************************************************************/
 // Perform ADC sampling and data acquisition
 //*****************************************************************************/
 int
 startADC1(void)
 {
-    // Array for storing data read from ADC FIFO
-    uint32_t pui32ADC0Value[1];
+    // Block of samples handed over by the ADC interrupt
+    tSampleBlock *psBlock;
+
+    // Output sink selected for this run
+    const tSampleSink *psSink;
 
-    // Add a loop counter
-    uint32_t loopCounter = 0;
+    // Sample sets taken from the current block
+    uint32_t ui32Count;
 
-    // Define sample variables and set a maximum number of samples
-    #define MAX_SAMPLE_NUM 1000
+    // Add a loop counter.  64 bits so continuous runs at 1 MSPS do not wrap.
+    uint64_t loopCounter = 0;
+
+    // Number of sample sets requested; 0 runs until a stop request
     uint32_t sample_num;
+    bool bContinuous;
 
-    // Call user input function for the number of samples
-    sample_num = getUserInput();
+    // Commit time and sequence number of the first and last blocks, to
+    // compare the measured block timing with the nominal sample rate
+    uint64_t ui64FirstTicks = 0;
+    uint64_t ui64LastTicks = 0;
+    uint32_t ui32FirstSeq = 0;
+    uint32_t ui32LastSeq = 0;
+    uint64_t ui64NominalUs;
+
+    // Sample interrupt latency, tenths of a microsecond
+    uint32_t ui32Latency;
+
+    // Pick up any settings saved since the last run
+    loadAcqConfig();
 
-    // Validate user input
-    if (sample_num <= 0 || sample_num > MAX_SAMPLE_NUM) {
+    // Call user input function for the number of samples
+    if (!getUserInput(&sample_num)) {
         UARTprintf("Invalid number of samples. Exiting.\n");
         return 1;
     }
+    bContinuous = (sample_num == 0);
+
+    // Validate the front-end configuration
+    if (!preparePipeline()) {
+        return 1;
+    }
 
-    // Add this variable to represent the text file
-    FILE *file;
+    // Ask where the samples should go
+    g_sAcqConfig.ui32Sink = getUserSink(g_sAcqConfig.pcFilePath, sizeof(g_sAcqConfig.pcFilePath));
 
-    // Open the file for writing
-    file = fopen("/Users/Tyler/Desktop/RESEARCH/1 Sensor Module/Electronics/adc_data.txt", "w+");
+    psSink = sampleSinkGet(g_sAcqConfig.ui32Sink);
+    if (psSink == NULL) {
+        UARTprintf("Invalid output. Exiting.\n");
+        return 1;
+    }
 
-    // Check if the file was opened successfully
-    if (file == NULL) {
-        UARTprintf("Error opening file for writing.\n");
+    // Remember the choice across resets
+    configSet(CONFIG_KEY_SINK, g_sAcqConfig.ui32Sink);
+
+    // Check if the sink was opened successfully
+    if (psSink->pfnOpen(g_sAcqConfig.pcFilePath) != 0) {
+        UARTprintf("Error opening %s output.\n", psSink->pcName);
         return 1; // Exit the program with an error code
     }
 
     // Turn on the blue LED
     GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_2, GPIO_PIN_2);
 
-    // Loop for the specified number of samples
-    for (loopCounter = 0; loopCounter < sample_num; loopCounter++)
+    eventCaptureStart(psSink);
+    if (g_sAcqConfig.ui32EventMode != EVENT_MODE_OFF) {
+        UARTprintf("Event capture armed: threshold %d codes, %d blocks before and %d after each trigger.\n",
+                   g_sAcqConfig.ui32EventThreshold, g_sAcqConfig.ui32EventPreBlocks, g_sAcqConfig.ui32EventPostBlocks);
+    }
+
+    statsStart(g_sAcqConfig.pui8Channels, g_sAcqConfig.ui32NumChannels, (g_sAcqConfig.ui32Decimation > 1) ? 4 : 0);
+
+    // Start timer-triggered sampling into the ring buffer
+    g_bStopRequested = false;
+    g_ui64RunSamples = 0;
+    g_ui64RunStartTicks = timebaseNow();
+    g_bRunning = true;
+    startSampling();
+
+    if (bContinuous) {
+        UARTprintf("Continuous capture, press Enter or type 'stop' to stop.\n");
+    }
+    else {
+        UARTprintf("Press Enter or type 'stop' to end early, 'status' for progress.\n");
+    }
+
+    // Drain the ring buffer one block at a time until enough samples arrived
+    // or, in continuous mode, until the user stops the run.  Sampling
+    // continues in the background at the timer rate; if this loop falls
+    // behind, whole blocks are dropped and counted by the buffer, so memory
+    // use stays fixed regardless of run length.
+    while (bContinuous || loopCounter < sample_num)
     {
-        // Causes a processor trigger for a sample sequence
-        ADCProcessorTrigger(ADC0_BASE, 3);
+        // Commands typed during the run are assembled from the receive
+        // buffer a few characters at a time, so this never blocks
+        consoleService();
+        if (g_bStopRequested) {
+            break;
+        }
 
-        // Wait until the sample sequence has completed
-        while (!ADCIntStatus(ADC0_BASE, 3, false))
-        {
+        psBlock = sampleBufferPeek();
+        if (psBlock == NULL) {
+            psSink->pfnIdle();
+            continue;
         }
 
-        // Used after the ADC conversion is complete to clear the interrupt status flag.
-        // This is necessary to acknowledge that the ADC conversion has been processed,
-        // and the ADC is ready for the next trigger.
-        ADCIntClear(ADC0_BASE, 3);
+        processBlock(psBlock);
+
+        ui32Count = psBlock->ui32Count / g_sAcqConfig.ui32NumChannels;
+        if (!bContinuous && ui32Count > sample_num - loopCounter) {
+            ui32Count = (uint32_t)(sample_num - loopCounter);
+        }
 
-        // Read ADC Value
-        ADCSequenceDataGet(ADC0_BASE, 3, pui32ADC0Value);
+        // Statistics cover every delivered sample, whether or not event
+        // capture passes it on to the sink
+        statsBlock(psBlock, ui32Count);
 
-        // Display the [AIN0(PE3) - AIN1(PE2)] digital value on the console
-        UARTprintf("\nLoop # = %d, Timestamp = %d, AIN0 - AIN1 = %4d\r", loopCounter + 1, clock(), pui32ADC0Value[0]);
+        // In event mode only the windows around triggers reach the sink
+        if (g_sAcqConfig.ui32EventMode != EVENT_MODE_OFF) {
+            eventCaptureBlock(psBlock, ui32Count, loopCounter);
+        }
+        else {
+            psSink->pfnWrite(psBlock, ui32Count, loopCounter);
+        }
+        if (loopCounter == 0) {
+            ui64FirstTicks = psBlock->ui64Ticks;
+            ui32FirstSeq = psBlock->ui32Seq;
+        }
+        ui64LastTicks = psBlock->ui64Ticks;
+        ui32LastSeq = psBlock->ui32Seq;
+        loopCounter += ui32Count;
+        g_ui64RunSamples = loopCounter;
 
-        // Write the ADC value to the file and flush the buffer
-        fprintf(file, "%d\t%d\t%4d\n", loopCounter + 1, clock(), pui32ADC0Value[0]);
-        fflush(file);
+        sampleBufferRelease();
     }
 
+    // Stop triggering conversions
+    stopSampling();
+    g_bRunning = false;
+
     // Turn off the blue LED
     GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_2, 0);
 
+    // Flush and close the output before reporting
+    psSink->pfnClose();
+
     // Success Statement
     UARTprintf("\n\nSampling Completed");
 
-    // Close the file before exiting
-    fclose(file);
+    // Report buffer backpressure: blocks lost because the consumer could
+    // not keep up, and how close the ring came to filling
+    UARTprintf("\nSamples:        ");
+    printSampleCount(loopCounter);
+    UARTprintf("\nDropped Blocks: %d (%d samples)", sampleBufferDropped(), sampleBufferDropped() * g_ui32BlockSets);
+    UARTprintf("\nHigh Water:     %d of %d blocks", sampleBufferHighWater(), SAMPLE_BUFFER_BLOCKS);
+    if (g_sAcqConfig.ui32Mode == ADC_MODE_DMA) {
+        UARTprintf("\nFIFO Overruns:  %d", getADCDMAOverruns());
+    }
+    if (g_sAcqConfig.ui32EventMode != EVENT_MODE_OFF) {
+        UARTprintf("\nEvents:         %d (%d blocks written)", eventCaptureEvents(), eventCaptureBlocksWritten());
+    }
+
+    // Worst case delay of the sample interrupts, and the spacing of the
+    // block commits against the nominal rate that block timestamps assume
+    ui32Latency = getMaxLatencyTenthsUs();
+    UARTprintf("\nISR Latency:    %d.%d us max (trigger to handler)", ui32Latency / 10, ui32Latency % 10);
+    if (ui32LastSeq != ui32FirstSeq) {
+        ui64NominalUs = getBlockTimestampUs(ui32LastSeq) - getBlockTimestampUs(ui32FirstSeq);
+        UARTprintf("\nBlock Timing:   %u ms measured, %u ms nominal, drift %d ppm",
+                   (uint32_t)(timebaseTicksToUs(ui64LastTicks - ui64FirstTicks) / 1000),
+                   (uint32_t)(ui64NominalUs / 1000),
+                   timebaseDriftPpm(ui64LastTicks - ui64FirstTicks, ui64NominalUs));
+    }
+
+    // Per-channel summaries of the delivered samples, then the tracked
+    // frequencies
+    UARTprintf("\n\n");
+    statsReport();
+    if (goertzelBins()) {
+        goertzelReport();
+    }
+
     return 0;
 }
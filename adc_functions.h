@@ -8,7 +8,82 @@
 #ifndef ADC_FUNCTIONS_H_
 #define ADC_FUNCTIONS_H_
 
+// Acquisition transfer modes
+#define ADC_MODE_INTERRUPT  0   // Sequence 3, one interrupt per sample
+#define ADC_MODE_DMA        1   // Sequence 0 + uDMA ping-pong, one interrupt per block
+
+// Differential pairs available on the TM4C123 (AIN0-AIN1 ... AIN10-AIN11).
+// Sequence 0 has eight steps, so every pair fits in one sequencer.
+#define ADC_MAX_CHANNELS    6
+
+// Runtime acquisition settings
+typedef struct
+{
+    // ADC_MODE_INTERRUPT or ADC_MODE_DMA
+    uint32_t ui32Mode;
+
+    // Timer-triggered sample rate in Hz, per channel.  Each trigger converts
+    // every channel in the list once, so the converter rate of a module is
+    // ui32SampleRate times the number of channels it samples (up to 1 MSPS).
+    uint32_t ui32SampleRate;
+
+    // Channel list: differential pair numbers (n samples AIN(2n) - AIN(2n+1))
+    // in ascending order.  ADC_MODE_INTERRUPT supports a single channel.
+    uint32_t ui32NumChannels;
+    uint8_t pui8Channels[ADC_MAX_CHANNELS];
+
+    // Split the channel list across ADC0 and ADC1, both triggered by the
+    // same timer, to halve the per-module conversion rate.  ADC0 takes the
+    // first half of the list (rounded up) and ADC1 the rest.
+    bool bDualADC;
+
+    // ADC hardware averaging: 1 (off), 2, 4, 8, 16, 32 or 64 conversions per
+    // sample.  ui32SampleRate * ui32Oversample must not exceed 1 MSPS.
+    uint32_t ui32Oversample;
+
+    // Software CIC decimation factor (1 = off, power of two up to
+    // SAMPLE_BLOCK_SIZE) and number of CIC stages (1 = boxcar average).
+    // Decimated output is 16-bit: a 12-bit code x at DC becomes x << 4.
+    uint32_t ui32Decimation;
+    uint32_t ui32CICStages;
+
+    // FIR conditioning ahead of decimation (fir.h), per channel: low-pass
+    // cutoff and notch centre in Hz, 0 = off
+    uint32_t ui32LowPassHz;
+    uint32_t ui32NotchHz;
+
+    // Event capture (event_capture.h): EVENT_MODE_* trigger, threshold in
+    // 12-bit codes, and the number of blocks written before and after each
+    // triggering block.  EVENT_MODE_OFF records every sample.
+    uint32_t ui32EventMode;
+    uint32_t ui32EventThreshold;
+    uint32_t ui32EventPreBlocks;
+    uint32_t ui32EventPostBlocks;
+
+    // SINK_SPECTRUM: seconds of output samples averaged into each spectrum
+    uint32_t ui32SpectrumSeconds;
+
+    // Output sink, one of the SINK_* identifiers in sample_sink.h
+    uint32_t ui32Sink;
+
+    // Host file written by SINK_FILE over CCS semihosting
+    char pcFilePath[64];
+}
+tAcqConfig;
+
+extern tAcqConfig g_sAcqConfig;
+
 void configureADC1(void);
 int startADC1(void);
+uint32_t getOutputRate(void);
+uint32_t getBlockSets(void);
+uint32_t getChannelMask(void);
+void loadAcqConfig(void);
+uint64_t getBlockTimestampUs(uint32_t ui32Seq);
+bool acqIsRunning(void);
+void acqRequestStop(void);
+void printAcqStatus(void);
+void noteSampleLatency(void);
+void ADC0SS3IntHandler(void);
 
 #endif /* ADC_FUNCTIONS_H_ */
@@ -32,7 +32,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
-#include "utils/cmdline.h"
+#include <math.h>
+#include "cmdline.h"
+#include "ustdlib.h"
 
 //*****************************************************************************
 //
@@ -50,6 +52,86 @@
 //*****************************************************************************
 static char *g_ppcArgv[CMDLINE_MAX_ARGS + 1];
 
+//*****************************************************************************
+//
+// The number of entries in the command table, or -1 if the table has not been
+// scanned yet, and whether the entries are sorted by command name.
+//
+//*****************************************************************************
+static int32_t g_i32CmdCount = -1;
+static bool g_bCmdSorted;
+
+//*****************************************************************************
+//
+// Finds the command table entry for a command name.  The table is scanned
+// once to count its entries and check their order; after that, a sorted table
+// is searched with a binary search, and an unsorted one linearly.
+//
+//*****************************************************************************
+static tCmdLineEntry *
+CmdLineFind(const char *pcCmd)
+{
+    int32_t i32Low, i32High, i32Mid, i32Cmp;
+
+    //
+    // Count the entries on the first call.
+    //
+    if(g_i32CmdCount < 0)
+    {
+        g_bCmdSorted = true;
+        for(i32Mid = 0; g_psCmdTable[i32Mid].pcCmd; i32Mid++)
+        {
+            if(i32Mid &&
+               (strcmp(g_psCmdTable[i32Mid - 1].pcCmd,
+                       g_psCmdTable[i32Mid].pcCmd) >= 0))
+            {
+                g_bCmdSorted = false;
+            }
+        }
+        g_i32CmdCount = i32Mid;
+    }
+
+    //
+    // Fall back to a linear search if the table is not sorted.
+    //
+    if(!g_bCmdSorted)
+    {
+        for(i32Mid = 0; i32Mid < g_i32CmdCount; i32Mid++)
+        {
+            if(!strcmp(pcCmd, g_psCmdTable[i32Mid].pcCmd))
+            {
+                return(&g_psCmdTable[i32Mid]);
+            }
+        }
+        return(0);
+    }
+
+    //
+    // Binary search the sorted table.
+    //
+    i32Low = 0;
+    i32High = g_i32CmdCount - 1;
+    while(i32Low <= i32High)
+    {
+        i32Mid = (i32Low + i32High) / 2;
+        i32Cmp = strcmp(pcCmd, g_psCmdTable[i32Mid].pcCmd);
+        if(i32Cmp == 0)
+        {
+            return(&g_psCmdTable[i32Mid]);
+        }
+        else if(i32Cmp < 0)
+        {
+            i32High = i32Mid - 1;
+        }
+        else
+        {
+            i32Low = i32Mid + 1;
+        }
+    }
+
+    return(0);
+}
+
 //*****************************************************************************
 //
 //! Process a command line string into arguments and execute the command.
@@ -66,7 +148,9 @@ static char *g_ppcArgv[CMDLINE_MAX_ARGS + 1];
 //! The command table is contained in an array named <tt>g_psCmdTable</tt>
 //! containing <tt>tCmdLineEntry</tt> structures which must be provided by the
 //! application.  The array must be terminated with an entry whose \b pcCmd
-//! field contains a NULL pointer.
+//! field contains a NULL pointer.  If the entries are sorted by command name
+//! (in \b strcmp order), the command is found with a binary search;
+//! otherwise the table is searched from the start.
 //!
 //! \return Returns \b CMDLINE_BAD_CMD if the command is not found,
 //! \b CMDLINE_TOO_MANY_ARGS if there are more arguments than can be parsed.
@@ -150,31 +234,13 @@ CmdLineProcess(char *pcCmdLine)
     if(ui8Argc)
     {
         //
-        // Start at the beginning of the command table, to look for a matching
-        // command.
+        // Look up argv[0] in the command table, and if it is found, call the
+        // function for this command, passing the command line arguments.
         //
-        psCmdEntry = &g_psCmdTable[0];
-
-        //
-        // Search through the command table until a null command string is
-        // found, which marks the end of the table.
-        //
-        while(psCmdEntry->pcCmd)
+        psCmdEntry = CmdLineFind(g_ppcArgv[0]);
+        if(psCmdEntry)
         {
-            //
-            // If this command entry command string matches argv[0], then call
-            // the function for this command, passing the command line
-            // arguments.
-            //
-            if(!strcmp(g_ppcArgv[0], psCmdEntry->pcCmd))
-            {
-                return(psCmdEntry->pfnCmd(ui8Argc, g_ppcArgv));
-            }
-
-            //
-            // Not found, so advance to the next entry.
-            //
-            psCmdEntry++;
+            return(psCmdEntry->pfnCmd(ui8Argc, g_ppcArgv));
         }
     }
 
@@ -185,6 +251,175 @@ CmdLineProcess(char *pcCmdLine)
     return(CMDLINE_BAD_CMD);
 }
 
+//*****************************************************************************
+//
+// Converts a command argument, after an optional sign, to a 32-bit magnitude.
+// The radix follows the prefix as for ustrtoul(): 0x for hexadecimal, a
+// leading 0 for octal, and decimal otherwise.  Unlike ustrtoul(), a value
+// that does not fit in 32 bits is rejected rather than wrapped.
+//
+//*****************************************************************************
+static bool
+CmdLineArgMagnitude(const char *pcArg, uint32_t *pui32Value, bool *pbNeg)
+{
+    uint32_t ui32Base, ui32Digit, ui32Value;
+
+    //
+    // Take a leading + or - from the value.
+    //
+    *pbNeg = (*pcArg == '-');
+    if((*pcArg == '-') || (*pcArg == '+'))
+    {
+        pcArg++;
+    }
+
+    //
+    // Determine the radix from the prefix.
+    //
+    if((pcArg[0] == '0') && ((pcArg[1] == 'x') || (pcArg[1] == 'X')))
+    {
+        ui32Base = 16;
+        pcArg += 2;
+    }
+    else if(pcArg[0] == '0')
+    {
+        ui32Base = 8;
+    }
+    else
+    {
+        ui32Base = 10;
+    }
+
+    //
+    // There must be at least one digit, and nothing but digits.
+    //
+    if(!*pcArg)
+    {
+        return(false);
+    }
+    for(ui32Value = 0; *pcArg; pcArg++)
+    {
+        if((*pcArg >= '0') && (*pcArg <= '9'))
+        {
+            ui32Digit = *pcArg - '0';
+        }
+        else if((*pcArg >= 'a') && (*pcArg <= 'f'))
+        {
+            ui32Digit = *pcArg - 'a' + 10;
+        }
+        else if((*pcArg >= 'A') && (*pcArg <= 'F'))
+        {
+            ui32Digit = *pcArg - 'A' + 10;
+        }
+        else
+        {
+            return(false);
+        }
+
+        //
+        // Reject a digit outside the radix or one that would overflow.
+        //
+        if((ui32Digit >= ui32Base) ||
+           (ui32Value > (0xFFFFFFFF - ui32Digit) / ui32Base))
+        {
+            return(false);
+        }
+        ui32Value = (ui32Value * ui32Base) + ui32Digit;
+    }
+
+    *pui32Value = ui32Value;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Converts a command argument to an unsigned integer.
+//!
+//! \param pcArg points to the argument string.
+//! \param pui32Value points to the location to store the value.
+//!
+//! The argument may be decimal, hexadecimal with a leading \b 0x, or octal
+//! with a leading \b 0.  The whole argument must be a number, and it must fit
+//! in 32 bits.
+//!
+//! \return Returns \b true if the argument is a valid number, and \b false
+//! (leaving the value unchanged) if it is not.
+//
+//*****************************************************************************
+bool
+CmdLineArgUInt(const char *pcArg, uint32_t *pui32Value)
+{
+    uint32_t ui32Value;
+    bool bNeg;
+
+    if(!CmdLineArgMagnitude(pcArg, &ui32Value, &bNeg) || bNeg)
+    {
+        return(false);
+    }
+
+    *pui32Value = ui32Value;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Converts a command argument to a signed integer.
+//!
+//! \param pcArg points to the argument string.
+//! \param pi32Value points to the location to store the value.
+//!
+//! This is the same as CmdLineArgUInt(), except that the argument may start
+//! with a minus sign, and the value must fit in a signed 32-bit integer.
+//!
+//! \return Returns \b true if the argument is a valid number, and \b false
+//! (leaving the value unchanged) if it is not.
+//
+//*****************************************************************************
+bool
+CmdLineArgInt(const char *pcArg, int32_t *pi32Value)
+{
+    uint32_t ui32Value;
+    bool bNeg;
+
+    if(!CmdLineArgMagnitude(pcArg, &ui32Value, &bNeg) ||
+       (ui32Value > (bNeg ? 0x80000000 : 0x7FFFFFFF)))
+    {
+        return(false);
+    }
+
+    *pi32Value = bNeg ? (int32_t)(0 - ui32Value) : (int32_t)ui32Value;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Converts a command argument to a floating point number.
+//!
+//! \param pcArg points to the argument string.
+//! \param pfValue points to the location to store the value.
+//!
+//! The whole argument must be a number, and it must not overflow a float.
+//!
+//! \return Returns \b true if the argument is a valid number, and \b false
+//! (leaving the value unchanged) if it is not.
+//
+//*****************************************************************************
+bool
+CmdLineArgFloat(const char *pcArg, float *pfValue)
+{
+    const char *pcEnd;
+    float fValue;
+
+    fValue = ustrtof(pcArg, &pcEnd);
+    if((pcEnd == pcArg) || *pcEnd || !isfinite(fValue))
+    {
+        return(false);
+    }
+
+    *pfValue = fValue;
+    return(true);
+}
+
 //*****************************************************************************
 //
 // Close the Doxygen group.
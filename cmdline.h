@@ -106,7 +106,8 @@ tCmdLineEntry;
 //
 //! This is the command table that must be provided by the application.  The
 //! last element of the array must be a structure whose pcCmd field contains
-//! a NULL pointer.
+//! a NULL pointer.  Sorting the other elements by command name makes command
+//! lookup a binary search.
 //
 //*****************************************************************************
 extern tCmdLineEntry g_psCmdTable[];
@@ -124,6 +125,9 @@ extern tCmdLineEntry g_psCmdTable[];
 //
 //*****************************************************************************
 extern int CmdLineProcess(char *pcCmdLine);
+extern bool CmdLineArgUInt(const char *pcArg, uint32_t *pui32Value);
+extern bool CmdLineArgInt(const char *pcArg, int32_t *pi32Value);
+extern bool CmdLineArgFloat(const char *pcArg, float *pfValue);
 
 //*****************************************************************************
 //
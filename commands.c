@@ -0,0 +1,351 @@
+/*
+ * commands.c
+ *
+ *  Created on: Mar 18, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "adc_functions.h"
+#include "cmdline.h"
+#include "commands.h"
+#include "config_store.h"
+#include "flash_log.h"
+#include "goertzel.h"
+#include "sample_buffer.h"
+#include "stats.h"
+#include "uart_functions.h"
+#include "uartstdio.h"
+
+static int cmdHelp(int argc, char *argv[]);
+static int cmdRun(int argc, char *argv[]);
+static int cmdDump(int argc, char *argv[]);
+static int cmdConfig(int argc, char *argv[]);
+static int cmdStats(int argc, char *argv[]);
+static int cmdStatus(int argc, char *argv[]);
+static int cmdStop(int argc, char *argv[]);
+static int cmdTones(int argc, char *argv[]);
+
+//*****************************************************************************/
+// Console command table, searched by CmdLineProcess().  Keep the entries in
+// alphabetical order so the lookup is a binary search.
+//*****************************************************************************/
+tCmdLineEntry g_psCmdTable[] =
+{
+    { "config", cmdConfig, "Show or save settings: config [key value]" },
+    { "dump",   cmdDump,   "Stream a flash run: dump [run [offset]]" },
+    { "help",   cmdHelp,   "Show this list" },
+    { "run",    cmdRun,    "Sample to the selected output" },
+    { "stats",  cmdStats,  "Show sample statistics: stats [pair]" },
+    { "status", cmdStatus, "Show the progress of a run" },
+    { "stop",   cmdStop,   "End the run in progress" },
+    { "tones",  cmdTones,  "Track frequencies: tones [window hz... | add hz... | off]" },
+    { 0, 0, 0 }
+};
+
+//*****************************************************************************/
+// help: list the commands
+//*****************************************************************************/
+static int
+cmdHelp(int argc, char *argv[])
+{
+    tCmdLineEntry *psEntry;
+
+    for (psEntry = g_psCmdTable; psEntry->pcCmd; psEntry++)
+    {
+        UARTprintf("%6s  %s\n", psEntry->pcCmd, psEntry->pcHelp);
+    }
+
+    return 0;
+}
+
+//*****************************************************************************/
+// run: one acquisition, with the usual sample count and output prompts
+//*****************************************************************************/
+static int
+cmdRun(int argc, char *argv[])
+{
+    if (acqIsRunning()) {
+        UARTprintf("Already sampling.\n");
+        return 0;
+    }
+
+    return startADC1();
+}
+
+//*****************************************************************************/
+// status: progress of the run in progress, or uptime when idle
+//*****************************************************************************/
+static int
+cmdStatus(int argc, char *argv[])
+{
+    printAcqStatus();
+    return 0;
+}
+
+//*****************************************************************************/
+// stats [pair]: statistics of the run in progress or the last run, or the
+// histogram of one differential pair
+//*****************************************************************************/
+static int
+cmdStats(int argc, char *argv[])
+{
+    uint32_t ui32Pair;
+
+    if (argc > 2) {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+
+    if (argc == 1) {
+        statsReport();
+        return 0;
+    }
+
+    if (!CmdLineArgUInt(argv[1], &ui32Pair)) {
+        return CMDLINE_INVALID_ARG;
+    }
+
+    statsReportHistogram(statsChannelOfPair(ui32Pair));
+    return 0;
+}
+
+//*****************************************************************************/
+// stop: end the run in progress, as Enter on an empty line does
+//*****************************************************************************/
+static int
+cmdStop(int argc, char *argv[])
+{
+    if (!acqIsRunning()) {
+        UARTprintf("Not sampling.\n");
+        return 0;
+    }
+
+    acqRequestStop();
+    return 0;
+}
+
+//*****************************************************************************/
+// tones [window hz... | add hz... | off]: show the last Goertzel results, or
+// choose the frequencies tracked on the first channel from the next run on.
+// The window is in output samples; "add" appends to the current list, for
+// more frequencies than fit on one line.
+//*****************************************************************************/
+static int
+cmdTones(int argc, char *argv[])
+{
+    float pfHz[GOERTZEL_MAX_BINS];
+    float fAmplitude;
+    float fPhase;
+    uint32_t ui32NumBins = 0;
+    uint32_t ui32Window;
+    int iArg;
+
+    if (argc == 1) {
+        goertzelReport();
+        return 0;
+    }
+    if (acqIsRunning()) {
+        UARTprintf("Stop sampling first.\n");
+        return 0;
+    }
+
+    if (strcmp(argv[1], "off") == 0) {
+        goertzelSetup(pfHz, 0, 0);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "add") == 0) {
+        ui32Window = goertzelWindow();
+        while (goertzelResult(ui32NumBins, &pfHz[ui32NumBins], &fAmplitude, &fPhase))
+        {
+            ui32NumBins++;
+        }
+        if (ui32NumBins == 0) {
+            UARTprintf("No tones to add to.\n");
+            return 0;
+        }
+    }
+    else if (!CmdLineArgUInt(argv[1], &ui32Window)) {
+        return CMDLINE_INVALID_ARG;
+    }
+
+    if (argc == 2) {
+        return CMDLINE_TOO_FEW_ARGS;
+    }
+
+    for (iArg = 2; iArg < argc; iArg++)
+    {
+        if (ui32NumBins == GOERTZEL_MAX_BINS) {
+            UARTprintf("At most %d tones.\n", GOERTZEL_MAX_BINS);
+            return 0;
+        }
+        if (!CmdLineArgFloat(argv[iArg], &pfHz[ui32NumBins++])) {
+            return CMDLINE_INVALID_ARG;
+        }
+    }
+
+    if (!goertzelSetup(pfHz, ui32NumBins, ui32Window)) {
+        UARTprintf("Window must be 2 to %d samples.\n", GOERTZEL_MAX_WINDOW);
+    }
+
+    return 0;
+}
+
+//*****************************************************************************/
+// dump [run [offset]]: stream a recorded run back over the console.  The run
+// defaults to the most recent one; offset resumes a broken transfer and is
+// the "Next Offset" reported by the previous attempt.
+//*****************************************************************************/
+static int
+cmdDump(int argc, char *argv[])
+{
+    uint32_t ui32RunID = flashLogLastRun();
+    uint32_t ui32Offset = 0;
+
+    if (argc > 3) {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    if (acqIsRunning()) {
+        UARTprintf("Stop sampling first.\n");
+        return 0;
+    }
+    if (argc > 1 && !CmdLineArgUInt(argv[1], &ui32RunID)) {
+        return CMDLINE_INVALID_ARG;
+    }
+    if (argc > 2 && !CmdLineArgUInt(argv[2], &ui32Offset)) {
+        return CMDLINE_INVALID_ARG;
+    }
+
+    flashLogDump(ui32RunID, ui32Offset);
+    return 0;
+}
+
+//*****************************************************************************/
+// config [key value]: list the saved settings, or save one and apply it to
+// the next run.  Keys that were never saved are listed as "-".  Saving is
+// refused during a run, since programming internal flash stalls the CPU.
+//*****************************************************************************/
+static int
+cmdConfig(int argc, char *argv[])
+{
+    uint32_t ui32Key;
+    uint32_t ui32Value;
+    int32_t i32Value;
+
+    if (argc > 3) {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+
+    if (argc == 3) {
+        if (acqIsRunning()) {
+            UARTprintf("Stop sampling first.\n");
+            return 0;
+        }
+
+        ui32Key = configFindKey(argv[1]);
+        if (ui32Key == CONFIG_KEY_COUNT) {
+            UARTprintf("Unknown key '%s'.\n", argv[1]);
+            return 0;
+        }
+        if (!CmdLineArgInt(argv[2], &i32Value)) {
+            return CMDLINE_INVALID_ARG;
+        }
+        if (configSet(ui32Key, (uint32_t)i32Value) != 0) {
+            UARTprintf("Error saving %s.\n", argv[1]);
+        }
+        return 0;
+    }
+
+    if (argc == 2) {
+        return CMDLINE_TOO_FEW_ARGS;
+    }
+
+    for (ui32Key = 0; ui32Key < CONFIG_KEY_COUNT; ui32Key++)
+    {
+        if (configGet(ui32Key, &ui32Value)) {
+            UARTprintf("%10s  %d\n", configKeyName(ui32Key), ui32Value);
+        }
+        else {
+            UARTprintf("%10s  -\n", configKeyName(ui32Key));
+        }
+    }
+    UARTprintf("Log: %d of %d records\n", configLogUsed(), configLogSize());
+
+    return 0;
+}
+
+//*****************************************************************************/
+// Execute one command line and report command line errors
+//*****************************************************************************/
+static void
+processLine(char *pcLine)
+{
+    int iStatus;
+
+    iStatus = CmdLineProcess(pcLine);
+    if (iStatus == CMDLINE_BAD_CMD) {
+        UARTprintf("Unknown command, try 'help'.\n");
+    }
+    else if (iStatus == CMDLINE_TOO_MANY_ARGS) {
+        UARTprintf("Too many arguments.\n");
+    }
+    else if (iStatus == CMDLINE_TOO_FEW_ARGS) {
+        UARTprintf("Too few arguments.\n");
+    }
+    else if (iStatus == CMDLINE_INVALID_ARG) {
+        UARTprintf("Invalid argument.\n");
+    }
+}
+
+//*****************************************************************************/
+// Poll for a command during a run.  Called from the acquisition loop; only
+// takes characters that have already been received, so it returns at once
+// when no complete line is waiting.  An empty line (Enter or ESC) stops the
+// run.
+//*****************************************************************************/
+void
+consoleService(void)
+{
+    // Line being assembled, separate from the runConsole() line that holds
+    // the run command itself
+    static char pcLine[COMMAND_LINE_SIZE];
+
+    if (!consoleGetLine(pcLine, sizeof(pcLine))) {
+        return;
+    }
+
+    if (pcLine[0] == '\0') {
+        acqRequestStop();
+        return;
+    }
+
+    processLine(pcLine);
+}
+
+//*****************************************************************************/
+// Read and execute console commands forever
+//*****************************************************************************/
+void
+runConsole(void)
+{
+    // Line buffer, kept off the small stack
+    static char pcLine[COMMAND_LINE_SIZE];
+
+    UARTprintf("\nType 'help' for a list of commands.\n");
+
+    while (1)
+    {
+        UARTprintf("\n> ");
+        UARTgets(pcLine, sizeof(pcLine));
+        if (pcLine[0] == '\0') {
+            continue;
+        }
+
+        processLine(pcLine);
+    }
+}
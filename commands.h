@@ -0,0 +1,17 @@
+/*
+ * commands.h
+ *
+ *  Created on: Mar 18, 2024
+ *      Author: Tyler
+ */
+
+#ifndef COMMANDS_H_
+#define COMMANDS_H_
+
+// Longest console command line, including the terminator
+#define COMMAND_LINE_SIZE   64
+
+void consoleService(void);
+void runConsole(void);
+
+#endif /* COMMANDS_H_ */
@@ -0,0 +1,341 @@
+/*
+ * config_store.c
+ *
+ *  Created on: Mar 25, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "config_store.h"
+#include "crc.h"
+#include "flash_pb.h"
+
+// Tiva C Series libraries
+#include "driverlib/flash.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+
+//*****************************************************************************/
+// Key-value configuration store in internal flash.
+//
+// A snapshot of every value is kept as a flash_pb.h parameter block, so it is
+// always intact even if power fails while a new one is written.  Changes are
+// not written as whole snapshots: each configSet() appends one 8-byte record
+// to the log area instead.  When the log is full, the current values are
+// written as a new snapshot and the log is erased (compaction).
+//
+// Snapshots carry a generation number, incremented by every compaction, and
+// each log record carries the low byte of the generation it was written in.
+// A power failure after a compaction but before the log is erased leaves
+// records of an older generation behind; they are already part of the
+// snapshot, so they are ignored and the log erase is finished at boot.
+//
+// The values are read once at boot into a RAM index, so configGet() never
+// touches flash.
+//
+// Snapshots saved through the old parameter block format have the same
+// layout, but only the first two bytes of the header are used: an 8-bit
+// sequence number and an additive checksum.  When there is no snapshot in
+// the current format, the latest old one is imported and saved again in
+// the current format.
+//*****************************************************************************/
+
+// Snapshot layout: parameter block header, generation, bitmap of the keys
+// that have a value, then the values indexed by key.  The block size must be
+// a power of two; 58 value slots fill 256 bytes.  Slots past
+// CONFIG_KEY_COUNT are spare: a new key takes the next one with its bit clear
+// in older snapshots, so adding keys does not change the format.
+#define CONFIG_SNAPSHOT_SIZE        256
+#define CONFIG_SNAPSHOT_VALUES      58
+#define CONFIG_VALID_WORDS          2
+
+#if CONFIG_KEY_COUNT > CONFIG_SNAPSHOT_VALUES
+#error "CONFIG_KEY_COUNT does not fit in a configuration snapshot"
+#endif
+
+typedef struct
+{
+    tFlashPBHeader sHeader;
+    uint32_t ui32Generation;
+    uint32_t pui32Valid[CONFIG_VALID_WORDS];
+    uint32_t pui32Values[CONFIG_SNAPSHOT_VALUES];
+}
+tConfigSnapshot;
+
+// Log record.  An erased slot reads as all ones; a record torn by a power
+// failure fails its CRC-16 (over the key, generation and value) and is
+// skipped.
+typedef struct
+{
+    uint8_t ui8Key;
+    uint8_t ui8Generation;
+    uint16_t ui16CRC;
+    uint32_t ui32Value;
+}
+tConfigRecord;
+
+#define CONFIG_LOG_RECORDS  ((CONFIG_LOG_END - CONFIG_LOG_START) / sizeof(tConfigRecord))
+
+// Console names, indexed by key
+static const char * const g_ppcKeyNames[CONFIG_KEY_COUNT] =
+{
+    "mode", "rate", "channels", "dual", "oversample", "decimation", "stages",
+    "sink",
+    "offset0", "offset1", "offset2", "offset3", "offset4", "offset5",
+    "gain0", "gain1", "gain2", "gain3", "gain4", "gain5",
+    "event", "threshold", "pre", "post",
+    "lowpass", "notch", "average"
+};
+
+// Current values: the latest snapshot with the log applied.  Also the RAM
+// image written by the next compaction.
+static tConfigSnapshot g_sConfig;
+
+// Next free record in the log
+static tConfigRecord *g_psLogNext;
+
+//*****************************************************************************/
+// Bitmap of the keys that have a value
+//*****************************************************************************/
+static bool
+keyIsSet(uint32_t ui32Key)
+{
+    return (g_sConfig.pui32Valid[ui32Key / 32] & (1 << (ui32Key % 32))) != 0;
+}
+
+static void
+markKeySet(uint32_t ui32Key)
+{
+    g_sConfig.pui32Valid[ui32Key / 32] |= 1 << (ui32Key % 32);
+}
+
+//*****************************************************************************/
+// CRC of a log record, over everything but the CRC field itself
+//*****************************************************************************/
+static uint16_t
+recordCRC(const tConfigRecord *psRecord)
+{
+    uint16_t ui16CRC;
+
+    ui16CRC = crc16Update(CRC16_INIT, &psRecord->ui8Key, 2);
+    return crc16Update(ui16CRC, (const uint8_t *)&psRecord->ui32Value, 4);
+}
+
+//*****************************************************************************/
+// True if a log slot has never been programmed since the last erase
+//*****************************************************************************/
+static bool
+recordIsErased(const tConfigRecord *psRecord)
+{
+    const uint32_t *pui32Word = (const uint32_t *)psRecord;
+
+    return (pui32Word[0] == 0xFFFFFFFF) && (pui32Word[1] == 0xFFFFFFFF);
+}
+
+//*****************************************************************************/
+// Erase the whole log area and start appending from its beginning
+//*****************************************************************************/
+static void
+eraseLog(void)
+{
+    uint32_t ui32Addr;
+
+    for (ui32Addr = CONFIG_LOG_START; ui32Addr < CONFIG_LOG_END; ui32Addr += CONFIG_FLASH_SECTOR_SIZE)
+    {
+        MAP_FlashErase(ui32Addr);
+    }
+
+    g_psLogNext = (tConfigRecord *)CONFIG_LOG_START;
+}
+
+//*****************************************************************************/
+// Build the RAM index from the latest snapshot and the log.  Must be called
+// once before any other configuration function.
+//*****************************************************************************/
+void
+configStoreInit(void)
+{
+    tConfigRecord *psRecord;
+    uint8_t *pui8Snapshot;
+    bool bStale = false;
+
+    FlashPBInit(CONFIG_SNAPSHOT_START, CONFIG_SNAPSHOT_END, CONFIG_SNAPSHOT_SIZE);
+
+    // Start from the latest snapshot, then from an old-format one, or from
+    // nothing on a blank part.  FlashPBGetLegacy() only returns a block when
+    // there is none in the current format.
+    pui8Snapshot = FlashPBGet();
+    if (!pui8Snapshot) {
+        pui8Snapshot = FlashPBGetLegacy();
+    }
+    if (pui8Snapshot) {
+        memcpy(&g_sConfig, pui8Snapshot, sizeof(g_sConfig));
+    }
+    else {
+        memset(&g_sConfig, 0, sizeof(g_sConfig));
+    }
+
+    // Replay the log in write order.  The whole log is scanned rather than
+    // stopping at the first erased slot, since an interrupted log erase can
+    // leave stale records after erased sectors.
+    g_psLogNext = (tConfigRecord *)CONFIG_LOG_START;
+    for (psRecord = (tConfigRecord *)CONFIG_LOG_START; psRecord < (tConfigRecord *)CONFIG_LOG_END; psRecord++)
+    {
+        if (recordIsErased(psRecord)) {
+            continue;
+        }
+
+        // Appends continue after the last programmed slot
+        g_psLogNext = psRecord + 1;
+
+        if (psRecord->ui8Generation != (uint8_t)g_sConfig.ui32Generation) {
+            bStale = true;
+            continue;
+        }
+
+        if ((psRecord->ui16CRC == recordCRC(psRecord)) && (psRecord->ui8Key < CONFIG_KEY_COUNT)) {
+            g_sConfig.pui32Values[psRecord->ui8Key] = psRecord->ui32Value;
+            markKeySet(psRecord->ui8Key);
+        }
+    }
+
+    // Save an imported snapshot in the current format, which also erases the
+    // log, or finish a compaction that lost power before the log was erased
+    if (FlashPBGetLegacy()) {
+        configCompact();
+    }
+    else if (bStale) {
+        eraseLog();
+    }
+}
+
+//*****************************************************************************/
+// Read a value.  Returns false, leaving *pui32Value alone, if the key has
+// never been set.
+//*****************************************************************************/
+bool
+configGet(uint32_t ui32Key, uint32_t *pui32Value)
+{
+    if ((ui32Key >= CONFIG_KEY_COUNT) || !keyIsSet(ui32Key)) {
+        return false;
+    }
+
+    *pui32Value = g_sConfig.pui32Values[ui32Key];
+    return true;
+}
+
+//*****************************************************************************/
+// Write a value.  Setting a key to the value it already holds costs no flash
+// write.  Returns 0 on success.
+//*****************************************************************************/
+int
+configSet(uint32_t ui32Key, uint32_t ui32Value)
+{
+    tConfigRecord sRecord;
+    tConfigRecord *psRecord;
+
+    if (ui32Key >= CONFIG_KEY_COUNT) {
+        return -1;
+    }
+
+    if (keyIsSet(ui32Key) && (g_sConfig.pui32Values[ui32Key] == ui32Value)) {
+        return 0;
+    }
+
+    // Make room by folding the log into a new snapshot
+    if (g_psLogNext == (tConfigRecord *)CONFIG_LOG_END) {
+        if (configCompact() != 0) {
+            return -1;
+        }
+    }
+
+    sRecord.ui8Key = ui32Key;
+    sRecord.ui8Generation = g_sConfig.ui32Generation;
+    sRecord.ui32Value = ui32Value;
+    sRecord.ui16CRC = recordCRC(&sRecord);
+
+    // The slot is used up even if programming fails; the record is then
+    // rejected by its CRC at the next boot.
+    psRecord = g_psLogNext++;
+    MAP_FlashProgram((uint32_t *)&sRecord, (uint32_t)psRecord, sizeof(sRecord));
+    if (memcmp(psRecord, &sRecord, sizeof(sRecord)) != 0) {
+        return -1;
+    }
+
+    g_sConfig.pui32Values[ui32Key] = ui32Value;
+    markKeySet(ui32Key);
+    return 0;
+}
+
+//*****************************************************************************/
+// Write the current values as a new snapshot and erase the log.  Returns 0 on
+// success; on failure the previous snapshot and the log are left in place.
+//*****************************************************************************/
+int
+configCompact(void)
+{
+    uint8_t *pui8Snapshot;
+
+    g_sConfig.ui32Generation++;
+    FlashPBSave((uint8_t *)&g_sConfig);
+
+    // FlashPBSave() keeps the previous block current if the new one did not
+    // program correctly
+    pui8Snapshot = FlashPBGet();
+    if ((pui8Snapshot == NULL) || (((tConfigSnapshot *)pui8Snapshot)->ui32Generation != g_sConfig.ui32Generation)) {
+        g_sConfig.ui32Generation--;
+        return -1;
+    }
+
+    eraseLog();
+    return 0;
+}
+
+//*****************************************************************************/
+// Look up a key by its console name.  Returns CONFIG_KEY_COUNT if there is
+// no such key.
+//*****************************************************************************/
+uint32_t
+configFindKey(const char *pcName)
+{
+    uint32_t ui32Key;
+
+    for (ui32Key = 0; ui32Key < CONFIG_KEY_COUNT; ui32Key++)
+    {
+        if (strcmp(pcName, g_ppcKeyNames[ui32Key]) == 0) {
+            break;
+        }
+    }
+
+    return ui32Key;
+}
+
+//*****************************************************************************/
+// Console name of a key
+//*****************************************************************************/
+const char *
+configKeyName(uint32_t ui32Key)
+{
+    return (ui32Key < CONFIG_KEY_COUNT) ? g_ppcKeyNames[ui32Key] : "?";
+}
+
+//*****************************************************************************/
+// Number of log records written since the last compaction, and the number
+// the log can hold
+//*****************************************************************************/
+uint32_t
+configLogUsed(void)
+{
+    return g_psLogNext - (tConfigRecord *)CONFIG_LOG_START;
+}
+
+uint32_t
+configLogSize(void)
+{
+    return CONFIG_LOG_RECORDS;
+}
@@ -0,0 +1,54 @@
+/*
+ * config_store.h
+ *
+ *  Created on: Mar 25, 2024
+ *      Author: Tyler
+ */
+
+#ifndef CONFIG_STORE_H_
+#define CONFIG_STORE_H_
+
+// Internal flash set aside for the configuration (see project_ccs.cmd): the
+// snapshot area holds flash_pb.h parameter blocks with every value, and the
+// log area holds one record per change made since the last snapshot.  Both
+// must be whole 1 KB erase blocks, the snapshot area at least two of them.
+#define CONFIG_FLASH_SECTOR_SIZE    1024
+#define CONFIG_SNAPSHOT_START       0x0003E000
+#define CONFIG_SNAPSHOT_END         0x0003F000
+#define CONFIG_LOG_START            0x0003F000
+#define CONFIG_LOG_END              0x00040000
+
+// Keys.  Every value is 32 bits wide.
+#define CONFIG_KEY_MODE             0   // ADC_MODE_*
+#define CONFIG_KEY_SAMPLE_RATE      1   // Hz per channel
+#define CONFIG_KEY_CHANNELS         2   // Bit n selects differential pair n
+#define CONFIG_KEY_DUAL_ADC         3   // 0 or 1
+#define CONFIG_KEY_OVERSAMPLE       4   // Hardware averaging factor
+#define CONFIG_KEY_DECIMATION       5   // CIC decimation factor
+#define CONFIG_KEY_CIC_STAGES       6   // CIC stage count
+#define CONFIG_KEY_SINK             7   // SINK_*
+#define CONFIG_KEY_OFFSET_0         8   // Per-pair offset, signed ADC codes
+#define CONFIG_KEY_GAIN_0           14  // Per-pair gain, unsigned Q16
+#define CONFIG_KEY_EVENT_MODE       20  // EVENT_MODE_*
+#define CONFIG_KEY_EVENT_THRESHOLD  21  // Trigger threshold, 12-bit codes
+#define CONFIG_KEY_EVENT_PRE        22  // Pre-trigger blocks
+#define CONFIG_KEY_EVENT_POST       23  // Post-trigger blocks
+#define CONFIG_KEY_LOWPASS          24  // FIR low-pass cutoff, Hz (0 = off)
+#define CONFIG_KEY_NOTCH            25  // FIR notch centre, Hz (0 = off)
+#define CONFIG_KEY_AVERAGE          26  // Spectrum averaging time, seconds
+#define CONFIG_KEY_COUNT            27
+
+// Calibration keys for differential pair n (0 to ADC_MAX_CHANNELS - 1)
+#define CONFIG_KEY_OFFSET(n)        (CONFIG_KEY_OFFSET_0 + (n))
+#define CONFIG_KEY_GAIN(n)          (CONFIG_KEY_GAIN_0 + (n))
+
+void configStoreInit(void);
+bool configGet(uint32_t ui32Key, uint32_t *pui32Value);
+int configSet(uint32_t ui32Key, uint32_t ui32Value);
+int configCompact(void);
+uint32_t configFindKey(const char *pcName);
+const char *configKeyName(uint32_t ui32Key);
+uint32_t configLogUsed(void);
+uint32_t configLogSize(void);
+
+#endif /* CONFIG_STORE_H_ */
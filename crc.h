@@ -0,0 +1,22 @@
+/*
+ * crc.h
+ *
+ *  Created on: Feb 19, 2024
+ *      Author: Tyler
+ */
+
+#ifndef CRC_H_
+#define CRC_H_
+
+// Initial value for crc16Update()
+#define CRC16_INIT 0xFFFF
+
+// Initial value for crc32Update(), and the final inversion applied to the
+// running value
+#define CRC32_INIT 0xFFFFFFFF
+#define CRC32_FINAL(ui32CRC) ((ui32CRC) ^ 0xFFFFFFFF)
+
+uint16_t crc16Update(uint16_t ui16CRC, const uint8_t *pui8Data, uint32_t ui32Len);
+uint32_t crc32Update(uint32_t ui32CRC, const uint8_t *pui8Data, uint32_t ui32Len);
+
+#endif /* CRC_H_ */
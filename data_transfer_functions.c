@@ -13,8 +13,62 @@
 #include <time.h>
 #include <string.h>
 
+// Custom project-specific headers
+#include "adc_functions.h"
+#include "sample_buffer.h"
+
 // Tiva C Series libraries
+#include "driverlib/adc.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
 #include "driverlib/udma.h"
+#include "inc/hw_adc.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+
+// A single uDMA transfer moves at most 1024 items
+#if SAMPLE_BLOCK_SIZE > 1024
+#error "SAMPLE_BLOCK_SIZE exceeds the uDMA transfer limit"
+#endif
+
+//*****************************************************************************
+// The uDMA channel control table.  It must be aligned on a 1024-byte boundary
+// and is shared by every peripheral that uses uDMA.
+//*****************************************************************************
+#pragma DATA_ALIGN(g_pui8DMAControlTable, 1024)
+static uint8_t g_pui8DMAControlTable[1024];
+
+// Number of ADC modules streaming through uDMA (ADC0, or ADC0 and ADC1)
+#define ADC_DMA_MODULES 2
+
+// Per-module peripheral, interrupt and uDMA channel assignments
+static const uint32_t g_pui32ADCBase[ADC_DMA_MODULES] = { ADC0_BASE, ADC1_BASE };
+static const uint32_t g_pui32ADCInt[ADC_DMA_MODULES] = { INT_ADC0SS0, INT_ADC1SS0 };
+static const uint32_t g_pui32ADCChannel[ADC_DMA_MODULES] = { UDMA_CHANNEL_ADC0, UDMA_SEC_CHANNEL_ADC10 };
+static const uint32_t g_pui32ADCAssign[ADC_DMA_MODULES] = { UDMA_CH14_ADC0_0, UDMA_CH24_ADC1_0 };
+
+// Samples each module writes into a block, and where its region starts
+static uint32_t g_pui32DMACount[ADC_DMA_MODULES];
+static uint32_t g_pui32DMAOffset[ADC_DMA_MODULES];
+
+// Bit mask of the modules in use
+static uint32_t g_ui32DMAModules;
+
+// Blocks currently targeted by the primary [0] and alternate [1] control
+// structures.  Every module in use writes its own region of the same block.
+static tSampleBlock *g_psDMABlock[2];
+
+// Modules that have finished each half, and the next half to commit
+static uint32_t g_pui32DMADone[2];
+static uint32_t g_ui32DMACommit;
+
+// Which control structure (0 = primary, 1 = alternate) each module
+// completes next
+static uint32_t g_pui32DMANext[ADC_DMA_MODULES];
+
+// Number of times a sequence 0 FIFO overflowed because both ping-pong
+// buffers completed before the interrupt could re-arm one of them.
+static volatile uint32_t g_ui32DMAOverruns;
 
 //*****************************************************************************
 // The interrupt handler for uDMA errors.  This interrupt will occur if the
@@ -40,3 +94,256 @@ uDMAErrorHandler(void)
         g_ui32DMAErrCount++;
     }
 }
+
+//*****************************************************************************
+// Enable the uDMA controller and install the shared control table.  Safe to
+// call more than once.
+//*****************************************************************************
+void
+configureDMA(void)
+{
+    static bool bConfigured = false;
+
+    if (bConfigured) {
+        return;
+    }
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    uDMAEnable();
+    uDMAControlBaseSet(g_pui8DMAControlTable);
+
+    // Count bus errors in uDMAErrorHandler
+    IntEnable(INT_UDMAERR);
+
+    bConfigured = true;
+}
+
+//*****************************************************************************
+// Point one half of every active module's ping-pong transfer at a block.
+//*****************************************************************************
+static void
+armADCDMA(uint32_t ui32Half, tSampleBlock *psBlock)
+{
+    uint32_t ui32Module;
+
+    g_psDMABlock[ui32Half] = psBlock;
+
+    for (ui32Module = 0; ui32Module < ADC_DMA_MODULES; ui32Module++)
+    {
+        if (g_ui32DMAModules & (1 << ui32Module)) {
+            uDMAChannelTransferSet(g_pui32ADCChannel[ui32Module] | (ui32Half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT),
+                                   UDMA_MODE_PINGPONG,
+                                   (void *)(g_pui32ADCBase[ui32Module] + ADC_O_SSFIFO0),
+                                   psBlock->pui16Data + g_pui32DMAOffset[ui32Module],
+                                   g_pui32DMACount[ui32Module]);
+        }
+    }
+}
+
+//*****************************************************************************
+// Set up the uDMA channels that drain sequence 0 of ADC0 and ADC1 in
+// ping-pong mode.  The sequencer steps themselves are programmed by the
+// caller before startADCDMA().
+//*****************************************************************************
+void
+configureADCDMA(void)
+{
+    uint32_t ui32Module;
+    uint32_t ui32Channel;
+
+    configureDMA();
+
+    for (ui32Module = 0; ui32Module < ADC_DMA_MODULES; ui32Module++)
+    {
+        ui32Channel = g_pui32ADCChannel[ui32Module];
+
+        // Route sequence 0 requests to the module's uDMA channel.
+        uDMAChannelAssign(g_pui32ADCAssign[ui32Module]);
+
+        // Start from a known channel state: use the primary structure first,
+        // normal priority and do not mask requests.
+        uDMAChannelAttributeDisable(ui32Channel,
+                                    UDMA_ATTR_ALTSELECT | UDMA_ATTR_HIGH_PRIORITY |
+                                    UDMA_ATTR_REQMASK);
+
+        // The ADC only issues burst requests.
+        uDMAChannelAttributeEnable(ui32Channel, UDMA_ATTR_USEBURST);
+
+        // 16-bit reads from the fixed FIFO register into consecutive samples,
+        // one item per request (every step sets ADC_CTL_IE).  Both halves use
+        // the same settings.
+        uDMAChannelControlSet(ui32Channel | UDMA_PRI_SELECT,
+                              UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 |
+                              UDMA_ARB_1);
+        uDMAChannelControlSet(ui32Channel | UDMA_ALT_SELECT,
+                              UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 |
+                              UDMA_ARB_1);
+    }
+}
+
+//*****************************************************************************
+// Hand the first two sample blocks to the uDMA and enable the sequencers.
+// ADC0 writes ui32Count0 samples at the start of each block; if ui32Count1
+// is non-zero, ADC1 writes ui32Count1 samples right after them.  The sample
+// buffer must have been reset with sampleBufferInit().
+//*****************************************************************************
+void
+startADCDMA(uint32_t ui32Count0, uint32_t ui32Count1)
+{
+    uint32_t ui32Module;
+    uint32_t ui32Base;
+
+    g_pui32DMACount[0] = ui32Count0;
+    g_pui32DMAOffset[0] = 0;
+    g_pui32DMACount[1] = ui32Count1;
+    g_pui32DMAOffset[1] = ui32Count0;
+    g_ui32DMAModules = ui32Count1 ? 3 : 1;
+
+    g_ui32DMAOverruns = 0;
+    g_ui32DMACommit = 0;
+    g_pui32DMADone[0] = 0;
+    g_pui32DMADone[1] = 0;
+
+    armADCDMA(0, sampleBufferReserve());
+    armADCDMA(1, sampleBufferReserve());
+
+    for (ui32Module = 0; ui32Module < ADC_DMA_MODULES; ui32Module++)
+    {
+        if (!(g_ui32DMAModules & (1 << ui32Module))) {
+            continue;
+        }
+
+        ui32Base = g_pui32ADCBase[ui32Module];
+        g_pui32DMANext[ui32Module] = 0;
+        uDMAChannelEnable(g_pui32ADCChannel[ui32Module]);
+
+        // With uDMA enabled for the sequencer, the sequence interrupt only
+        // fires when a ping-pong half completes, not once per conversion.
+        ADCSequenceOverflowClear(ui32Base, 0);
+        ADCIntClear(ui32Base, 0);
+        ADCSequenceDMAEnable(ui32Base, 0);
+        ADCIntEnable(ui32Base, 0);
+        IntEnable(g_pui32ADCInt[ui32Module]);
+        ADCSequenceEnable(ui32Base, 0);
+    }
+}
+
+//*****************************************************************************
+// Stop the sequencers and uDMA channels.  Partially filled blocks are
+// discarded.
+//*****************************************************************************
+void
+stopADCDMA(void)
+{
+    uint32_t ui32Module;
+    uint32_t ui32Base;
+
+    for (ui32Module = 0; ui32Module < ADC_DMA_MODULES; ui32Module++)
+    {
+        if (!(g_ui32DMAModules & (1 << ui32Module))) {
+            continue;
+        }
+
+        ui32Base = g_pui32ADCBase[ui32Module];
+        ADCSequenceDisable(ui32Base, 0);
+        IntDisable(g_pui32ADCInt[ui32Module]);
+        ADCIntDisable(ui32Base, 0);
+        ADCSequenceDMADisable(ui32Base, 0);
+        uDMAChannelDisable(g_pui32ADCChannel[ui32Module]);
+    }
+}
+
+//*****************************************************************************
+// Number of ADC FIFO overflows seen since startADCDMA()
+//*****************************************************************************
+uint32_t
+getADCDMAOverruns(void)
+{
+    return g_ui32DMAOverruns;
+}
+
+//*****************************************************************************
+// Common completion handling for one ADC module.  Halves always complete in
+// primary, alternate, primary... order.  A block is committed only when
+// every active module has finished its region of it; the half is then
+// re-armed for all modules with a fresh block, so the CPU runs once per
+// block per module regardless of the channel count.
+//*****************************************************************************
+static void
+adcDMAComplete(uint32_t ui32Module)
+{
+    uint32_t ui32Base = g_pui32ADCBase[ui32Module];
+    uint32_t ui32Channel = g_pui32ADCChannel[ui32Module];
+    uint32_t ui32Bit = 1 << ui32Module;
+    uint32_t ui32Half;
+    uint32_t ui32Other;
+
+    noteSampleLatency();
+
+    ADCIntClear(ui32Base, 0);
+
+    // Record every half this module has finished.  If interrupt latency
+    // exceeded a whole block, both halves may be done.
+    for (;;)
+    {
+        ui32Half = g_pui32DMANext[ui32Module];
+
+        if ((g_pui32DMADone[ui32Half] & ui32Bit) ||
+            uDMAChannelModeGet(ui32Channel | (ui32Half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT)) != UDMA_MODE_STOP) {
+            break;
+        }
+
+        g_pui32DMADone[ui32Half] |= ui32Bit;
+        g_pui32DMANext[ui32Module] = ui32Half ^ 1;
+    }
+
+    // Commit complete blocks in order and re-arm their halves
+    while (g_pui32DMADone[g_ui32DMACommit] == g_ui32DMAModules)
+    {
+        ui32Half = g_ui32DMACommit;
+
+        g_psDMABlock[ui32Half]->ui32Count = g_pui32DMACount[0] + g_pui32DMACount[1];
+        sampleBufferCommit(g_psDMABlock[ui32Half]);
+        armADCDMA(ui32Half, sampleBufferReserve());
+
+        g_pui32DMADone[ui32Half] = 0;
+        g_ui32DMACommit = ui32Half ^ 1;
+    }
+
+    // When both halves of a module had stopped, its channel disabled itself
+    // and the sequencer FIFO overflowed in the meantime.  Count it and
+    // restart any channel whose next half has been re-armed.
+    if (ADCSequenceOverflow(ui32Base, 0)) {
+        ADCSequenceOverflowClear(ui32Base, 0);
+        g_ui32DMAOverruns++;
+    }
+    for (ui32Other = 0; ui32Other < ADC_DMA_MODULES; ui32Other++)
+    {
+        ui32Channel = g_pui32ADCChannel[ui32Other];
+
+        if ((g_ui32DMAModules & (1 << ui32Other)) && !uDMAChannelIsEnabled(ui32Channel) &&
+            uDMAChannelModeGet(ui32Channel | (g_pui32DMANext[ui32Other] ? UDMA_ALT_SELECT : UDMA_PRI_SELECT)) != UDMA_MODE_STOP) {
+            uDMAChannelEnable(ui32Channel);
+        }
+    }
+}
+
+//*****************************************************************************
+// ADC0 sequence 0 interrupt handler, raised by the uDMA each time one half of
+// the ping-pong transfer completes.
+//*****************************************************************************
+void
+ADC0SS0IntHandler(void)
+{
+    adcDMAComplete(0);
+}
+
+//*****************************************************************************
+// ADC1 sequence 0 interrupt handler, used when the channel list is split
+// across both ADC modules.
+//*****************************************************************************
+void
+ADC1SS0IntHandler(void)
+{
+    adcDMAComplete(1);
+}
@@ -9,5 +9,12 @@
 #define DATA_TRANSFER_FUNCTIONS_H_
 
 void uDMAErrorHandler(void);
+void configureDMA(void);
+void configureADCDMA(void);
+void startADCDMA(uint32_t ui32Count0, uint32_t ui32Count1);
+void stopADCDMA(void);
+uint32_t getADCDMAOverruns(void);
+void ADC0SS0IntHandler(void);
+void ADC1SS0IntHandler(void);
 
 #endif /* DATA_TRANSFER_FUNCTIONS_H_ */
@@ -0,0 +1,109 @@
+/*
+ * decimator.c
+ *
+ *  Created on: Mar 4, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "decimator.h"
+
+//*****************************************************************************/
+// Set up a CIC decimator.  ui32Factor must be a power of two from 1 to
+// DECIMATOR_MAX_FACTOR.  Returns false for an unsupported configuration.
+//
+// The output is a 16-bit code scaled so that a 12-bit input code x at DC
+// produces x << 4; the extra four bits carry the resolution gained by
+// averaging.
+//*****************************************************************************/
+bool
+decimatorInit(tDecimator *psDec, uint32_t ui32Factor, uint32_t ui32Stages)
+{
+    uint32_t ui32Log2 = 0;
+
+    if (ui32Factor == 0 || ui32Factor > DECIMATOR_MAX_FACTOR ||
+        (ui32Factor & (ui32Factor - 1)) != 0 ||
+        ui32Stages == 0 || ui32Stages > DECIMATOR_MAX_STAGES) {
+        return false;
+    }
+
+    while ((1u << ui32Log2) < ui32Factor) {
+        ui32Log2++;
+    }
+
+    if (ui32Stages * ui32Log2 > DECIMATOR_MAX_GROWTH) {
+        return false;
+    }
+
+    memset(psDec, 0, sizeof(*psDec));
+    psDec->ui32Stages = ui32Stages;
+    psDec->ui32Log2Factor = ui32Log2;
+    psDec->ui32Phase = ui32Factor;
+
+    // The CIC gain is factor^stages = 2^(stages * log2).  Scale 12-bit input
+    // up to 16 bits, or down when the gain exceeds 16.
+    psDec->ui32OutShift = ui32Stages * ui32Log2;
+
+    return true;
+}
+
+//*****************************************************************************/
+// Decimate ui32Count 12-bit samples.  Writes one 16-bit output per factor
+// inputs to pui16Out and returns the number of outputs.  pui16Out may equal
+// pui16In for in-place processing.
+//*****************************************************************************/
+uint32_t
+decimatorProcess(tDecimator *psDec, const uint16_t *pui16In,
+                 uint32_t ui32Count, uint16_t *pui16Out)
+{
+    uint32_t ui32Outputs = 0;
+    uint32_t ui32Phase = psDec->ui32Phase;
+    uint32_t ui32I0 = psDec->pui32Integ[0];
+    uint32_t ui32I1 = psDec->pui32Integ[1];
+    uint32_t ui32I2 = psDec->pui32Integ[2];
+    uint32_t ui32Value;
+    uint32_t ui32Prev;
+    uint32_t ui32Stage;
+
+    while (ui32Count--)
+    {
+        // Integrator section runs at the input rate.  Unused stages are
+        // computed anyway; it is cheaper than branching per sample.
+        ui32I0 += *pui16In++;
+        ui32I1 += ui32I0;
+        ui32I2 += ui32I1;
+
+        if (--ui32Phase) {
+            continue;
+        }
+        ui32Phase = 1u << psDec->ui32Log2Factor;
+
+        // Comb section runs at the output rate on the last integrator
+        ui32Value = (psDec->ui32Stages == 1) ? ui32I0 :
+                    (psDec->ui32Stages == 2) ? ui32I1 : ui32I2;
+
+        for (ui32Stage = 0; ui32Stage < psDec->ui32Stages; ui32Stage++)
+        {
+            ui32Prev = psDec->pui32Comb[ui32Stage];
+            psDec->pui32Comb[ui32Stage] = ui32Value;
+            ui32Value -= ui32Prev;
+        }
+
+        // Remove the CIC gain and left-justify to 16 bits
+        ui32Value = (psDec->ui32OutShift >= 4) ? (ui32Value >> (psDec->ui32OutShift - 4))
+                                               : (ui32Value << (4 - psDec->ui32OutShift));
+        pui16Out[ui32Outputs++] = (ui32Value > 0xFFFF) ? 0xFFFF : (uint16_t)ui32Value;
+    }
+
+    psDec->ui32Phase = ui32Phase;
+    psDec->pui32Integ[0] = ui32I0;
+    psDec->pui32Integ[1] = ui32I1;
+    psDec->pui32Integ[2] = ui32I2;
+
+    return ui32Outputs;
+}
@@ -0,0 +1,44 @@
+/*
+ * decimator.h
+ *
+ *  Created on: Mar 4, 2024
+ *      Author: Tyler
+ */
+
+#ifndef DECIMATOR_H_
+#define DECIMATOR_H_
+
+// Limits of the CIC decimator.  Bit growth is ui32Stages * log2(ui32Factor)
+// and must leave the 12-bit input inside a 32-bit accumulator.
+#define DECIMATOR_MAX_STAGES    3
+#define DECIMATOR_MAX_FACTOR    256
+#define DECIMATOR_MAX_GROWTH    20
+
+// State of a CIC (cascaded integrator-comb) decimator.  A single stage is a
+// boxcar average.  The structure holds all state, so no memory is allocated.
+typedef struct
+{
+    // Number of integrator/comb stages, 1 to DECIMATOR_MAX_STAGES
+    uint32_t ui32Stages;
+
+    // log2 of the decimation factor
+    uint32_t ui32Log2Factor;
+
+    // Right shift that maps the CIC gain onto a 16-bit output
+    uint32_t ui32OutShift;
+
+    // Input samples remaining until the next output
+    uint32_t ui32Phase;
+
+    // Integrator and comb delay registers.  Integrators are allowed to wrap;
+    // two's complement arithmetic makes the comb output exact regardless.
+    uint32_t pui32Integ[DECIMATOR_MAX_STAGES];
+    uint32_t pui32Comb[DECIMATOR_MAX_STAGES];
+}
+tDecimator;
+
+bool decimatorInit(tDecimator *psDec, uint32_t ui32Factor, uint32_t ui32Stages);
+uint32_t decimatorProcess(tDecimator *psDec, const uint16_t *pui16In,
+                          uint32_t ui32Count, uint16_t *pui16Out);
+
+#endif /* DECIMATOR_H_ */
@@ -0,0 +1,238 @@
+/*
+ * event_capture.c
+ *
+ *  Created on: Apr 8, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "adc_functions.h"
+#include "sample_buffer.h"
+#include "sample_sink.h"
+#include "event_capture.h"
+
+//*****************************************************************************/
+// Threshold-triggered event capture.
+//
+// While armed, processed blocks are copied into a small circular history
+// instead of being written.  When a block trips the trigger, the history
+// (oldest first) and the triggering block go to the sink, followed by the
+// next ui32EventPostBlocks blocks.  A trigger during the post-trigger window
+// extends it.  The window then closes and the capture re-arms with an empty
+// history.
+//
+// Blocks keep their sequence numbers and first sample numbers, so the sink
+// output of every window carries its true timestamps and the gaps between
+// windows are visible downstream.
+//*****************************************************************************/
+
+// A block held back as pre-trigger history
+typedef struct
+{
+    tSampleBlock sBlock;
+    uint32_t ui32Count;
+    uint64_t ui64FirstSample;
+}
+tEventHistory;
+
+static tEventHistory g_psHistory[EVENT_MAX_PRE_BLOCKS];
+
+// Oldest history entry and number of entries held
+static uint32_t g_ui32HistoryFirst;
+static uint32_t g_ui32HistoryCount;
+
+// Number of history blocks to keep for this run
+static uint32_t g_ui32PreBlocks;
+
+// Blocks still to be written in the current post-trigger window; zero while
+// armed
+static uint32_t g_ui32PostRemaining;
+
+// Trigger settings for this run, in output codes
+static const tSampleSink *g_psSink;
+static uint32_t g_ui32Threshold;
+static int32_t g_i32MidScale;
+
+// Last trigger channel sample of the previous block, for the slope trigger
+static int32_t g_i32LastSample;
+static bool g_bHaveLast;
+
+// Counters for the end-of-run report
+static uint32_t g_ui32Events;
+static uint32_t g_ui32BlocksWritten;
+
+//*****************************************************************************/
+// Reset the capture for a new run writing to psSink, using the event
+// settings in g_sAcqConfig.
+//*****************************************************************************/
+void
+eventCaptureStart(const tSampleSink *psSink)
+{
+    // Thresholds are given in 12-bit codes; decimated output is 16-bit
+    uint32_t ui32Shift = (g_sAcqConfig.ui32Decimation > 1) ? 4 : 0;
+
+    g_psSink = psSink;
+    g_ui32Threshold = g_sAcqConfig.ui32EventThreshold << ui32Shift;
+    g_i32MidScale = 2048 << ui32Shift;
+
+    // preparePipeline() rejects longer histories; this only guards the
+    // history array
+    g_ui32PreBlocks = g_sAcqConfig.ui32EventPreBlocks;
+    if (g_ui32PreBlocks > EVENT_MAX_PRE_BLOCKS) {
+        g_ui32PreBlocks = EVENT_MAX_PRE_BLOCKS;
+    }
+
+    g_ui32HistoryFirst = 0;
+    g_ui32HistoryCount = 0;
+    g_ui32PostRemaining = 0;
+    g_bHaveLast = false;
+    g_ui32Events = 0;
+    g_ui32BlocksWritten = 0;
+}
+
+//*****************************************************************************/
+// Evaluate the trigger over the first ui32Count samples of the block's first
+// plane
+//*****************************************************************************/
+static bool
+isTriggered(const tSampleBlock *psBlock, uint32_t ui32Count)
+{
+    const uint16_t *pui16Plane = psBlock->pui16Data;
+    uint64_t ui64SumSquares = 0;
+    uint32_t ui32Index;
+    int32_t i32Sample;
+    int32_t i32Deviation;
+    bool bTriggered = false;
+
+    if (ui32Count == 0) {
+        return false;
+    }
+
+    switch (g_sAcqConfig.ui32EventMode)
+    {
+    case EVENT_MODE_LEVEL:
+        for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+        {
+            if ((uint32_t)abs((int32_t)pui16Plane[ui32Index] - g_i32MidScale) > g_ui32Threshold) {
+                return true;
+            }
+        }
+        break;
+
+    case EVENT_MODE_SLOPE:
+        // The whole block is scanned so the last sample is carried over
+        if (!g_bHaveLast) {
+            g_i32LastSample = pui16Plane[0];
+            g_bHaveLast = true;
+        }
+        for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+        {
+            i32Sample = pui16Plane[ui32Index];
+            if ((uint32_t)abs(i32Sample - g_i32LastSample) > g_ui32Threshold) {
+                bTriggered = true;
+            }
+            g_i32LastSample = i32Sample;
+        }
+        break;
+
+    case EVENT_MODE_RMS:
+        // Compare mean squares rather than take a square root
+        for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+        {
+            i32Deviation = (int32_t)pui16Plane[ui32Index] - g_i32MidScale;
+            ui64SumSquares += (uint64_t)((int64_t)i32Deviation * i32Deviation);
+        }
+        bTriggered = ui64SumSquares > (uint64_t)g_ui32Threshold * g_ui32Threshold * ui32Count;
+        break;
+
+    default:
+        break;
+    }
+
+    return bTriggered;
+}
+
+//*****************************************************************************/
+// Hand one block to the sink
+//*****************************************************************************/
+static void
+writeBlock(const tSampleBlock *psBlock, uint32_t ui32Count, uint64_t ui64FirstSample)
+{
+    g_psSink->pfnWrite(psBlock, ui32Count, ui64FirstSample);
+    g_ui32BlocksWritten++;
+}
+
+//*****************************************************************************/
+// Consume one processed block, with the same arguments as a sink's pfnWrite.
+// The block itself may be released as soon as this returns.
+//*****************************************************************************/
+void
+eventCaptureBlock(const tSampleBlock *psBlock, uint32_t ui32Count, uint64_t ui64FirstSample)
+{
+    tEventHistory *psEntry;
+    bool bTriggered = isTriggered(psBlock, ui32Count);
+
+    // Inside a window: write the block, and restart the window on a new
+    // trigger
+    if (g_ui32PostRemaining) {
+        writeBlock(psBlock, ui32Count, ui64FirstSample);
+        if (bTriggered) {
+            g_ui32PostRemaining = g_sAcqConfig.ui32EventPostBlocks + 1;
+        }
+        g_ui32PostRemaining--;
+        return;
+    }
+
+    // Armed and triggered: open a window with the history in front
+    if (bTriggered) {
+        g_ui32Events++;
+        while (g_ui32HistoryCount)
+        {
+            psEntry = &g_psHistory[g_ui32HistoryFirst];
+            writeBlock(&psEntry->sBlock, psEntry->ui32Count, psEntry->ui64FirstSample);
+            g_ui32HistoryFirst = (g_ui32HistoryFirst + 1) % EVENT_MAX_PRE_BLOCKS;
+            g_ui32HistoryCount--;
+        }
+        writeBlock(psBlock, ui32Count, ui64FirstSample);
+        g_ui32PostRemaining = g_sAcqConfig.ui32EventPostBlocks;
+        return;
+    }
+
+    // Armed: keep the block as history, dropping the oldest when full
+    if (g_ui32PreBlocks == 0) {
+        return;
+    }
+    if (g_ui32HistoryCount == g_ui32PreBlocks) {
+        g_ui32HistoryFirst = (g_ui32HistoryFirst + 1) % EVENT_MAX_PRE_BLOCKS;
+        g_ui32HistoryCount--;
+    }
+    psEntry = &g_psHistory[(g_ui32HistoryFirst + g_ui32HistoryCount) % EVENT_MAX_PRE_BLOCKS];
+    memcpy(&psEntry->sBlock, psBlock, sizeof(psEntry->sBlock));
+    psEntry->ui32Count = ui32Count;
+    psEntry->ui64FirstSample = ui64FirstSample;
+    g_ui32HistoryCount++;
+}
+
+//*****************************************************************************/
+// Number of triggers that opened a window in this run
+//*****************************************************************************/
+uint32_t
+eventCaptureEvents(void)
+{
+    return g_ui32Events;
+}
+
+//*****************************************************************************/
+// Number of blocks written to the sink in this run
+//*****************************************************************************/
+uint32_t
+eventCaptureBlocksWritten(void)
+{
+    return g_ui32BlocksWritten;
+}
@@ -0,0 +1,31 @@
+/*
+ * event_capture.h
+ *
+ *  Created on: Apr 8, 2024
+ *      Author: Tyler
+ */
+
+#ifndef EVENT_CAPTURE_H_
+#define EVENT_CAPTURE_H_
+
+// Event trigger modes, used as g_sAcqConfig.ui32EventMode.  The trigger is
+// evaluated once per block on the first channel of the list (AIN0 - AIN1 by
+// default), as a deviation from mid-scale in output codes.
+#define EVENT_MODE_OFF      0   // Record every sample
+#define EVENT_MODE_LEVEL    1   // Any |sample - mid-scale| above the threshold
+#define EVENT_MODE_SLOPE    2   // Any step between samples above the threshold
+#define EVENT_MODE_RMS      3   // Block RMS about mid-scale above the threshold
+#define EVENT_MODE_COUNT    4
+
+// Most blocks of pre-trigger history kept while armed.  Each one costs a
+// tSampleBlock of RAM.
+#ifndef EVENT_MAX_PRE_BLOCKS
+#define EVENT_MAX_PRE_BLOCKS    4
+#endif
+
+void eventCaptureStart(const tSampleSink *psSink);
+void eventCaptureBlock(const tSampleBlock *psBlock, uint32_t ui32Count, uint64_t ui64FirstSample);
+uint32_t eventCaptureEvents(void);
+uint32_t eventCaptureBlocksWritten(void);
+
+#endif /* EVENT_CAPTURE_H_ */
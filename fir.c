@@ -0,0 +1,304 @@
+/*
+ * fir.c
+ *
+ *  Created on: Apr 15, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "sample_buffer.h"
+#include "fir.h"
+
+//*****************************************************************************/
+// Dual 16-bit multiply-accumulate: acc + lo(x) * lo(y) + hi(x) * hi(y).  The
+// Cortex-M4 does this in one SMLAD instruction; other targets use the
+// portable C version, which gives the same result as long as the
+// accumulator does not overflow (see fir.h).
+//*****************************************************************************/
+#if defined(ccs) && defined(__TI_ARM_V7M4__)
+#define FIR_SMLAD(x, y, acc)    _smlad((x), (y), (acc))
+#elif defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#define FIR_SMLAD(x, y, acc)    __smlad((x), (y), (acc))
+#else
+#define FIR_SMLAD(x, y, acc)    ((acc) + (int32_t)(int16_t)(x) * (int16_t)(y) + \
+                                 ((int32_t)(x) >> 16) * ((int32_t)(y) >> 16))
+#endif
+
+// Mid-scale of a 12-bit code, subtracted before filtering
+#define FIR_MID_SCALE       2048
+#define FIR_MAX_CODE        4095
+
+// Largest sum of Q15 coefficient magnitudes for which the accumulator,
+// starting from the rounding term, stays within 32 bits for any input
+#define FIR_MAX_MAGNITUDE   ((0x7FFFFFFF - (1 << 14)) / FIR_MID_SCALE)
+
+// A notch must cut its centre frequency by at least 20 dB and keep the gain
+// at the Nyquist frequency within 1 dB of the gain at DC (linear gains)
+#define FIR_NOTCH_DEPTH     0.1f
+#define FIR_PASS_LOW        0.891f
+#define FIR_PASS_HIGH       1.122f
+
+// The Hamming window's transition band is about 3.3 / taps of the sample
+// rate wide.  A low-pass needs it no wider than the cutoff to reach -6 dB
+// there.
+#define FIR_TRANSITION      3.3f
+
+// Scratch line: a filter's history followed by the block being filtered, so
+// every output is a dot product over a contiguous window
+static int16_t g_pi16Line[FIR_MAX_TAPS - 1 + FIR_MAX_BLOCK];
+
+//*****************************************************************************/
+// Load two adjacent 16-bit values as one word, low half first.  The window
+// start moves one sample per output, so this is often unaligned; the
+// Cortex-M4 handles that in a single load.
+//*****************************************************************************/
+static inline int32_t
+readPair(const int16_t *pi16Data)
+{
+    int32_t i32Pair;
+
+    memcpy(&i32Pair, pi16Data, sizeof(i32Pair));
+    return i32Pair;
+}
+
+//*****************************************************************************/
+// Set up a filter with a designed coefficient set and a history at mid-scale
+//*****************************************************************************/
+void
+firInit(tFIRFilter *psFilter, const tFIRCoeffs *psCoeffs)
+{
+    psFilter->psCoeffs = psCoeffs;
+    memset(psFilter->pi16History, 0, sizeof(psFilter->pi16History));
+}
+
+//*****************************************************************************/
+// Filter ui32Count (at most FIR_MAX_BLOCK) 12-bit codes in place.  Outputs
+// are rounded and clamped to the 12-bit range.
+//*****************************************************************************/
+void
+firProcess(tFIRFilter *psFilter, uint16_t *pui16Data, uint32_t ui32Count)
+{
+    const int16_t *pi16Coeffs = psFilter->psCoeffs->pi16Coeffs;
+    const int16_t *pi16Window;
+    uint32_t ui32Taps = psFilter->psCoeffs->ui32Taps;
+    uint32_t ui32History = (ui32Taps - 1) * sizeof(int16_t);
+    uint32_t ui32Index;
+    uint32_t ui32Tap;
+    int32_t i32Acc;
+
+    memcpy(g_pi16Line, psFilter->pi16History, ui32History);
+    for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+    {
+        g_pi16Line[ui32Taps - 1 + ui32Index] = (int16_t)pui16Data[ui32Index] - FIR_MID_SCALE;
+    }
+
+    for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+    {
+        // The coefficients are stored time-reversed, so they line up with
+        // the window oldest sample first
+        pi16Window = &g_pi16Line[ui32Index];
+        i32Acc = 1 << 14;
+        for (ui32Tap = 0; ui32Tap < ui32Taps; ui32Tap += 2)
+        {
+            i32Acc = FIR_SMLAD(readPair(&pi16Coeffs[ui32Tap]), readPair(&pi16Window[ui32Tap]), i32Acc);
+        }
+
+        i32Acc = (i32Acc >> 15) + FIR_MID_SCALE;
+        if (i32Acc < 0) {
+            i32Acc = 0;
+        }
+        else if (i32Acc > FIR_MAX_CODE) {
+            i32Acc = FIR_MAX_CODE;
+        }
+        pui16Data[ui32Index] = (uint16_t)i32Acc;
+    }
+
+    memcpy(psFilter->pi16History, &g_pi16Line[ui32Count], ui32History);
+}
+
+//*****************************************************************************/
+// Hamming-windowed ideal low-pass response at tap ui32Tap of the designed
+// ui32Taps - 1 taps, with the cutoff in cycles per sample
+//*****************************************************************************/
+static float
+windowedSinc(uint32_t ui32Tap, uint32_t ui32Taps, float fCutoff)
+{
+    const float fPi = 3.14159265f;
+    float fWindow;
+    float fOffset;
+
+    fWindow = 0.54f - 0.46f * cosf(2.0f * fPi * ui32Tap / (ui32Taps - 2));
+    fOffset = (float)ui32Tap - (float)((ui32Taps - 2) / 2);
+
+    if (fOffset == 0.0f) {
+        return 2.0f * fCutoff * fWindow;
+    }
+
+    return sinf(2.0f * fPi * fCutoff * fOffset) / (fPi * fOffset) * fWindow;
+}
+
+//*****************************************************************************/
+// Quantize a designed response to Q15 and store it time-reversed, with the
+// centre tap adjusted so the coefficients sum to exactly 1.0: mid-scale and
+// any DC level pass through unchanged.  The response is symmetric, so
+// reversing it only moves the unused zero slot to the front.  Returns false,
+// leaving psCoeffs undefined, if a tap does not fit in Q15 or the magnitudes
+// sum to FIR_MAX_MAGNITUDE or more.
+//*****************************************************************************/
+static bool
+storeCoeffs(tFIRCoeffs *psCoeffs, const float *pfResponse, uint32_t ui32Taps)
+{
+    int32_t pi32Taps[FIR_MAX_TAPS - 1];
+    int32_t i32Sum = 0;
+    int32_t i32Magnitude = 0;
+    uint32_t ui32Tap;
+
+    for (ui32Tap = 0; ui32Tap < ui32Taps - 1; ui32Tap++)
+    {
+        pi32Taps[ui32Tap] = lroundf(pfResponse[ui32Tap] * 32768.0f);
+        i32Sum += pi32Taps[ui32Tap];
+    }
+    pi32Taps[(ui32Taps - 2) / 2] += 32768 - i32Sum;
+
+    psCoeffs->ui32Taps = ui32Taps;
+    psCoeffs->pi16Coeffs[0] = 0;
+    for (ui32Tap = 0; ui32Tap < ui32Taps - 1; ui32Tap++)
+    {
+        if (pi32Taps[ui32Tap] < -32768 || pi32Taps[ui32Tap] > 32767) {
+            return false;
+        }
+        psCoeffs->pi16Coeffs[ui32Tap + 1] = (int16_t)pi32Taps[ui32Tap];
+        i32Magnitude += abs(pi32Taps[ui32Tap]);
+    }
+
+    return i32Magnitude < FIR_MAX_MAGNITUDE;
+}
+
+//*****************************************************************************/
+// Gain of a stored coefficient set at fFreq, as a fraction of the sample rate
+//*****************************************************************************/
+static float
+coeffsGain(const tFIRCoeffs *psCoeffs, float fFreq)
+{
+    const float fPi = 3.14159265f;
+    float fRe = 0.0f;
+    float fIm = 0.0f;
+    uint32_t ui32Tap;
+
+    for (ui32Tap = 0; ui32Tap < psCoeffs->ui32Taps; ui32Tap++)
+    {
+        fRe += psCoeffs->pi16Coeffs[ui32Tap] * cosf(2.0f * fPi * fFreq * ui32Tap);
+        fIm -= psCoeffs->pi16Coeffs[ui32Tap] * sinf(2.0f * fPi * fFreq * ui32Tap);
+    }
+
+    return sqrtf(fRe * fRe + fIm * fIm) / 32768.0f;
+}
+
+//*****************************************************************************/
+// Design a low-pass filter.  fCutoff is the -6 dB frequency as a fraction of
+// the sample rate and must be at most 0.45.  The tap count grows as the
+// cutoff falls, to keep the transition band inside it; returns false if the
+// cutoff is out of range or would need more than FIR_MAX_TAPS, which limits
+// it to about 0.035 and up.
+//*****************************************************************************/
+bool
+firDesignLowPass(tFIRCoeffs *psCoeffs, float fCutoff)
+{
+    float pfResponse[FIR_MAX_TAPS - 1];
+    float fSum = 0.0f;
+    uint32_t ui32Taps;
+    uint32_t ui32Tap;
+
+    if (fCutoff * (FIR_MAX_TAPS - 1) < FIR_TRANSITION || fCutoff > 0.45f) {
+        return false;
+    }
+
+    // Fewest even slots whose ui32Taps - 1 taps narrow the transition to
+    // the cutoff
+    ui32Taps = FIR_MIN_TAPS;
+    while (fCutoff * (ui32Taps - 1) < FIR_TRANSITION)
+    {
+        ui32Taps += 2;
+    }
+
+    for (ui32Tap = 0; ui32Tap < ui32Taps - 1; ui32Tap++)
+    {
+        pfResponse[ui32Tap] = windowedSinc(ui32Tap, ui32Taps, fCutoff);
+        fSum += pfResponse[ui32Tap];
+    }
+
+    // Unity gain at DC
+    for (ui32Tap = 0; ui32Tap < ui32Taps - 1; ui32Tap++)
+    {
+        pfResponse[ui32Tap] /= fSum;
+    }
+
+    return storeCoeffs(psCoeffs, pfResponse, ui32Taps);
+}
+
+//*****************************************************************************/
+// Design a band-stop filter with ui32Taps slots, or return false if it misses
+// the limits below
+//*****************************************************************************/
+static bool
+designNotch(tFIRCoeffs *psCoeffs, float fCenter, uint32_t ui32Taps)
+{
+    float pfResponse[FIR_MAX_TAPS - 1];
+    float fHalfWidth = 1.5f / (ui32Taps - 1);
+    float fGain;
+    uint32_t ui32Tap;
+
+    if (fCenter - fHalfWidth <= 0.0f || fCenter + fHalfWidth >= 0.5f) {
+        return false;
+    }
+
+    // An impulse minus the band-pass between the two cutoffs
+    for (ui32Tap = 0; ui32Tap < ui32Taps - 1; ui32Tap++)
+    {
+        pfResponse[ui32Tap] = windowedSinc(ui32Tap, ui32Taps, fCenter - fHalfWidth) -
+                              windowedSinc(ui32Tap, ui32Taps, fCenter + fHalfWidth);
+    }
+    pfResponse[(ui32Taps - 2) / 2] += 1.0f;
+
+    if (!storeCoeffs(psCoeffs, pfResponse, ui32Taps)) {
+        return false;
+    }
+
+    // Near DC or Nyquist the stop band overlaps the window's transition
+    // band, and the unity-DC correction no longer leaves a notch at fCenter
+    fGain = coeffsGain(psCoeffs, 0.5f);
+    return (coeffsGain(psCoeffs, fCenter) <= FIR_NOTCH_DEPTH) && (fGain >= FIR_PASS_LOW) && (fGain <= FIR_PASS_HIGH);
+}
+
+//*****************************************************************************/
+// Design a band-stop filter centred on fCenter, as a fraction of the sample
+// rate.  With ui32Taps - 1 taps the stop band is about 3 / (ui32Taps - 1) of
+// the sample rate wide, so a notch near DC or Nyquist needs more taps; the
+// fewest that work are used.  Returns false if no tap count up to
+// FIR_MAX_TAPS cuts fCenter by at least 20 dB and keeps the gains at DC and
+// Nyquist within 1 dB of each other, which limits fCenter to about 0.03 to
+// 0.47 (a 50 Hz notch works up to about 1.7 kHz sampling, 60 Hz up to about
+// 2 kHz).
+//*****************************************************************************/
+bool
+firDesignNotch(tFIRCoeffs *psCoeffs, float fCenter)
+{
+    uint32_t ui32Taps;
+
+    for (ui32Taps = FIR_MIN_TAPS; ui32Taps <= FIR_MAX_TAPS; ui32Taps += 2)
+    {
+        if (designNotch(psCoeffs, fCenter, ui32Taps)) {
+            return true;
+        }
+    }
+
+    return false;
+}
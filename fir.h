@@ -0,0 +1,53 @@
+/*
+ * fir.h
+ *
+ *  Created on: Apr 15, 2024
+ *      Author: Tyler
+ */
+
+#ifndef FIR_H_
+#define FIR_H_
+
+// Coefficient slots per filter, from FIR_MIN_TAPS up to FIR_MAX_TAPS.  Always
+// even, since the inner loop takes two taps per step.  A design with
+// ui32Taps slots uses ui32Taps - 1 taps (an odd, symmetric, linear-phase
+// response delaying the signal by ui32Taps / 2 - 1 samples) and leaves the
+// first slot zero.  Each design takes the fewest slots that meet its limits,
+// since the filtering time grows with the tap count.
+#define FIR_MIN_TAPS        32
+#define FIR_MAX_TAPS        96
+
+// Largest block accepted by firProcess()
+#define FIR_MAX_BLOCK       SAMPLE_BLOCK_SIZE
+
+// A designed coefficient set.  Inputs are 12-bit codes less mid-scale, at
+// most 2048 in magnitude, so the 32-bit accumulator cannot overflow while the
+// coefficient magnitudes sum to less than about 32.0 (see fir.c).
+typedef struct
+{
+    // Slots in use, even
+    uint32_t ui32Taps;
+
+    // Coefficients in time-reversed order, Q15
+    int16_t pi16Coeffs[FIR_MAX_TAPS];
+}
+tFIRCoeffs;
+
+// Q15 FIR filter on 12-bit ADC codes, about mid-scale.  Coefficients may be
+// shared by several filters (one per channel); the history is per filter.
+typedef struct
+{
+    const tFIRCoeffs *psCoeffs;
+
+    // Last psCoeffs->ui32Taps - 1 inputs, oldest first, as signed offsets
+    // from mid-scale
+    int16_t pi16History[FIR_MAX_TAPS - 1];
+}
+tFIRFilter;
+
+void firInit(tFIRFilter *psFilter, const tFIRCoeffs *psCoeffs);
+void firProcess(tFIRFilter *psFilter, uint16_t *pui16Data, uint32_t ui32Count);
+bool firDesignLowPass(tFIRCoeffs *psCoeffs, float fCutoff);
+bool firDesignNotch(tFIRCoeffs *psCoeffs, float fCenter);
+
+#endif /* FIR_H_ */
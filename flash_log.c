@@ -0,0 +1,834 @@
+/*
+ * flash_log.c
+ *
+ *  Created on: Mar 11, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "crc.h"
+#include "data_transfer_functions.h"
+#include "flash_log.h"
+#include "spi_flash.h"
+#include "timebase.h"
+#include "uart_functions.h"
+#include "uartstdio.h"
+
+// Tiva C Series libraries
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+
+#if (FLASH_LOG_SIZE % FLASH_LOG_SECTOR_SIZE) != 0
+#error "FLASH_LOG_SIZE must be a whole number of sectors"
+#endif
+
+#if (FLASH_LOG_QUEUE_PAGES < 2) || ((FLASH_LOG_QUEUE_PAGES & (FLASH_LOG_QUEUE_PAGES - 1)) != 0)
+#error "FLASH_LOG_QUEUE_PAGES must be a power of two, at least 2"
+#endif
+
+// The sector being written must never come up for erase
+#if (FLASH_LOG_ERASE_AHEAD < 1) || (FLASH_LOG_ERASE_AHEAD > FLASH_LOG_SECTORS - 2)
+#error "FLASH_LOG_ERASE_AHEAD must be between 1 and FLASH_LOG_SECTORS - 2"
+#endif
+
+// Write-in-progress bit of the flash status register
+#define FLASH_STATUS_WIP    0x01
+
+// Background writer states
+#define WRITER_IDLE         0   // Flash idle, nothing in flight
+#define WRITER_WAIT         1   // Flash busy with a page program or erase
+#define WRITER_PROGRAM      2   // Page program command being shifted out
+#define WRITER_READ         3   // flashLogDump() read being shifted in
+
+//*****************************************************************************/
+// Append-only sample log on the external SPI flash.
+//
+// Records are packed into page-sized segments (flash_log.h) and pages are
+// programmed strictly in order, wrapping at the end of the device.  Up to
+// FLASH_LOG_ERASE_AHEAD sectors past the one being filled are erased in the
+// background, so while that headroom lasts the writer crosses into a sector
+// whose erase has long finished and a page program never waits for more than
+// one page time.
+//
+// Nothing but the flash itself records where the log ends.  On boot the tail
+// is found again by reading the first page of every sector, taking the one
+// with the highest sequence number, and binary searching that sector for its
+// first erased page.  A page torn by a reset fails its CRC and is skipped by
+// readers; the writer simply carries on after it.
+//
+// Programming runs in the background.  Sealed pages wait in a small queue;
+// flashLogService() starts each page program with
+// SPIFlashPageProgramNonBlocking() over uDMA, SSI0IntHandler() retires it,
+// and the flash busy bit is then polled once per service call rather than
+// spun on.  The caller only waits when every page buffer is full, and that
+// time is accounted as a stall.
+//*****************************************************************************/
+static bool g_bPresent;
+
+// Page buffers.  Slot (head & mask) is being filled by flashLogAppend();
+// slots from tail up to head are sealed and wait for the writer.  The head is
+// only advanced by the main loop and the tail only by SSI0IntHandler().
+static uint8_t g_ppui8Queue[FLASH_LOG_QUEUE_PAGES][FLASH_LOG_PAGE_SIZE];
+static uint32_t g_ui32QueueHead;
+static volatile uint32_t g_ui32QueueTail;
+static uint32_t g_ui32PageFill;
+static uint64_t g_ui64PageTimestamp;
+
+// Page the slot being filled will be programmed into, and its sequence number
+static uint32_t g_ui32WritePage;
+static uint32_t g_ui32WriteSeq;
+
+// Current run and whether its first segment is still to be written
+static uint32_t g_ui32RunID;
+static bool g_bRunStart;
+
+// Writer state and the page the oldest queued slot goes to
+static volatile uint32_t g_ui32WriterState;
+static uint32_t g_ui32ProgramPage;
+
+// Erase scheduler: the next sector to erase, and how many sectors before it
+// are erased but not yet entered by the writer.  Sectors are erased strictly
+// in order, so g_ui32EraseSector is always g_ui32Headroom sectors past the
+// next sector the writer will enter.
+static uint32_t g_ui32EraseSector;
+static uint32_t g_ui32Headroom;
+
+// Driver state for the non-blocking page program
+static tSPIFlashState g_sFlashState;
+
+// Writer statistics for the current run
+static tFlashLogStats g_sStats;
+static uint64_t g_ui64StallTicks;
+
+//*****************************************************************************/
+// Little-endian header field helpers
+//*****************************************************************************/
+static void
+putU16(uint8_t *pui8Dst, uint16_t ui16Value)
+{
+    pui8Dst[0] = (uint8_t)ui16Value;
+    pui8Dst[1] = (uint8_t)(ui16Value >> 8);
+}
+
+static void
+putU32(uint8_t *pui8Dst, uint32_t ui32Value)
+{
+    putU16(pui8Dst, (uint16_t)ui32Value);
+    putU16(pui8Dst + 2, (uint16_t)(ui32Value >> 16));
+}
+
+static uint16_t
+getU16(const uint8_t *pui8Src)
+{
+    return (uint16_t)(pui8Src[0] | (pui8Src[1] << 8));
+}
+
+static uint32_t
+getU32(const uint8_t *pui8Src)
+{
+    return getU16(pui8Src) | ((uint32_t)getU16(pui8Src + 2) << 16);
+}
+
+//*****************************************************************************/
+// Start erasing the next sector ahead of the writer.  The flash must be
+// idle; returns without waiting.
+//*****************************************************************************/
+static void
+eraseNextSector(void)
+{
+    SPIFlashWriteEnable(FLASH_LOG_SSI_BASE);
+    SPIFlashSectorErase(FLASH_LOG_SSI_BASE, g_ui32EraseSector * FLASH_LOG_SECTOR_SIZE);
+    g_ui32WriterState = WRITER_WAIT;
+
+    g_ui32EraseSector = (g_ui32EraseSector + 1) % FLASH_LOG_SECTORS;
+    g_ui32Headroom++;
+}
+
+//*****************************************************************************/
+// True if the header area of ui32Page has never been programmed
+//*****************************************************************************/
+static bool
+pageErased(uint32_t ui32Page)
+{
+    uint8_t pui8Header[FLASH_LOG_HEADER_SIZE];
+    uint32_t ui32Index;
+
+    SPIFlashRead(FLASH_LOG_SSI_BASE, ui32Page * FLASH_LOG_PAGE_SIZE, pui8Header, sizeof(pui8Header));
+
+    for (ui32Index = 0; ui32Index < sizeof(pui8Header); ui32Index++)
+    {
+        if (pui8Header[ui32Index] != 0xFF) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//*****************************************************************************/
+// Decode a segment header.  Returns false unless it looks like one of ours.
+//*****************************************************************************/
+static bool
+parseHeader(const uint8_t *pui8Header, tFlashLogSegment *psSegment)
+{
+    if (getU16(&pui8Header[0]) != FLASH_LOG_MAGIC) {
+        return false;
+    }
+
+    psSegment->ui16Flags = getU16(&pui8Header[2]);
+    psSegment->ui32Seq = getU32(&pui8Header[4]);
+    psSegment->ui32RunID = getU32(&pui8Header[8]);
+    psSegment->ui64Timestamp = getU32(&pui8Header[12]) | ((uint64_t)getU32(&pui8Header[16]) << 32);
+    psSegment->ui16Length = getU16(&pui8Header[20]);
+
+    return psSegment->ui16Length <= FLASH_LOG_PAYLOAD_SIZE;
+}
+
+//*****************************************************************************/
+// Check the CRC of a parsed segment against its payload
+//*****************************************************************************/
+static bool
+checkSegment(const uint8_t *pui8Header, const uint8_t *pui8Payload, const tFlashLogSegment *psSegment)
+{
+    uint16_t ui16CRC;
+
+    ui16CRC = crc16Update(CRC16_INIT, pui8Header, FLASH_LOG_HEADER_SIZE - 2);
+    ui16CRC = crc16Update(ui16CRC, pui8Payload, psSegment->ui16Length);
+
+    return ui16CRC == getU16(&pui8Header[22]);
+}
+
+//*****************************************************************************/
+// Read and check the segment in ui32Page.  The background writer must be
+// idle (see flashLogFlush()).  With pui8Payload NULL the payload is read into
+// a queue slot, which is only allowed while the queue is empty.  Returns
+// false for an erased or corrupt page.
+//*****************************************************************************/
+bool
+flashLogReadSegment(uint32_t ui32Page, tFlashLogSegment *psSegment, uint8_t *pui8Payload)
+{
+    uint8_t *pui8Buffer = pui8Payload ? pui8Payload : g_ppui8Queue[g_ui32QueueHead & (FLASH_LOG_QUEUE_PAGES - 1)];
+    uint8_t pui8Header[FLASH_LOG_HEADER_SIZE];
+    uint32_t ui32Addr = (ui32Page % FLASH_LOG_PAGES) * FLASH_LOG_PAGE_SIZE;
+
+    if (!g_bPresent) {
+        return false;
+    }
+
+    SPIFlashRead(FLASH_LOG_SSI_BASE, ui32Addr, pui8Header, FLASH_LOG_HEADER_SIZE);
+    if (!parseHeader(pui8Header, psSegment)) {
+        return false;
+    }
+
+    SPIFlashRead(FLASH_LOG_SSI_BASE, ui32Addr + FLASH_LOG_HEADER_SIZE, pui8Buffer, psSegment->ui16Length);
+
+    return checkSegment(pui8Header, pui8Buffer, psSegment);
+}
+
+//*****************************************************************************/
+// Locate the end of the log left by the previous boot
+//*****************************************************************************/
+static void
+findTail(void)
+{
+    tFlashLogSegment sSegment;
+    uint32_t ui32Sector;
+    uint32_t ui32TailSector = 0;
+    uint32_t ui32TailSeq = 0;
+    uint32_t ui32Low;
+    uint32_t ui32High;
+    uint32_t ui32Mid;
+    bool bFound = false;
+
+    // The newest sector is the one whose first segment has the highest
+    // sequence number.  Serial arithmetic keeps this right across a wrap of
+    // the 32-bit counter.
+    for (ui32Sector = 0; ui32Sector < FLASH_LOG_SECTORS; ui32Sector++)
+    {
+        if (flashLogReadSegment(ui32Sector * FLASH_LOG_PAGES_PER_SECTOR, &sSegment, NULL) &&
+            (!bFound || (int32_t)(sSegment.ui32Seq - ui32TailSeq) > 0)) {
+            ui32TailSector = ui32Sector;
+            ui32TailSeq = sSegment.ui32Seq;
+            g_ui32RunID = sSegment.ui32RunID;
+            bFound = true;
+        }
+    }
+
+    if (!bFound) {
+        // Blank (or foreign) device: start at the beginning
+        g_ui32WritePage = 0;
+        g_ui32WriteSeq = 0;
+        g_ui32RunID = 0;
+        g_ui32EraseSector = 0;
+        g_ui32Headroom = 0;
+        return;
+    }
+
+    // Pages within a sector are programmed in order, so the written ones form
+    // a prefix.  Page 0 is known to be written.
+    ui32Low = 1;
+    ui32High = FLASH_LOG_PAGES_PER_SECTOR;
+    while (ui32Low < ui32High)
+    {
+        ui32Mid = (ui32Low + ui32High) / 2;
+        if (pageErased(ui32TailSector * FLASH_LOG_PAGES_PER_SECTOR + ui32Mid)) {
+            ui32High = ui32Mid;
+        }
+        else {
+            ui32Low = ui32Mid + 1;
+        }
+    }
+
+    // The last intact segment carries the newest run ID
+    for (ui32Mid = ui32Low; ui32Mid > 1; ui32Mid--)
+    {
+        if (flashLogReadSegment(ui32TailSector * FLASH_LOG_PAGES_PER_SECTOR + ui32Mid - 1, &sSegment, NULL)) {
+            g_ui32RunID = sSegment.ui32RunID;
+            break;
+        }
+    }
+
+    g_ui32WritePage = (ui32TailSector * FLASH_LOG_PAGES_PER_SECTOR + ui32Low) % FLASH_LOG_PAGES;
+    g_ui32WriteSeq = ui32TailSeq + ui32Low;
+
+    // Nothing ahead of the tail is trusted to be erased: the next sector may
+    // hold old data or a half-finished erase.  The scheduler rebuilds the
+    // headroom from the first sector the writer will enter.
+    g_ui32EraseSector = ((g_ui32WritePage + FLASH_LOG_PAGES_PER_SECTOR - 1) / FLASH_LOG_PAGES_PER_SECTOR) % FLASH_LOG_SECTORS;
+    g_ui32Headroom = 0;
+}
+
+//*****************************************************************************/
+// Seal the slot being filled and hand it to the background writer
+//*****************************************************************************/
+static void
+sealPage(void)
+{
+    uint8_t *pui8Page = g_ppui8Queue[g_ui32QueueHead & (FLASH_LOG_QUEUE_PAGES - 1)];
+    uint32_t ui32Depth;
+    uint16_t ui16CRC;
+
+    putU16(&pui8Page[0], FLASH_LOG_MAGIC);
+    putU16(&pui8Page[2], g_bRunStart ? FLASH_LOG_FLAG_RUN_START : 0);
+    putU32(&pui8Page[4], g_ui32WriteSeq);
+    putU32(&pui8Page[8], g_ui32RunID);
+    putU32(&pui8Page[12], (uint32_t)g_ui64PageTimestamp);
+    putU32(&pui8Page[16], (uint32_t)(g_ui64PageTimestamp >> 32));
+    putU16(&pui8Page[20], (uint16_t)g_ui32PageFill);
+
+    ui16CRC = crc16Update(CRC16_INIT, pui8Page, FLASH_LOG_HEADER_SIZE - 2);
+    ui16CRC = crc16Update(ui16CRC, &pui8Page[FLASH_LOG_HEADER_SIZE], g_ui32PageFill);
+    putU16(&pui8Page[22], ui16CRC);
+
+    g_ui32QueueHead++;
+
+    ui32Depth = g_ui32QueueHead - g_ui32QueueTail;
+    if (ui32Depth > g_sStats.ui32QueueHighWater) {
+        g_sStats.ui32QueueHighWater = ui32Depth;
+    }
+
+    g_ui32WritePage = (g_ui32WritePage + 1) % FLASH_LOG_PAGES;
+    g_ui32WriteSeq++;
+    g_ui32PageFill = 0;
+    g_bRunStart = false;
+
+    // Start on it straight away if the flash is free
+    flashLogService();
+}
+
+//*****************************************************************************/
+// Make sure the slot at the queue head is free before filling it, running
+// the writer until one is.  Time spent here is a stall.
+//*****************************************************************************/
+static void
+waitForSlot(void)
+{
+    uint64_t ui64Start;
+
+    if ((g_ui32QueueHead - g_ui32QueueTail) < FLASH_LOG_QUEUE_PAGES) {
+        return;
+    }
+
+    g_sStats.ui32Stalls++;
+    ui64Start = timebaseNow();
+
+    while ((g_ui32QueueHead - g_ui32QueueTail) >= FLASH_LOG_QUEUE_PAGES)
+    {
+        flashLogService();
+    }
+
+    g_ui64StallTicks += timebaseNow() - ui64Start;
+}
+
+//*****************************************************************************/
+// Bring up SSI0 and the flash, then recover the log tail.  Must run after the
+// system clock is set.  Returns false if no flash answers.
+//
+// Uses the following I/O signals:
+//     SSI0CLK - PA2
+//     SSI0FSS - PA3
+//     SSI0RX  - PA4 (flash DO)
+//     SSI0TX  - PA5 (flash DI)
+//*****************************************************************************/
+bool
+configureFlashLog(void)
+{
+    uint8_t ui8Manufacturer;
+    uint16_t ui16Device;
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_SSI0);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
+
+    GPIOPinConfigure(GPIO_PA2_SSI0CLK);
+    GPIOPinConfigure(GPIO_PA3_SSI0FSS);
+    GPIOPinConfigure(GPIO_PA4_SSI0RX);
+    GPIOPinConfigure(GPIO_PA5_SSI0TX);
+    GPIOPinTypeSSI(GPIO_PORTA_BASE, GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4 | GPIO_PIN_5);
+
+    SPIFlashInit(FLASH_LOG_SSI_BASE, SysCtlClockGet(), FLASH_LOG_BIT_RATE);
+
+    // Page data is fed to SSI0 by uDMA; SPIFlashIntHandler() programs the
+    // channel itself once it is assigned.
+    configureDMA();
+    uDMAChannelAssign(UDMA_CH10_SSI0RX);
+    uDMAChannelAssign(UDMA_CH11_SSI0TX);
+    IntEnable(INT_SSI0);
+
+    // A missing chip reads back as all ones (or all zeros with a pull-down)
+    SPIFlashReadID(FLASH_LOG_SSI_BASE, &ui8Manufacturer, &ui16Device);
+    g_bPresent = (ui8Manufacturer != 0xFF) && (ui8Manufacturer != 0x00);
+
+    UARTprintf("Flash Log ->\n");
+    if (!g_bPresent) {
+        UARTprintf("    Device:         Not found\n");
+        return false;
+    }
+
+    g_ui32QueueHead = 0;
+    g_ui32QueueTail = 0;
+    g_ui32WriterState = WRITER_IDLE;
+
+    findTail();
+
+    g_ui32ProgramPage = g_ui32WritePage;
+    g_ui32PageFill = 0;
+    g_bRunStart = false;
+
+    UARTprintf("    Device:         %02x %04x, %d KB\n", ui8Manufacturer, ui16Device, FLASH_LOG_SIZE / 1024);
+    UARTprintf("    Next Page:      %d (segment %u)\n", g_ui32WritePage, g_ui32WriteSeq);
+    UARTprintf("    Last Run:       %u\n", g_ui32RunID);
+    UARTprintf("    Queue:          %d pages\n", FLASH_LOG_QUEUE_PAGES);
+    UARTprintf("    Erase Ahead:    %d sectors\n", FLASH_LOG_ERASE_AHEAD);
+
+    return true;
+}
+
+//*****************************************************************************/
+// True if configureFlashLog() found a flash device
+//*****************************************************************************/
+bool
+flashLogPresent(void)
+{
+    return g_bPresent;
+}
+
+//*****************************************************************************/
+// Begin a new run.  Its first segment starts on a fresh page and carries
+// FLASH_LOG_FLAG_RUN_START.  Returns the new run ID.
+//*****************************************************************************/
+uint32_t
+flashLogStartRun(void)
+{
+    flashLogFlush();
+
+    memset(&g_sStats, 0, sizeof(g_sStats));
+    g_sStats.ui32MinHeadroom = g_ui32Headroom;
+    g_ui64StallTicks = 0;
+
+    g_ui32RunID++;
+    g_bRunStart = true;
+
+    return g_ui32RunID;
+}
+
+//*****************************************************************************/
+// Append ui32Len bytes to the current run.  ui64Timestamp is the time of the
+// record and becomes the header timestamp of any segment the record opens.
+// Records may span segments.  Only waits if every page buffer is in use.
+//*****************************************************************************/
+void
+flashLogAppend(const uint8_t *pui8Data, uint32_t ui32Len, uint64_t ui64Timestamp)
+{
+    uint8_t *pui8Page;
+    uint32_t ui32Chunk;
+
+    if (!g_bPresent) {
+        return;
+    }
+
+    while (ui32Len)
+    {
+        if (g_ui32PageFill == 0) {
+            waitForSlot();
+            g_ui64PageTimestamp = ui64Timestamp;
+        }
+
+        pui8Page = g_ppui8Queue[g_ui32QueueHead & (FLASH_LOG_QUEUE_PAGES - 1)];
+
+        ui32Chunk = FLASH_LOG_PAYLOAD_SIZE - g_ui32PageFill;
+        if (ui32Chunk > ui32Len) {
+            ui32Chunk = ui32Len;
+        }
+
+        memcpy(&pui8Page[FLASH_LOG_HEADER_SIZE + g_ui32PageFill], pui8Data, ui32Chunk);
+        g_ui32PageFill += ui32Chunk;
+        pui8Data += ui32Chunk;
+        ui32Len -= ui32Chunk;
+
+        if (g_ui32PageFill == FLASH_LOG_PAYLOAD_SIZE) {
+            sealPage();
+        }
+    }
+
+    flashLogService();
+}
+
+//*****************************************************************************/
+// Advance the background writer by at most one step: notice that the flash
+// has finished, start programming the oldest queued page, or erase another
+// sector ahead.  Never waits for the flash; call it whenever the main loop
+// has nothing else to do.
+//
+// Erases are scheduled into idle windows (nothing queued) until
+// FLASH_LOG_ERASE_AHEAD sectors are ready, so page programs never queue
+// behind an erase while there is headroom.  Only when the headroom is gone
+// does an erase take priority over queued pages.
+//*****************************************************************************/
+void
+flashLogService(void)
+{
+    uint8_t *pui8Page;
+
+    // A transfer is still being shifted by SSI0IntHandler()
+    if (!g_bPresent || g_ui32WriterState >= WRITER_PROGRAM) {
+        return;
+    }
+
+    // One status read per call instead of spinning on the busy bit
+    if (g_ui32WriterState == WRITER_WAIT) {
+        if (SPIFlashReadStatus(FLASH_LOG_SSI_BASE) & FLASH_STATUS_WIP) {
+            return;
+        }
+        g_ui32WriterState = WRITER_IDLE;
+    }
+
+    // Erase in idle windows, or when the next page needs a sector and none
+    // is ready (first sector after boot, or the writer outran the scheduler)
+    if (g_ui32Headroom < FLASH_LOG_ERASE_AHEAD &&
+        (g_ui32QueueTail == g_ui32QueueHead ||
+         (g_ui32Headroom == 0 && (g_ui32ProgramPage % FLASH_LOG_PAGES_PER_SECTOR) == 0))) {
+        // Queued pages wait behind this erase
+        if (g_ui32QueueTail != g_ui32QueueHead) {
+            g_sStats.ui32EraseWaits++;
+        }
+
+        eraseNextSector();
+        return;
+    }
+
+    if (g_ui32QueueTail == g_ui32QueueHead) {
+        return;
+    }
+
+    // Entering a sector uses up one sector of headroom
+    if ((g_ui32ProgramPage % FLASH_LOG_PAGES_PER_SECTOR) == 0) {
+        g_ui32Headroom--;
+        if (g_ui32Headroom < g_sStats.ui32MinHeadroom) {
+            g_sStats.ui32MinHeadroom = g_ui32Headroom;
+        }
+    }
+
+    // Program only the used part of the page; the unused tail stays erased
+    pui8Page = g_ppui8Queue[g_ui32QueueTail & (FLASH_LOG_QUEUE_PAGES - 1)];
+
+    g_ui32WriterState = WRITER_PROGRAM;
+    SPIFlashWriteEnable(FLASH_LOG_SSI_BASE);
+    SPIFlashPageProgramNonBlocking(&g_sFlashState, FLASH_LOG_SSI_BASE,
+                                   g_ui32ProgramPage * FLASH_LOG_PAGE_SIZE, pui8Page,
+                                   FLASH_LOG_HEADER_SIZE + getU16(&pui8Page[20]),
+                                   true, UDMA_CH11_SSI0TX);
+
+    g_ui32ProgramPage = (g_ui32ProgramPage + 1) % FLASH_LOG_PAGES;
+    g_sStats.ui32Pages++;
+}
+
+//*****************************************************************************/
+// SSI0 interrupt: feed the transfer in flight.  Once the last byte of a page
+// program is out the flash has latched the page, so its buffer is released
+// and the writer moves on to polling the busy bit.  A finished read leaves
+// the flash idle.
+//*****************************************************************************/
+void
+SSI0IntHandler(void)
+{
+    if (SPIFlashIntHandler(&g_sFlashState) == SPI_FLASH_DONE) {
+        if (g_ui32WriterState == WRITER_PROGRAM) {
+            g_ui32QueueTail++;
+            g_ui32WriterState = WRITER_WAIT;
+        }
+        else {
+            g_ui32WriterState = WRITER_IDLE;
+        }
+    }
+}
+
+//*****************************************************************************/
+// Write out a partly filled segment and wait until every queued page is
+// programmed and the flash is idle, so the run survives a power loss from
+// here on.
+//*****************************************************************************/
+void
+flashLogFlush(void)
+{
+    if (!g_bPresent) {
+        return;
+    }
+
+    if (g_ui32PageFill) {
+        sealPage();
+    }
+
+    while (g_ui32QueueTail != g_ui32QueueHead || g_ui32WriterState != WRITER_IDLE)
+    {
+        flashLogService();
+    }
+}
+
+//*****************************************************************************/
+// Number of sealed pages not yet handed to the flash
+//*****************************************************************************/
+uint32_t
+flashLogQueueDepth(void)
+{
+    return g_ui32QueueHead - g_ui32QueueTail;
+}
+
+//*****************************************************************************/
+// Erased space ahead of the writer in bytes: the rest of the sector being
+// written plus the sectors erased ahead of it
+//*****************************************************************************/
+uint32_t
+flashLogHeadroom(void)
+{
+    uint32_t ui32Pages = (FLASH_LOG_PAGES_PER_SECTOR - g_ui32ProgramPage % FLASH_LOG_PAGES_PER_SECTOR) % FLASH_LOG_PAGES_PER_SECTOR;
+
+    return (ui32Pages + g_ui32Headroom * FLASH_LOG_PAGES_PER_SECTOR) * FLASH_LOG_PAGE_SIZE;
+}
+
+//*****************************************************************************/
+// Writer statistics since the last flashLogStartRun()
+//*****************************************************************************/
+void
+flashLogGetStats(tFlashLogStats *psStats)
+{
+    *psStats = g_sStats;
+    psStats->ui32StallUs = (uint32_t)timebaseTicksToUs(g_ui64StallTicks);
+}
+
+//*****************************************************************************/
+// Last run ID recorded in the log (0 if none)
+//*****************************************************************************/
+uint32_t
+flashLogLastRun(void)
+{
+    return g_ui32RunID;
+}
+
+//*****************************************************************************/
+// Readback.  The page queue is idle whenever no run is being recorded, so it
+// doubles as the dump buffer: one half is filled by a uDMA fast read while
+// the pages in the other half are copied to the console.
+//*****************************************************************************/
+#define DUMP_PAGES          (FLASH_LOG_QUEUE_PAGES / 2)
+
+//*****************************************************************************/
+// Start a background read of ui32Pages pages into pui8Buffer
+//*****************************************************************************/
+static void
+startRead(uint32_t ui32Page, uint8_t *pui8Buffer, uint32_t ui32Pages)
+{
+    g_ui32WriterState = WRITER_READ;
+    SPIFlashFastReadNonBlocking(&g_sFlashState, FLASH_LOG_SSI_BASE, ui32Page * FLASH_LOG_PAGE_SIZE,
+                                pui8Buffer, ui32Pages * FLASH_LOG_PAGE_SIZE, true,
+                                UDMA_CH11_SSI0TX, UDMA_CH10_SSI0RX);
+}
+
+//*****************************************************************************/
+// Pages in the next read chunk: bounded by the buffer half, the pages left
+// and the end of the device
+//*****************************************************************************/
+static uint32_t
+readChunk(uint32_t ui32Page, uint32_t ui32Remaining)
+{
+    uint32_t ui32Pages = DUMP_PAGES;
+
+    if (ui32Pages > ui32Remaining) {
+        ui32Pages = ui32Remaining;
+    }
+    if (ui32Pages > FLASH_LOG_PAGES - ui32Page) {
+        ui32Pages = FLASH_LOG_PAGES - ui32Page;
+    }
+
+    return ui32Pages;
+}
+
+//*****************************************************************************/
+// Stream run ui32RunID to the console as raw binary: the payload of its
+// segments in order, which is the SINK_UART_BINARY frame stream and decodes
+// with host/frame_decode.  The first ui32Offset payload bytes are skipped so
+// an interrupted transfer can be resumed.  Stops early on a console stop
+// request.  Returns the offset to resume from.
+//*****************************************************************************/
+uint32_t
+flashLogDump(uint32_t ui32RunID, uint32_t ui32Offset)
+{
+    tFlashLogSegment sSegment;
+    uint8_t *pui8Buffer;
+    uint8_t *pui8Page;
+    uint32_t ui32Page;
+    uint32_t ui32Remaining;
+    uint32_t ui32Pages;
+    uint32_t ui32Ready;
+    uint32_t ui32Half = 0;
+    uint32_t ui32Index;
+    uint32_t ui32Skip;
+    uint32_t ui32Position = 0;
+    uint32_t ui32Sent = 0;
+    uint32_t ui32Us;
+    uint64_t ui64Start;
+    bool bInRun = false;
+    bool bDone = false;
+
+    if (!g_bPresent) {
+        UARTprintf("No flash log.\n");
+        return ui32Offset;
+    }
+
+    flashLogFlush();
+
+    // The oldest data starts at the sector after the one being written.
+    ui32Page = ((g_ui32WritePage / FLASH_LOG_PAGES_PER_SECTOR + 1) % FLASH_LOG_SECTORS) * FLASH_LOG_PAGES_PER_SECTOR;
+    ui32Remaining = (g_ui32WritePage + FLASH_LOG_PAGES - ui32Page) % FLASH_LOG_PAGES;
+
+    // Skip whole sectors that are blank, or that are followed by a sector
+    // already on an earlier run than the one wanted.
+    while (ui32Remaining > FLASH_LOG_PAGES_PER_SECTOR &&
+           (!flashLogReadSegment(ui32Page, &sSegment, NULL) ||
+            (flashLogReadSegment(ui32Page + FLASH_LOG_PAGES_PER_SECTOR, &sSegment, NULL) &&
+             (int32_t)(sSegment.ui32RunID - ui32RunID) < 0)))
+    {
+        ui32Page = (ui32Page + FLASH_LOG_PAGES_PER_SECTOR) % FLASH_LOG_PAGES;
+        ui32Remaining -= FLASH_LOG_PAGES_PER_SECTOR;
+    }
+
+    UARTprintf("Dumping run %u from offset %u\n", ui32RunID, ui32Offset);
+
+#ifdef UART_BUFFERED
+    // Typed characters would be echoed into the middle of the binary data
+    UARTEchoSet(false);
+#endif
+
+    ui64Start = timebaseNow();
+
+    ui32Pages = readChunk(ui32Page, ui32Remaining);
+    if (ui32Pages) {
+        startRead(ui32Page, g_ppui8Queue[0], ui32Pages);
+    }
+
+    while (ui32Pages && !bDone)
+    {
+        while (g_ui32WriterState == WRITER_READ) {
+        }
+
+        // Start reading the next chunk into the other half before sending
+        // this one
+        pui8Buffer = g_ppui8Queue[ui32Half * DUMP_PAGES];
+        ui32Ready = ui32Pages;
+        ui32Page = (ui32Page + ui32Ready) % FLASH_LOG_PAGES;
+        ui32Remaining -= ui32Ready;
+        ui32Half ^= 1;
+
+        ui32Pages = readChunk(ui32Page, ui32Remaining);
+        if (ui32Pages) {
+            startRead(ui32Page, g_ppui8Queue[ui32Half * DUMP_PAGES], ui32Pages);
+        }
+
+        for (ui32Index = 0; ui32Index < ui32Ready && !bDone; ui32Index++)
+        {
+            pui8Page = pui8Buffer + ui32Index * FLASH_LOG_PAGE_SIZE;
+            if (!parseHeader(pui8Page, &sSegment) ||
+                !checkSegment(pui8Page, pui8Page + FLASH_LOG_HEADER_SIZE, &sSegment)) {
+                continue;
+            }
+
+            // Runs are contiguous, so the first segment of another run
+            // after this one ends the dump
+            if (sSegment.ui32RunID != ui32RunID) {
+                bDone = bInRun;
+                continue;
+            }
+            bInRun = true;
+
+            // Skip what the host already has
+            ui32Skip = 0;
+            if (ui32Position < ui32Offset) {
+                ui32Skip = ui32Offset - ui32Position;
+                if (ui32Skip > sSegment.ui16Length) {
+                    ui32Skip = sSegment.ui16Length;
+                }
+            }
+            ui32Position += sSegment.ui16Length;
+
+            if (sSegment.ui16Length > ui32Skip) {
+                UARTwriteBinary(pui8Page + FLASH_LOG_HEADER_SIZE + ui32Skip, sSegment.ui16Length - ui32Skip);
+                ui32Sent += sSegment.ui16Length - ui32Skip;
+            }
+        }
+
+        if (userStopRequested()) {
+            bDone = true;
+        }
+    }
+
+    // An early stop can leave the read ahead in flight
+    while (g_ui32WriterState == WRITER_READ) {
+    }
+
+#ifdef UART_BUFFERED
+    // Include the time to get the last bytes onto the wire
+    UARTFlushTx(false);
+    UARTEchoSet(true);
+#endif
+
+    ui32Us = (uint32_t)timebaseTicksToUs(timebaseNow() - ui64Start);
+    if (ui32Us == 0) {
+        ui32Us = 1;
+    }
+
+    UARTprintf("\nDump:           %u bytes in %u ms", ui32Sent, ui32Us / 1000);
+    UARTprintf("\nRate:           %u.%03u MB/s", ui32Sent / ui32Us,
+               (uint32_t)(((uint64_t)ui32Sent * 1000 / ui32Us) % 1000));
+    UARTprintf("\nNext Offset:    %u\n", ui32Offset + ui32Sent);
+
+    return ui32Offset + ui32Sent;
+}
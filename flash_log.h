@@ -0,0 +1,107 @@
+/*
+ * flash_log.h
+ *
+ *  Created on: Mar 11, 2024
+ *      Author: Tyler
+ */
+
+#ifndef FLASH_LOG_H_
+#define FLASH_LOG_H_
+
+// SSI module and clock rate used to reach the external SPI flash
+#define FLASH_LOG_SSI_BASE          SSI0_BASE
+#define FLASH_LOG_BIT_RATE          10000000
+
+// Number of page buffers between flashLogAppend() and the background
+// writer: one is filled while the others wait for or are being programmed.
+// Must be a power of two, at least 2.
+#ifndef FLASH_LOG_QUEUE_PAGES
+#define FLASH_LOG_QUEUE_PAGES       4
+#endif
+
+// Number of sectors the background writer keeps erased ahead of the sector
+// being written.  Each one absorbs a sector's worth of writes without an
+// erase in line, at the cost of discarding the oldest data that much sooner.
+#ifndef FLASH_LOG_ERASE_AHEAD
+#define FLASH_LOG_ERASE_AHEAD       2
+#endif
+
+// Flash geometry.  The log occupies the whole device and is written as a
+// circular sequence of 4 KB sectors; once full, the oldest sector is erased
+// to make room.
+#ifndef FLASH_LOG_SIZE
+#define FLASH_LOG_SIZE              0x200000    // 16 Mbit (W25Q16 class)
+#endif
+#define FLASH_LOG_PAGE_SIZE         256
+#define FLASH_LOG_SECTOR_SIZE       4096
+#define FLASH_LOG_PAGES             (FLASH_LOG_SIZE / FLASH_LOG_PAGE_SIZE)
+#define FLASH_LOG_SECTORS           (FLASH_LOG_SIZE / FLASH_LOG_SECTOR_SIZE)
+#define FLASH_LOG_PAGES_PER_SECTOR  (FLASH_LOG_SECTOR_SIZE / FLASH_LOG_PAGE_SIZE)
+
+// Every page is one self-describing segment: a header followed by payload.
+//
+//   offset  size  field
+//        0     2  magic, FLASH_LOG_MAGIC
+//        2     2  flags, FLASH_LOG_FLAG_*
+//        4     4  segment sequence number, +1 per page ever written
+//        8     4  run ID
+//       12     8  timestamp of the first record in the segment, us
+//       20     2  payload length
+//       22     2  CRC-16/CCITT-FALSE of bytes 0..21 and the payload
+//       24   232  payload: sample_frame.h frames as one byte stream
+//
+// All fields are little-endian.  Unused payload bytes stay erased (0xFF).
+#define FLASH_LOG_MAGIC             0x474C      // "LG"
+#define FLASH_LOG_HEADER_SIZE       24
+#define FLASH_LOG_PAYLOAD_SIZE      (FLASH_LOG_PAGE_SIZE - FLASH_LOG_HEADER_SIZE)
+
+// Segment flags
+#define FLASH_LOG_FLAG_RUN_START    0x0001      // First segment of a run
+
+// Decoded segment header
+typedef struct
+{
+    uint32_t ui32Seq;
+    uint32_t ui32RunID;
+    uint64_t ui64Timestamp;
+    uint16_t ui16Length;
+    uint16_t ui16Flags;
+}
+tFlashLogSegment;
+
+// Background writer statistics since the last flashLogStartRun()
+typedef struct
+{
+    // Pages handed to the flash
+    uint32_t ui32Pages;
+
+    // Deepest backlog of sealed pages waiting to be programmed
+    uint32_t ui32QueueHighWater;
+
+    // Number of times flashLogAppend() found no free page buffer, and the
+    // total time it spent waiting for one
+    uint32_t ui32Stalls;
+    uint32_t ui32StallUs;
+
+    // Number of erases that queued pages had to wait behind because no erased
+    // headroom was left, and the least headroom (in sectors) seen
+    uint32_t ui32EraseWaits;
+    uint32_t ui32MinHeadroom;
+}
+tFlashLogStats;
+
+bool configureFlashLog(void);
+bool flashLogPresent(void);
+uint32_t flashLogStartRun(void);
+void flashLogAppend(const uint8_t *pui8Data, uint32_t ui32Len, uint64_t ui64Timestamp);
+void flashLogService(void);
+void flashLogFlush(void);
+uint32_t flashLogQueueDepth(void);
+uint32_t flashLogHeadroom(void);
+void flashLogGetStats(tFlashLogStats *psStats);
+bool flashLogReadSegment(uint32_t ui32Page, tFlashLogSegment *psSegment, uint8_t *pui8Payload);
+uint32_t flashLogLastRun(void);
+uint32_t flashLogDump(uint32_t ui32RunID, uint32_t ui32Offset);
+void SSI0IntHandler(void);
+
+#endif /* FLASH_LOG_H_ */
@@ -23,6 +23,7 @@
 //*****************************************************************************
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "inc/hw_flash.h"
 #include "inc/hw_types.h"
@@ -32,7 +33,8 @@
 #include "driverlib/rom.h"
 #include "driverlib/rom_map.h"
 #include "driverlib/sysctl.h"
-#include "utils/flash_pb.h"
+#include "crc.h"
+#include "flash_pb.h"
 
 //*****************************************************************************
 //
@@ -75,6 +77,15 @@ static uint32_t g_ui32FlashPBSize;
 //*****************************************************************************
 static uint8_t *g_pui8FlashPBCurrent;
 
+//*****************************************************************************
+//
+// The address of the most recent parameter block in the old format (8-bit
+// sequence number and additive checksum), when there are no parameter blocks
+// in the current format.
+//
+//*****************************************************************************
+static uint8_t *g_pui8FlashPBLegacy;
+
 //*****************************************************************************
 //
 // The erase sector size of the current flash.
@@ -82,14 +93,54 @@ static uint8_t *g_pui8FlashPBCurrent;
 //*****************************************************************************
 #define FLASH_SECTOR_SIZE       MAP_SysCtlFlashSectorSizeGet()
 
+//*****************************************************************************
+//
+// Returns a pointer to the header of the parameter block at the given address.
+//
+//*****************************************************************************
+#define FlashPBHeader(pui8Offset)   ((tFlashPBHeader *)(pui8Offset))
+
+//*****************************************************************************
+//
+// Determines if the parameter block slot at the given address starts with a
+// block header for the configured block size.  This rejects erased and
+// foreign slots from the first few bytes, without reading the block data.
+//
+//*****************************************************************************
+static bool
+FlashPBHeaderIsValid(uint8_t *pui8Offset)
+{
+    return((FlashPBHeader(pui8Offset)->ui16Magic == FLASH_PB_MAGIC) &&
+           (FlashPBHeader(pui8Offset)->ui16Length == g_ui32FlashPBSize));
+}
+
+//*****************************************************************************
+//
+// Computes the CRC-32 of a parameter block: the header fields that precede the
+// CRC, followed by the application data.
+//
+//*****************************************************************************
+static uint32_t
+FlashPBCRC(uint8_t *pui8Offset)
+{
+    uint32_t ui32CRC;
+
+    ui32CRC = crc32Update(CRC32_INIT, pui8Offset,
+                          offsetof(tFlashPBHeader, ui32CRC));
+    ui32CRC = crc32Update(ui32CRC, pui8Offset + FLASH_PB_HEADER_SIZE,
+                          g_ui32FlashPBSize - FLASH_PB_HEADER_SIZE);
+
+    return(CRC32_FINAL(ui32CRC));
+}
+
 //*****************************************************************************
 //
 //! Determines if the parameter block at the given address is valid.
 //!
 //! \param pui8Offset is the address of the parameter block to check.
 //!
-//! This function will compute the checksum of a parameter block in flash to
-//! determine if it is valid.
+//! This function will check the header of a parameter block in flash and, if
+//! it is plausible, compute the CRC of the block to determine if it is valid.
 //!
 //! \return Returns one if the parameter block is valid and zero if it is not.
 //
@@ -97,42 +148,88 @@ static uint8_t *g_pui8FlashPBCurrent;
 static uint32_t
 FlashPBIsValid(uint8_t *pui8Offset)
 {
-    uint32_t ui32Idx, ui32Sum;
-
     //
     // Check the arguments.
     //
     ASSERT(pui8Offset != (void *)0);
 
     //
-    // Loop through the bytes in the block, computing the checksum.
+    // Erased and foreign slots are rejected from the header alone.
     //
-    for(ui32Idx = 0, ui32Sum = 0; ui32Idx < g_ui32FlashPBSize; ui32Idx++)
+    if(!FlashPBHeaderIsValid(pui8Offset))
     {
-        ui32Sum += pui8Offset[ui32Idx];
+        return(0);
     }
 
     //
-    // The checksum should be zero, so return a failure if it is not.
+    // This is a valid parameter block if the CRC matches.
     //
-    if((ui32Sum & 255) != 0)
-    {
-        return(0);
-    }
+    return(FlashPBHeader(pui8Offset)->ui32CRC == FlashPBCRC(pui8Offset));
+}
+
+//*****************************************************************************
+//
+// Determines if the parameter block at the given address is a valid block in
+// the old format: byte 0 is an 8-bit sequence number, byte 1 is chosen so
+// that all the bytes of the block sum to zero modulo 256, and the application
+// data follows.
+//
+//*****************************************************************************
+static bool
+FlashPBLegacyIsValid(uint8_t *pui8Offset)
+{
+    uint32_t ui32Idx, ui32Sum;
 
     //
-    // If the sum is equal to the size * 255, then the block is all ones and
-    // should not be considered valid.
+    // Loop through the bytes in the block, computing the checksum.
     //
-    if((g_ui32FlashPBSize * 255) == ui32Sum)
+    for(ui32Idx = 0, ui32Sum = 0; ui32Idx < g_ui32FlashPBSize; ui32Idx++)
     {
-        return(0);
+        ui32Sum += pui8Offset[ui32Idx];
     }
 
     //
-    // This is a valid parameter block.
+    // The checksum should be zero, and a block of all ones (which also sums to
+    // zero) is erased flash rather than a parameter block.
     //
-    return(1);
+    return(((ui32Sum & 255) == 0) && ((g_ui32FlashPBSize * 255) != ui32Sum));
+}
+
+//*****************************************************************************
+//
+// Determines if the parameter block slot at the given address is erased.  The
+// slot is word aligned, so it is checked a word at a time.
+//
+//*****************************************************************************
+static bool
+FlashPBIsErased(uint8_t *pui8Offset)
+{
+    uint32_t *pui32Word, ui32Idx;
+
+    pui32Word = (uint32_t *)pui8Offset;
+    for(ui32Idx = 0; ui32Idx < (g_ui32FlashPBSize / 4); ui32Idx++)
+    {
+        if(pui32Word[ui32Idx] != 0xffffffff)
+        {
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Determines if the parameter block at pui8Two is more recent than the one at
+// pui8One.  The 16-bit sequence numbers wrap, so they are compared by serial
+// number arithmetic.
+//
+//*****************************************************************************
+static bool
+FlashPBIsNewer(uint8_t *pui8One, uint8_t *pui8Two)
+{
+    return((int16_t)(FlashPBHeader(pui8Two)->ui16Sequence -
+                     FlashPBHeader(pui8One)->ui16Sequence) > 0);
 }
 
 //*****************************************************************************
@@ -166,6 +263,27 @@ FlashPBGet(void)
     return(0);
 }
 
+//*****************************************************************************
+//
+//! Gets the address of the most recent parameter block in the old format.
+//!
+//! Parameter blocks used to start with a one byte sequence number and a one
+//! byte checksum, with the application data following at offset 2.  When
+//! there are no parameter blocks in the current format, FlashPBInit() also
+//! looks for the most recent block in the old format so the application can
+//! convert its data and pass it to FlashPBSave().  Once a block has been saved
+//! in the current format, the old blocks are ignored.
+//!
+//! \return Returns the address of the most recent old-format parameter block,
+//! or NULL if there is none or if there is a block in the current format.
+//
+//*****************************************************************************
+uint8_t *
+FlashPBGetLegacy(void)
+{
+    return(g_pui8FlashPBLegacy);
+}
+
 //*****************************************************************************
 //
 //! Writes a new parameter block to flash.
@@ -176,17 +294,17 @@ FlashPBGet(void)
 //! This function will write a parameter block to flash.  Saving the new
 //! parameter blocks involves three steps:
 //!
-//! - Setting the sequence number such that it is one greater than the sequence
-//!   number of the latest parameter block in flash.
-//! - Computing the checksum of the parameter block.
+//! - Filling in the block header, with a sequence number one greater than the
+//!   sequence number of the latest parameter block in flash.
+//! - Computing the CRC of the parameter block.
 //! - Writing the parameter block into the storage immediately following the
 //!   latest parameter block in flash; if that storage is at the start of an
 //!   erase block, that block is erased first.
 //!
 //! By this process, there is always a valid parameter block in flash.  If
-//! power is lost while writing a new parameter block, the checksum will not
-//! match and the partially written parameter block will be ignored.  This is
-//! what makes this fault-tolerant.
+//! power is lost while writing a new parameter block, the CRC will not match
+//! and the partially written parameter block will be ignored.  This is what
+//! makes this fault-tolerant.
 //!
 //! Another benefit of this scheme is that it provides wear leveling on the
 //! flash.  Since multiple parameter blocks fit into each erase block of flash,
@@ -199,14 +317,23 @@ FlashPBGet(void)
 void
 FlashPBSave(uint8_t *pui8Buffer)
 {
+    tFlashPBHeader *psHeader;
     uint8_t *pui8New;
-    uint32_t ui32Idx, ui32Sum;
+    uint32_t ui32Idx;
 
     //
     // Check the arguments.
     //
     ASSERT(pui8Buffer != (void *)0);
 
+    //
+    // Fill in the fixed header fields.
+    //
+    psHeader = FlashPBHeader(pui8Buffer);
+    psHeader->ui16Magic = FLASH_PB_MAGIC;
+    psHeader->ui16Length = (uint16_t)g_ui32FlashPBSize;
+    psHeader->ui16Reserved = 0xffff;
+
     //
     // See if there is a valid parameter block in flash.
     //
@@ -216,7 +343,8 @@ FlashPBSave(uint8_t *pui8Buffer)
         // Set the sequence number to one greater than the most recent
         // parameter block.
         //
-        pui8Buffer[0] = g_pui8FlashPBCurrent[0] + 1;
+        psHeader->ui16Sequence =
+            FlashPBHeader(g_pui8FlashPBCurrent)->ui16Sequence + 1;
 
         //
         // Try to write the new parameter block immediately after the most
@@ -234,7 +362,7 @@ FlashPBSave(uint8_t *pui8Buffer)
         // There is not a valid parameter block in flash, so set the sequence
         // number of this parameter block to zero.
         //
-        pui8Buffer[0] = 0;
+        psHeader->ui16Sequence = 0;
 
         //
         // Try to write the new parameter block at the beginning of the flash
@@ -244,17 +372,9 @@ FlashPBSave(uint8_t *pui8Buffer)
     }
 
     //
-    // Compute the checksum of the parameter block to be written.
+    // Compute the CRC of the parameter block to be written.
     //
-    for(ui32Idx = 0, ui32Sum = 0; ui32Idx < g_ui32FlashPBSize; ui32Idx++)
-    {
-        ui32Sum -= pui8Buffer[ui32Idx];
-    }
-
-    //
-    // Store the checksum into the parameter block.
-    //
-    pui8Buffer[1] += ui32Sum;
+    psHeader->ui32CRC = FlashPBCRC(pui8Buffer);
 
     //
     // Look for a location to store this parameter block.  This infinite loop
@@ -278,23 +398,11 @@ FlashPBSave(uint8_t *pui8Buffer)
         }
 
         //
-        // Loop through this portion of flash to see if is all ones (in other
-        // words, it is an erased portion of flash).
-        //
-        for(ui32Idx = 0; ui32Idx < g_ui32FlashPBSize; ui32Idx++)
-        {
-            if(pui8New[ui32Idx] != 0xff)
-            {
-                break;
-            }
-        }
-
-        //
-        // If all bytes in this portion of flash are ones, then break out of
-        // the loop since this is a good location for storing the parameter
-        // block.
+        // If this portion of flash is all ones (in other words, it is an
+        // erased portion of flash), then break out of the loop since this is
+        // a good location for storing the parameter block.
         //
-        if(ui32Idx == g_ui32FlashPBSize)
+        if(FlashPBIsErased(pui8New))
         {
             break;
         }
@@ -332,18 +440,20 @@ FlashPBSave(uint8_t *pui8Buffer)
     // parameter block in flash as the most recent (since the current parameter
     // block failed to properly program).
     //
-    for(ui32Idx = 0; ui32Idx < g_ui32FlashPBSize; ui32Idx++)
+    for(ui32Idx = 0; ui32Idx < (g_ui32FlashPBSize / 4); ui32Idx++)
     {
-        if(pui8New[ui32Idx] != pui8Buffer[ui32Idx])
+        if(((uint32_t *)pui8New)[ui32Idx] != ((uint32_t *)pui8Buffer)[ui32Idx])
         {
             return;
         }
     }
 
     //
-    // The new parameter block becomes the most recent parameter block.
+    // The new parameter block becomes the most recent parameter block, and
+    // supersedes any block in the old format.
     //
     g_pui8FlashPBCurrent = pui8New;
+    g_pui8FlashPBLegacy = 0;
 }
 
 //*****************************************************************************
@@ -360,7 +470,7 @@ FlashPBSave(uint8_t *pui8Buffer)
 //! block of flash is to be used.
 //! \param ui32Size is the size of the parameter block when stored in flash;
 //! this must be a power of two less than or equal to the flash erase block
-//! size (typically 1024).
+//! size (typically 1024), and larger than the block header.
 //!
 //! This function initializes a fault-tolerant, persistent storage mechanism
 //! for a parameter block for an application.  The last several erase blocks
@@ -370,17 +480,19 @@ FlashPBSave(uint8_t *pui8Buffer)
 //!
 //! A parameter block is an array of bytes that contain the persistent
 //! parameters for the application.  The only special requirement for the
-//! parameter block is that the first byte is a sequence number (explained
-//! in FlashPBSave()) and the second byte is a checksum used to validate the
-//! correctness of the data (the checksum byte is the byte such that the sum of
-//! all bytes in the parameter block is zero).
+//! parameter block is that the first \b FLASH_PB_HEADER_SIZE bytes are
+//! reserved for a tFlashPBHeader, which holds a sequence number (explained in
+//! FlashPBSave()) and a CRC-32 used to validate the correctness of the data.
 //!
 //! The portion of flash for parameter block storage is split into N
 //! equal-sized regions, where each region is the size of a parameter block
-//! (\e ui32Size).  Each region is scanned to find the most recent valid
-//! parameter block.  The region that has a valid checksum and has the highest
-//! sequence number (with special consideration given to wrapping back to zero)
-//! is considered to be the current parameter block.
+//! (\e ui32Size).  Blocks are written to consecutive regions, so starting from
+//! the first region the blocks form a run of increasing sequence numbers up
+//! to the most recent one.  The end of that run is found by a binary search on
+//! the block headers, and only the blocks around it have their CRC checked.
+//! If the first region does not hold a valid block (power was lost while it
+//! was being erased or written), every region is scanned instead, again
+//! rejecting most regions from the header alone.
 //!
 //! In order to make this efficient and effective, three conditions must be
 //! met.  The first is \e ui32Start and \e ui32End must be specified such that
@@ -393,9 +505,9 @@ FlashPBSave(uint8_t *pui8Buffer)
 //! blocks of flash, making it more difficult to manage.  The final condition
 //! is that the size of the flash dedicated to parameter blocks (\e ui32End -
 //! \e ui32Start) divided by the parameter block size (\e ui32Size) must be
-//! less than or equal to 128.  If not, it will not be possible in all cases to
-//! determine which parameter block is the most recent (specifically when
-//! dealing with the sequence number wrapping back to zero).
+//! less than 32768.  If not, it will not be possible in all cases to determine
+//! which parameter block is the most recent (specifically when dealing with
+//! the sequence number wrapping back to zero).
 //!
 //! When the microcontroller is initially programmed, the flash blocks used for
 //! parameter block storage are left in an erased state.
@@ -410,7 +522,7 @@ void
 FlashPBInit(uint32_t ui32Start, uint32_t ui32End, uint32_t ui32Size)
 {
     uint8_t *pui8Offset, *pui8Current;
-    uint8_t ui8One, ui8Two;
+    uint32_t ui32Low, ui32High, ui32Mid;
 
     //
     // Check the arguments.
@@ -418,6 +530,8 @@ FlashPBInit(uint32_t ui32Start, uint32_t ui32End, uint32_t ui32Size)
     ASSERT((ui32Start % FLASH_SECTOR_SIZE) == 0);
     ASSERT((ui32End % FLASH_SECTOR_SIZE) == 0);
     ASSERT((FLASH_SECTOR_SIZE % ui32Size) == 0);
+    ASSERT(ui32Size > FLASH_PB_HEADER_SIZE);
+    ASSERT(((ui32End - ui32Start) / ui32Size) < 32768);
 
     //
     // Save the characteristics of the flash memory to be used for storing
@@ -428,53 +542,95 @@ FlashPBInit(uint32_t ui32Start, uint32_t ui32End, uint32_t ui32Size)
     g_ui32FlashPBSize = ui32Size;
 
     //
-    // Loop through the portion of flash memory used for storing parameter
-    // blocks.
+    // See if the first region holds a valid block to anchor the search.
     //
-    for(pui8Offset = g_pui8FlashPBStart, pui8Current = 0;
-        pui8Offset < g_pui8FlashPBEnd; pui8Offset += g_ui32FlashPBSize)
+    if(FlashPBIsValid(g_pui8FlashPBStart))
     {
         //
-        // See if this is a valid parameter block (in other words, the checksum
-        // is correct).
+        // Binary search for the last region whose header is that of a block
+        // newer than the first one.  Regions after the most recent block are
+        // either erased or hold blocks from before the first one was written:
+        // older blocks, or torn attempts at writing the first one, which
+        // carry its sequence number.  So the newer regions and the first one
+        // form a prefix of the storage.
         //
-        if(FlashPBIsValid(pui8Offset))
+        ui32Low = 0;
+        ui32High = ((ui32End - ui32Start) / ui32Size) - 1;
+        while(ui32Low < ui32High)
         {
-            //
-            // See if a valid parameter block has been previously found.
-            //
-            if(pui8Current != 0)
+            ui32Mid = (ui32Low + ui32High + 1) / 2;
+            pui8Offset = g_pui8FlashPBStart + (ui32Mid * ui32Size);
+            if(FlashPBHeaderIsValid(pui8Offset) &&
+               FlashPBIsNewer(g_pui8FlashPBStart, pui8Offset))
             {
-                //
-                // Get the sequence numbers for the current and new parameter
-                // blocks.
-                //
-                ui8One = pui8Current[0];
-                ui8Two = pui8Offset[0];
-
-                //
-                // See if the sequence number for the new parameter block is
-                // greater than the current block.  The comparison isn't
-                // straightforward since the one byte sequence number will wrap
-                // after 256 parameter blocks.
-                //
-                if(((ui8One > ui8Two) && ((ui8One - ui8Two) < 128)) ||
-                   ((ui8Two > ui8One) && ((ui8Two - ui8One) > 128)))
+                ui32Low = ui32Mid;
+            }
+            else
+            {
+                ui32High = ui32Mid - 1;
+            }
+        }
+
+        //
+        // The header alone does not show a block torn by a power loss, so
+        // step back to the nearest block with a good CRC.  This stops at the
+        // first region at the latest.
+        //
+        pui8Current = g_pui8FlashPBStart + (ui32Low * ui32Size);
+        while(!FlashPBIsValid(pui8Current))
+        {
+            pui8Current -= ui32Size;
+        }
+
+        //
+        // A torn block in the middle of the run can make the search stop
+        // short, so walk forward until the erased space after the most
+        // recent block, or an older block, is reached.
+        //
+        for(pui8Offset = pui8Current + ui32Size; pui8Offset < g_pui8FlashPBEnd;
+            pui8Offset += ui32Size)
+        {
+            if(FlashPBIsErased(pui8Offset))
+            {
+                break;
+            }
+            if(FlashPBIsValid(pui8Offset))
+            {
+                if(!FlashPBIsNewer(pui8Current, pui8Offset))
                 {
-                    //
-                    // The new parameter block is older than the current
-                    // parameter block, so skip the new parameter block and
-                    // keep searching.
-                    //
-                    continue;
+                    break;
                 }
+                pui8Current = pui8Offset;
+            }
+        }
+    }
+    else
+    {
+        //
+        // Loop through the portion of flash memory used for storing
+        // parameter blocks.
+        //
+        for(pui8Offset = g_pui8FlashPBStart, pui8Current = 0;
+            pui8Offset < g_pui8FlashPBEnd; pui8Offset += g_ui32FlashPBSize)
+        {
+            //
+            // Skip this region unless it holds a block more recent than the
+            // current one; only then is the CRC worth computing.
+            //
+            if(!FlashPBHeaderIsValid(pui8Offset) ||
+               (pui8Current && !FlashPBIsNewer(pui8Current, pui8Offset)))
+            {
+                continue;
             }
 
             //
             // The new parameter block is more recent than the current one, so
-            // make it the new current parameter block.
+            // make it the new current parameter block if it is intact.
             //
-            pui8Current = pui8Offset;
+            if(FlashPBIsValid(pui8Offset))
+            {
+                pui8Current = pui8Offset;
+            }
         }
     }
 
@@ -483,6 +639,35 @@ FlashPBInit(uint32_t ui32Start, uint32_t ui32End, uint32_t ui32Size)
     // parameter blocks were found, this will be a NULL pointer.
     //
     g_pui8FlashPBCurrent = pui8Current;
+
+    //
+    // Without a block in the current format, look for the most recent block
+    // in the old format so that it can be migrated.
+    //
+    g_pui8FlashPBLegacy = 0;
+    if(!pui8Current)
+    {
+        for(pui8Offset = g_pui8FlashPBStart; pui8Offset < g_pui8FlashPBEnd;
+            pui8Offset += g_ui32FlashPBSize)
+        {
+            if(!FlashPBLegacyIsValid(pui8Offset))
+            {
+                continue;
+            }
+
+            //
+            // Keep the new block unless the current one is more recent.  The
+            // comparison is made modulo 256 since the one byte sequence
+            // number wraps after 256 parameter blocks.
+            //
+            if(g_pui8FlashPBLegacy &&
+               ((int8_t)(pui8Offset[0] - g_pui8FlashPBLegacy[0]) < 0))
+            {
+                continue;
+            }
+            g_pui8FlashPBLegacy = pui8Offset;
+        }
+    }
 }
 
 //*****************************************************************************
@@ -36,12 +36,53 @@ extern "C"
 {
 #endif
 
+//*****************************************************************************
+//
+// The header at the start of every parameter block.  The first
+// FLASH_PB_HEADER_SIZE bytes of the buffer passed to FlashPBSave() are
+// reserved for it and are filled in by FlashPBSave(); the application data
+// follows.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // FLASH_PB_MAGIC; anything else (including erased flash) is not a block.
+    //
+    uint16_t ui16Magic;
+
+    //
+    // The sequence number, one greater than the previous block's.
+    //
+    uint16_t ui16Sequence;
+
+    //
+    // The size of the whole block in bytes, header included.
+    //
+    uint16_t ui16Length;
+
+    //
+    // Reserved; written as 0xffff.
+    //
+    uint16_t ui16Reserved;
+
+    //
+    // CRC-32 of the preceding header fields and the application data.
+    //
+    uint32_t ui32CRC;
+}
+tFlashPBHeader;
+
+#define FLASH_PB_MAGIC          0x4250      // "PB"
+#define FLASH_PB_HEADER_SIZE    (sizeof(tFlashPBHeader))
+
 //*****************************************************************************
 //
 // Prototype for the flash parameter block functions.
 //
 //*****************************************************************************
 extern uint8_t *FlashPBGet(void);
+extern uint8_t *FlashPBGetLegacy(void);
 extern void FlashPBSave(uint8_t *pui8Buffer);
 extern void FlashPBInit(uint32_t ui32Start, uint32_t ui32End,
                         uint32_t ui32Size);
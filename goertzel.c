@@ -0,0 +1,347 @@
+/*
+ * goertzel.c
+ *
+ *  Created on: Apr 29, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Custom project-specific headers
+#include "goertzel.h"
+#include "timebase.h"
+#include "uartstdio.h"
+
+//*****************************************************************************/
+// Goertzel filter bank: amplitude and phase of a few chosen frequencies in one
+// sample stream, without buffering samples.
+//
+// Each bin runs the second-order recurrence
+//
+//     s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2]
+//
+// in 32-bit integers with the coefficient in Q30, so every sample costs one
+// 32 x 32 -> 64-bit multiply and two adds per bin.  After ui32Window samples
+// the two states give the DFT term at w, which is converted to an amplitude
+// and phase in floating point (once per window) and the states restart from
+// zero.  Results always describe the last complete window.
+//*****************************************************************************/
+
+// Q30 fixed-point scale of the recurrence coefficient
+#define GOERTZEL_COEFF_SHIFT    30
+
+typedef struct
+{
+    // Requested frequency in Hz
+    float fHz;
+
+    // 2 cos(w) in Q30, and the last two filter states
+    int32_t i32Coeff;
+    int32_t i32S1;
+    int32_t i32S2;
+
+    // cos(w), sin(w) and the rotation back to the window start,
+    // exp(-i w (N - 1)), for the end-of-window conversion
+    float fCos;
+    float fSin;
+    float fRotRe;
+    float fRotIm;
+
+    // Result of the last complete window: amplitude in 12-bit codes and
+    // phase of the cosine at the window start in degrees
+    float fAmplitude;
+    float fPhase;
+}
+tGoertzelBin;
+
+static tGoertzelBin g_psBins[GOERTZEL_MAX_BINS];
+static uint32_t g_ui32NumBins;
+static uint32_t g_ui32Window;
+
+// Per-run input scaling: mid-scale is removed and the result shifted down to
+// 12 bits
+static int32_t g_i32MidScale;
+static uint32_t g_ui32Shift;
+
+// Samples into the current window and windows completed this run
+static uint32_t g_ui32Fill;
+static uint32_t g_ui32Windows;
+
+// Processing time for the end-of-run report
+static uint64_t g_ui64Ticks;
+static uint64_t g_ui64Samples;
+
+//*****************************************************************************/
+// Choose the tracked frequencies and the window length in samples.  Zero bins
+// turns the bank off.  Frequencies are checked against the sample rate by
+// goertzelStart().  Returns false if the counts are out of range.
+//*****************************************************************************/
+bool
+goertzelSetup(const float *pfHz, uint32_t ui32NumBins, uint32_t ui32Window)
+{
+    uint32_t ui32Bin;
+
+    if (ui32NumBins > GOERTZEL_MAX_BINS) {
+        return false;
+    }
+    if (ui32NumBins && (ui32Window < 2 || ui32Window > GOERTZEL_MAX_WINDOW)) {
+        return false;
+    }
+
+    for (ui32Bin = 0; ui32Bin < ui32NumBins; ui32Bin++)
+    {
+        g_psBins[ui32Bin].fHz = pfHz[ui32Bin];
+        g_psBins[ui32Bin].fAmplitude = 0.0f;
+        g_psBins[ui32Bin].fPhase = 0.0f;
+    }
+
+    g_ui32NumBins = ui32NumBins;
+    g_ui32Window = ui32Window;
+    g_ui32Windows = 0;
+    return true;
+}
+
+//*****************************************************************************/
+// Number of tracked frequencies, zero when the bank is off
+//*****************************************************************************/
+uint32_t
+goertzelBins(void)
+{
+    return g_ui32NumBins;
+}
+
+//*****************************************************************************/
+// Window length in samples
+//*****************************************************************************/
+uint32_t
+goertzelWindow(void)
+{
+    return g_ui32Window;
+}
+
+//*****************************************************************************/
+// Prepare the bank for a run at ui32SampleRate, with input samples that are
+// 12-bit codes shifted up by ui32Shift bits.  Returns false if a frequency is
+// less than one cycle per window from DC or the Nyquist frequency, which
+// would let the filter states overflow.
+//*****************************************************************************/
+bool
+goertzelStart(uint32_t ui32SampleRate, uint32_t ui32Shift)
+{
+    const float fPi = 3.14159265f;
+    tGoertzelBin *psBin;
+    float fMinHz = (float)ui32SampleRate / g_ui32Window;
+    float fOmega;
+    uint32_t ui32Bin;
+
+    for (ui32Bin = 0; ui32Bin < g_ui32NumBins; ui32Bin++)
+    {
+        psBin = &g_psBins[ui32Bin];
+        if (psBin->fHz < fMinHz || psBin->fHz > ui32SampleRate / 2.0f - fMinHz) {
+            return false;
+        }
+
+        fOmega = 2.0f * fPi * psBin->fHz / ui32SampleRate;
+        psBin->fCos = cosf(fOmega);
+        psBin->fSin = sinf(fOmega);
+        psBin->fRotRe = cosf(fOmega * (g_ui32Window - 1));
+        psBin->fRotIm = -sinf(fOmega * (g_ui32Window - 1));
+        // Single precision would leave the low bits of the Q30 coefficient
+        // to rounding noise; this runs once per run
+        psBin->i32Coeff = (int32_t)lround(2.0 * cos(2.0 * 3.14159265358979 * psBin->fHz / ui32SampleRate) *
+                                          (1 << GOERTZEL_COEFF_SHIFT));
+        psBin->i32S1 = 0;
+        psBin->i32S2 = 0;
+        psBin->fAmplitude = 0.0f;
+        psBin->fPhase = 0.0f;
+    }
+
+    g_i32MidScale = 2048 << ui32Shift;
+    g_ui32Shift = ui32Shift;
+    g_ui32Fill = 0;
+    g_ui32Windows = 0;
+    g_ui64Ticks = 0;
+    g_ui64Samples = 0;
+    return true;
+}
+
+//*****************************************************************************/
+// Run one bin over ui32Count samples
+//*****************************************************************************/
+static void
+runBin(tGoertzelBin *psBin, const uint16_t *pui16Samples, uint32_t ui32Count)
+{
+    int32_t i32Coeff = psBin->i32Coeff;
+    int32_t i32S1 = psBin->i32S1;
+    int32_t i32S2 = psBin->i32S2;
+    int32_t i32S0;
+    int32_t i32MidScale = g_i32MidScale;
+    uint32_t ui32Shift = g_ui32Shift;
+    uint32_t ui32Index;
+
+    for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+    {
+        i32S0 = (((int32_t)pui16Samples[ui32Index] - i32MidScale) >> ui32Shift) +
+                (int32_t)(((int64_t)i32Coeff * i32S1) >> GOERTZEL_COEFF_SHIFT) - i32S2;
+        i32S2 = i32S1;
+        i32S1 = i32S0;
+    }
+
+    psBin->i32S1 = i32S1;
+    psBin->i32S2 = i32S2;
+}
+
+//*****************************************************************************/
+// Turn a bin's states at the end of a window into its amplitude and phase,
+// and restart it
+//*****************************************************************************/
+static void
+finishBin(tGoertzelBin *psBin)
+{
+    const float fDegrees = 180.0f / 3.14159265f;
+    float fYRe;
+    float fYIm;
+    float fXRe;
+    float fXIm;
+
+    // y = s[N-1] - exp(-i w) s[N-2] = sum x[n] exp(i w (N - 1 - n))
+    fYRe = psBin->i32S1 - psBin->fCos * psBin->i32S2;
+    fYIm = psBin->fSin * psBin->i32S2;
+
+    // X = exp(-i w (N - 1)) y = sum x[n] exp(-i w n)
+    fXRe = fYRe * psBin->fRotRe - fYIm * psBin->fRotIm;
+    fXIm = fYRe * psBin->fRotIm + fYIm * psBin->fRotRe;
+
+    psBin->fAmplitude = 2.0f * sqrtf(fXRe * fXRe + fXIm * fXIm) / g_ui32Window;
+    psBin->fPhase = atan2f(fXIm, fXRe) * fDegrees;
+
+    psBin->i32S1 = 0;
+    psBin->i32S2 = 0;
+}
+
+//*****************************************************************************/
+// Feed ui32Count samples to every bin.  Bins are run one at a time over each
+// stretch of samples up to the next window boundary, which keeps a bin's
+// states in registers.
+//*****************************************************************************/
+void
+goertzelProcess(const uint16_t *pui16Samples, uint32_t ui32Count)
+{
+    uint64_t ui64Start = timebaseNow();
+    uint32_t ui32Run;
+    uint32_t ui32Bin;
+
+    g_ui64Samples += ui32Count;
+
+    while (ui32Count)
+    {
+        ui32Run = g_ui32Window - g_ui32Fill;
+        if (ui32Run > ui32Count) {
+            ui32Run = ui32Count;
+        }
+
+        for (ui32Bin = 0; ui32Bin < g_ui32NumBins; ui32Bin++)
+        {
+            runBin(&g_psBins[ui32Bin], pui16Samples, ui32Run);
+        }
+
+        g_ui32Fill += ui32Run;
+        if (g_ui32Fill == g_ui32Window) {
+            for (ui32Bin = 0; ui32Bin < g_ui32NumBins; ui32Bin++)
+            {
+                finishBin(&g_psBins[ui32Bin]);
+            }
+            g_ui32Fill = 0;
+            g_ui32Windows++;
+        }
+
+        pui16Samples += ui32Run;
+        ui32Count -= ui32Run;
+    }
+
+    g_ui64Ticks += timebaseNow() - ui64Start;
+}
+
+//*****************************************************************************/
+// Number of windows completed this run
+//*****************************************************************************/
+uint32_t
+goertzelWindows(void)
+{
+    return g_ui32Windows;
+}
+
+//*****************************************************************************/
+// Frequency, amplitude (12-bit codes) and phase (degrees, cosine at the
+// window start) of a bin from the last complete window.  Returns false for a
+// bin that is not in use.
+//*****************************************************************************/
+bool
+goertzelResult(uint32_t ui32Bin, float *pfHz, float *pfAmplitude, float *pfPhase)
+{
+    if (ui32Bin >= g_ui32NumBins) {
+        return false;
+    }
+
+    *pfHz = g_psBins[ui32Bin].fHz;
+    *pfAmplitude = g_psBins[ui32Bin].fAmplitude;
+    *pfPhase = g_psBins[ui32Bin].fPhase;
+    return true;
+}
+
+//*****************************************************************************/
+// Print a non-negative value with two decimals, or a signed one with one
+//*****************************************************************************/
+static void
+printHundredths(float fValue)
+{
+    uint32_t ui32Value = (uint32_t)lroundf(fValue * 100.0f);
+
+    UARTprintf("%d.%02d", ui32Value / 100, ui32Value % 100);
+}
+
+static void
+printSignedTenths(float fValue)
+{
+    int32_t i32Value = (int32_t)lroundf(fValue * 10.0f);
+
+    UARTprintf("%s%d.%d", (i32Value < 0) ? "-" : "", abs(i32Value) / 10, abs(i32Value) % 10);
+}
+
+//*****************************************************************************/
+// Console report: the bank settings, its cost in system clock cycles per bin
+// per sample, and the last result of every bin
+//*****************************************************************************/
+void
+goertzelReport(void)
+{
+    uint32_t ui32Bin;
+    uint32_t ui32Cycles = 0;
+
+    if (g_ui32NumBins == 0) {
+        UARTprintf("Tones off\n");
+        return;
+    }
+
+    if (g_ui64Samples) {
+        ui32Cycles = (uint32_t)(g_ui64Ticks / (g_ui64Samples * g_ui32NumBins));
+    }
+
+    UARTprintf("Tones: %d bins, %d-sample window, %d windows, %d cycles per bin per sample\n",
+               g_ui32NumBins, g_ui32Window, g_ui32Windows, ui32Cycles);
+
+    for (ui32Bin = 0; ui32Bin < g_ui32NumBins; ui32Bin++)
+    {
+        UARTprintf("    ");
+        printHundredths(g_psBins[ui32Bin].fHz);
+        UARTprintf(" Hz: ");
+        printHundredths(g_psBins[ui32Bin].fAmplitude);
+        UARTprintf(" codes, ");
+        printSignedTenths(g_psBins[ui32Bin].fPhase);
+        UARTprintf(" deg\n");
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ * goertzel.h
+ *
+ *  Created on: Apr 29, 2024
+ *      Author: Tyler
+ */
+
+#ifndef GOERTZEL_H_
+#define GOERTZEL_H_
+
+// Largest number of tracked frequencies
+#define GOERTZEL_MAX_BINS       16
+
+// Longest analysis window in samples.  With 12-bit input and every
+// frequency at least one cycle per window away from DC and Nyquist, the
+// filter states stay below 2^31 for windows up to this length.
+#define GOERTZEL_MAX_WINDOW     2048
+
+bool goertzelSetup(const float *pfHz, uint32_t ui32NumBins, uint32_t ui32Window);
+uint32_t goertzelBins(void);
+uint32_t goertzelWindow(void);
+bool goertzelStart(uint32_t ui32SampleRate, uint32_t ui32Shift);
+void goertzelProcess(const uint16_t *pui16Samples, uint32_t ui32Count);
+uint32_t goertzelWindows(void);
+bool goertzelResult(uint32_t ui32Bin, float *pfHz, float *pfAmplitude, float *pfPhase);
+void goertzelReport(void);
+
+#endif /* GOERTZEL_H_ */
@@ -0,0 +1,334 @@
+/*
+ * cmdline_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the console command lookup and the typed argument
+ * converters.  A table of TEST_COMMANDS commands, with names that share
+ * prefixes, is built in name order, or shuffled when built with
+ * CMDLINE_TEST_UNSORTED so that CmdLineProcess() falls back to its linear
+ * search.  Every name must reach its command with its arguments, and names
+ * between, before and after the entries, prefixes and extensions of them, and
+ * empty lines must not.  The time per dispatch is printed for the first, a
+ * middle and the last entry and for a miss.
+ *
+ * CmdLineArgUInt(), CmdLineArgInt() and CmdLineArgFloat() must take every
+ * radix and sign they document and the limits of their types, and must
+ * reject trailing garbage, bare prefixes and signs, and values that overflow
+ * their types, leaving the value unchanged.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -Ihost/stubs -o cmdline_test host/cmdline_test.c cmdline.c ustdlib.c -lm && ./cmdline_test
+ */
+
+// Standard C libraries
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Custom project-specific headers
+#include "cmdline.h"
+
+#define TEST_COMMANDS       64
+#define TEST_NAME_SIZE      12
+#define TEST_DISPATCHES     1000000
+
+// Name stems, so that neighbouring names share prefixes
+static const char *g_ppcStems[] =
+{
+    "adc", "cal", "config", "dump", "log", "run", "stat", "tone"
+};
+
+static char g_ppcNames[TEST_COMMANDS][TEST_NAME_SIZE];
+static uint32_t g_ui32Called;
+static int g_iLastArgc;
+static char *g_pcLastArg;
+
+tCmdLineEntry g_psCmdTable[TEST_COMMANDS + 1];
+
+static int g_iFailures;
+
+//*****************************************************************************/
+// The command table
+//*****************************************************************************/
+static int
+cmdRecord(int argc, char *argv[])
+{
+    g_ui32Called++;
+    g_iLastArgc = argc;
+    g_pcLastArg = argv[argc - 1];
+    return argc;
+}
+
+static int
+compareEntries(const void *pvA, const void *pvB)
+{
+    return strcmp(((const tCmdLineEntry *)pvA)->pcCmd, ((const tCmdLineEntry *)pvB)->pcCmd);
+}
+
+// Names run stem, stem1, stem2 ... so that each stem is a prefix of the
+// names after it
+static void
+buildTable(void)
+{
+    uint32_t ui32Index, ui32Swap;
+    tCmdLineEntry sEntry;
+    uint32_t ui32Stems = sizeof(g_ppcStems) / sizeof(g_ppcStems[0]);
+
+    for (ui32Index = 0; ui32Index < TEST_COMMANDS; ui32Index++) {
+        if (ui32Index < ui32Stems) {
+            snprintf(g_ppcNames[ui32Index], TEST_NAME_SIZE, "%s", g_ppcStems[ui32Index]);
+        } else {
+            snprintf(g_ppcNames[ui32Index], TEST_NAME_SIZE, "%s%u", g_ppcStems[ui32Index % ui32Stems],
+                     ui32Index / ui32Stems);
+        }
+        g_psCmdTable[ui32Index].pcCmd = g_ppcNames[ui32Index];
+        g_psCmdTable[ui32Index].pfnCmd = cmdRecord;
+        g_psCmdTable[ui32Index].pcHelp = "";
+    }
+    qsort(g_psCmdTable, TEST_COMMANDS, sizeof(g_psCmdTable[0]), compareEntries);
+
+#ifdef CMDLINE_TEST_UNSORTED
+    // Shuffle, keeping the first two out of order so the table is unsorted
+    for (ui32Index = TEST_COMMANDS - 1; ui32Index > 0; ui32Index--) {
+        ui32Swap = rand() % (ui32Index + 1);
+        sEntry = g_psCmdTable[ui32Index];
+        g_psCmdTable[ui32Index] = g_psCmdTable[ui32Swap];
+        g_psCmdTable[ui32Swap] = sEntry;
+    }
+    if (strcmp(g_psCmdTable[0].pcCmd, g_psCmdTable[1].pcCmd) < 0) {
+        sEntry = g_psCmdTable[0];
+        g_psCmdTable[0] = g_psCmdTable[1];
+        g_psCmdTable[1] = sEntry;
+    }
+#else
+    (void)ui32Swap;
+    (void)sEntry;
+#endif
+}
+
+//*****************************************************************************/
+// Checks
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, const char *pcInput)
+{
+    if (!bPass) {
+        printf("FAIL: %s, \"%s\"\n", pcWhat, pcInput);
+        g_iFailures++;
+    }
+}
+
+// Run one line and return its status, leaving the line itself untouched
+static int
+dispatch(const char *pcLine)
+{
+    static char pcBuffer[64];
+    size_t szLen = strlen(pcLine);
+
+    if (szLen >= sizeof(pcBuffer)) {
+        szLen = sizeof(pcBuffer) - 1;
+    }
+    memcpy(pcBuffer, pcLine, szLen);
+    pcBuffer[szLen] = '\0';
+    g_ui32Called = 0;
+    return CmdLineProcess(pcBuffer);
+}
+
+static void
+checkLookup(void)
+{
+    static const char *ppcMisses[] =
+    {
+        "", " ", "   ", "a", "aaa", "zzz", "ad", "adcx", "adc00", "co", "confi", "configx", "tone9",
+        "tone10", "Run", "RUN", "-run", "runrun", "stat0"
+    };
+    char pcLine[64];
+    uint32_t ui32Index;
+    int iStatus;
+
+    for (ui32Index = 0; ui32Index < TEST_COMMANDS; ui32Index++) {
+        // The name alone, and with arguments and extra spaces
+        iStatus = dispatch(g_ppcNames[ui32Index]);
+        check(iStatus == 1 && g_ui32Called == 1, "command not found", g_ppcNames[ui32Index]);
+
+        strcpy(pcLine, "  ");
+        strcat(pcLine, g_ppcNames[ui32Index]);
+        strcat(pcLine, "  12 last ");
+        iStatus = dispatch(pcLine);
+        check(iStatus == 3 && g_ui32Called == 1 && g_iLastArgc == 3 && strcmp(g_pcLastArg, "last") == 0,
+              "command with arguments", pcLine);
+    }
+
+    for (ui32Index = 0; ui32Index < sizeof(ppcMisses) / sizeof(ppcMisses[0]); ui32Index++) {
+        iStatus = dispatch(ppcMisses[ui32Index]);
+        check(iStatus == CMDLINE_BAD_CMD && g_ui32Called == 0, "miss found a command", ppcMisses[ui32Index]);
+    }
+
+    // Up to CMDLINE_MAX_ARGS arguments, the command included
+    check(dispatch("adc 1 2 3 4 5 6 7") == 8, "eight arguments", "adc 1 2 3 4 5 6 7");
+    check(dispatch("adc 1 2 3 4 5 6 7 8") == CMDLINE_TOO_MANY_ARGS && g_ui32Called == 0, "nine arguments",
+          "adc 1 2 3 4 5 6 7 8");
+}
+
+static void
+benchmarkLookup(void)
+{
+    char *ppcLines[4];
+    char pcMiss[] = "zzz";
+    const char *ppcWhere[4] = { "first entry", "middle entry", "last entry", "miss" };
+    struct timespec sStart, sEnd;
+    uint32_t ui32Line, ui32Rep;
+    double dNs;
+
+    // Lines without spaces are not modified, so they can be reused
+    ppcLines[0] = (char *)g_psCmdTable[0].pcCmd;
+    ppcLines[1] = (char *)g_psCmdTable[TEST_COMMANDS / 2].pcCmd;
+    ppcLines[2] = (char *)g_psCmdTable[TEST_COMMANDS - 1].pcCmd;
+    ppcLines[3] = pcMiss;
+
+    for (ui32Line = 0; ui32Line < 4; ui32Line++) {
+        clock_gettime(CLOCK_MONOTONIC, &sStart);
+        for (ui32Rep = 0; ui32Rep < TEST_DISPATCHES; ui32Rep++) {
+            CmdLineProcess(ppcLines[ui32Line]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &sEnd);
+        dNs = ((sEnd.tv_sec - sStart.tv_sec) * 1e9 + (sEnd.tv_nsec - sStart.tv_nsec)) / TEST_DISPATCHES;
+        printf("cmdline: %u commands, %s, %s: %.1f ns per dispatch\n", TEST_COMMANDS,
+#ifdef CMDLINE_TEST_UNSORTED
+               "unsorted",
+#else
+               "sorted",
+#endif
+               ppcWhere[ui32Line], dNs);
+    }
+}
+
+static void
+checkUInt(const char *pcArg, bool bValid, uint32_t ui32Expected)
+{
+    uint32_t ui32Value = 0xA5A5A5A5;
+    bool bResult = CmdLineArgUInt(pcArg, &ui32Value);
+
+    check(bResult == bValid && ui32Value == (bValid ? ui32Expected : 0xA5A5A5A5), "CmdLineArgUInt", pcArg);
+}
+
+static void
+checkInt(const char *pcArg, bool bValid, int32_t i32Expected)
+{
+    int32_t i32Value = 0x5A5A5A5A;
+    bool bResult = CmdLineArgInt(pcArg, &i32Value);
+
+    check(bResult == bValid && i32Value == (bValid ? i32Expected : 0x5A5A5A5A), "CmdLineArgInt", pcArg);
+}
+
+static void
+checkFloat(const char *pcArg, bool bValid, float fExpected)
+{
+    float fValue = 1234.5f;
+    bool bResult = CmdLineArgFloat(pcArg, &fValue);
+
+    check(bResult == bValid && (bValid ? (fValue >= fExpected - fabsf(fExpected) * 1e-6f &&
+                                          fValue <= fExpected + fabsf(fExpected) * 1e-6f) :
+                                (fValue == 1234.5f)), "CmdLineArgFloat", pcArg);
+}
+
+static void
+checkArguments(void)
+{
+    checkUInt("0", true, 0);
+    checkUInt("42", true, 42);
+    checkUInt("+42", true, 42);
+    checkUInt("0x2A", true, 42);
+    checkUInt("0X2a", true, 42);
+    checkUInt("052", true, 42);
+    checkUInt("4294967295", true, 0xFFFFFFFF);
+    checkUInt("0xFFFFFFFF", true, 0xFFFFFFFF);
+    checkUInt("037777777777", true, 0xFFFFFFFF);
+    checkUInt("0x00000000FFFFFFFF", true, 0xFFFFFFFF);
+    checkUInt("4294967296", false, 0);
+    checkUInt("42949672950", false, 0);
+    checkUInt("99999999999999999999", false, 0);
+    checkUInt("0x100000000", false, 0);
+    checkUInt("040000000000", false, 0);
+    checkUInt("-1", false, 0);
+    checkUInt("-0", false, 0);
+    checkUInt("", false, 0);
+    checkUInt("+", false, 0);
+    checkUInt("0x", false, 0);
+    checkUInt("12abc", false, 0);
+    checkUInt("12 ", false, 0);
+    checkUInt("1.5", false, 0);
+    checkUInt("0x1g", false, 0);
+    checkUInt("08", false, 0);
+    checkUInt("abc", false, 0);
+    checkUInt("1e3", false, 0);
+
+    checkInt("0", true, 0);
+    checkInt("-0", true, 0);
+    checkInt("-42", true, -42);
+    checkInt("+42", true, 42);
+    checkInt("-0x2A", true, -42);
+    checkInt("-052", true, -42);
+    checkInt("2147483647", true, INT32_MAX);
+    checkInt("-2147483648", true, INT32_MIN);
+    checkInt("0x7FFFFFFF", true, INT32_MAX);
+    checkInt("-0x80000000", true, INT32_MIN);
+    checkInt("2147483648", false, 0);
+    checkInt("-2147483649", false, 0);
+    checkInt("0x80000000", false, 0);
+    checkInt("4294967295", false, 0);
+    checkInt("-4294967296", false, 0);
+    checkInt("99999999999999999999", false, 0);
+    checkInt("-", false, 0);
+    checkInt("--1", false, 0);
+    checkInt("+-1", false, 0);
+    checkInt("1-", false, 0);
+    checkInt("-12abc", false, 0);
+    checkInt("7x", false, 0);
+
+    checkFloat("0", true, 0.0f);
+    checkFloat("1.5", true, 1.5f);
+    checkFloat("-0.25", true, -0.25f);
+    checkFloat("+3", true, 3.0f);
+    checkFloat("1000", true, 1000.0f);
+    checkFloat("1e3", true, 1000.0f);
+    checkFloat("2.5E-2", true, 0.025f);
+    checkFloat("3e38", true, 3e38f);
+    checkFloat("-3e38", true, -3e38f);
+    checkFloat("1e39", false, 0);
+    checkFloat("-1e39", false, 0);
+    checkFloat("1e128", false, 0);
+    checkFloat("1e300", false, 0);
+    checkFloat("1e99999999999", false, 0);
+    checkFloat("1000000000000000000000000000000000000000", false, 0);
+    checkFloat("", false, 0);
+    checkFloat(".", false, 0);
+    checkFloat("-", false, 0);
+    checkFloat("1.5x", false, 0);
+    checkFloat("1.5 ", false, 0);
+    checkFloat("1..5", false, 0);
+    checkFloat("1e", false, 0);
+    checkFloat("1e+", false, 0);
+    checkFloat("nan", false, 0);
+    checkFloat("inf", false, 0);
+    checkFloat("0x10", false, 0);
+}
+
+int
+main(void)
+{
+    buildTable();
+    checkLookup();
+    benchmarkLookup();
+    checkArguments();
+
+    printf("cmdline: %d failures\n", g_iFailures);
+    return g_iFailures != 0;
+}
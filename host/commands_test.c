@@ -0,0 +1,178 @@
+/*
+ * commands_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the project's console command table.  The table in
+ * commands.c must hold its eight commands in name order, so that
+ * CmdLineProcess() finds them with its binary search, and each name must
+ * reach its own handler, which is told apart by the module call it makes.
+ * The handlers' numeric arguments must be converted, and arguments with
+ * trailing garbage or that overflow must be refused before any module is
+ * called.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -Ihost/stubs -o commands_test host/commands_test.c commands.c cmdline.c ustdlib.c -lm && ./commands_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "adc_functions.h"
+#include "cmdline.h"
+#include "commands.h"
+#include "config_store.h"
+#include "flash_log.h"
+#include "goertzel.h"
+#include "sample_buffer.h"
+#include "stats.h"
+#include "uart_functions.h"
+#include "uartstdio.h"
+
+#define TEST_COMMANDS       8
+
+// The module call the last command made, and its arguments
+static const char *g_pcCalled;
+static uint32_t g_pui32Args[2];
+static uint32_t g_ui32Lines;
+static bool g_bRunning;
+
+static int g_iFailures;
+
+//*****************************************************************************/
+// Stand-ins for the modules the commands call
+//*****************************************************************************/
+void
+UARTprintf(const char *pcString, ...)
+{
+    (void)pcString;
+    g_ui32Lines++;
+}
+
+bool acqIsRunning(void) { return g_bRunning; }
+void acqRequestStop(void) { g_pcCalled = "acqRequestStop"; }
+void printAcqStatus(void) { g_pcCalled = "printAcqStatus"; }
+int startADC1(void) { g_pcCalled = "startADC1"; return 0; }
+bool configGet(uint32_t ui32Key, uint32_t *pui32Value) { (void)ui32Key; *pui32Value = 0; return false; }
+int configSet(uint32_t ui32Key, uint32_t ui32Value) { g_pcCalled = "configSet"; g_pui32Args[0] = ui32Key; g_pui32Args[1] = ui32Value; return 0; }
+uint32_t configFindKey(const char *pcName) { return strcmp(pcName, "key") == 0 ? 1 : CONFIG_KEY_COUNT; }
+const char *configKeyName(uint32_t ui32Key) { (void)ui32Key; return "key"; }
+uint32_t configLogUsed(void) { g_pcCalled = "configLogUsed"; return 0; }
+uint32_t configLogSize(void) { return 0; }
+uint32_t flashLogLastRun(void) { return 7; }
+uint32_t flashLogDump(uint32_t ui32RunID, uint32_t ui32Offset) { g_pcCalled = "flashLogDump"; g_pui32Args[0] = ui32RunID; g_pui32Args[1] = ui32Offset; return 0; }
+bool goertzelSetup(const float *pfHz, uint32_t ui32NumBins, uint32_t ui32Window) { (void)pfHz; g_pcCalled = "goertzelSetup"; g_pui32Args[0] = ui32NumBins; g_pui32Args[1] = ui32Window; return true; }
+uint32_t goertzelWindow(void) { return 0; }
+bool goertzelResult(uint32_t ui32Bin, float *pfHz, float *pfAmplitude, float *pfPhase) { (void)ui32Bin; (void)pfHz; (void)pfAmplitude; (void)pfPhase; return false; }
+void goertzelReport(void) { g_pcCalled = "goertzelReport"; }
+uint32_t statsChannelOfPair(uint32_t ui32Pair) { return ui32Pair * 2; }
+void statsReport(void) { g_pcCalled = "statsReport"; }
+void statsReportHistogram(uint32_t ui32Channel) { g_pcCalled = "statsReportHistogram"; g_pui32Args[0] = ui32Channel; }
+bool consoleGetLine(char *pcLine, uint32_t ui32Size) { (void)pcLine; (void)ui32Size; return false; }
+int UARTgets(char *pcBuf, uint32_t ui32Len) { (void)ui32Len; pcBuf[0] = '\0'; return 0; }
+
+//*****************************************************************************/
+// Checks
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, const char *pcLine)
+{
+    if (!bPass) {
+        printf("FAIL: %s, \"%s\"\n", pcWhat, pcLine);
+        g_iFailures++;
+    }
+}
+
+// Run one line; the module call it should make, or NULL for none, and the
+// status it should return
+static void
+checkLine(const char *pcLine, int iStatus, const char *pcCall)
+{
+    char pcBuffer[COMMAND_LINE_SIZE];
+
+    strcpy(pcBuffer, pcLine);
+    g_pcCalled = NULL;
+    g_ui32Lines = 0;
+    g_pui32Args[0] = g_pui32Args[1] = 0xFFFFFFFF;
+    check(CmdLineProcess(pcBuffer) == iStatus, "status", pcLine);
+    check(pcCall ? (g_pcCalled && strcmp(g_pcCalled, pcCall) == 0) : !g_pcCalled, pcCall ? pcCall : "no call",
+          pcLine);
+}
+
+static void
+checkTable(void)
+{
+    uint32_t ui32Index;
+
+    for (ui32Index = 0; g_psCmdTable[ui32Index].pcCmd; ui32Index++) {
+        check(g_psCmdTable[ui32Index].pfnCmd && g_psCmdTable[ui32Index].pcHelp, "incomplete entry",
+              g_psCmdTable[ui32Index].pcCmd);
+        if (ui32Index) {
+            check(strcmp(g_psCmdTable[ui32Index - 1].pcCmd, g_psCmdTable[ui32Index].pcCmd) < 0,
+                  "table out of order", g_psCmdTable[ui32Index].pcCmd);
+        }
+    }
+    check(ui32Index == TEST_COMMANDS, "table size", "");
+
+    // help lists every entry, one line each
+    checkLine("help", 0, NULL);
+    check(g_ui32Lines == TEST_COMMANDS, "help lines", "help");
+}
+
+static void
+checkDispatch(void)
+{
+    g_bRunning = false;
+    checkLine("config", 0, "configLogUsed");
+    checkLine("dump", 0, "flashLogDump");
+    check(g_pui32Args[0] == 7 && g_pui32Args[1] == 0, "dump defaults", "dump");
+    checkLine("run", 0, "startADC1");
+    checkLine("stats", 0, "statsReport");
+    checkLine("status", 0, "printAcqStatus");
+    checkLine("tones", 0, "goertzelReport");
+    checkLine("stop", 0, NULL);
+    g_bRunning = true;
+    checkLine("stop", 0, "acqRequestStop");
+    g_bRunning = false;
+
+    checkLine("sta", CMDLINE_BAD_CMD, NULL);
+    checkLine("statss", CMDLINE_BAD_CMD, NULL);
+    checkLine("Help", CMDLINE_BAD_CMD, NULL);
+
+    // Converted arguments
+    checkLine("dump 3 0x1000", 0, "flashLogDump");
+    check(g_pui32Args[0] == 3 && g_pui32Args[1] == 0x1000, "dump arguments", "dump 3 0x1000");
+    checkLine("stats 2", 0, "statsReportHistogram");
+    check(g_pui32Args[0] == 4, "stats argument", "stats 2");
+    checkLine("config key -5", 0, "configSet");
+    check(g_pui32Args[0] == 1 && g_pui32Args[1] == (uint32_t)-5, "config arguments", "config key -5");
+    checkLine("tones 256 50 60.5", 0, "goertzelSetup");
+    check(g_pui32Args[0] == 2 && g_pui32Args[1] == 256, "tones arguments", "tones 256 50 60.5");
+
+    // Refused arguments
+    checkLine("dump 3x", CMDLINE_INVALID_ARG, NULL);
+    checkLine("dump 4294967296", CMDLINE_INVALID_ARG, NULL);
+    checkLine("dump 1 -1", CMDLINE_INVALID_ARG, NULL);
+    checkLine("stats 1.5", CMDLINE_INVALID_ARG, NULL);
+    checkLine("config key 2147483648", CMDLINE_INVALID_ARG, NULL);
+    checkLine("config key 12abc", CMDLINE_INVALID_ARG, NULL);
+    checkLine("tones 256 50 1e39", CMDLINE_INVALID_ARG, NULL);
+    checkLine("tones 256 50hz", CMDLINE_INVALID_ARG, NULL);
+    checkLine("tones 0x100000000 50", CMDLINE_INVALID_ARG, NULL);
+}
+
+int
+main(void)
+{
+    checkTable();
+    checkDispatch();
+
+    printf("commands: %d failures\n", g_iFailures);
+    return g_iFailures != 0;
+}
@@ -0,0 +1,296 @@
+/*
+ * config_store_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the key-value configuration store on the flash model,
+ * at the store's own flash addresses.  Random values are written to random
+ * keys through many compactions and compared with a RAM copy after every
+ * write and every reboot.  Then power is cut at random words of record
+ * writes, snapshot writes, log erases and the log erase a reboot finishes:
+ * after the reboot every key must hold its last written value, except the
+ * one being written, which may hold the old or the new one.  A snapshot in
+ * the old parameter block format, next to log records of its generation,
+ * must be imported and saved again in the current format.  Also prints
+ * the flash cost per change against writing a whole snapshot per change.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -Ihost/stubs -o config_store_test host/config_store_test.c host/flash_model.c config_store.c flash_pb.c crc.c && ./config_store_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "config_store.h"
+#include "crc.h"
+#include "flash_model.h"
+#include "flash_pb.h"
+
+// Tiva C Series libraries
+#include "driverlib/flash.h"
+
+#define TEST_WRITES         20000
+#define TEST_POWER_LOSSES   20000
+
+// The snapshot layout in config_store.c
+#define TEST_SNAPSHOT_SIZE  256
+typedef struct
+{
+    tFlashPBHeader sHeader;
+    uint32_t ui32Generation;
+    uint32_t pui32Valid[2];
+    uint32_t pui32Values[58];
+}
+tTestSnapshot;
+
+// Last written value of each key
+static uint32_t g_pui32Expected[CONFIG_KEY_COUNT];
+static bool g_pbExpected[CONFIG_KEY_COUNT];
+static int g_iFailures;
+
+//*****************************************************************************/
+// Record a failed check
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, uint32_t ui32Count)
+{
+    if (!bPass) {
+        printf("FAIL: %s, after %u\n", pcWhat, ui32Count);
+        g_iFailures++;
+    }
+}
+
+//*****************************************************************************/
+// Random value, now and then all ones, which looks like erased flash
+//*****************************************************************************/
+static uint32_t
+randomValue(void)
+{
+    return (rand() % 16 == 0) ? 0xFFFFFFFF : ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+//*****************************************************************************/
+// True if every key reads back as expected
+//*****************************************************************************/
+static bool
+storeMatches(void)
+{
+    uint32_t ui32Key;
+    uint32_t ui32Value;
+    bool bSet;
+
+    for (ui32Key = 0; ui32Key < CONFIG_KEY_COUNT; ui32Key++)
+    {
+        ui32Value = 0x12345678;
+        bSet = configGet(ui32Key, &ui32Value);
+        if (bSet != g_pbExpected[ui32Key] || (bSet && ui32Value != g_pui32Expected[ui32Key])) {
+            printf("key %s: %s 0x%08X, expected %s 0x%08X\n", configKeyName(ui32Key), bSet ? "set" : "unset",
+                   ui32Value, g_pbExpected[ui32Key] ? "set" : "unset", g_pui32Expected[ui32Key]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//*****************************************************************************/
+// Writes and reboots with the power on, then the cost per change
+//*****************************************************************************/
+static void
+checkWrites(void)
+{
+    const tFlashModelCounts *psCounts = flashModelCounts();
+    uint32_t ui32Count;
+    uint32_t ui32Key;
+    uint32_t ui32Value;
+    uint32_t ui32Used;
+    uint32_t ui32Changes = 0;
+    bool bChange;
+
+    flashModelErase();
+    configStoreInit();
+    memset(g_pbExpected, 0, sizeof(g_pbExpected));
+    check(storeMatches(), "blank store has values", 0);
+    check(configSet(CONFIG_KEY_COUNT, 1) != 0 && !configGet(CONFIG_KEY_COUNT, &ui32Value), "unknown key accepted", 0);
+
+    flashModelResetCounts();
+    for (ui32Count = 0; ui32Count < TEST_WRITES; ui32Count++)
+    {
+        ui32Key = rand() % CONFIG_KEY_COUNT;
+        ui32Value = randomValue();
+        ui32Used = configLogUsed();
+        bChange = !(g_pbExpected[ui32Key] && g_pui32Expected[ui32Key] == ui32Value);
+        ui32Changes += bChange;
+
+        check(configSet(ui32Key, ui32Value) == 0, "write failed", ui32Count);
+        g_pui32Expected[ui32Key] = ui32Value;
+        g_pbExpected[ui32Key] = true;
+
+        // One record per change, none for a repeated value, and a full log
+        // is compacted first
+        check(configLogUsed() == (!bChange ? ui32Used : (ui32Used == configLogSize()) ? 1 : ui32Used + 1), "log use",
+              ui32Count);
+
+        // Write the same value again now and then; it must cost nothing
+        if (ui32Count % 10 == 0) {
+            ui32Used = configLogUsed();
+            configSet(ui32Key, ui32Value);
+            check(configLogUsed() == ui32Used, "repeated value written", ui32Count);
+        }
+
+        if (ui32Count % 101 == 0) {
+            configStoreInit();
+        }
+        if (!storeMatches()) {
+            check(false, "values wrong", ui32Count);
+            return;
+        }
+    }
+
+    printf("%u changes: %.2f words and %.4f erases each, %.1f us modelled; "
+           "a snapshot per change would be %u words and %.2f erases, %.1f us\n",
+           ui32Changes, (double)psCounts->ui32Words / ui32Changes, (double)psCounts->ui32Erases / ui32Changes,
+           (double)psCounts->ui64Us / ui32Changes, 256 / 4, 256.0 / FLASH_MODEL_SECTOR_SIZE,
+           256 / 4 * FLASH_MODEL_WORD_US + 256.0 / FLASH_MODEL_SECTOR_SIZE * FLASH_MODEL_ERASE_US);
+}
+
+//*****************************************************************************/
+// Write random values until the power fails, then reboot, sometimes losing
+// power again while the reboot finishes an interrupted compaction
+//*****************************************************************************/
+static void
+checkPowerLoss(void)
+{
+    uint32_t ui32Trial;
+    uint32_t ui32Key = CONFIG_KEY_COUNT;
+    uint32_t ui32Value = 0;
+    uint32_t ui32Read;
+
+    flashModelErase();
+    configStoreInit();
+    memset(g_pbExpected, 0, sizeof(g_pbExpected));
+
+    for (ui32Trial = 0; ui32Trial < TEST_POWER_LOSSES; ui32Trial++)
+    {
+        // A log holds 512 two-word records, so some trials reach a compaction
+        flashModelPowerLoss(rand() % 1500);
+        while (!flashModelPowerLost())
+        {
+            ui32Key = rand() % CONFIG_KEY_COUNT;
+            ui32Value = randomValue();
+            if (configSet(ui32Key, ui32Value) == 0 && !flashModelPowerLost()) {
+                g_pui32Expected[ui32Key] = ui32Value;
+                g_pbExpected[ui32Key] = true;
+            }
+        }
+
+        if (rand() % 4 == 0) {
+            flashModelPowerLoss(rand() % 1100);
+            configStoreInit();
+        }
+        flashModelPowerLoss(-1);
+        configStoreInit();
+
+        // The key being written when the power failed may hold either value
+        if (configGet(ui32Key, &ui32Read) && ui32Read == ui32Value) {
+            g_pui32Expected[ui32Key] = ui32Value;
+            g_pbExpected[ui32Key] = true;
+        }
+        if (!storeMatches()) {
+            check(false, "values wrong after power loss", ui32Trial);
+            return;
+        }
+
+        // And the store keeps working
+        ui32Key = rand() % CONFIG_KEY_COUNT;
+        ui32Value = randomValue();
+        check(configSet(ui32Key, ui32Value) == 0, "write after power loss failed", ui32Trial);
+        g_pui32Expected[ui32Key] = ui32Value;
+        g_pbExpected[ui32Key] = true;
+    }
+}
+
+//*****************************************************************************/
+// Boot with only an old-format snapshot, holding every other key, and one
+// log record written after it.  The values must be imported and saved in
+// the current format, and the next reboot must find the same values.
+//*****************************************************************************/
+static void
+checkLegacy(void)
+{
+    static tTestSnapshot sSnapshot;
+    uint8_t *pui8Byte = (uint8_t *)&sSnapshot;
+    uint32_t ui32Record[2];
+    uint32_t ui32Key;
+    uint32_t ui32Index;
+    uint32_t ui32Sum = 0;
+
+    flashModelErase();
+    memset(&sSnapshot, 0xFF, sizeof(sSnapshot));
+    memset(g_pbExpected, 0, sizeof(g_pbExpected));
+    sSnapshot.ui32Generation = 7;
+    sSnapshot.pui32Valid[0] = 0;
+    sSnapshot.pui32Valid[1] = 0;
+    for (ui32Key = 0; ui32Key < CONFIG_KEY_COUNT; ui32Key += 2)
+    {
+        sSnapshot.pui32Values[ui32Key] = randomValue();
+        sSnapshot.pui32Valid[ui32Key / 32] |= 1 << (ui32Key % 32);
+        g_pui32Expected[ui32Key] = sSnapshot.pui32Values[ui32Key];
+        g_pbExpected[ui32Key] = true;
+    }
+
+    // Sequence number, then the byte that makes the block sum to zero
+    pui8Byte[0] = 42;
+    pui8Byte[1] = 0;
+    for (ui32Index = 0; ui32Index < TEST_SNAPSHOT_SIZE; ui32Index++)
+    {
+        ui32Sum += pui8Byte[ui32Index];
+    }
+    pui8Byte[1] = (uint8_t)(0 - ui32Sum);
+    FlashProgram((uint32_t *)&sSnapshot, CONFIG_SNAPSHOT_START + 2 * TEST_SNAPSHOT_SIZE, TEST_SNAPSHOT_SIZE);
+
+    // A change to key 1 logged against the old snapshot's generation
+    ui32Record[0] = 1 | (7 << 8);
+    ui32Record[1] = 0x5A5A1234;
+    ui32Record[0] |= (uint32_t)crc16Update(crc16Update(CRC16_INIT, (uint8_t *)ui32Record, 2),
+                                           (uint8_t *)&ui32Record[1], 4) << 16;
+    FlashProgram(ui32Record, CONFIG_LOG_START, 8);
+    g_pui32Expected[1] = 0x5A5A1234;
+    g_pbExpected[1] = true;
+
+    configStoreInit();
+    check(storeMatches(), "old-format snapshot not imported", 0);
+    check(FlashPBGet() != NULL && FlashPBGetLegacy() == NULL, "imported snapshot not saved", 0);
+    check(configLogUsed() == 0, "log not erased after the import", 0);
+
+    configStoreInit();
+    check(storeMatches(), "imported values lost on reboot", 0);
+    check(configSet(2, 99) == 0, "write after the import failed", 0);
+    g_pui32Expected[2] = 99;
+    g_pbExpected[2] = true;
+    configStoreInit();
+    check(storeMatches(), "values wrong after the import", 0);
+}
+
+int
+main(void)
+{
+    if (!flashModelMap(CONFIG_SNAPSHOT_START, CONFIG_LOG_END)) {
+        return 1;
+    }
+
+    srand(9);
+    checkWrites();
+    checkPowerLoss();
+    checkLegacy();
+
+    printf("config_store: %d failures\n", g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
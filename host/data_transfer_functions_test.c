@@ -0,0 +1,409 @@
+/*
+ * data_transfer_functions_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the uDMA ping-pong acquisition path.  The ADC sequence 0
+ * FIFOs and the uDMA channels that drain them are modelled in software: each
+ * conversion goes through the FIFO into the active control structure, a
+ * finished half raises the module's interrupt and switches to the other
+ * structure, and a channel that switches to a stopped structure disables
+ * itself, after which the 8-entry FIFO overflows.  The completion interrupts
+ * run adcDMAComplete() after a random latency, and a consumer drains the
+ * sample ring with random stalls.
+ *
+ * With latencies shorter than a block, every block must be committed in
+ * order with exactly the samples its sequence number implies, on one module
+ * or split across two, and the dropped blocks must be exactly the sequence
+ * gaps.  With latencies longer than two blocks, the overruns must be counted
+ * and the stream must keep going.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -Ihost/stubs -o data_transfer_functions_test host/data_transfer_functions_test.c data_transfer_functions.c sample_buffer.c && ./data_transfer_functions_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Custom project-specific headers
+#include "adc_functions.h"
+#include "data_transfer_functions.h"
+#include "sample_buffer.h"
+#include "timebase.h"
+
+// Tiva C Series libraries
+#include "driverlib/adc.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+#include "inc/hw_memmap.h"
+
+#define TEST_TRIGGERS       2000000
+#define MODEL_FIFO_DEPTH    8
+#define MODEL_CHANNELS      32
+
+// One uDMA control structure
+typedef struct
+{
+    uint32_t ui32Mode;
+    uint16_t *pui16Dst;
+    uint32_t ui32Left;
+}
+tModelStruct;
+
+// One uDMA channel: primary [0] and alternate [1] structures
+typedef struct
+{
+    bool bEnabled;
+    uint32_t ui32Active;
+    tModelStruct psStruct[2];
+}
+tModelChannel;
+
+// Sequence 0 of one ADC module and its interrupt
+typedef struct
+{
+    uint32_t ui32Channel;
+    uint16_t pui16FIFO[MODEL_FIFO_DEPTH];
+    uint32_t ui32FIFOHead;
+    uint32_t ui32FIFOCount;
+    bool bOverflow;
+    uint32_t ui32Conversions;
+    uint32_t ui32Lost;
+    bool bIntPending;
+    uint32_t ui32IntDue;
+}
+tModelADC;
+
+static tModelChannel g_psChannels[MODEL_CHANNELS];
+static tModelADC g_psADC[2];
+
+// Current time in triggers
+static uint32_t g_ui32Now;
+static int g_iFailures;
+
+// Interrupt latency of the running scenario, in triggers: up to
+// g_ui32MaxLatency, or g_ui32LongLatency with odds 1 in g_ui32LongOdds
+static uint32_t g_ui32MaxLatency;
+static uint32_t g_ui32LongLatency;
+static uint32_t g_ui32LongOdds;
+
+//*****************************************************************************/
+// Timebase in nanoseconds, and the latency note the handlers make
+//*****************************************************************************/
+uint64_t
+timebaseNow(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (uint64_t)sNow.tv_sec * 1000000000 + sNow.tv_nsec;
+}
+
+uint64_t
+timebaseTicksToUs(uint64_t ui64Ticks)
+{
+    return ui64Ticks / 1000;
+}
+
+void
+noteSampleLatency(void)
+{
+}
+
+//*****************************************************************************/
+// Model of the uDMA channels
+//*****************************************************************************/
+static tModelADC *
+adcOfBase(uint32_t ui32Base)
+{
+    return &g_psADC[ui32Base == ADC1_BASE];
+}
+
+// Move FIFO entries into the active structure while the channel can take
+// them.  A finished half raises the module interrupt and hands over to the
+// other structure, or disables the channel if that one is stopped.
+static void
+serveFIFO(tModelADC *psADC)
+{
+    tModelChannel *psChannel = &g_psChannels[psADC->ui32Channel];
+    tModelStruct *psStruct;
+
+    while (psADC->ui32FIFOCount && psChannel->bEnabled)
+    {
+        psStruct = &psChannel->psStruct[psChannel->ui32Active];
+        *psStruct->pui16Dst++ = psADC->pui16FIFO[psADC->ui32FIFOHead];
+        psADC->ui32FIFOHead = (psADC->ui32FIFOHead + 1) % MODEL_FIFO_DEPTH;
+        psADC->ui32FIFOCount--;
+
+        if (--psStruct->ui32Left == 0) {
+            psStruct->ui32Mode = UDMA_MODE_STOP;
+            psChannel->ui32Active ^= 1;
+            if (psChannel->psStruct[psChannel->ui32Active].ui32Mode == UDMA_MODE_STOP) {
+                psChannel->bEnabled = false;
+            }
+            if (!psADC->bIntPending) {
+                psADC->bIntPending = true;
+                psADC->ui32IntDue = g_ui32Now + ((g_ui32LongOdds && rand() % g_ui32LongOdds == 0) ?
+                                                 g_ui32LongLatency : rand() % (g_ui32MaxLatency + 1));
+            }
+        }
+    }
+}
+
+void
+uDMAChannelTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode, void *pvSrcAddr, void *pvDstAddr,
+                       uint32_t ui32TransferSize)
+{
+    tModelStruct *psStruct = &g_psChannels[ui32ChannelStructIndex & 0x1F].psStruct[(ui32ChannelStructIndex &
+                                                                                   UDMA_ALT_SELECT) != 0];
+
+    (void)pvSrcAddr;
+    psStruct->ui32Mode = ui32Mode;
+    psStruct->pui16Dst = pvDstAddr;
+    psStruct->ui32Left = ui32TransferSize;
+}
+
+uint32_t
+uDMAChannelModeGet(uint32_t ui32ChannelStructIndex)
+{
+    return g_psChannels[ui32ChannelStructIndex & 0x1F].psStruct[(ui32ChannelStructIndex & UDMA_ALT_SELECT) != 0]
+           .ui32Mode;
+}
+
+void
+uDMAChannelEnable(uint32_t ui32ChannelNum)
+{
+    g_psChannels[ui32ChannelNum].bEnabled = true;
+    serveFIFO(&g_psADC[ui32ChannelNum == UDMA_SEC_CHANNEL_ADC10]);
+}
+
+void
+uDMAChannelDisable(uint32_t ui32ChannelNum)
+{
+    g_psChannels[ui32ChannelNum].bEnabled = false;
+}
+
+bool
+uDMAChannelIsEnabled(uint32_t ui32ChannelNum)
+{
+    return g_psChannels[ui32ChannelNum].bEnabled;
+}
+
+void
+uDMAChannelAttributeDisable(uint32_t ui32ChannelNum, uint32_t ui32Attr)
+{
+    if (ui32Attr & UDMA_ATTR_ALTSELECT) {
+        g_psChannels[ui32ChannelNum].ui32Active = 0;
+    }
+}
+
+void uDMAChannelAttributeEnable(uint32_t ui32ChannelNum, uint32_t ui32Attr) { (void)ui32ChannelNum; (void)ui32Attr; }
+void uDMAChannelControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control) { (void)ui32ChannelStructIndex; (void)ui32Control; }
+void uDMAChannelAssign(uint32_t ui32Mapping) { (void)ui32Mapping; }
+void uDMAEnable(void) { }
+void uDMAControlBaseSet(void *pControlTable) { (void)pControlTable; }
+uint32_t uDMAErrorStatusGet(void) { return 0; }
+void uDMAErrorStatusClear(void) { }
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral) { (void)ui32Peripheral; }
+void IntEnable(uint32_t ui32Interrupt) { (void)ui32Interrupt; }
+void IntDisable(uint32_t ui32Interrupt) { (void)ui32Interrupt; }
+
+//*****************************************************************************/
+// Model of ADC sequence 0
+//*****************************************************************************/
+int32_t
+ADCSequenceOverflow(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    (void)ui32SequenceNum;
+    return adcOfBase(ui32Base)->bOverflow;
+}
+
+void
+ADCSequenceOverflowClear(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    (void)ui32SequenceNum;
+    adcOfBase(ui32Base)->bOverflow = false;
+}
+
+void
+ADCIntClear(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    (void)ui32SequenceNum;
+    adcOfBase(ui32Base)->bIntPending = false;
+}
+
+void ADCIntEnable(uint32_t ui32Base, uint32_t ui32SequenceNum) { (void)ui32Base; (void)ui32SequenceNum; }
+void ADCIntDisable(uint32_t ui32Base, uint32_t ui32SequenceNum) { (void)ui32Base; (void)ui32SequenceNum; }
+void ADCSequenceEnable(uint32_t ui32Base, uint32_t ui32SequenceNum) { (void)ui32Base; (void)ui32SequenceNum; }
+void ADCSequenceDisable(uint32_t ui32Base, uint32_t ui32SequenceNum) { (void)ui32Base; (void)ui32SequenceNum; }
+void ADCSequenceDMAEnable(uint32_t ui32Base, uint32_t ui32SequenceNum) { (void)ui32Base; (void)ui32SequenceNum; }
+void ADCSequenceDMADisable(uint32_t ui32Base, uint32_t ui32SequenceNum) { (void)ui32Base; (void)ui32SequenceNum; }
+
+// One conversion: module 0 counts up from 0, module 1 from 2048
+static void
+convert(uint32_t ui32Module)
+{
+    tModelADC *psADC = &g_psADC[ui32Module];
+    uint16_t ui16Value = (uint16_t)((psADC->ui32Conversions++ + ui32Module * 2048) & 0xFFF);
+
+    if (psADC->ui32FIFOCount == MODEL_FIFO_DEPTH) {
+        psADC->bOverflow = true;
+        psADC->ui32Lost++;
+        return;
+    }
+
+    psADC->pui16FIFO[(psADC->ui32FIFOHead + psADC->ui32FIFOCount++) % MODEL_FIFO_DEPTH] = ui16Value;
+    serveFIFO(psADC);
+}
+
+// Run the handlers of the interrupts that are due
+static void
+serveInterrupts(uint32_t ui32Modules)
+{
+    uint32_t ui32Module;
+
+    for (ui32Module = 0; ui32Module < ui32Modules; ui32Module++)
+    {
+        if (g_psADC[ui32Module].bIntPending && g_psADC[ui32Module].ui32IntDue <= g_ui32Now) {
+            (ui32Module ? ADC1SS0IntHandler : ADC0SS0IntHandler)();
+        }
+    }
+}
+
+//*****************************************************************************/
+// Run one scenario: each trigger converts ui32Channels0 channels on ADC0 and
+// ui32Channels1 on ADC1, and a block holds ui32Sets triggers.  Each interrupt
+// is served at most ui32MaxLatency triggers after it was raised, or after
+// ui32LongLatency with probability 1 in ui32LongOdds.
+//*****************************************************************************/
+static void
+runScenario(const char *pcName, uint32_t ui32Sets, uint32_t ui32Channels0, uint32_t ui32Channels1,
+            uint32_t ui32MaxLatency, uint32_t ui32LongLatency, uint32_t ui32LongOdds)
+{
+    uint32_t ui32Modules = ui32Channels1 ? 2 : 1;
+    uint32_t pui32Channels[2] = { ui32Channels0, ui32Channels1 };
+    uint32_t pui32Counts[2] = { ui32Sets * ui32Channels0, ui32Sets * ui32Channels1 };
+    uint32_t ui32Count0 = pui32Counts[0];
+    uint32_t ui32Count1 = pui32Counts[1];
+    tSampleBlock *psBlock;
+    uint32_t ui32Module;
+    uint32_t ui32Channel;
+    uint32_t ui32Expected = 0;
+    uint32_t ui32Received = 0;
+    uint32_t ui32LastReceived = 0;
+    uint32_t ui32Gaps = 0;
+    uint32_t ui32Index;
+    uint32_t ui32StallUntil = 0;
+    uint16_t ui16Value;
+    bool bExact = (ui32LongOdds == 0);
+    bool bBad = false;
+
+    memset(g_psChannels, 0, sizeof(g_psChannels));
+    memset(g_psADC, 0, sizeof(g_psADC));
+    g_psADC[0].ui32Channel = UDMA_CHANNEL_ADC0;
+    g_psADC[1].ui32Channel = UDMA_SEC_CHANNEL_ADC10;
+    g_ui32MaxLatency = ui32MaxLatency;
+    g_ui32LongLatency = ui32LongLatency;
+    g_ui32LongOdds = ui32LongOdds;
+
+    sampleBufferInit();
+    configureADCDMA();
+    startADCDMA(ui32Count0, ui32Count1);
+
+    for (g_ui32Now = 0; g_ui32Now < TEST_TRIGGERS; g_ui32Now++)
+    {
+        // ADC0's sequence finishes first, and its interrupt may be served
+        // before ADC1's sequence does
+        for (ui32Module = 0; ui32Module < ui32Modules; ui32Module++)
+        {
+            for (ui32Channel = 0; ui32Channel < pui32Channels[ui32Module]; ui32Channel++)
+            {
+                convert(ui32Module);
+            }
+            serveInterrupts(ui32Modules);
+        }
+
+        // The consumer drains everything waiting, then stalls now and then
+        // long enough to fill the ring
+        if (g_ui32Now < ui32StallUntil) {
+            continue;
+        }
+        while ((psBlock = sampleBufferPeek()) != NULL && !bBad)
+        {
+            if (psBlock->ui32Seq < ui32Expected || psBlock->ui32Count != ui32Count0 + ui32Count1) {
+                printf("FAIL: %s: block %u of %u samples after %u\n", pcName, psBlock->ui32Seq,
+                       psBlock->ui32Count, ui32Expected);
+                bBad = true;
+            }
+
+            // Each region holds the module's conversions for this block
+            for (ui32Module = 0; ui32Module < ui32Modules && bExact; ui32Module++)
+            {
+                for (ui32Index = 0; ui32Index < pui32Counts[ui32Module]; ui32Index++)
+                {
+                    ui16Value = (uint16_t)((psBlock->ui32Seq * pui32Counts[ui32Module] + ui32Index +
+                                            ui32Module * 2048) & 0xFFF);
+                    if (psBlock->pui16Data[ui32Module * ui32Count0 + ui32Index] != ui16Value) {
+                        printf("FAIL: %s: block %u, module %u, sample %u\n", pcName, psBlock->ui32Seq, ui32Module,
+                               ui32Index);
+                        bBad = true;
+                        break;
+                    }
+                }
+            }
+
+            ui32Gaps += psBlock->ui32Seq - ui32Expected;
+            ui32Expected = psBlock->ui32Seq + 1;
+            ui32Received++;
+            ui32LastReceived = g_ui32Now;
+            sampleBufferRelease();
+        }
+        if (rand() % 2000 == 0) {
+            ui32StallUntil = g_ui32Now + rand() % (2 * SAMPLE_BUFFER_BLOCKS * ui32Sets);
+        }
+    }
+
+    stopADCDMA();
+
+    // Blocks dropped after the last one received are still in flight or
+    // committed; only the gaps before it are checked
+    if (bBad || ui32Received == 0 || ui32Gaps > sampleBufferDropped() ||
+        (bExact && (g_psADC[0].ui32Lost || g_psADC[1].ui32Lost || getADCDMAOverruns())) ||
+        (!bExact && (getADCDMAOverruns() == 0 || g_ui32Now - ui32LastReceived > 4 * SAMPLE_BUFFER_BLOCKS * ui32Sets))) {
+        printf("FAIL: %s: %u received, %u gaps, %u dropped, %u and %u conversions lost, %u overruns\n", pcName,
+               ui32Received, ui32Gaps, sampleBufferDropped(), g_psADC[0].ui32Lost, g_psADC[1].ui32Lost,
+               getADCDMAOverruns());
+        g_iFailures++;
+    }
+
+    printf("%s: %u blocks received, %u dropped, %u overruns, %u conversions lost\n", pcName, ui32Received,
+           sampleBufferDropped(), getADCDMAOverruns(), g_psADC[0].ui32Lost + g_psADC[1].ui32Lost);
+}
+
+int
+main(void)
+{
+    srand(17);
+
+    // Interrupts always served within the block: nothing may be lost, and
+    // only the consumer's stalls drop blocks
+    runScenario("ADC0, 1 channel", SAMPLE_BLOCK_SIZE, 1, 0, SAMPLE_BLOCK_SIZE - 1, 0, 0);
+    runScenario("ADC0, 4 channels", SAMPLE_BLOCK_SIZE / 4, 4, 0, SAMPLE_BLOCK_SIZE / 4 - 1, 0, 0);
+    runScenario("ADC0 and ADC1, 1 + 1 channels", SAMPLE_BLOCK_SIZE / 2, 1, 1, SAMPLE_BLOCK_SIZE / 2 - 1, 0, 0);
+    runScenario("ADC0 and ADC1, 3 + 2 channels", SAMPLE_BLOCK_SIZE / 5, 3, 2, SAMPLE_BLOCK_SIZE / 5 - 1, 0, 0);
+
+    // Now and then an interrupt held off for more than both halves
+    runScenario("ADC0, held off", SAMPLE_BLOCK_SIZE, 1, 0, 8, 3 * SAMPLE_BLOCK_SIZE, 500);
+    runScenario("ADC0 and ADC1, held off", SAMPLE_BLOCK_SIZE / 5, 3, 2, 4, SAMPLE_BLOCK_SIZE, 500);
+
+    printf("data_transfer_functions: %d failures\n", g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * decimator_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the CIC decimator.  For every supported factor and stage
+ * count, random 12-bit input (plus a full-scale stretch that wraps the
+ * integrators) is decimated in uneven, in-place pieces and compared with a
+ * double-precision direct convolution by the CIC impulse response, scaled
+ * the same way: the outputs must be identical.  Also prints the host cost
+ * per input sample.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -o decimator_test host/decimator_test.c decimator.c && ./decimator_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Custom project-specific headers
+#include "decimator.h"
+
+#define TEST_SAMPLES        (1 << 18)
+#define BENCH_SAMPLES       (1 << 22)
+
+static uint16_t g_pui16Input[TEST_SAMPLES];
+static uint16_t g_pui16Work[TEST_SAMPLES];
+static double g_pdImpulse[DECIMATOR_MAX_STAGES * (DECIMATOR_MAX_FACTOR - 1) + 1];
+
+//*****************************************************************************/
+// Impulse response of ui32Stages boxcars of length ui32Factor.  Returns its
+// length.
+//*****************************************************************************/
+static uint32_t
+makeImpulse(uint32_t ui32Factor, uint32_t ui32Stages)
+{
+    static double pdNext[DECIMATOR_MAX_STAGES * (DECIMATOR_MAX_FACTOR - 1) + 1];
+    uint32_t ui32Length = 1;
+    uint32_t ui32Stage;
+    uint32_t ui32Index;
+    uint32_t ui32Tap;
+
+    g_pdImpulse[0] = 1.0;
+    for (ui32Stage = 0; ui32Stage < ui32Stages; ui32Stage++)
+    {
+        memset(pdNext, 0, sizeof(pdNext));
+        for (ui32Index = 0; ui32Index < ui32Length; ui32Index++)
+        {
+            for (ui32Tap = 0; ui32Tap < ui32Factor; ui32Tap++)
+            {
+                pdNext[ui32Index + ui32Tap] += g_pdImpulse[ui32Index];
+            }
+        }
+        ui32Length += ui32Factor - 1;
+        memcpy(g_pdImpulse, pdNext, ui32Length * sizeof(double));
+    }
+
+    return ui32Length;
+}
+
+//*****************************************************************************/
+// Reference output m: the filter at input n = (m + 1) * factor - 1, with the
+// gain removed and the result left-justified to 16 bits as the firmware does
+//*****************************************************************************/
+static uint16_t
+referenceOutput(uint32_t ui32Output, uint32_t ui32Factor, uint32_t ui32Log2, uint32_t ui32Stages,
+                uint32_t ui32Length)
+{
+    int32_t i32Input = (int32_t)((ui32Output + 1) * ui32Factor - 1);
+    uint32_t ui32Shift = ui32Stages * ui32Log2;
+    uint32_t ui32Tap;
+    double dSum = 0.0;
+    uint64_t ui64Value;
+
+    for (ui32Tap = 0; ui32Tap < ui32Length && (int32_t)ui32Tap <= i32Input; ui32Tap++)
+    {
+        dSum += g_pdImpulse[ui32Tap] * g_pui16Input[i32Input - ui32Tap];
+    }
+
+    ui64Value = (uint64_t)dSum;
+    ui64Value = (ui32Shift >= 4) ? (ui64Value >> (ui32Shift - 4)) : (ui64Value << (4 - ui32Shift));
+    return (ui64Value > 0xFFFF) ? 0xFFFF : (uint16_t)ui64Value;
+}
+
+int
+main(void)
+{
+    tDecimator sDec;
+    struct timespec sStart;
+    struct timespec sEnd;
+    uint32_t ui32Factor;
+    uint32_t ui32Log2;
+    uint32_t ui32Stages;
+    uint32_t ui32Length;
+    uint32_t ui32Pos;
+    uint32_t ui32Piece;
+    uint32_t ui32Outputs;
+    uint32_t ui32Index;
+    uint32_t ui32Configs = 0;
+    int iFailures = 0;
+
+    // Random codes, then a full-scale stretch long enough to wrap every
+    // integrator
+    srand(11);
+    for (ui32Index = 0; ui32Index < TEST_SAMPLES; ui32Index++)
+    {
+        g_pui16Input[ui32Index] = (ui32Index < TEST_SAMPLES / 2) ? (uint16_t)(rand() & 0xFFF) : 4095;
+    }
+
+    if (decimatorInit(&sDec, 3, 1) || decimatorInit(&sDec, 512, 1) || decimatorInit(&sDec, 2, 0) ||
+        decimatorInit(&sDec, 2, DECIMATOR_MAX_STAGES + 1) || decimatorInit(&sDec, 256, 3)) {
+        printf("FAIL: unsupported configuration accepted\n");
+        iFailures++;
+    }
+
+    for (ui32Stages = 1; ui32Stages <= DECIMATOR_MAX_STAGES; ui32Stages++)
+    {
+        for (ui32Log2 = 0, ui32Factor = 1; ui32Factor <= DECIMATOR_MAX_FACTOR; ui32Log2++, ui32Factor <<= 1)
+        {
+            if (!decimatorInit(&sDec, ui32Factor, ui32Stages)) {
+                if (ui32Stages * ui32Log2 <= DECIMATOR_MAX_GROWTH) {
+                    printf("FAIL: /%u with %u stages rejected\n", ui32Factor, ui32Stages);
+                    iFailures++;
+                }
+                continue;
+            }
+            ui32Configs++;
+
+            // Uneven pieces, each decimated in place
+            memcpy(g_pui16Work, g_pui16Input, sizeof(g_pui16Work));
+            ui32Outputs = 0;
+            for (ui32Pos = 0; ui32Pos < TEST_SAMPLES; ui32Pos += ui32Piece)
+            {
+                ui32Piece = 1 + rand() % 300;
+                if (ui32Piece > TEST_SAMPLES - ui32Pos) {
+                    ui32Piece = TEST_SAMPLES - ui32Pos;
+                }
+                memmove(&g_pui16Work[ui32Outputs], &g_pui16Work[ui32Pos], ui32Piece * sizeof(uint16_t));
+                ui32Outputs += decimatorProcess(&sDec, &g_pui16Work[ui32Outputs], ui32Piece, &g_pui16Work[ui32Outputs]);
+            }
+            if (ui32Outputs != TEST_SAMPLES / ui32Factor) {
+                printf("FAIL: /%u with %u stages: %u outputs\n", ui32Factor, ui32Stages, ui32Outputs);
+                iFailures++;
+                continue;
+            }
+
+            ui32Length = makeImpulse(ui32Factor, ui32Stages);
+            for (ui32Index = 0; ui32Index < ui32Outputs; ui32Index++)
+            {
+                if (g_pui16Work[ui32Index] != referenceOutput(ui32Index, ui32Factor, ui32Log2, ui32Stages, ui32Length)) {
+                    printf("FAIL: /%u with %u stages: output %u is %u, reference %u\n", ui32Factor, ui32Stages,
+                           ui32Index, g_pui16Work[ui32Index],
+                           referenceOutput(ui32Index, ui32Factor, ui32Log2, ui32Stages, ui32Length));
+                    iFailures++;
+                    break;
+                }
+            }
+
+            // Full scale at DC settles to 4095 << 4
+            if (g_pui16Work[ui32Outputs - 1] != 4095 << 4) {
+                printf("FAIL: /%u with %u stages: full scale gives %u\n", ui32Factor, ui32Stages,
+                       g_pui16Work[ui32Outputs - 1]);
+                iFailures++;
+            }
+        }
+    }
+
+    // Host cost per input sample, in place over whole blocks
+    for (ui32Stages = 1; ui32Stages <= DECIMATOR_MAX_STAGES; ui32Stages++)
+    {
+        decimatorInit(&sDec, 16, ui32Stages);
+        clock_gettime(CLOCK_MONOTONIC, &sStart);
+        for (ui32Pos = 0; ui32Pos < BENCH_SAMPLES; ui32Pos += TEST_SAMPLES)
+        {
+            memcpy(g_pui16Work, g_pui16Input, sizeof(g_pui16Work));
+            decimatorProcess(&sDec, g_pui16Work, TEST_SAMPLES, g_pui16Work);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &sEnd);
+        printf("/16 with %u stages: %.2f ns per input sample\n", ui32Stages,
+               ((sEnd.tv_sec - sStart.tv_sec) * 1e9 + (sEnd.tv_nsec - sStart.tv_nsec)) / BENCH_SAMPLES);
+    }
+
+    printf("decimator: %u configurations checked, %d failures\n", ui32Configs, iFailures);
+    return iFailures ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * event_capture_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the event capture on synthetic waveforms.  Quiet noise
+ * about mid-scale carries spikes, steps and bursts at known blocks; for each
+ * trigger mode the blocks reaching the sink must be exactly the pre-trigger
+ * history, the triggering block and the post-trigger window (extended by a
+ * trigger inside it), in order, with their contents, sequence numbers and
+ * sample numbers unchanged.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -o event_capture_test host/event_capture_test.c event_capture.c && ./event_capture_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "adc_functions.h"
+#include "sample_buffer.h"
+#include "sample_sink.h"
+#include "event_capture.h"
+
+#define TEST_BLOCKS         64
+
+tAcqConfig g_sAcqConfig;
+
+static tSampleBlock g_psBlocks[TEST_BLOCKS];
+
+// Sequence numbers of the blocks written to the sink, in order
+static uint32_t g_pui32Written[TEST_BLOCKS];
+static uint32_t g_ui32Written;
+static int g_iFailures;
+
+//*****************************************************************************/
+// Sink that records and checks what it is given
+//*****************************************************************************/
+static void
+recordWrite(const tSampleBlock *psBlock, uint32_t ui32Count, uint64_t ui64FirstSample)
+{
+    const tSampleBlock *psOriginal = &g_psBlocks[psBlock->ui32Seq];
+
+    if (ui32Count != SAMPLE_BLOCK_SIZE || ui64FirstSample != (uint64_t)psBlock->ui32Seq * SAMPLE_BLOCK_SIZE ||
+        memcmp(psBlock->pui16Data, psOriginal->pui16Data, sizeof(psOriginal->pui16Data)) != 0) {
+        printf("FAIL: block %u altered\n", psBlock->ui32Seq);
+        g_iFailures++;
+    }
+
+    if (g_ui32Written < TEST_BLOCKS) {
+        g_pui32Written[g_ui32Written++] = psBlock->ui32Seq;
+    }
+}
+
+static const tSampleSink g_sRecordSink = { "record", NULL, recordWrite, NULL, NULL };
+
+//*****************************************************************************/
+// Fill every block with noise of a few codes about mid-scale, in 12-bit or
+// 16-bit codes
+//*****************************************************************************/
+static void
+makeQuiet(uint32_t ui32Shift)
+{
+    uint32_t ui32Block;
+    uint32_t ui32Index;
+
+    srand(5);
+    for (ui32Block = 0; ui32Block < TEST_BLOCKS; ui32Block++)
+    {
+        g_psBlocks[ui32Block].ui32Seq = ui32Block;
+        g_psBlocks[ui32Block].ui32Count = SAMPLE_BLOCK_SIZE;
+        for (ui32Index = 0; ui32Index < SAMPLE_BLOCK_SIZE; ui32Index++)
+        {
+            g_psBlocks[ui32Block].pui16Data[ui32Index] = (uint16_t)((2048 + rand() % 7 - 3) << ui32Shift);
+        }
+    }
+}
+
+//*****************************************************************************/
+// Run every block through the capture and compare the sink's blocks with the
+// expected list (terminated by TEST_BLOCKS)
+//*****************************************************************************/
+static void
+runCapture(const char *pcName, const uint32_t *pui32Expected, uint32_t ui32Events)
+{
+    uint32_t ui32Block;
+    uint32_t ui32Count = 0;
+
+    g_ui32Written = 0;
+    eventCaptureStart(&g_sRecordSink);
+    for (ui32Block = 0; ui32Block < TEST_BLOCKS; ui32Block++)
+    {
+        eventCaptureBlock(&g_psBlocks[ui32Block], SAMPLE_BLOCK_SIZE, (uint64_t)ui32Block * SAMPLE_BLOCK_SIZE);
+    }
+
+    while (pui32Expected[ui32Count] != TEST_BLOCKS)
+    {
+        ui32Count++;
+    }
+
+    if (g_ui32Written != ui32Count || memcmp(g_pui32Written, pui32Expected, ui32Count * sizeof(uint32_t)) != 0 ||
+        eventCaptureEvents() != ui32Events || eventCaptureBlocksWritten() != ui32Count) {
+        printf("FAIL: %s: %u events, blocks", pcName, eventCaptureEvents());
+        for (ui32Block = 0; ui32Block < g_ui32Written; ui32Block++)
+        {
+            printf(" %u", g_pui32Written[ui32Block]);
+        }
+        printf("\n");
+        g_iFailures++;
+    }
+}
+
+int
+main(void)
+{
+    // Spikes in blocks 10, 30 and 32: the second window is extended by the
+    // third spike
+    const uint32_t pui32Level[] = { 8, 9, 10, 11, 12, 13, 28, 29, 30, 31, 32, 33, 34, 35, TEST_BLOCKS };
+    const uint32_t pui32LevelNoPre[] = { 10, 11, 12, 13, 30, 31, 32, 33, 34, 35, TEST_BLOCKS };
+    // Four blocks of history and a step in block 2.  The spike at the end of
+    // block 32 falls back at the start of block 33, which extends the window
+    // once more.
+    const uint32_t pui32Slope[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+                                    35, 36, TEST_BLOCKS };
+    // A burst filling block 40; single spikes are too short for the RMS
+    const uint32_t pui32Rms[] = { 39, 40, 41, TEST_BLOCKS };
+    uint32_t ui32Shift;
+    uint32_t ui32Index;
+
+    g_sAcqConfig.ui32NumChannels = 1;
+
+    for (ui32Shift = 0; ui32Shift <= 4; ui32Shift += 4)
+    {
+        g_sAcqConfig.ui32Decimation = ui32Shift ? 16 : 1;
+        makeQuiet(ui32Shift);
+
+        g_psBlocks[10].pui16Data[17] = (uint16_t)((2048 + 300) << ui32Shift);
+        g_psBlocks[30].pui16Data[0] = (uint16_t)((2048 - 300) << ui32Shift);
+        g_psBlocks[32].pui16Data[SAMPLE_BLOCK_SIZE - 1] = (uint16_t)((2048 + 300) << ui32Shift);
+
+        g_sAcqConfig.ui32EventMode = EVENT_MODE_LEVEL;
+        g_sAcqConfig.ui32EventThreshold = 200;
+        g_sAcqConfig.ui32EventPreBlocks = 2;
+        g_sAcqConfig.ui32EventPostBlocks = 3;
+        runCapture("level", pui32Level, 2);
+
+        g_sAcqConfig.ui32EventPreBlocks = 0;
+        runCapture("level without history", pui32LevelNoPre, 2);
+
+        // A 100-code step starting at the first sample of block 2
+        for (ui32Index = 2 * SAMPLE_BLOCK_SIZE; ui32Index < TEST_BLOCKS * SAMPLE_BLOCK_SIZE; ui32Index++)
+        {
+            g_psBlocks[ui32Index / SAMPLE_BLOCK_SIZE].pui16Data[ui32Index % SAMPLE_BLOCK_SIZE] += 100 << ui32Shift;
+        }
+        g_sAcqConfig.ui32EventPreBlocks = 4;
+        g_sAcqConfig.ui32EventMode = EVENT_MODE_SLOPE;
+        g_sAcqConfig.ui32EventThreshold = 50;
+        runCapture("slope", pui32Slope, 3);
+
+        // Undo the step and add a 150-code square burst in block 40
+        makeQuiet(ui32Shift);
+        g_psBlocks[10].pui16Data[17] = (uint16_t)((2048 + 300) << ui32Shift);
+        for (ui32Index = 0; ui32Index < SAMPLE_BLOCK_SIZE; ui32Index++)
+        {
+            g_psBlocks[40].pui16Data[ui32Index] = (uint16_t)((2048 + ((ui32Index & 2) ? 150 : -150)) << ui32Shift);
+        }
+        g_sAcqConfig.ui32EventMode = EVENT_MODE_RMS;
+        g_sAcqConfig.ui32EventThreshold = 100;
+        g_sAcqConfig.ui32EventPreBlocks = 1;
+        g_sAcqConfig.ui32EventPostBlocks = 1;
+        runCapture("rms", pui32Rms, 1);
+    }
+
+    printf("event_capture: %d failures\n", g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * fir_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the FIR designs.  Every design the firmware accepts is
+ * run through firProcess() and its measured gain checked: unity at DC, a
+ * notch at least 20 dB deep with the gain at Nyquist within 1 dB, a low-pass
+ * 6 dB down at its cutoff and at least 30 dB down at Nyquist.  50 and 60 Hz
+ * notches at 1 kHz must be accepted, with more taps than at 500 Hz, and
+ * low-pass cutoffs too low for FIR_MAX_TAPS to realize must be rejected.
+ * The filter output is also compared with a double-precision convolution of
+ * the same Q15 taps.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -o fir_test host/fir_test.c fir.c -lm && ./fir_test
+ */
+
+// Standard C libraries
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Custom project-specific headers
+#include "sample_buffer.h"
+#include "fir.h"
+
+// Test tone amplitude in codes, samples left for the filter to settle and
+// samples measured
+#define TONE_AMPLITUDE      1000.0
+#define SETTLE_SAMPLES      (4 * FIR_MAX_TAPS)
+#define MEASURE_SAMPLES     (64 * FIR_MAX_BLOCK)
+
+static int g_iFailures;
+
+//*****************************************************************************/
+// Record a failed check
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, double dFreq, double dValue)
+{
+    if (!bPass) {
+        printf("FAIL: %s at %.4f: %.2f\n", pcWhat, dFreq, dValue);
+        g_iFailures++;
+    }
+}
+
+//*****************************************************************************/
+// Filter a tone at dFreq (cycles per sample) and return its measured gain in
+// dB.  dFreq of 0 gives the gain of a DC offset.
+//*****************************************************************************/
+static double
+measureGainDb(const tFIRCoeffs *psCoeffs, double dFreq)
+{
+    tFIRFilter sFilter;
+    uint16_t pui16Block[FIR_MAX_BLOCK];
+    uint32_t ui32Sample = 0;
+    uint32_t ui32Index;
+    double dOmega = 2.0 * M_PI * dFreq;
+    double dRe = 0.0;
+    double dIm = 0.0;
+    double dOut;
+
+    firInit(&sFilter, psCoeffs);
+
+    while (ui32Sample < SETTLE_SAMPLES + MEASURE_SAMPLES)
+    {
+        for (ui32Index = 0; ui32Index < FIR_MAX_BLOCK; ui32Index++)
+        {
+            pui16Block[ui32Index] = (uint16_t)lround(2048.0 + TONE_AMPLITUDE * cos(dOmega * (ui32Sample + ui32Index)));
+        }
+        firProcess(&sFilter, pui16Block, FIR_MAX_BLOCK);
+
+        for (ui32Index = 0; ui32Index < FIR_MAX_BLOCK; ui32Index++, ui32Sample++)
+        {
+            if (ui32Sample < SETTLE_SAMPLES) {
+                continue;
+            }
+            dOut = pui16Block[ui32Index] - 2048.0;
+            dRe += dOut * cos(dOmega * ui32Sample);
+            dIm += dOut * sin(dOmega * ui32Sample);
+        }
+    }
+
+    // Correlating DC or Nyquist with cos gives the full amplitude, other
+    // frequencies half of it
+    if (dFreq == 0.0 || dFreq == 0.5) {
+        dOut = sqrt(dRe * dRe + dIm * dIm) / MEASURE_SAMPLES;
+    }
+    else {
+        dOut = 2.0 * sqrt(dRe * dRe + dIm * dIm) / MEASURE_SAMPLES;
+    }
+
+    return 20.0 * log10(dOut / TONE_AMPLITUDE + 1e-9);
+}
+
+//*****************************************************************************/
+// Compare firProcess() with a double-precision convolution of the same taps
+// on pseudo-random input.  Outputs may differ by the final rounding only.
+//*****************************************************************************/
+static void
+compareConvolution(const tFIRCoeffs *psCoeffs, double dFreq)
+{
+    static uint16_t pui16Input[16 * FIR_MAX_BLOCK];
+    tFIRFilter sFilter;
+    uint16_t pui16Block[FIR_MAX_BLOCK];
+    uint32_t ui32Block;
+    uint32_t ui32Index;
+    uint32_t ui32Tap;
+    int32_t i32Input;
+    double dSum;
+    double dWorst = 0.0;
+
+    // Stay clear of the rails so clamping does not mask differences
+    for (ui32Index = 0; ui32Index < 16 * FIR_MAX_BLOCK; ui32Index++)
+    {
+        pui16Input[ui32Index] = (uint16_t)(1024 + rand() % 2048);
+    }
+
+    firInit(&sFilter, psCoeffs);
+    for (ui32Block = 0; ui32Block < 16; ui32Block++)
+    {
+        for (ui32Index = 0; ui32Index < FIR_MAX_BLOCK; ui32Index++)
+        {
+            pui16Block[ui32Index] = pui16Input[ui32Block * FIR_MAX_BLOCK + ui32Index];
+        }
+        firProcess(&sFilter, pui16Block, FIR_MAX_BLOCK);
+
+        // Coefficients are time-reversed: tap t multiplies input n - (taps - 1 - t)
+        for (ui32Index = 0; ui32Index < FIR_MAX_BLOCK; ui32Index++)
+        {
+            dSum = 0.0;
+            for (ui32Tap = 0; ui32Tap < psCoeffs->ui32Taps; ui32Tap++)
+            {
+                i32Input = (int32_t)(ui32Block * FIR_MAX_BLOCK + ui32Index) -
+                           ((int32_t)psCoeffs->ui32Taps - 1 - (int32_t)ui32Tap);
+                if (i32Input >= 0) {
+                    dSum += psCoeffs->pi16Coeffs[ui32Tap] / 32768.0 * (pui16Input[i32Input] - 2048.0);
+                }
+            }
+            dSum = fabs(dSum + 2048.0 - pui16Block[ui32Index]);
+            if (dSum > dWorst) {
+                dWorst = dSum;
+            }
+        }
+    }
+
+    check(dWorst <= 0.5 + 1e-6, "convolution difference", dFreq, dWorst);
+}
+
+//*****************************************************************************/
+// A mains notch: accepted, with its tap count, depth and pass-band gains
+//*****************************************************************************/
+static void
+checkMains(tFIRCoeffs *psCoeffs, double dNotchHz, double dRateHz)
+{
+    double dFreq = dNotchHz / dRateHz;
+    double dGain;
+
+    if (!firDesignNotch(psCoeffs, (float)dFreq)) {
+        check(false, "mains notch rejected", dFreq, dRateHz);
+        return;
+    }
+
+    dGain = measureGainDb(psCoeffs, dFreq);
+    printf("%.0f Hz notch at %.0f Hz: %u taps, %.1f dB at %.0f Hz, %.2f dB at DC, %.2f dB at Nyquist\n", dNotchHz,
+           dRateHz, psCoeffs->ui32Taps, dGain, dNotchHz, measureGainDb(psCoeffs, 0.0), measureGainDb(psCoeffs, 0.5));
+    check(dGain <= -20.0, "mains notch depth", dFreq, dGain);
+}
+
+int
+main(void)
+{
+    tFIRCoeffs sCoeffs;
+    uint32_t ui32Step;
+    uint32_t ui32Notches = 0;
+    uint32_t ui32LowPasses = 0;
+    uint32_t ui32Taps;
+    double dFreq;
+    double dGain;
+
+    // The mains cases from the firmware documentation and review.  At 1 kHz
+    // the stop band of the shortest filter reaches DC, so these need more
+    // taps than at 500 Hz.
+    checkMains(&sCoeffs, 50.0, 500.0);
+    check(sCoeffs.ui32Taps == FIR_MIN_TAPS, "50 Hz notch at 500 Hz taps", 0.1, sCoeffs.ui32Taps);
+    checkMains(&sCoeffs, 50.0, 1000.0);
+    check(sCoeffs.ui32Taps > FIR_MIN_TAPS, "50 Hz notch at 1 kHz taps", 0.05, sCoeffs.ui32Taps);
+    checkMains(&sCoeffs, 60.0, 1000.0);
+    check(sCoeffs.ui32Taps > FIR_MIN_TAPS, "60 Hz notch at 1 kHz taps", 0.06, sCoeffs.ui32Taps);
+
+    // Every accepted notch must do what the firmware promises
+    for (ui32Step = 1; ui32Step < 100; ui32Step++)
+    {
+        dFreq = ui32Step * 0.005;
+        if (!firDesignNotch(&sCoeffs, (float)dFreq)) {
+            continue;
+        }
+        ui32Notches++;
+
+        dGain = measureGainDb(&sCoeffs, 0.0);
+        check(fabs(dGain) < 0.01, "notch gain at DC", dFreq, dGain);
+        dGain = measureGainDb(&sCoeffs, dFreq);
+        check(dGain <= -19.5, "notch depth", dFreq, dGain);
+        dGain = measureGainDb(&sCoeffs, 0.5);
+        check(fabs(dGain) <= 1.1, "notch gain at Nyquist", dFreq, dGain);
+        compareConvolution(&sCoeffs, dFreq);
+    }
+    check(ui32Notches >= 80, "accepted notch count", 0.0, ui32Notches);
+
+    // Low-passes from 0.005 up: too low a cutoff for FIR_MAX_TAPS must be
+    // rejected, and every accepted one must be 6 dB down at its cutoff
+    ui32Taps = FIR_MAX_TAPS;
+    for (ui32Step = 1; ui32Step <= 90; ui32Step++)
+    {
+        dFreq = ui32Step * 0.005;
+        if (!firDesignLowPass(&sCoeffs, (float)dFreq)) {
+            check(dFreq < 0.035, "low-pass rejected", dFreq, 0.0);
+            continue;
+        }
+        check(dFreq >= 0.03, "unrealizable low-pass accepted", dFreq, sCoeffs.ui32Taps);
+        check(sCoeffs.ui32Taps <= ui32Taps, "low-pass taps grow with the cutoff", dFreq, sCoeffs.ui32Taps);
+        ui32Taps = sCoeffs.ui32Taps;
+        ui32LowPasses++;
+
+        dGain = measureGainDb(&sCoeffs, 0.0);
+        check(fabs(dGain) < 0.01, "low-pass gain at DC", dFreq, dGain);
+        dGain = measureGainDb(&sCoeffs, dFreq);
+        check(fabs(dGain + 6.0) <= 1.0, "low-pass gain at cutoff", dFreq, dGain);
+        dGain = measureGainDb(&sCoeffs, 0.5);
+        check(dGain <= -30.0, "low-pass gain at Nyquist", dFreq, dGain);
+        compareConvolution(&sCoeffs, dFreq);
+    }
+    check(!firDesignLowPass(&sCoeffs, 0.46f), "low-pass above 0.45 accepted", 0.46, 0.0);
+    check(!firDesignLowPass(&sCoeffs, 10.0f / 1000.0f), "10 Hz low-pass at 1 kHz accepted", 0.01, 0.0);
+    check(firDesignLowPass(&sCoeffs, 40.0f / 1000.0f), "40 Hz low-pass at 1 kHz rejected", 0.04, 0.0);
+    printf("40 Hz low-pass at 1 kHz: %u taps\n", sCoeffs.ui32Taps);
+
+    printf("fir: %u notches and %u low-passes checked, %d failures\n", ui32Notches, ui32LowPasses, g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
@@ -0,0 +1,519 @@
+/*
+ * flash_log_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the SPI flash sample log on the SPI flash model, which
+ * programs and erases in the part's datasheet times and raises the SSI
+ * interrupt from a host timer signal.  The log is shrunk to 128 KB so runs
+ * wrap the device.
+ *
+ * Sample frames are appended as sample_sink.c does, paced at a sample rate
+ * in real time: at the target rate no append may wait for the flash, and at
+ * an overload rate the sustained throughput is printed.  Every run is dumped
+ * back and its frames decoded and compared with what was appended.  Dumps
+ * resumed from a range of offsets must give the same bytes as the whole
+ * dump, and dumps stopped by console stop requests must report offsets that
+ * resume to the same bytes.  Then
+ * power is cut at random page programs and erases while runs are recorded
+ * unpaced, with the model sped up: after the reboot the recovered tail must
+ * carry on after the last intact page, and the dump must hold every frame up
+ * to the last flush, in order, and nothing that was not appended.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -Ihost/stubs -DFLASH_LOG_SIZE=0x20000 -o flash_log_test host/flash_log_test.c host/spi_flash_model.c flash_log.c sample_frame.c crc.c && ./flash_log_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Custom project-specific headers
+#include "flash_log.h"
+#include "sample_frame.h"
+#include "spi_flash_model.h"
+
+// Tiva C Series libraries
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+
+#define TEST_FRAME_SAMPLES  64
+#define TEST_POWER_LOSSES   200
+#define TEST_SPEED_UP       20
+#define TEST_TIMEOUT_S      120
+
+// Sample rate that must be logged without waiting for the flash: all six
+// channels at the default 1 kHz, with a third to spare.  The page queue has
+// to cover a sector erase, so its limit is about FLASH_LOG_QUEUE_PAGES pages
+// per SPI_FLASH_MODEL_ERASE_US.  The overload rate is beyond what the flash
+// can sustain at all.
+#define TARGET_RATE         8000
+#define TARGET_SECONDS      2.0
+#define OVERLOAD_RATE       100000
+#define OVERLOAD_SECONDS    1.0
+
+// Console output of flashLogDump()
+static uint8_t g_pui8Dump[FLASH_LOG_SIZE];
+static uint32_t g_ui32DumpLen;
+
+// userStopRequested() reports a stop once this many bytes of a dump are
+// out, as if the key were pressed then, and records that it did
+static uint32_t g_ui32StopAt = UINT32_MAX;
+static bool g_bStopped;
+
+static int g_iFailures;
+
+//*****************************************************************************/
+// Record a failed check
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, uint32_t ui32Count)
+{
+    if (!bPass) {
+        printf("FAIL: %s, after %u\n", pcWhat, ui32Count);
+        g_iFailures++;
+    }
+}
+
+//*****************************************************************************/
+// Timebase in nanoseconds
+//*****************************************************************************/
+uint64_t
+timebaseNow(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (uint64_t)sNow.tv_sec * 1000000000 + sNow.tv_nsec;
+}
+
+uint64_t
+timebaseTicksToUs(uint64_t ui64Ticks)
+{
+    return ui64Ticks / 1000;
+}
+
+//*****************************************************************************/
+// Console: the dump is captured, the rest discarded
+//*****************************************************************************/
+void
+UARTprintf(const char *pcString, ...)
+{
+    (void)pcString;
+}
+
+int
+UARTwriteBinary(const uint8_t *pui8Buf, uint32_t ui32Len)
+{
+    if (ui32Len > sizeof(g_pui8Dump) - g_ui32DumpLen) {
+        ui32Len = sizeof(g_pui8Dump) - g_ui32DumpLen;
+    }
+    memcpy(&g_pui8Dump[g_ui32DumpLen], pui8Buf, ui32Len);
+    g_ui32DumpLen += ui32Len;
+
+    return (int)ui32Len;
+}
+
+bool
+userStopRequested(void)
+{
+    if (g_ui32DumpLen < g_ui32StopAt) {
+        return false;
+    }
+
+    g_bStopped = true;
+    return true;
+}
+
+//*****************************************************************************/
+// Peripheral setup, which the model does not need
+//*****************************************************************************/
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral) { (void)ui32Peripheral; }
+uint32_t SysCtlClockGet(void) { return 80000000; }
+void GPIOPinConfigure(uint32_t ui32PinConfig) { (void)ui32PinConfig; }
+void GPIOPinTypeSSI(uint32_t ui32Port, uint8_t ui8Pins) { (void)ui32Port; (void)ui8Pins; }
+void configureDMA(void) { }
+void uDMAChannelAssign(uint32_t ui32Mapping) { (void)ui32Mapping; }
+void IntEnable(uint32_t ui32Interrupt) { (void)ui32Interrupt; }
+
+//*****************************************************************************/
+// The samples of frame ui32Seq, a pattern that differs from frame to frame
+//*****************************************************************************/
+static void
+frameSamples(uint32_t ui32Seq, uint16_t *pui16Samples)
+{
+    uint32_t ui32Index;
+
+    for (ui32Index = 0; ui32Index < TEST_FRAME_SAMPLES; ui32Index++)
+    {
+        pui16Samples[ui32Index] = (uint16_t)(((ui32Seq * TEST_FRAME_SAMPLES + ui32Index) * 2654435761u) >> 20);
+    }
+}
+
+//*****************************************************************************/
+// Append frame ui32Seq of a run at ui32Rate samples/s
+//*****************************************************************************/
+static void
+appendFrame(uint32_t ui32Seq, uint32_t ui32Rate)
+{
+    uint8_t pui8Frame[SAMPLE_FRAME_SIZE(TEST_FRAME_SAMPLES, 0)];
+    uint16_t pui16Samples[TEST_FRAME_SAMPLES];
+    tSampleFrameHeader sHeader;
+
+    frameSamples(ui32Seq, pui16Samples);
+
+    sHeader.ui32Seq = ui32Seq;
+    sHeader.ui64Timestamp = (uint64_t)ui32Seq * TEST_FRAME_SAMPLES * 1000000 / ui32Rate;
+    sHeader.ui32PeriodNs = 1000000000 / ui32Rate;
+    sHeader.ui16Count = TEST_FRAME_SAMPLES;
+    sHeader.ui16ChannelMask = 0x0001;
+    sHeader.ui8Flags = 0;
+
+    flashLogAppend(pui8Frame, sampleFrameEncode(pui8Frame, &sHeader, pui16Samples), sHeader.ui64Timestamp);
+}
+
+//*****************************************************************************/
+// Dump run ui32RunID from ui32Offset into g_pui8Dump
+//*****************************************************************************/
+static void
+dumpRun(uint32_t ui32RunID, uint32_t ui32Offset)
+{
+    uint32_t ui32Next;
+
+    g_ui32DumpLen = 0;
+    ui32Next = flashLogDump(ui32RunID, ui32Offset);
+    check(ui32Next == ui32Offset + g_ui32DumpLen, "dump resume offset", ui32RunID);
+}
+
+//*****************************************************************************/
+// Decode the dump of a run and check it holds consecutive frames from frame
+// 0, with the samples appended, and only a partial frame after them.  If
+// bWrapped the run's oldest pages may have been overwritten, so it may start
+// with the tail of a frame and with any frame, which is returned in
+// *pui32First.  Returns the number of frames.
+//*****************************************************************************/
+static uint32_t
+checkDump(uint32_t ui32RunID, uint32_t *pui32First, bool bWrapped)
+{
+    uint32_t ui32First = 0;
+    uint16_t pui16Samples[SAMPLE_FRAME_MAX_SAMPLES];
+    uint16_t pui16Expected[TEST_FRAME_SAMPLES];
+    tSampleFrameHeader sHeader;
+    uint32_t ui32Position = 0;
+    uint32_t ui32Frames = 0;
+    uint32_t ui32Result;
+    uint32_t ui32Used;
+
+    while (ui32Position < g_ui32DumpLen)
+    {
+        ui32Result = sampleFrameDecode(&g_pui8Dump[ui32Position], g_ui32DumpLen - ui32Position, &sHeader,
+                                       pui16Samples, &ui32Used);
+        if (ui32Result == SAMPLE_FRAME_NEED_MORE) {
+            break;
+        }
+        if (ui32Result == SAMPLE_FRAME_BAD) {
+            if (!bWrapped || ui32Frames) {
+                check(false, "dump corrupt", ui32RunID);
+                return ui32Frames;
+            }
+            ui32Position++;
+            continue;
+        }
+
+        if (ui32Frames == 0 && bWrapped) {
+            ui32First = sHeader.ui32Seq;
+            *pui32First = ui32First;
+        }
+        frameSamples(ui32First + ui32Frames, pui16Expected);
+        if (sHeader.ui32Seq != ui32First + ui32Frames || sHeader.ui16Count != TEST_FRAME_SAMPLES ||
+            memcmp(pui16Samples, pui16Expected, sizeof(pui16Expected)) != 0) {
+            printf("run %u: frame %u where %u was expected\n", ui32RunID, sHeader.ui32Seq, ui32First + ui32Frames);
+            check(false, "dump out of order", ui32RunID);
+            return ui32Frames;
+        }
+
+        ui32Position += ui32Used;
+        ui32Frames++;
+    }
+
+    return ui32Frames;
+}
+
+//*****************************************************************************/
+// Check that the intact segments of each sector carry the sequence numbers
+// of their pages: the sector is filled in one pass, and after a torn page
+// the writer carries on with the number of the page it writes
+//*****************************************************************************/
+static bool
+sequenceIntact(void)
+{
+    uint8_t pui8Payload[FLASH_LOG_PAYLOAD_SIZE];
+    tFlashLogSegment sSegment;
+    uint32_t ui32Page;
+    uint32_t ui32Base = 0;
+    bool bBase = false;
+
+    for (ui32Page = 0; ui32Page < FLASH_LOG_PAGES; ui32Page++)
+    {
+        if ((ui32Page % FLASH_LOG_PAGES_PER_SECTOR) == 0) {
+            bBase = false;
+        }
+        if (!flashLogReadSegment(ui32Page, &sSegment, pui8Payload)) {
+            continue;
+        }
+
+        if (bBase && sSegment.ui32Seq - ui32Page != ui32Base) {
+            printf("page %u: segment %u, expected %u\n", ui32Page, sSegment.ui32Seq, ui32Base + ui32Page);
+            return false;
+        }
+        ui32Base = sSegment.ui32Seq - ui32Page;
+        bBase = true;
+    }
+
+    return true;
+}
+
+//*****************************************************************************/
+// Record a run paced at ui32Rate samples/s, as the acquisition loop would,
+// running the writer in between, then read it back
+//*****************************************************************************/
+static void
+runAtRate(const char *pcName, uint32_t ui32Rate, double dSeconds, bool bTarget)
+{
+    tFlashLogStats sStats;
+    uint32_t ui32Frames = (uint32_t)(dSeconds * ui32Rate / TEST_FRAME_SAMPLES);
+    uint32_t ui32RunID;
+    uint32_t ui32Seq;
+    uint32_t ui32Read;
+    uint32_t ui32First = 0;
+    uint32_t ui32Bytes;
+    uint64_t ui64Start;
+    uint64_t ui64Due;
+    uint64_t ui64Now;
+    uint64_t ui64Late;
+    uint64_t ui64MaxLate = 0;
+    uint64_t ui64MaxAppend = 0;
+    uint64_t ui64End;
+    bool bWrapped;
+
+    ui32RunID = flashLogStartRun();
+    ui64Start = timebaseNow();
+
+    for (ui32Seq = 0; ui32Seq < ui32Frames; ui32Seq++)
+    {
+        ui64Due = ui64Start + (uint64_t)(ui32Seq + 1) * TEST_FRAME_SAMPLES * 1000000000 / ui32Rate;
+        while ((ui64Now = timebaseNow()) < ui64Due)
+        {
+            flashLogService();
+        }
+        ui64Late = ui64Now - ui64Due;
+        ui64MaxLate = (ui64Late > ui64MaxLate) ? ui64Late : ui64MaxLate;
+
+        appendFrame(ui32Seq, ui32Rate);
+        ui64Now = timebaseNow() - ui64Now;
+        ui64MaxAppend = (ui64Now > ui64MaxAppend) ? ui64Now : ui64MaxAppend;
+    }
+
+    flashLogFlush();
+    ui64End = timebaseNow();
+    flashLogGetStats(&sStats);
+
+    ui32Bytes = ui32Frames * SAMPLE_FRAME_SIZE(TEST_FRAME_SAMPLES, 0);
+    printf("%s: %.1f KB/s to flash, %u pages, queue high water %u of %d, %u stalls (%u us), "
+           "%u erases in line, min headroom %u, worst append %.1f us, worst block %.1f us late\n",
+           pcName, ui32Bytes / 1024.0 * 1e9 / (ui64End - ui64Start), sStats.ui32Pages,
+           sStats.ui32QueueHighWater, FLASH_LOG_QUEUE_PAGES, sStats.ui32Stalls, sStats.ui32StallUs,
+           sStats.ui32EraseWaits, sStats.ui32MinHeadroom, ui64MaxAppend / 1e3, ui64MaxLate / 1e3);
+
+    if (bTarget) {
+        check(sStats.ui32Stalls == 0 && sStats.ui32EraseWaits == 0, "waited for the flash at the target rate",
+              ui32Frames);
+    }
+
+    // Every frame comes back, or the newest ones if the run filled the log
+    bWrapped = sStats.ui32Pages > FLASH_LOG_PAGES - (FLASH_LOG_ERASE_AHEAD + 1) * FLASH_LOG_PAGES_PER_SECTOR;
+    dumpRun(ui32RunID, 0);
+    ui32Read = checkDump(ui32RunID, &ui32First, bWrapped);
+    check(ui32First + ui32Read == ui32Frames && ui32Read > ui32Frames / 4, "frames lost", ui32Read);
+
+    // And a resumed dump picks up where it was cut
+    ui32Bytes = g_ui32DumpLen;
+    dumpRun(ui32RunID, ui32Bytes / 3);
+    check(g_ui32DumpLen == ui32Bytes - ui32Bytes / 3, "resumed dump length", g_ui32DumpLen);
+}
+
+//*****************************************************************************/
+// Resume the dump of run ui32RunID from a range of offsets, and stop it now
+// and then and resume from the reported offset: the bytes must always be
+// those of the uninterrupted dump from the same offset
+//*****************************************************************************/
+static void
+checkDumpResume(uint32_t ui32RunID)
+{
+    static uint8_t pui8Whole[FLASH_LOG_SIZE];
+    static uint8_t pui8Joined[FLASH_LOG_SIZE];
+    uint32_t ui32Whole;
+    uint32_t ui32Joined;
+    uint32_t ui32Offset;
+    uint32_t ui32Next;
+    uint32_t ui32Trial;
+    uint32_t ui32Stops;
+    uint32_t pui32Offsets[8];
+
+    dumpRun(ui32RunID, 0);
+    ui32Whole = g_ui32DumpLen;
+    memcpy(pui8Whole, g_pui8Dump, ui32Whole);
+    if (ui32Whole <= 2 * FLASH_LOG_PAYLOAD_SIZE) {
+        check(false, "dump too short to resume", ui32RunID);
+        return;
+    }
+
+    // Segment boundaries either side, the ends, and past the end
+    pui32Offsets[0] = 1;
+    pui32Offsets[1] = FLASH_LOG_PAYLOAD_SIZE - 1;
+    pui32Offsets[2] = FLASH_LOG_PAYLOAD_SIZE;
+    pui32Offsets[3] = FLASH_LOG_PAYLOAD_SIZE + 1;
+    pui32Offsets[4] = (uint32_t)rand() % ui32Whole;
+    pui32Offsets[5] = ui32Whole - 1;
+    pui32Offsets[6] = ui32Whole;
+    pui32Offsets[7] = ui32Whole + 100;
+    for (ui32Trial = 0; ui32Trial < sizeof(pui32Offsets) / sizeof(pui32Offsets[0]); ui32Trial++)
+    {
+        ui32Offset = pui32Offsets[ui32Trial];
+        dumpRun(ui32RunID, ui32Offset);
+        if (ui32Offset >= ui32Whole) {
+            check(g_ui32DumpLen == 0, "dump resumed past the end sent data", ui32Offset);
+            continue;
+        }
+        check(g_ui32DumpLen == ui32Whole - ui32Offset &&
+              memcmp(g_pui8Dump, &pui8Whole[ui32Offset], g_ui32DumpLen) == 0, "resumed dump bytes", ui32Offset);
+    }
+
+    // Stop requests after a random number of bytes, each resumed from the
+    // offset the dump returned, until a dump runs to the end
+    for (ui32Trial = 0; ui32Trial < 8; ui32Trial++)
+    {
+        ui32Offset = 0;
+        ui32Joined = 0;
+        ui32Stops = 0;
+        do
+        {
+            g_ui32StopAt = 1 + (uint32_t)rand() % (ui32Whole / 3);
+            g_bStopped = false;
+            g_ui32DumpLen = 0;
+            ui32Next = flashLogDump(ui32RunID, ui32Offset);
+            ui32Stops += g_bStopped;
+            g_ui32StopAt = UINT32_MAX;
+
+            check(ui32Next == ui32Offset + g_ui32DumpLen, "stopped dump resume offset", ui32Offset);
+            if (ui32Joined + g_ui32DumpLen > sizeof(pui8Joined)) {
+                check(false, "stopped dumps longer than the run", ui32Trial);
+                return;
+            }
+            memcpy(&pui8Joined[ui32Joined], g_pui8Dump, g_ui32DumpLen);
+            ui32Joined += g_ui32DumpLen;
+            ui32Offset = ui32Next;
+        }
+        while (g_bStopped);
+
+        check(ui32Stops > 0, "dump never stopped", ui32Trial);
+        check(ui32Joined == ui32Whole && memcmp(pui8Joined, pui8Whole, ui32Whole) == 0, "stopped dumps joined",
+              ui32Trial);
+    }
+}
+
+//*****************************************************************************/
+// Record unpaced runs until the power fails, flushing now and then, and
+// check what a reboot recovers
+//*****************************************************************************/
+static void
+checkPowerLoss(void)
+{
+    uint32_t ui32Trial;
+    uint32_t ui32RunID;
+    uint32_t ui32Durable;
+    uint32_t ui32Appended;
+    uint32_t ui32Read;
+
+    spiFlashModelSpeedUp(TEST_SPEED_UP);
+
+    for (ui32Trial = 0; ui32Trial < TEST_POWER_LOSSES; ui32Trial++)
+    {
+        // Runs stay well inside the log, so none of a run is overwritten
+        spiFlashModelPowerLoss(rand() % 300);
+        ui32RunID = flashLogStartRun();
+        ui32Durable = 0;
+        ui32Appended = 0;
+
+        while (!spiFlashModelPowerLost())
+        {
+            appendFrame(ui32Appended++, TARGET_RATE);
+            if (rand() % 16 == 0) {
+                flashLogFlush();
+                if (!spiFlashModelPowerLost()) {
+                    ui32Durable = ui32Appended;
+                }
+            }
+        }
+
+        spiFlashModelPowerLoss(-1);
+        check(configureFlashLog(), "no flash after reboot", ui32Trial);
+        check(sequenceIntact(), "segment numbers", ui32Trial);
+
+        // The run is the newest unless none of it reached the flash
+        check(flashLogLastRun() == ui32RunID || (flashLogLastRun() == ui32RunID - 1 && ui32Durable == 0),
+              "last run", ui32Trial);
+
+        dumpRun(ui32RunID, 0);
+        ui32Read = checkDump(ui32RunID, NULL, false);
+        if (ui32Read < ui32Durable || ui32Read > ui32Appended) {
+            printf("run %u: %u frames read back, %u flushed, %u appended\n", ui32RunID, ui32Read, ui32Durable,
+                   ui32Appended);
+            check(false, "frames lost after power loss", ui32Trial);
+        }
+    }
+
+    spiFlashModelSpeedUp(1);
+}
+
+int
+main(void)
+{
+    const tSPIFlashModelCounts *psCounts = spiFlashModelCounts();
+
+    // A writer that stops getting its interrupt would hang
+    alarm(TEST_TIMEOUT_S);
+
+    if (!spiFlashModelInit(FLASH_LOG_SIZE, SSI0IntHandler)) {
+        return 1;
+    }
+
+    srand(11);
+    check(configureFlashLog() && flashLogLastRun() == 0, "blank flash", 0);
+
+    // The overload run wraps the log and overwrites the first
+    runAtRate("target", TARGET_RATE, TARGET_SECONDS, true);
+    checkDumpResume(1);
+    runAtRate("overload", OVERLOAD_RATE, OVERLOAD_SECONDS, false);
+
+    // The tail survives a clean reboot too
+    check(configureFlashLog() && flashLogLastRun() == 2, "last run after reboot", 2);
+    checkDumpResume(2);
+
+    checkPowerLoss();
+
+    check(psCounts->ui32Errors == 0, "command refused by the flash", psCounts->ui32Errors);
+    printf("%u programs, %u erases\n", psCounts->ui32Programs, psCounts->ui32Erases);
+
+    printf("flash_log: %d failures\n", g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * flash_model.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host model of the TM4C123 internal flash.  Erasing sets a 1 KB sector to
+ * all ones and programming can only clear bits, as on the part.  A power loss
+ * can be scheduled after a number of words have been erased or programmed:
+ * the operation in progress stops at that word and later ones change nothing
+ * until power is restored, which is how the tests tear erases and writes.
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// Custom project-specific headers
+#include "flash_model.h"
+
+// Tiva C Series libraries
+#include "driverlib/flash.h"
+#include "driverlib/sysctl.h"
+
+static uint32_t g_ui32Start;
+static uint32_t g_ui32End;
+
+// Words left before the power fails, or negative for none scheduled
+static int32_t g_i32PowerWords = -1;
+static bool g_bPowerLost;
+
+static tFlashModelCounts g_sCounts;
+
+//*****************************************************************************/
+// Map RAM at the flash addresses ui32Start to ui32End, erased.  Fails if the
+// range is not free in the host process.
+//*****************************************************************************/
+bool
+flashModelMap(uint32_t ui32Start, uint32_t ui32End)
+{
+    void *pvMap;
+
+    pvMap = mmap((void *)(uintptr_t)ui32Start, ui32End - ui32Start, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (pvMap != (void *)(uintptr_t)ui32Start) {
+        perror("flash model mmap");
+        return false;
+    }
+
+    g_ui32Start = ui32Start;
+    g_ui32End = ui32End;
+    flashModelErase();
+    return true;
+}
+
+//*****************************************************************************/
+// Erase the whole model, as on a freshly programmed part
+//*****************************************************************************/
+void
+flashModelErase(void)
+{
+    memset((void *)(uintptr_t)g_ui32Start, 0xFF, g_ui32End - g_ui32Start);
+}
+
+//*****************************************************************************/
+// Lose power after i32Words more words are erased or programmed.  A negative
+// count restores power and cancels any scheduled loss.
+//*****************************************************************************/
+void
+flashModelPowerLoss(int32_t i32Words)
+{
+    g_i32PowerWords = i32Words;
+    g_bPowerLost = false;
+}
+
+bool
+flashModelPowerLost(void)
+{
+    return g_bPowerLost;
+}
+
+void
+flashModelResetCounts(void)
+{
+    memset(&g_sCounts, 0, sizeof(g_sCounts));
+}
+
+const tFlashModelCounts *
+flashModelCounts(void)
+{
+    return &g_sCounts;
+}
+
+//*****************************************************************************/
+// Account for one word of an erase or program.  Returns false once the power
+// has failed.
+//*****************************************************************************/
+static bool
+powerForWord(void)
+{
+    if (g_bPowerLost) {
+        return false;
+    }
+    if (g_i32PowerWords == 0) {
+        g_bPowerLost = true;
+        return false;
+    }
+    if (g_i32PowerWords > 0) {
+        g_i32PowerWords--;
+    }
+
+    return true;
+}
+
+//*****************************************************************************/
+// TivaWare flash API over the model
+//*****************************************************************************/
+int32_t
+FlashErase(uint32_t ui32Address)
+{
+    uint32_t *pui32Word = (uint32_t *)(uintptr_t)ui32Address;
+    uint32_t ui32Index;
+
+    if ((ui32Address % FLASH_MODEL_SECTOR_SIZE) || ui32Address < g_ui32Start || ui32Address >= g_ui32End) {
+        fprintf(stderr, "FlashErase(0x%08X) outside the model\n", ui32Address);
+        return -1;
+    }
+
+    if (!g_bPowerLost) {
+        g_sCounts.ui32Erases++;
+        g_sCounts.ui64Us += FLASH_MODEL_ERASE_US;
+    }
+    for (ui32Index = 0; ui32Index < FLASH_MODEL_SECTOR_SIZE / 4 && powerForWord(); ui32Index++)
+    {
+        pui32Word[ui32Index] = 0xFFFFFFFF;
+    }
+
+    return 0;
+}
+
+int32_t
+FlashProgram(uint32_t *pui32Data, uint32_t ui32Address, uint32_t ui32Count)
+{
+    uint32_t *pui32Word = (uint32_t *)(uintptr_t)ui32Address;
+    uint32_t ui32Index;
+
+    if ((ui32Address & 3) || (ui32Count & 3) || ui32Address < g_ui32Start || ui32Count > g_ui32End - ui32Address) {
+        fprintf(stderr, "FlashProgram(0x%08X, %u) outside the model\n", ui32Address, ui32Count);
+        return -1;
+    }
+
+    for (ui32Index = 0; ui32Index < ui32Count / 4 && powerForWord(); ui32Index++)
+    {
+        pui32Word[ui32Index] &= pui32Data[ui32Index];
+        g_sCounts.ui32Words++;
+        g_sCounts.ui64Us += FLASH_MODEL_WORD_US;
+    }
+
+    return 0;
+}
+
+uint32_t
+SysCtlFlashSectorSizeGet(void)
+{
+    return FLASH_MODEL_SECTOR_SIZE;
+}
@@ -0,0 +1,39 @@
+/*
+ * flash_model.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host model of the TM4C123 internal flash for the tests of flash_pb.c and
+ * config_store.c.  The firmware addresses flash by its 32-bit address, so the
+ * model maps RAM at the same addresses and provides FlashErase(),
+ * FlashProgram() and SysCtlFlashSectorSizeGet() over it.
+ */
+
+#ifndef FLASH_MODEL_H_
+#define FLASH_MODEL_H_
+
+// Erase sector size of the TM4C123GH6PM
+#define FLASH_MODEL_SECTOR_SIZE     1024
+
+// Datasheet typical times, used for the modelled write time
+#define FLASH_MODEL_ERASE_US        15000   // One sector
+#define FLASH_MODEL_WORD_US         30      // One word
+
+// Operation counts and modelled time since the last flashModelResetCounts()
+typedef struct
+{
+    uint32_t ui32Erases;
+    uint32_t ui32Words;
+    uint64_t ui64Us;
+}
+tFlashModelCounts;
+
+bool flashModelMap(uint32_t ui32Start, uint32_t ui32End);
+void flashModelErase(void);
+void flashModelPowerLoss(int32_t i32Words);
+bool flashModelPowerLost(void);
+void flashModelResetCounts(void);
+const tFlashModelCounts *flashModelCounts(void);
+
+#endif /* FLASH_MODEL_H_ */
@@ -0,0 +1,552 @@
+/*
+ * flash_pb_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the parameter block store on the flash model.  Checks
+ * crc16Update() and crc32Update() against bitwise references (check values,
+ * every alignment and length), then saves blocks of each size through more
+ * than one wrap of the 16-bit sequence number, re-initialising along the way.
+ * Power is cut at random words of erases and writes and random bits of the
+ * stored blocks are cleared; after every reboot FlashPBInit() must find the
+ * block a full scan with a bitwise CRC finds, which is the last saved or the
+ * one being saved.  Blocks in the old format, an 8-bit sequence number and
+ * an additive checksum, must be found by FlashPBGetLegacy() across a wrap of
+ * the sequence number, skipping a bad checksum, until a block is saved in
+ * the current format.  Also prints the CRC-32 throughput against a byte-wide
+ * table, the bitwise CRC and the old additive checksum, and FlashPBInit()
+ * time against the region size, next to a scan that checks the CRC of every
+ * slot.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -Ihost/stubs -o flash_pb_test host/flash_pb_test.c host/flash_model.c flash_pb.c crc.c && ./flash_pb_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Custom project-specific headers
+#include "crc.h"
+#include "flash_model.h"
+#include "flash_pb.h"
+
+// Tiva C Series libraries
+#include "driverlib/flash.h"
+
+// Flash set aside for the model, clear of the host program's own mappings
+#define TEST_START          0x00100000
+#define TEST_MAX_SECTORS    256
+#define TEST_END            (TEST_START + TEST_MAX_SECTORS * FLASH_MODEL_SECTOR_SIZE)
+
+#define TEST_SAVES          70000
+#define TEST_POWER_LOSSES   20000
+#define TEST_CORRUPTIONS    2000
+
+static uint32_t g_pui32Block[FLASH_MODEL_SECTOR_SIZE / 4];
+static int g_iFailures;
+
+//*****************************************************************************/
+// Record a failed check
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, uint32_t ui32Size, uint32_t ui32Count)
+{
+    if (!bPass) {
+        printf("FAIL: %s, %u-byte blocks, after %u\n", pcWhat, ui32Size, ui32Count);
+        g_iFailures++;
+    }
+}
+
+//*****************************************************************************/
+// Bitwise CRC-32 (IEEE 802.3) and CRC-16/CCITT-FALSE, final values
+//*****************************************************************************/
+static uint32_t
+refCRC32(const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    uint32_t ui32CRC = 0xFFFFFFFF;
+    uint32_t ui32Bit;
+
+    while (ui32Len--)
+    {
+        ui32CRC ^= *pui8Data++;
+        for (ui32Bit = 0; ui32Bit < 8; ui32Bit++)
+        {
+            ui32CRC = (ui32CRC >> 1) ^ ((ui32CRC & 1) ? 0xEDB88320 : 0);
+        }
+    }
+
+    return ui32CRC ^ 0xFFFFFFFF;
+}
+
+static uint16_t
+refCRC16(const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    uint16_t ui16CRC = 0xFFFF;
+    uint32_t ui32Bit;
+
+    while (ui32Len--)
+    {
+        ui16CRC ^= (uint16_t)(*pui8Data++ << 8);
+        for (ui32Bit = 0; ui32Bit < 8; ui32Bit++)
+        {
+            ui16CRC = (uint16_t)((ui16CRC << 1) ^ ((ui16CRC & 0x8000) ? 0x1021 : 0));
+        }
+    }
+
+    return ui16CRC;
+}
+
+//*****************************************************************************/
+// The most recent intact block found by checking every slot, or NULL
+//*****************************************************************************/
+static uint8_t *
+refLatest(uint32_t ui32End, uint32_t ui32Size)
+{
+    static uint8_t pui8Copy[FLASH_MODEL_SECTOR_SIZE];
+    tFlashPBHeader *psHeader;
+    tFlashPBHeader *psLatest = NULL;
+    uint32_t ui32Addr;
+
+    for (ui32Addr = TEST_START; ui32Addr < ui32End; ui32Addr += ui32Size)
+    {
+        psHeader = (tFlashPBHeader *)(uintptr_t)ui32Addr;
+        if (psHeader->ui16Magic != FLASH_PB_MAGIC || psHeader->ui16Length != ui32Size) {
+            continue;
+        }
+
+        // The CRC covers the header up to the CRC field, then the data
+        memcpy(pui8Copy, psHeader, offsetof(tFlashPBHeader, ui32CRC));
+        memcpy(pui8Copy + offsetof(tFlashPBHeader, ui32CRC), (uint8_t *)psHeader + FLASH_PB_HEADER_SIZE,
+               ui32Size - FLASH_PB_HEADER_SIZE);
+        if (refCRC32(pui8Copy, ui32Size - sizeof(uint32_t)) != psHeader->ui32CRC) {
+            continue;
+        }
+
+        if (!psLatest || (int16_t)(psHeader->ui16Sequence - psLatest->ui16Sequence) > 0) {
+            psLatest = psHeader;
+        }
+    }
+
+    return (uint8_t *)psLatest;
+}
+
+//*****************************************************************************/
+// Block contents for save number ui32Count: the number after the header, then
+// a pattern derived from it
+//*****************************************************************************/
+static void
+fillBlock(uint32_t ui32Size, uint32_t ui32Count)
+{
+    uint32_t ui32Index;
+
+    g_pui32Block[FLASH_PB_HEADER_SIZE / 4] = ui32Count;
+    for (ui32Index = FLASH_PB_HEADER_SIZE / 4 + 1; ui32Index < ui32Size / 4; ui32Index++)
+    {
+        g_pui32Block[ui32Index] = (ui32Count + 1) * 2654435761u ^ ui32Index * 40503u;
+    }
+}
+
+//*****************************************************************************/
+// True if pui8Stored holds save number ui32Count
+//*****************************************************************************/
+static bool
+blockIs(const uint8_t *pui8Stored, uint32_t ui32Size, uint32_t ui32Count)
+{
+    fillBlock(ui32Size, ui32Count);
+    return pui8Stored && memcmp(pui8Stored + FLASH_PB_HEADER_SIZE, (uint8_t *)g_pui32Block + FLASH_PB_HEADER_SIZE,
+                                ui32Size - FLASH_PB_HEADER_SIZE) == 0;
+}
+
+static uint32_t
+blockNumber(const uint8_t *pui8Stored)
+{
+    return ((const uint32_t *)pui8Stored)[FLASH_PB_HEADER_SIZE / 4];
+}
+
+static void
+save(uint32_t ui32Size, uint32_t ui32Count)
+{
+    fillBlock(ui32Size, ui32Count);
+    FlashPBSave((uint8_t *)g_pui32Block);
+}
+
+//*****************************************************************************/
+// Write save number ui32Count at ui32Addr in the old format: the sequence
+// number in byte 0, and byte 1 set so that the whole block sums to zero
+//*****************************************************************************/
+static void
+writeLegacy(uint32_t ui32Addr, uint32_t ui32Size, uint8_t ui8Sequence, uint32_t ui32Count, bool bBad)
+{
+    uint8_t *pui8Block = (uint8_t *)g_pui32Block;
+    uint32_t ui32Index;
+    uint32_t ui32Sum = 0;
+
+    fillBlock(ui32Size, ui32Count);
+    memset(pui8Block, 0xFF, FLASH_PB_HEADER_SIZE);
+    pui8Block[0] = ui8Sequence;
+    pui8Block[1] = 0;
+    for (ui32Index = 0; ui32Index < ui32Size; ui32Index++)
+    {
+        ui32Sum += pui8Block[ui32Index];
+    }
+    pui8Block[1] = (uint8_t)(0 - ui32Sum + bBad);
+    FlashProgram(g_pui32Block, ui32Addr, ui32Size);
+}
+
+//*****************************************************************************/
+// CRC check values, and the word-at-a-time CRC-32 at every alignment
+//*****************************************************************************/
+static void
+checkCRCs(void)
+{
+    static uint8_t pui8Data[300 + 4];
+    uint32_t ui32Offset;
+    uint32_t ui32Len;
+    uint32_t ui32Index;
+    uint32_t ui32CRC;
+
+    check(CRC32_FINAL(crc32Update(CRC32_INIT, (const uint8_t *)"123456789", 9)) == 0xCBF43926,
+          "CRC-32 check value", 0, 0);
+    check(crc16Update(CRC16_INIT, (const uint8_t *)"123456789", 9) == 0x29B1, "CRC-16 check value", 0, 0);
+
+    for (ui32Index = 0; ui32Index < sizeof(pui8Data); ui32Index++)
+    {
+        pui8Data[ui32Index] = (uint8_t)rand();
+    }
+    for (ui32Offset = 0; ui32Offset < 4; ui32Offset++)
+    {
+        for (ui32Len = 0; ui32Len <= 300; ui32Len++)
+        {
+            check(CRC32_FINAL(crc32Update(CRC32_INIT, pui8Data + ui32Offset, ui32Len)) ==
+                  refCRC32(pui8Data + ui32Offset, ui32Len), "CRC-32", ui32Offset, ui32Len);
+            check(crc16Update(CRC16_INIT, pui8Data + ui32Offset, ui32Len) == refCRC16(pui8Data + ui32Offset, ui32Len),
+                  "CRC-16", ui32Offset, ui32Len);
+
+            // Split at every point: the running value carries across calls
+            ui32Index = ui32Len / 3;
+            ui32CRC = crc32Update(CRC32_INIT, pui8Data + ui32Offset, ui32Index);
+            ui32CRC = crc32Update(ui32CRC, pui8Data + ui32Offset + ui32Index, ui32Len - ui32Index);
+            check(CRC32_FINAL(ui32CRC) == refCRC32(pui8Data + ui32Offset, ui32Len), "split CRC-32", ui32Offset,
+                  ui32Len);
+        }
+    }
+}
+
+//*****************************************************************************/
+// Save through more than one wrap of the sequence number, re-initialising
+// every so often as a reboot would
+//*****************************************************************************/
+static void
+checkSaves(uint32_t ui32Size)
+{
+    const uint32_t ui32End = TEST_START + 4 * FLASH_MODEL_SECTOR_SIZE;
+    uint32_t ui32Count;
+
+    flashModelErase();
+    FlashPBInit(TEST_START, ui32End, ui32Size);
+    check(FlashPBGet() == NULL, "block found in erased flash", ui32Size, 0);
+
+    for (ui32Count = 0; ui32Count < TEST_SAVES; ui32Count++)
+    {
+        save(ui32Size, ui32Count);
+        if (ui32Count % 97 == 0) {
+            FlashPBInit(TEST_START, ui32End, ui32Size);
+            check(FlashPBGet() == refLatest(ui32End, ui32Size), "reboot disagrees with a full scan", ui32Size,
+                  ui32Count);
+        }
+        if (!blockIs(FlashPBGet(), ui32Size, ui32Count)) {
+            check(false, "latest block wrong", ui32Size, ui32Count);
+            return;
+        }
+    }
+}
+
+//*****************************************************************************/
+// Cut the power at a random word of a save, then reboot.  The block found
+// must be the previous one or, if its write completed, the new one.
+//*****************************************************************************/
+static void
+checkPowerLoss(uint32_t ui32Size)
+{
+    const uint32_t ui32End = TEST_START + 3 * FLASH_MODEL_SECTOR_SIZE;
+    uint32_t ui32Trial;
+    uint32_t ui32Next = 0;
+    uint8_t *pui8Found;
+
+    flashModelErase();
+    FlashPBInit(TEST_START, ui32End, ui32Size);
+
+    for (ui32Trial = 0; ui32Trial < TEST_POWER_LOSSES; ui32Trial++)
+    {
+        // Enough words to sometimes finish an erase and the write
+        flashModelPowerLoss(rand() % (FLASH_MODEL_SECTOR_SIZE / 4 + ui32Size / 4 + 8));
+        save(ui32Size, ui32Next);
+        flashModelPowerLoss(-1);
+
+        FlashPBInit(TEST_START, ui32End, ui32Size);
+        pui8Found = FlashPBGet();
+        if (pui8Found != refLatest(ui32End, ui32Size)) {
+            check(false, "reboot after power loss disagrees with a full scan", ui32Size, ui32Trial);
+            return;
+        }
+        if (ui32Next == 0 && pui8Found == NULL) {
+            continue;
+        }
+        if (!(pui8Found && (blockNumber(pui8Found) == ui32Next || blockNumber(pui8Found) + 1 == ui32Next) &&
+              blockIs(pui8Found, ui32Size, blockNumber(pui8Found)))) {
+            check(false, "wrong block after power loss", ui32Size, ui32Trial);
+            return;
+        }
+        ui32Next = blockNumber(pui8Found) + 1;
+    }
+}
+
+//*****************************************************************************/
+// Clear a random bit of a random slot after a random number of saves
+//*****************************************************************************/
+static void
+checkCorruption(uint32_t ui32Size)
+{
+    const uint32_t ui32End = TEST_START + 4 * FLASH_MODEL_SECTOR_SIZE;
+    uint32_t ui32Slots = (ui32End - TEST_START) / ui32Size;
+    uint32_t ui32Trial;
+    uint32_t ui32Count;
+    uint32_t ui32Saves;
+    uint32_t ui32Word;
+    uint32_t ui32Addr;
+
+    for (ui32Trial = 0; ui32Trial < TEST_CORRUPTIONS; ui32Trial++)
+    {
+        flashModelErase();
+        FlashPBInit(TEST_START, ui32End, ui32Size);
+        ui32Saves = 1 + rand() % (3 * ui32Slots);
+        for (ui32Count = 0; ui32Count < ui32Saves; ui32Count++)
+        {
+            save(ui32Size, ui32Count);
+        }
+
+        // Bias towards the header, where the search looks
+        ui32Addr = TEST_START + (rand() % ui32Slots) * ui32Size;
+        ui32Addr += 4 * ((rand() & 1) ? rand() % (FLASH_PB_HEADER_SIZE / 4) : rand() % (ui32Size / 4));
+        ui32Word = ~(1u << (rand() % 32));
+        FlashProgram(&ui32Word, ui32Addr, 4);
+
+        FlashPBInit(TEST_START, ui32End, ui32Size);
+        if (FlashPBGet() != refLatest(ui32End, ui32Size)) {
+            check(false, "reboot after a cleared bit disagrees with a full scan", ui32Size, ui32Trial);
+            return;
+        }
+    }
+}
+
+//*****************************************************************************/
+// Old-format blocks whose sequence number wraps, then one with a bad checksum
+// and a later sequence number.  The last good one must be offered for
+// migration, and no longer once it has been saved in the current format.
+//*****************************************************************************/
+static void
+checkLegacy(uint32_t ui32Size)
+{
+    const uint32_t ui32End = TEST_START + 4 * FLASH_MODEL_SECTOR_SIZE;
+    uint32_t ui32Slots = (ui32End - TEST_START) / ui32Size;
+    uint32_t ui32Blocks = (ui32Slots - 1 < 40) ? ui32Slots - 1 : 40;
+    uint32_t ui32Index;
+    uint8_t *pui8Legacy;
+
+    flashModelErase();
+    for (ui32Index = 0; ui32Index < ui32Blocks; ui32Index++)
+    {
+        writeLegacy(TEST_START + ui32Index * ui32Size, ui32Size, (uint8_t)(256 - ui32Blocks / 2 + ui32Index),
+                    1000 + ui32Index, false);
+    }
+    writeLegacy(TEST_START + ui32Blocks * ui32Size, ui32Size, (uint8_t)(256 - ui32Blocks / 2 + ui32Blocks),
+                2000, true);
+
+    FlashPBInit(TEST_START, ui32End, ui32Size);
+    pui8Legacy = FlashPBGetLegacy();
+    check(FlashPBGet() == NULL, "old-format block taken as current", ui32Size, ui32Blocks);
+    check(pui8Legacy == (uint8_t *)(uintptr_t)(TEST_START + (ui32Blocks - 1) * ui32Size), "latest old-format block",
+          ui32Size, ui32Blocks);
+    check(blockIs(pui8Legacy, ui32Size, 1000 + ui32Blocks - 1), "old-format block contents", ui32Size, ui32Blocks);
+
+    // Migrate it, as configStoreInit() does, then reboot
+    memcpy(g_pui32Block, pui8Legacy, ui32Size);
+    FlashPBSave((uint8_t *)g_pui32Block);
+    check(FlashPBGetLegacy() == NULL, "old-format block offered after saving", ui32Size, ui32Blocks);
+    FlashPBInit(TEST_START, ui32End, ui32Size);
+    check(FlashPBGetLegacy() == NULL, "old-format block offered after migration", ui32Size, ui32Blocks);
+    check(blockIs(FlashPBGet(), ui32Size, 1000 + ui32Blocks - 1), "migrated block", ui32Size, ui32Blocks);
+}
+
+//*****************************************************************************/
+// Throughput of the checksum kernels over one 256-byte configuration snapshot
+// and over a whole 64 KB, in MB/s: the slice-by-4 CRC-32, a CRC-32 a byte at
+// a time from one table, the bitwise CRC-32, and the old additive checksum
+//*****************************************************************************/
+static void
+benchmarkCRC(void)
+{
+    static uint8_t pui8Data[65536];
+    static const uint32_t pui32Lens[] = { 256, sizeof(pui8Data) };
+    uint32_t pui32Table[256];
+    struct timespec sStart;
+    struct timespec sEnd;
+    uint32_t ui32Index;
+    uint32_t ui32Bit;
+    uint32_t ui32Len;
+    uint32_t ui32Reps;
+    uint32_t ui32Rep;
+    uint32_t ui32Kernel;
+    uint32_t ui32CRC;
+    uint32_t ui32Offset;
+    volatile uint32_t ui32Sink = 0;
+    double pdMBs[4];
+
+    for (ui32Index = 0; ui32Index < 256; ui32Index++)
+    {
+        ui32CRC = ui32Index;
+        for (ui32Bit = 0; ui32Bit < 8; ui32Bit++)
+        {
+            ui32CRC = (ui32CRC >> 1) ^ ((ui32CRC & 1) ? 0xEDB88320 : 0);
+        }
+        pui32Table[ui32Index] = ui32CRC;
+    }
+    for (ui32Index = 0; ui32Index < sizeof(pui8Data); ui32Index++)
+    {
+        pui8Data[ui32Index] = (uint8_t)rand();
+    }
+
+    for (ui32Len = 0; ui32Len < sizeof(pui32Lens) / sizeof(pui32Lens[0]); ui32Len++)
+    {
+        for (ui32Kernel = 0; ui32Kernel < 4; ui32Kernel++)
+        {
+            // About 16 MB through each, a quarter of that for the bitwise one
+            ui32Reps = ((ui32Kernel == 2) ? 4 : 16) * 1048576 / pui32Lens[ui32Len];
+            clock_gettime(CLOCK_MONOTONIC, &sStart);
+            for (ui32Rep = 0; ui32Rep < ui32Reps; ui32Rep++)
+            {
+                switch (ui32Kernel)
+                {
+                case 0:
+                    ui32Sink += crc32Update(CRC32_INIT, pui8Data, pui32Lens[ui32Len]);
+                    break;
+                case 1:
+                    ui32CRC = CRC32_INIT;
+                    for (ui32Offset = 0; ui32Offset < pui32Lens[ui32Len]; ui32Offset++)
+                    {
+                        ui32CRC = (ui32CRC >> 8) ^ pui32Table[(ui32CRC ^ pui8Data[ui32Offset]) & 0xFF];
+                    }
+                    ui32Sink += ui32CRC;
+                    break;
+                case 2:
+                    ui32Sink += refCRC32(pui8Data, pui32Lens[ui32Len]);
+                    break;
+                default:
+                    ui32CRC = 0;
+                    for (ui32Offset = 0; ui32Offset < pui32Lens[ui32Len]; ui32Offset++)
+                    {
+                        ui32CRC += pui8Data[ui32Offset];
+                    }
+                    ui32Sink += ui32CRC & 255;
+                    break;
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &sEnd);
+            pdMBs[ui32Kernel] = (double)ui32Reps * pui32Lens[ui32Len] / 1048576 /
+                                ((sEnd.tv_sec - sStart.tv_sec) + (sEnd.tv_nsec - sStart.tv_nsec) / 1e9);
+        }
+
+        printf("%5u bytes: CRC-32 slice-by-4 %6.0f MB/s, byte table %6.0f MB/s, bitwise %5.0f MB/s; "
+               "additive checksum %6.0f MB/s\n", pui32Lens[ui32Len], pdMBs[0], pdMBs[1], pdMBs[2], pdMBs[3]);
+    }
+}
+
+//*****************************************************************************/
+// Mean time of FlashPBInit() and of a full CRC scan for a region of
+// ui32Sectors sectors holding a run that has wrapped and stops halfway
+//*****************************************************************************/
+static void
+benchmarkInit(uint32_t ui32Sectors, uint32_t ui32Size)
+{
+    const uint32_t ui32End = TEST_START + ui32Sectors * FLASH_MODEL_SECTOR_SIZE;
+    uint32_t ui32Slots = (ui32End - TEST_START) / ui32Size;
+    struct timespec sStart;
+    struct timespec sEnd;
+    uint32_t ui32Count;
+    uint32_t ui32Reps;
+    uint32_t ui32Addr;
+    volatile uint32_t ui32Sink = 0;
+    double dInitUs;
+    double dScanUs;
+
+    flashModelErase();
+    FlashPBInit(TEST_START, ui32End, ui32Size);
+    for (ui32Count = 0; ui32Count < ui32Slots + ui32Slots / 2; ui32Count++)
+    {
+        save(ui32Size, ui32Count);
+    }
+
+    ui32Reps = 1 + 65536 / ui32Slots;
+    clock_gettime(CLOCK_MONOTONIC, &sStart);
+    for (ui32Count = 0; ui32Count < ui32Reps; ui32Count++)
+    {
+        FlashPBInit(TEST_START, ui32End, ui32Size);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &sEnd);
+    dInitUs = ((sEnd.tv_sec - sStart.tv_sec) * 1e6 + (sEnd.tv_nsec - sStart.tv_nsec) / 1e3) / ui32Reps;
+    check(blockIs(FlashPBGet(), ui32Size, ui32Slots + ui32Slots / 2 - 1), "benchmark block", ui32Size, ui32Sectors);
+
+    clock_gettime(CLOCK_MONOTONIC, &sStart);
+    for (ui32Count = 0; ui32Count < ui32Reps; ui32Count++)
+    {
+        for (ui32Addr = TEST_START; ui32Addr < ui32End; ui32Addr += ui32Size)
+        {
+            ui32Sink += crc32Update(CRC32_INIT, (const uint8_t *)(uintptr_t)ui32Addr, ui32Size);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &sEnd);
+    dScanUs = ((sEnd.tv_sec - sStart.tv_sec) * 1e6 + (sEnd.tv_nsec - sStart.tv_nsec) / 1e3) / ui32Reps;
+
+    printf("%3u sectors, %4u slots: FlashPBInit %7.2f us, CRC of every slot %8.2f us\n", ui32Sectors, ui32Slots,
+           dInitUs, dScanUs);
+}
+
+int
+main(void)
+{
+    uint32_t ui32Size;
+    uint32_t ui32Sectors;
+
+    if (!flashModelMap(TEST_START, TEST_END)) {
+        return 1;
+    }
+
+    srand(7);
+    checkCRCs();
+
+    for (ui32Size = 16; ui32Size <= FLASH_MODEL_SECTOR_SIZE; ui32Size *= 4)
+    {
+        checkSaves(ui32Size);
+        checkPowerLoss(ui32Size);
+        checkCorruption(ui32Size);
+        checkLegacy(ui32Size);
+    }
+
+    benchmarkCRC();
+
+    for (ui32Sectors = 2; ui32Sectors <= TEST_MAX_SECTORS; ui32Sectors *= 2)
+    {
+        benchmarkInit(ui32Sectors, 64);
+    }
+
+    printf("flash_pb: %d failures\n", g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
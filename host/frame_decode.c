@@ -0,0 +1,145 @@
+/*
+ * frame_decode.c
+ *
+ *  Created on: Feb 19, 2024
+ *      Author: Tyler
+ *
+ * Host-side decoder for the binary sample stream.  Converts a captured UART
+ * byte stream back into the tab-separated adc_data.txt format:
+ *
+ *     <sample #>\t<timestamp us>\t<AIN0 - AIN1>[\t<next channel>...]
+ *
+ * Decimated streams carry 16-bit codes (12-bit code << 4 at DC) and are
+ * written as such.  Spectrum frames are written one line per bin instead:
+ *
+ *     <window start us>\t<frequency Hz>\t<power spectral density dB>
+ *
+ * Build on the host from the project directory:
+ *
+ *     cc -I. -o frame_decode host/frame_decode.c sample_frame.c crc.c
+ *
+ * Usage: frame_decode [capture.bin [adc_data.txt]]
+ * Reads stdin and writes stdout when files are not given.
+ */
+
+// Standard C libraries
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "sample_frame.h"
+
+// Input buffer, large enough for several maximum-size frames
+#define INPUT_BUFFER_SIZE (4 * SAMPLE_FRAME_MAX_SIZE)
+
+static uint8_t g_pui8Input[INPUT_BUFFER_SIZE];
+static uint16_t g_pui16Samples[SAMPLE_FRAME_MAX_SAMPLES];
+
+int
+main(int argc, char *argv[])
+{
+    FILE *psIn = stdin;
+    FILE *psOut = stdout;
+    tSampleFrameHeader sHeader;
+    uint32_t ui32Fill = 0;
+    uint32_t ui32Start = 0;
+    uint32_t ui32Used;
+    uint32_t ui32Status;
+    uint32_t ui32Channels;
+    uint32_t ui32Index;
+    uint32_t ui32Channel;
+    uint32_t ui32NextSeq = 0;
+    unsigned long ulSampleNum = 0;
+    unsigned long ulFrames = 0;
+    unsigned long ulSkipped = 0;
+    unsigned long ulLost = 0;
+    size_t nRead;
+
+    if (argc > 1 && (psIn = fopen(argv[1], "rb")) == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (argc > 2 && (psOut = fopen(argv[2], "w")) == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    for (;;) {
+        // Move any partial frame to the start and top up the buffer
+        memmove(g_pui8Input, g_pui8Input + ui32Start, ui32Fill - ui32Start);
+        ui32Fill -= ui32Start;
+        ui32Start = 0;
+
+        nRead = fread(g_pui8Input + ui32Fill, 1, INPUT_BUFFER_SIZE - ui32Fill, psIn);
+        if (nRead == 0 && ui32Fill == 0) {
+            break;
+        }
+        ui32Fill += (uint32_t)nRead;
+
+        while (ui32Start < ui32Fill) {
+            ui32Status = sampleFrameDecode(g_pui8Input + ui32Start, ui32Fill - ui32Start,
+                                           &sHeader, g_pui16Samples, &ui32Used);
+
+            if (ui32Status == SAMPLE_FRAME_NEED_MORE) {
+                break;
+            }
+            if (ui32Status == SAMPLE_FRAME_BAD) {
+                // Resynchronise on the next byte
+                ui32Start++;
+                ulSkipped++;
+                continue;
+            }
+            ui32Start += ui32Used;
+            ulFrames++;
+
+            if (ulFrames > 1 && sHeader.ui32Seq != ui32NextSeq) {
+                ulLost += sHeader.ui32Seq - ui32NextSeq;
+            }
+            ui32NextSeq = sHeader.ui32Seq + 1;
+
+            if (sHeader.ui8Flags & SAMPLE_FRAME_FLAG_SPECTRUM) {
+                for (ui32Index = 0; ui32Index < sHeader.ui16Count; ui32Index++) {
+                    fprintf(psOut, "%llu\t%.3f\t%.2f\n", (unsigned long long)sHeader.ui64Timestamp,
+                            (double)ui32Index * sHeader.ui32PeriodNs / 1000.0,
+                            (int16_t)g_pui16Samples[ui32Index] / 100.0);
+                }
+                continue;
+            }
+
+            ui32Channels = sampleFrameChannels(sHeader.ui16ChannelMask);
+            if (ui32Channels == 0) {
+                ui32Channels = 1;
+            }
+
+            for (ui32Index = 0; ui32Index + ui32Channels <= sHeader.ui16Count; ui32Index += ui32Channels) {
+                fprintf(psOut, "%lu\t%llu", ++ulSampleNum,
+                        (unsigned long long)(sHeader.ui64Timestamp +
+                        ((uint64_t)(ui32Index / ui32Channels) * sHeader.ui32PeriodNs) / 1000));
+                for (ui32Channel = 0; ui32Channel < ui32Channels; ui32Channel++) {
+                    fprintf(psOut, "\t%4d", g_pui16Samples[ui32Index + ui32Channel]);
+                }
+                fputc('\n', psOut);
+            }
+        }
+
+        // A full buffer that still cannot hold a frame means garbage input
+        if (nRead == 0) {
+            if (ui32Start == 0) {
+                ulSkipped += ui32Fill;
+                break;
+            }
+        }
+    }
+
+    fprintf(stderr, "%lu frames, %lu samples, %lu frames lost, %lu bytes skipped\n",
+            ulFrames, ulSampleNum, ulLost, ulSkipped);
+
+    if (psOut != stdout) {
+        fclose(psOut);
+    }
+    if (psIn != stdin) {
+        fclose(psIn);
+    }
+    return 0;
+}
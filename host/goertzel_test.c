@@ -0,0 +1,210 @@
+/*
+ * goertzel_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the Goertzel bank.  A mix of six tones, including the
+ * lowest and highest frequencies goertzelStart() accepts, is fed in uneven
+ * pieces and every bin compared with a double-precision DFT of the last
+ * complete window: amplitude within 0.05 codes, phase within 0.05 degrees.
+ * What remains is the rounding of the 32-bit states, about 0.02 codes.
+ * Also checks a full-scale square wave at the lowest bin (the worst case
+ * for the 32-bit states), 16-bit decimated input, the frequency range
+ * checks, and prints the cost per bin per sample for 1 to 16 bins.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -o goertzel_test host/goertzel_test.c goertzel.c -lm && ./goertzel_test
+ */
+
+// Standard C libraries
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Custom project-specific headers
+#include "goertzel.h"
+#include "timebase.h"
+#include "uartstdio.h"
+
+#define TEST_WINDOW         2048
+#define TEST_RATE           1000
+#define TEST_TONES          6
+#define BENCH_SAMPLES       65536
+
+static int g_iFailures;
+
+//*****************************************************************************/
+// Timebase in nanoseconds, and the console on stdout
+//*****************************************************************************/
+uint64_t
+timebaseNow(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (uint64_t)sNow.tv_sec * 1000000000 + sNow.tv_nsec;
+}
+
+uint64_t
+timebaseTicksToUs(uint64_t ui64Ticks)
+{
+    return ui64Ticks / 1000;
+}
+
+void
+UARTprintf(const char *pcString, ...)
+{
+    va_list vaArgP;
+
+    va_start(vaArgP, pcString);
+    vprintf(pcString, vaArgP);
+    va_end(vaArgP);
+}
+
+//*****************************************************************************/
+// Record a failed check
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, double dHz, double dValue)
+{
+    if (!bPass) {
+        printf("FAIL: %s at %.3f Hz: %.4f\n", pcWhat, dHz, dValue);
+        g_iFailures++;
+    }
+}
+
+//*****************************************************************************/
+// Difference of two angles in degrees, wrapped to +-180
+//*****************************************************************************/
+static double
+angleDiff(double dA, double dB)
+{
+    return fabs(remainder(dA - dB, 360.0));
+}
+
+int
+main(void)
+{
+    static uint16_t pui16Samples[3 * TEST_WINDOW];
+    static uint16_t pui16Bench[BENCH_SAMPLES];
+    float pfHz[GOERTZEL_MAX_BINS] =
+    {
+        (float)TEST_RATE / TEST_WINDOW, 37.3f, 50.0f, 123.45f, 250.0f,
+        TEST_RATE / 2.0f - (float)TEST_RATE / TEST_WINDOW
+    };
+    const double pdAmplitude[TEST_TONES] = { 600.0, 900.0, 300.0, 50.0, 200.0, 400.0 };
+    const double pdPhase[TEST_TONES] = { 0.3, -1.2, 2.0, 0.7, -2.5, 1.0 };
+    float fHz;
+    float fAmplitude;
+    float fPhase;
+    double dValue;
+    double dRe;
+    double dIm;
+    uint64_t ui64Start;
+    uint32_t ui32Bins;
+    uint32_t ui32Bin;
+    uint32_t ui32Index;
+
+    srand(3);
+    for (ui32Index = 0; ui32Index < 3 * TEST_WINDOW; ui32Index++)
+    {
+        dValue = 2048.0 + (rand() % 5) - 2;
+        for (ui32Bin = 0; ui32Bin < TEST_TONES; ui32Bin++)
+        {
+            dValue += pdAmplitude[ui32Bin] * cos(2.0 * M_PI * pfHz[ui32Bin] * ui32Index / TEST_RATE + pdPhase[ui32Bin]);
+        }
+        pui16Samples[ui32Index] = (uint16_t)lround(fmin(fmax(dValue, 0.0), 4095.0));
+    }
+
+    check(goertzelSetup(pfHz, TEST_TONES, TEST_WINDOW), "setup", 0.0, 0.0);
+    check(goertzelStart(TEST_RATE, 0), "start", 0.0, 0.0);
+    goertzelProcess(pui16Samples, 100);
+    goertzelProcess(pui16Samples + 100, 3 * TEST_WINDOW - 105);
+    goertzelProcess(pui16Samples + 3 * TEST_WINDOW - 5, 5);
+    check(goertzelWindows() == 3, "window count", 0.0, goertzelWindows());
+
+    // The last complete window is samples 2N to 3N - 1, with phases
+    // relative to its first sample
+    for (ui32Bin = 0; ui32Bin < TEST_TONES; ui32Bin++)
+    {
+        dRe = 0.0;
+        dIm = 0.0;
+        for (ui32Index = 0; ui32Index < TEST_WINDOW; ui32Index++)
+        {
+            dValue = pui16Samples[2 * TEST_WINDOW + ui32Index] - 2048.0;
+            dRe += dValue * cos(2.0 * M_PI * pfHz[ui32Bin] * ui32Index / TEST_RATE);
+            dIm -= dValue * sin(2.0 * M_PI * pfHz[ui32Bin] * ui32Index / TEST_RATE);
+        }
+
+        goertzelResult(ui32Bin, &fHz, &fAmplitude, &fPhase);
+        dValue = 2.0 * hypot(dRe, dIm) / TEST_WINDOW;
+        check(fabs(fAmplitude - dValue) <= 0.05, "amplitude error", fHz, fAmplitude - dValue);
+        check(angleDiff(fPhase, atan2(dIm, dRe) * 180.0 / M_PI) <= 0.05, "phase error", fHz,
+              angleDiff(fPhase, atan2(dIm, dRe) * 180.0 / M_PI));
+    }
+    goertzelReport();
+
+    // Frequencies closer than one cycle per window to DC or Nyquist
+    pfHz[0] = 0.4f;
+    goertzelSetup(pfHz, 1, TEST_WINDOW);
+    check(!goertzelStart(TEST_RATE, 0), "too close to DC accepted", pfHz[0], 0.0);
+    pfHz[0] = 499.8f;
+    goertzelSetup(pfHz, 1, TEST_WINDOW);
+    check(!goertzelStart(TEST_RATE, 0), "too close to Nyquist accepted", pfHz[0], 0.0);
+    check(!goertzelSetup(pfHz, 1, GOERTZEL_MAX_WINDOW + 1), "oversized window accepted", 0.0, 0.0);
+
+    // A full-scale square wave at the lowest bin drives the states hardest;
+    // its fundamental is 4 / pi of the half swing
+    pfHz[0] = (float)TEST_RATE / TEST_WINDOW;
+    for (ui32Index = 0; ui32Index < TEST_WINDOW; ui32Index++)
+    {
+        pui16Samples[ui32Index] = (cos(2.0 * M_PI * pfHz[0] * ui32Index / TEST_RATE) >= 0.0) ? 4095 : 0;
+    }
+    goertzelSetup(pfHz, 1, TEST_WINDOW);
+    goertzelStart(TEST_RATE, 0);
+    goertzelProcess(pui16Samples, TEST_WINDOW);
+    goertzelResult(0, &fHz, &fAmplitude, &fPhase);
+    check(fabs(fAmplitude - 4.0 * 2048.0 / M_PI) < 5.0, "square wave amplitude", fHz, fAmplitude);
+
+    // Decimated output is 16-bit; results stay in 12-bit codes
+    pfHz[0] = 100.0f;
+    for (ui32Index = 0; ui32Index < TEST_WINDOW; ui32Index++)
+    {
+        pui16Samples[ui32Index] = (uint16_t)lround(32768.0 + 16.0 * 1000.0 * cos(2.0 * M_PI * 100.0 * ui32Index / TEST_RATE));
+    }
+    goertzelSetup(pfHz, 1, TEST_WINDOW);
+    goertzelStart(TEST_RATE, 4);
+    goertzelProcess(pui16Samples, TEST_WINDOW);
+    goertzelResult(0, &fHz, &fAmplitude, &fPhase);
+    check(fabs(fAmplitude - 1000.0) < 0.5, "16-bit amplitude", fHz, fAmplitude);
+    check(fabs(fPhase) < 0.05, "16-bit phase", fHz, fPhase);
+
+    // Cost should grow linearly with the number of bins
+    for (ui32Index = 0; ui32Index < BENCH_SAMPLES; ui32Index++)
+    {
+        pui16Bench[ui32Index] = rand() & 4095;
+    }
+    for (ui32Bins = 1; ui32Bins <= GOERTZEL_MAX_BINS; ui32Bins++)
+    {
+        for (ui32Bin = 0; ui32Bin < ui32Bins; ui32Bin++)
+        {
+            pfHz[ui32Bin] = 10.0f + ui32Bin * 25.0f;
+        }
+        goertzelSetup(pfHz, ui32Bins, 1024);
+        goertzelStart(TEST_RATE, 0);
+
+        ui64Start = timebaseNow();
+        goertzelProcess(pui16Bench, BENCH_SAMPLES);
+        printf("%2u bins: %.2f ns per bin per sample\n", ui32Bins,
+               (double)(timebaseNow() - ui64Start) / BENCH_SAMPLES / ui32Bins);
+    }
+
+    printf("goertzel: %d failures\n", g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
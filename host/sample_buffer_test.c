@@ -0,0 +1,227 @@
+/*
+ * sample_buffer_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side stress test of the sample block ring.  A producer thread stands
+ * in for the timer-triggered ADC interrupt: at each tick of a software timer
+ * it appends the next sample to its block as ADC0SS3IntHandler() does, and
+ * commits full blocks.  The consumer drains every waiting block, then
+ * stalls for a random time.  Every block the consumer sees must carry the next sequence
+ * number after the dropped ones, with the samples of that sequence number,
+ * and committed plus dropped blocks must account for every block produced.
+ *
+ * Runs once unpaced, where the consumer's stalls overrun the ring, and once
+ * paced at 250 kHz and 1 MHz, printing the sustained rate, the worst tick
+ * latency and the commit time jitter.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -pthread -o sample_buffer_test host/sample_buffer_test.c sample_buffer.c && ./sample_buffer_test
+ */
+
+// Standard C libraries
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Custom project-specific headers
+#include "sample_buffer.h"
+#include "timebase.h"
+
+#define UNPACED_BLOCKS      2000000
+#define PACED_SECONDS       0.5
+
+// Producer settings and results
+typedef struct
+{
+    // Tick period in ns, 0 = as fast as possible
+    uint64_t ui64PeriodNs;
+    uint32_t ui32Blocks;
+
+    uint64_t ui64StartNs;
+    uint64_t ui64EndNs;
+    uint64_t ui64MaxLatencyNs;
+}
+tProducer;
+
+static volatile bool g_bProducerDone;
+static int g_iFailures;
+
+//*****************************************************************************/
+// Timebase in nanoseconds
+//*****************************************************************************/
+uint64_t
+timebaseNow(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (uint64_t)sNow.tv_sec * 1000000000 + sNow.tv_nsec;
+}
+
+uint64_t
+timebaseTicksToUs(uint64_t ui64Ticks)
+{
+    return ui64Ticks / 1000;
+}
+
+//*****************************************************************************/
+// The "interrupt": one sample per timer tick.  A late tick is served as soon
+// as possible, as the pending interrupt would be, so ticks are never lost.
+//*****************************************************************************/
+static void *
+producer(void *pvArg)
+{
+    tProducer *psProducer = pvArg;
+    tSampleBlock *psBlock;
+    uint64_t ui64Sample = 0;
+    uint64_t ui64Tick;
+    uint64_t ui64Now;
+    uint32_t ui32Fill = 0;
+
+    psBlock = sampleBufferReserve();
+    psProducer->ui64StartNs = timebaseNow();
+
+    while (ui64Sample < (uint64_t)psProducer->ui32Blocks * SAMPLE_BLOCK_SIZE)
+    {
+        if (psProducer->ui64PeriodNs) {
+            ui64Tick = psProducer->ui64StartNs + ui64Sample * psProducer->ui64PeriodNs;
+            while ((ui64Now = timebaseNow()) < ui64Tick)
+            {
+                // Let the consumer run unless the tick is close
+                if (ui64Tick - ui64Now > 20000) {
+                    sched_yield();
+                }
+            }
+            if (ui64Now - ui64Tick > psProducer->ui64MaxLatencyNs) {
+                psProducer->ui64MaxLatencyNs = ui64Now - ui64Tick;
+            }
+        }
+
+        psBlock->pui16Data[ui32Fill++] = (uint16_t)ui64Sample++;
+        if (ui32Fill == SAMPLE_BLOCK_SIZE) {
+            psBlock->ui32Count = SAMPLE_BLOCK_SIZE;
+            sampleBufferCommit(psBlock);
+            psBlock = sampleBufferReserve();
+            ui32Fill = 0;
+        }
+    }
+
+    psProducer->ui64EndNs = timebaseNow();
+    g_bProducerDone = true;
+    return NULL;
+}
+
+//*****************************************************************************/
+// Run the producer against a consumer on this thread, checking every block
+//*****************************************************************************/
+static void
+runStress(const char *pcName, uint64_t ui64PeriodNs, uint32_t ui32Blocks, uint32_t ui32StallNs)
+{
+    tProducer sProducer = { ui64PeriodNs, ui32Blocks, 0, 0, 0 };
+    pthread_t sThread;
+    tSampleBlock *psBlock;
+    struct timespec sStall = { 0, 0 };
+    uint64_t ui64Late;
+    uint64_t ui64MaxLate = 0;
+    double dSumLate = 0.0;
+    uint32_t ui32Expected = 0;
+    uint32_t ui32Received = 0;
+    uint32_t ui32Gaps = 0;
+    uint32_t ui32Index;
+    bool bDone;
+
+    sampleBufferInit();
+    g_bProducerDone = false;
+    pthread_create(&sThread, NULL, producer, &sProducer);
+
+    do
+    {
+        // Read the flag first, so a block committed just before it was set
+        // is still drained below
+        bDone = g_bProducerDone;
+
+        while ((psBlock = sampleBufferPeek()) != NULL)
+        {
+            if (psBlock->ui32Seq < ui32Expected || psBlock->ui32Count != SAMPLE_BLOCK_SIZE) {
+                printf("FAIL: %s: block %u after %u\n", pcName, psBlock->ui32Seq, ui32Expected);
+                g_iFailures++;
+                break;
+            }
+            ui32Gaps += psBlock->ui32Seq - ui32Expected;
+            for (ui32Index = 0; ui32Index < SAMPLE_BLOCK_SIZE; ui32Index++)
+            {
+                if (psBlock->pui16Data[ui32Index] != (uint16_t)(psBlock->ui32Seq * SAMPLE_BLOCK_SIZE + ui32Index)) {
+                    printf("FAIL: %s: block %u sample %u\n", pcName, psBlock->ui32Seq, ui32Index);
+                    g_iFailures++;
+                    break;
+                }
+            }
+
+            // Commit time against the tick of the block's last sample
+            if (ui64PeriodNs) {
+                ui64Late = psBlock->ui64Ticks - (sProducer.ui64StartNs +
+                           ((uint64_t)psBlock->ui32Seq * SAMPLE_BLOCK_SIZE + SAMPLE_BLOCK_SIZE - 1) * ui64PeriodNs);
+                ui64MaxLate = (ui64Late > ui64MaxLate) ? ui64Late : ui64MaxLate;
+                dSumLate += (double)ui64Late;
+            }
+
+            ui32Expected = psBlock->ui32Seq + 1;
+            ui32Received++;
+            sampleBufferRelease();
+        }
+
+        // A random stall, as the consumer loop would take for a slow sink
+        sStall.tv_nsec = ui32StallNs ? rand() % ui32StallNs : 0;
+        if (sStall.tv_nsec) {
+            nanosleep(&sStall, NULL);
+        }
+        else {
+            sched_yield();
+        }
+    }
+    while (!bDone);
+
+    pthread_join(sThread, NULL);
+
+    // The scratch blocks take sequence numbers too, so the gaps, including
+    // any after the last block received, are exactly the dropped blocks
+    ui32Gaps += ui32Blocks - ui32Expected;
+    if (ui32Received + sampleBufferDropped() != ui32Blocks || ui32Gaps != sampleBufferDropped() ||
+        sampleBufferCount() != 0 || sampleBufferHighWater() > SAMPLE_BUFFER_BLOCKS) {
+        printf("FAIL: %s: %u received, %u dropped, %u gaps, %u of %u blocks\n", pcName, ui32Received,
+               sampleBufferDropped(), ui32Gaps, ui32Received + sampleBufferDropped(), ui32Blocks);
+        g_iFailures++;
+    }
+
+    printf("%s: %.0f samples/s, %u of %u blocks dropped, high water %u", pcName,
+           (double)ui32Blocks * SAMPLE_BLOCK_SIZE * 1e9 / (sProducer.ui64EndNs - sProducer.ui64StartNs),
+           sampleBufferDropped(), ui32Blocks, sampleBufferHighWater());
+    if (ui64PeriodNs) {
+        printf(", worst tick latency %.1f us, commit %.2f us mean / %.1f us worst after the last tick",
+               sProducer.ui64MaxLatencyNs / 1e3, dSumLate / (ui32Received ? ui32Received : 1) / 1e3,
+               ui64MaxLate / 1e3);
+    }
+    printf("\n");
+}
+
+int
+main(void)
+{
+    srand(13);
+
+    // Stalls long enough to overrun the ring now and then
+    runStress("unpaced", 0, UNPACED_BLOCKS, 20000);
+
+    runStress("250 kHz", 4000, (uint32_t)(PACED_SECONDS * 250000 / SAMPLE_BLOCK_SIZE), 100000);
+    runStress("1 MHz", 1000, (uint32_t)(PACED_SECONDS * 1000000 / SAMPLE_BLOCK_SIZE), 100000);
+
+    printf("sample_buffer: %d failures\n", g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
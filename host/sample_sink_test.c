@@ -0,0 +1,335 @@
+/*
+ * sample_sink_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the channel order through the sinks.  For 1 to 6 pairs,
+ * on ADC0 alone and split across ADC0 and ADC1 with bDualADC, a block is laid
+ * out as the sequencers' uDMA channels write it, each module's sample sets
+ * interleaved in its own region, reordered into planes with
+ * sampleBlockPlanarize() as processBlock() does, and written through the
+ * uart-binary and file sinks, in full and as a short final block.  The
+ * decoded frame and the TSV columns must carry every sample of every channel
+ * in channel list order, with 12-bit and 16-bit samples.
+ *
+ * The binary sinks, uart-binary and spectrum, must turn echo off when they
+ * open and flush before turning it back on when they close; the other sinks
+ * must leave it alone.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -DUART_BUFFERED -I. -o sample_sink_test host/sample_sink_test.c sample_sink.c sample_buffer.c sample_frame.c crc.c && ./sample_sink_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "adc_functions.h"
+#include "flash_log.h"
+#include "sample_buffer.h"
+#include "sample_frame.h"
+#include "sample_sink.h"
+#include "spectrum.h"
+#include "timebase.h"
+#include "uartstdio.h"
+
+#define TEST_FILE           "sample_sink_test.tsv"
+#define TEST_LIST_ROUNDS    20
+
+tAcqConfig g_sAcqConfig;
+
+// The last frame written to the console UART
+static uint8_t g_pui8Written[SAMPLE_FRAME_MAX_SIZE];
+static uint32_t g_ui32WrittenLen;
+
+// Echo calls made by the sinks, in order: 'F' flush, '0' echo off, '1' on
+static char g_pcEchoCalls[16];
+static uint32_t g_ui32EchoCalls;
+
+// The configuration under test, for failure messages
+static char g_pcCase[96];
+
+static int g_iFailures;
+
+//*****************************************************************************/
+// Stand-ins for the acquisition, timebase, console, flash and spectrum
+// modules
+//*****************************************************************************/
+uint64_t timebaseNow(void) { return 0; }
+uint32_t getOutputRate(void) { return 1000; }
+uint64_t getBlockTimestampUs(uint32_t ui32Seq) { return (uint64_t)ui32Seq * 1000; }
+
+uint32_t
+getChannelMask(void)
+{
+    uint32_t ui32Mask = 0;
+    uint32_t ui32Channel;
+
+    for (ui32Channel = 0; ui32Channel < g_sAcqConfig.ui32NumChannels; ui32Channel++) {
+        ui32Mask |= 1 << g_sAcqConfig.pui8Channels[ui32Channel];
+    }
+    return ui32Mask;
+}
+
+int
+UARTwriteBinary(const uint8_t *pui8Buf, uint32_t ui32Len)
+{
+    if (ui32Len <= sizeof(g_pui8Written)) {
+        memcpy(g_pui8Written, pui8Buf, ui32Len);
+        g_ui32WrittenLen = ui32Len;
+    }
+    return ui32Len;
+}
+
+static void
+noteEcho(char cCall)
+{
+    if (g_ui32EchoCalls < sizeof(g_pcEchoCalls) - 1) {
+        g_pcEchoCalls[g_ui32EchoCalls++] = cCall;
+    }
+}
+
+void UARTEchoSet(bool bEnable) { noteEcho(bEnable ? '1' : '0'); }
+void UARTFlushTx(bool bDiscard) { (void)bDiscard; noteEcho('F'); }
+void UARTprintf(const char *pcString, ...) { (void)pcString; }
+int UARTwrite(const char *pcBuf, uint32_t ui32Len) { (void)pcBuf; return ui32Len; }
+int UARTTxBytesFree(void) { return UART_TX_BUFFER_SIZE; }
+bool UARTFormatCompile(tUARTFormat *psFormat, const char *pcString) { (void)psFormat; (void)pcString; return true; }
+void UARTFormatPrintf(const tUARTFormat *psFormat, ...) { (void)psFormat; }
+bool flashLogPresent(void) { return false; }
+uint32_t flashLogStartRun(void) { return 0; }
+void flashLogAppend(const uint8_t *pui8Data, uint32_t ui32Len, uint64_t ui64Timestamp) { (void)pui8Data; (void)ui32Len; (void)ui64Timestamp; }
+void flashLogService(void) {}
+void flashLogFlush(void) {}
+void flashLogGetStats(tFlashLogStats *psStats) { memset(psStats, 0, sizeof(*psStats)); }
+void spectrumInit(void) {}
+void spectrumAddSamples(const uint16_t *pui16Samples, uint32_t ui32Count) { (void)pui16Samples; (void)ui32Count; }
+uint32_t spectrumAverages(void) { return 0; }
+void spectrumGetDb(int16_t *pi16Db, float fSampleRate) { (void)pi16Db; (void)fSampleRate; }
+uint32_t spectrumTransformUs(void) { return 0; }
+
+//*****************************************************************************/
+// Checks
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat)
+{
+    if (!bPass) {
+        printf("FAIL: %s, %s\n", pcWhat, g_pcCase);
+        g_iFailures++;
+    }
+}
+
+// Sample ui32Set of channel list entry ui32Channel, tagged with the pair so
+// a sample in the wrong column cannot match
+static uint16_t
+sampleValue(uint32_t ui32Channel, uint32_t ui32Set)
+{
+    uint32_t ui32Pair = g_sAcqConfig.pui8Channels[ui32Channel];
+
+    if (g_sAcqConfig.ui32Decimation > 1) {
+        return (uint16_t)(0x8000 | (ui32Pair << 12) | (ui32Set * 37 + ui32Channel));
+    }
+    return (uint16_t)((ui32Pair << 8) | ui32Set);
+}
+
+// Lay out a block as the sequencers' uDMA channels write it and reorder it as
+// processBlock() does.  Returns the sample sets in the block.
+static uint32_t
+fillBlock(tSampleBlock *psBlock)
+{
+    uint32_t ui32NumChannels = g_sAcqConfig.ui32NumChannels;
+    uint32_t ui32Channels0 = g_sAcqConfig.bDualADC ? (ui32NumChannels + 1) / 2 : ui32NumChannels;
+    uint32_t ui32Channels1 = ui32NumChannels - ui32Channels0;
+    uint32_t ui32Sets = SAMPLE_BLOCK_SIZE / ui32NumChannels;
+    uint32_t ui32Channel;
+    uint32_t ui32Set;
+
+    memset(psBlock, 0xFF, sizeof(*psBlock));
+    psBlock->ui32Seq = 3;
+    psBlock->ui32Count = ui32Sets * ui32NumChannels;
+    for (ui32Set = 0; ui32Set < ui32Sets; ui32Set++) {
+        for (ui32Channel = 0; ui32Channel < ui32Channels0; ui32Channel++) {
+            psBlock->pui16Data[ui32Set * ui32Channels0 + ui32Channel] = sampleValue(ui32Channel, ui32Set);
+        }
+        for (ui32Channel = 0; ui32Channel < ui32Channels1; ui32Channel++) {
+            psBlock->pui16Data[ui32Sets * ui32Channels0 + ui32Set * ui32Channels1 + ui32Channel] =
+                sampleValue(ui32Channels0 + ui32Channel, ui32Set);
+        }
+    }
+
+    if (ui32NumChannels > 1) {
+        sampleBlockPlanarize(psBlock, ui32Sets, ui32Channels0, ui32Channels1);
+    }
+    return ui32Sets;
+}
+
+static void
+checkBinary(const tSampleBlock *psBlock, uint32_t ui32Count)
+{
+    const tSampleSink *psSink = sampleSinkGet(SINK_UART_BINARY);
+    uint16_t pui16Samples[SAMPLE_FRAME_MAX_SAMPLES];
+    tSampleFrameHeader sHeader;
+    uint32_t ui32NumChannels = g_sAcqConfig.ui32NumChannels;
+    uint32_t ui32Used;
+    uint32_t ui32Index;
+    bool bOrdered = true;
+
+    g_ui32WrittenLen = 0;
+    psSink->pfnWrite(psBlock, ui32Count, 0);
+    if (sampleFrameDecode(g_pui8Written, g_ui32WrittenLen, &sHeader, pui16Samples, &ui32Used) != SAMPLE_FRAME_OK) {
+        check(false, "frame does not decode");
+        return;
+    }
+    check(ui32Used == g_ui32WrittenLen, "frame length");
+    check(sHeader.ui16Count == ui32Count * ui32NumChannels, "frame sample count");
+    check(sHeader.ui16ChannelMask == getChannelMask(), "frame channel mask");
+    check(sampleFrameChannels(sHeader.ui16ChannelMask) == ui32NumChannels, "frame channels");
+    for (ui32Index = 0; ui32Index < ui32Count * ui32NumChannels; ui32Index++) {
+        bOrdered &= pui16Samples[ui32Index] == sampleValue(ui32Index % ui32NumChannels, ui32Index / ui32NumChannels);
+    }
+    check(bOrdered, "frame channel order");
+}
+
+static void
+checkFile(const tSampleBlock *psBlock, uint32_t ui32Count)
+{
+    const tSampleSink *psSink = sampleSinkGet(SINK_FILE);
+    char pcLine[256];
+    char *pcField;
+    uint32_t ui32Set;
+    uint32_t ui32Channel;
+    uint32_t ui32Lines = 0;
+    bool bOrdered = true;
+    FILE *psFile;
+
+    if (psSink->pfnOpen(TEST_FILE) != 0) {
+        check(false, "file sink open");
+        return;
+    }
+    psSink->pfnWrite(psBlock, ui32Count, 0);
+    psSink->pfnClose();
+
+    psFile = fopen(TEST_FILE, "r");
+    while (psFile && fgets(pcLine, sizeof(pcLine), psFile)) {
+        ui32Set = ui32Lines++;
+
+        // Skip the sample number and timestamp, then one column per channel
+        pcField = strchr(strchr(pcLine, '\t') + 1, '\t');
+        for (ui32Channel = 0; ui32Channel < g_sAcqConfig.ui32NumChannels; ui32Channel++) {
+            bOrdered &= pcField && strtoul(pcField + 1, &pcField, 10) == sampleValue(ui32Channel, ui32Set);
+        }
+        bOrdered &= pcField && *pcField == '\n';
+    }
+    if (psFile) {
+        fclose(psFile);
+    }
+    remove(TEST_FILE);
+
+    check(ui32Lines == ui32Count, "file line count");
+    check(bOrdered, "file channel order");
+}
+
+static void
+describeCase(void)
+{
+    uint32_t ui32Channel;
+    int iLen;
+
+    iLen = snprintf(g_pcCase, sizeof(g_pcCase), "pairs");
+    for (ui32Channel = 0; ui32Channel < g_sAcqConfig.ui32NumChannels; ui32Channel++) {
+        iLen += snprintf(g_pcCase + iLen, sizeof(g_pcCase) - iLen, " %u", g_sAcqConfig.pui8Channels[ui32Channel]);
+    }
+    snprintf(g_pcCase + iLen, sizeof(g_pcCase) - iLen, "%s, /%u", g_sAcqConfig.bDualADC ? " on ADC0 + ADC1" : "",
+             (unsigned)g_sAcqConfig.ui32Decimation);
+}
+
+static void
+checkChannelOrder(void)
+{
+    tSampleBlock sBlock;
+    uint32_t ui32NumChannels;
+    uint32_t ui32Round;
+    uint32_t ui32Pair;
+    uint32_t ui32Channel;
+    uint32_t ui32Sets;
+    uint32_t ui32Dual;
+    uint32_t ui32Decimation;
+
+    for (ui32NumChannels = 1; ui32NumChannels <= ADC_MAX_CHANNELS; ui32NumChannels++) {
+        for (ui32Round = 0; ui32Round < TEST_LIST_ROUNDS; ui32Round++) {
+            // A random ascending list of ui32NumChannels pairs
+            g_sAcqConfig.ui32NumChannels = ui32NumChannels;
+            for (ui32Pair = ui32Channel = 0; ui32Pair < ADC_MAX_CHANNELS; ui32Pair++) {
+                if ((uint32_t)rand() % (ADC_MAX_CHANNELS - ui32Pair) < ui32NumChannels - ui32Channel) {
+                    g_sAcqConfig.pui8Channels[ui32Channel++] = (uint8_t)ui32Pair;
+                }
+            }
+
+            for (ui32Dual = 0; ui32Dual < 2; ui32Dual++) {
+                for (ui32Decimation = 1; ui32Decimation <= 4; ui32Decimation *= 4) {
+                    g_sAcqConfig.bDualADC = ui32Dual != 0;
+                    g_sAcqConfig.ui32Decimation = ui32Decimation;
+                    describeCase();
+
+                    ui32Sets = fillBlock(&sBlock);
+                    checkBinary(&sBlock, ui32Sets);
+                    checkBinary(&sBlock, ui32Sets - 1);
+                    checkFile(&sBlock, ui32Sets);
+                    checkFile(&sBlock, 1);
+                }
+            }
+        }
+    }
+}
+
+//*****************************************************************************/
+// Echo is off while a binary sink is open
+//*****************************************************************************/
+static void
+checkEcho(void)
+{
+    const tSampleSink *psSink;
+    uint32_t ui32Sink;
+    bool bBinary;
+
+    for (ui32Sink = 0; ui32Sink < SINK_COUNT; ui32Sink++) {
+        psSink = sampleSinkGet(ui32Sink);
+        bBinary = (ui32Sink == SINK_UART_BINARY) || (ui32Sink == SINK_SPECTRUM);
+        snprintf(g_pcCase, sizeof(g_pcCase), "%s sink", psSink->pcName);
+        memset(g_pcEchoCalls, 0, sizeof(g_pcEchoCalls));
+        g_ui32EchoCalls = 0;
+
+        // The flash sink does not open without a flash part
+        if (psSink->pfnOpen(TEST_FILE) == 0) {
+            check(strcmp(g_pcEchoCalls, bBinary ? "0" : "") == 0, "echo on open");
+            psSink->pfnClose();
+            check(strcmp(g_pcEchoCalls, bBinary ? "0F1" : "") == 0, "flush and echo on close");
+        }
+        else {
+            check(ui32Sink == SINK_FLASH, "open");
+        }
+    }
+    remove(TEST_FILE);
+
+    check(sampleSinkGet(SINK_COUNT) == NULL, "unknown sink");
+}
+
+int
+main(void)
+{
+    srand(1);
+    g_sAcqConfig.ui32SpectrumSeconds = 1;
+
+    checkChannelOrder();
+    checkEcho();
+
+    printf("sample_sink: %d failures\n", g_iFailures);
+    return g_iFailures != 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * spectrum_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the averaged spectrum.  A two-tone signal with noise is
+ * fed to spectrumAddSamples() in odd-sized pieces and the result compared
+ * with a Welch average of double-precision DFTs (same Hann window, 50%
+ * overlap, mean removed per segment).  Every bin within 80 dB of the peak
+ * must agree to 0.01 dB.  Also prints the mean time per transform.
+ *
+ * Build and run on the host from the project directory, for any
+ * SPECTRUM_FFT_SIZE:
+ *
+ *     cc -I. -DSPECTRUM_FFT_SIZE=256 -o spectrum_test host/spectrum_test.c spectrum.c -lm && ./spectrum_test
+ */
+
+// Standard C libraries
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Custom project-specific headers
+#include "spectrum.h"
+#include "timebase.h"
+
+#define FFT_N               SPECTRUM_FFT_SIZE
+#define TEST_SEGMENTS       16
+#define TEST_SAMPLES        ((TEST_SEGMENTS + 1) * FFT_N / 2)
+#define TEST_RATE           1000.0
+
+//*****************************************************************************/
+// Timebase in nanoseconds for the transform timing
+//*****************************************************************************/
+uint64_t
+timebaseNow(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (uint64_t)sNow.tv_sec * 1000000000 + sNow.tv_nsec;
+}
+
+uint64_t
+timebaseTicksToUs(uint64_t ui64Ticks)
+{
+    return ui64Ticks / 1000;
+}
+
+int
+main(void)
+{
+    static uint16_t pui16Samples[TEST_SAMPLES];
+    static double pdWindow[FFT_N];
+    static double pdPower[SPECTRUM_BINS];
+    int16_t pi16Db[SPECTRUM_BINS];
+    double dWindowPower = 0.0;
+    double dPeak = 0.0;
+    double dMean;
+    double dValue;
+    double dRe;
+    double dIm;
+    double dWorst = 0.0;
+    uint32_t ui32Segments = 0;
+    uint32_t ui32Start;
+    uint32_t ui32Index;
+    uint32_t ui32Bin;
+    uint32_t ui32Piece;
+    int iFailures = 0;
+
+    // One tone between bins, one on a bin, and a little noise
+    srand(1);
+    for (ui32Index = 0; ui32Index < TEST_SAMPLES; ui32Index++)
+    {
+        pui16Samples[ui32Index] = (uint16_t)(2048 + (int)(800.0 * sin(2.0 * M_PI * 0.1457 * ui32Index) +
+                                                         300.0 * cos(2.0 * M_PI * 0.25 * ui32Index)) + rand() % 8);
+    }
+
+    spectrumInit();
+    for (ui32Index = 0; ui32Index < TEST_SAMPLES; ui32Index += ui32Piece)
+    {
+        ui32Piece = (TEST_SAMPLES - ui32Index < 7) ? TEST_SAMPLES - ui32Index : 7;
+        spectrumAddSamples(&pui16Samples[ui32Index], ui32Piece);
+    }
+    if (spectrumAverages() != TEST_SEGMENTS) {
+        printf("FAIL: %u transforms, expected %u\n", spectrumAverages(), TEST_SEGMENTS);
+        iFailures++;
+    }
+    spectrumGetDb(pi16Db, (float)TEST_RATE);
+    if (spectrumAverages() != 0) {
+        printf("FAIL: average not restarted\n");
+        iFailures++;
+    }
+
+    // Reference Welch average
+    for (ui32Index = 0; ui32Index < FFT_N; ui32Index++)
+    {
+        pdWindow[ui32Index] = 0.5 - 0.5 * cos(2.0 * M_PI * ui32Index / FFT_N);
+        dWindowPower += pdWindow[ui32Index] * pdWindow[ui32Index];
+    }
+    for (ui32Start = 0; ui32Start + FFT_N <= TEST_SAMPLES; ui32Start += FFT_N / 2, ui32Segments++)
+    {
+        dMean = 0.0;
+        for (ui32Index = 0; ui32Index < FFT_N; ui32Index++)
+        {
+            dMean += pui16Samples[ui32Start + ui32Index];
+        }
+        dMean /= FFT_N;
+
+        for (ui32Bin = 0; ui32Bin < SPECTRUM_BINS; ui32Bin++)
+        {
+            dRe = 0.0;
+            dIm = 0.0;
+            for (ui32Index = 0; ui32Index < FFT_N; ui32Index++)
+            {
+                dValue = (pui16Samples[ui32Start + ui32Index] - dMean) * pdWindow[ui32Index];
+                dRe += dValue * cos(2.0 * M_PI * ui32Bin * ui32Index / FFT_N);
+                dIm -= dValue * sin(2.0 * M_PI * ui32Bin * ui32Index / FFT_N);
+            }
+            pdPower[ui32Bin] += dRe * dRe + dIm * dIm;
+        }
+    }
+
+    // One-sided density in 0.01 dB, compared where the single-precision
+    // transform still has the resolution
+    for (ui32Bin = 0; ui32Bin < SPECTRUM_BINS; ui32Bin++)
+    {
+        pdPower[ui32Bin] /= ui32Segments * TEST_RATE * dWindowPower;
+        if (ui32Bin != 0 && ui32Bin != FFT_N / 2) {
+            pdPower[ui32Bin] *= 2.0;
+        }
+        dPeak = fmax(dPeak, pdPower[ui32Bin]);
+    }
+    for (ui32Bin = 0; ui32Bin < SPECTRUM_BINS; ui32Bin++)
+    {
+        if (pdPower[ui32Bin] < dPeak * 1e-8) {
+            continue;
+        }
+        dValue = fabs(1000.0 * log10(pdPower[ui32Bin]) - pi16Db[ui32Bin]);
+        dWorst = fmax(dWorst, dValue);
+        if (dValue > 1.0) {
+            printf("FAIL: bin %u is %.2f dB, reference %.3f dB\n", ui32Bin, pi16Db[ui32Bin] / 100.0,
+                   10.0 * log10(pdPower[ui32Bin]));
+            iFailures++;
+        }
+    }
+
+    printf("spectrum %d points: %u transforms, worst bin %.3f dB from the DFT, %u us per transform, %d failures\n",
+           FFT_N, ui32Segments, dWorst / 100.0, spectrumTransformUs(), iFailures);
+    return iFailures ? 1 : 0;
+}
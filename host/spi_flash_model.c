@@ -0,0 +1,415 @@
+/*
+ * spi_flash_model.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host model of a W25Q16-class SPI NOR flash.  Erasing sets a 4 KB sector to
+ * all ones and a page program can only clear bits, wrapping at the end of
+ * the page, as on the part.  A program or erase needs a write enable first
+ * and leaves the part busy for its datasheet time; a non-blocking transfer
+ * takes the time to shift its bytes at the SSI bit rate, after which a host
+ * timer signal calls the SSI interrupt handler as the real interrupt would.
+ * Blocking commands take no modelled time.
+ *
+ * A power loss can be scheduled after a number of programs and erases: the
+ * next one stops at a random byte and later ones change nothing until power
+ * is restored, which is how the test tears pages and erases.
+ */
+
+// Standard C libraries
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Custom project-specific headers
+#include "spi_flash.h"
+#include "spi_flash_model.h"
+
+static uint8_t *g_pui8Flash;
+static uint32_t g_ui32Size;
+static uint32_t g_ui32SpeedUp = 1;
+static uint32_t g_ui32BitRate = 1;
+
+// Status: write enable latch, and the time the program or erase in progress
+// ends
+static bool g_bWriteEnabled;
+static uint64_t g_ui64BusyUntilNs;
+
+// The non-blocking transfer being shifted.  g_bActive is set last and
+// cleared by the interrupt, so the signal handler only sees whole transfers.
+static volatile bool g_bActive;
+static bool g_bProgram;
+static uint32_t g_ui32Addr;
+static const uint8_t *g_pui8Source;
+static uint8_t *g_pui8Dest;
+static uint32_t g_ui32Count;
+static uint64_t g_ui64ShiftedNs;
+
+// Programs and erases left before the power fails, or negative for none
+// scheduled
+static int32_t g_i32PowerOperations = -1;
+static bool g_bPowerLost;
+
+static void (*g_pfnIntHandler)(void);
+static tSPIFlashModelCounts g_sCounts;
+
+//*****************************************************************************/
+// Host clock in nanoseconds
+//*****************************************************************************/
+static uint64_t
+nowNs(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (uint64_t)sNow.tv_sec * 1000000000 + sNow.tv_nsec;
+}
+
+//*****************************************************************************/
+// The SSI interrupt: raised once the transfer in flight has been shifted
+//*****************************************************************************/
+static void
+tick(int iSignal)
+{
+    (void)iSignal;
+
+    if (g_bActive && nowNs() >= g_ui64ShiftedNs) {
+        g_pfnIntHandler();
+    }
+}
+
+//*****************************************************************************/
+// Allocate a ui32Size byte part, erased, and start raising the SSI interrupt
+// through pfnIntHandler.  Returns false if the host timer cannot be set up.
+//*****************************************************************************/
+bool
+spiFlashModelInit(uint32_t ui32Size, void (*pfnIntHandler)(void))
+{
+    struct sigaction sAction;
+    struct sigevent sEvent;
+    struct itimerspec sPeriod;
+    timer_t sTimer;
+
+    g_pui8Flash = malloc(ui32Size);
+    if (!g_pui8Flash) {
+        return false;
+    }
+    g_ui32Size = ui32Size;
+    g_pfnIntHandler = pfnIntHandler;
+    spiFlashModelErase();
+
+    // SIGALRM is left to the test's timeout
+    memset(&sAction, 0, sizeof(sAction));
+    sAction.sa_handler = tick;
+    sAction.sa_flags = SA_RESTART;
+    sigemptyset(&sAction.sa_mask);
+    sigaction(SIGUSR1, &sAction, NULL);
+
+    memset(&sEvent, 0, sizeof(sEvent));
+    sEvent.sigev_notify = SIGEV_SIGNAL;
+    sEvent.sigev_signo = SIGUSR1;
+    if (timer_create(CLOCK_MONOTONIC, &sEvent, &sTimer) != 0) {
+        perror("spi flash model timer");
+        return false;
+    }
+
+    sPeriod.it_interval.tv_sec = 0;
+    sPeriod.it_interval.tv_nsec = SPI_FLASH_MODEL_TICK_US * 1000;
+    sPeriod.it_value = sPeriod.it_interval;
+    timer_settime(sTimer, 0, &sPeriod, NULL);
+
+    return true;
+}
+
+//*****************************************************************************/
+// Erase the whole part, as delivered
+//*****************************************************************************/
+void
+spiFlashModelErase(void)
+{
+    memset(g_pui8Flash, 0xFF, g_ui32Size);
+}
+
+//*****************************************************************************/
+// Divide every modelled time by ui32Factor, to run many power cuts quickly
+//*****************************************************************************/
+void
+spiFlashModelSpeedUp(uint32_t ui32Factor)
+{
+    g_ui32SpeedUp = ui32Factor ? ui32Factor : 1;
+}
+
+//*****************************************************************************/
+// Lose power during the program or erase after i32Operations more.  A
+// negative count restores power, which leaves the part idle, and cancels any
+// scheduled loss.
+//*****************************************************************************/
+void
+spiFlashModelPowerLoss(int32_t i32Operations)
+{
+    if (i32Operations < 0) {
+        g_bActive = false;
+        g_bWriteEnabled = false;
+        g_ui64BusyUntilNs = 0;
+    }
+
+    g_i32PowerOperations = i32Operations;
+    g_bPowerLost = false;
+}
+
+bool
+spiFlashModelPowerLost(void)
+{
+    return g_bPowerLost;
+}
+
+void
+spiFlashModelResetCounts(void)
+{
+    memset(&g_sCounts, 0, sizeof(g_sCounts));
+}
+
+const tSPIFlashModelCounts *
+spiFlashModelCounts(void)
+{
+    return &g_sCounts;
+}
+
+//*****************************************************************************/
+// Check that the part would accept a command, counting an error if not.  A
+// program or erase also needs the write enable latch, which it clears.
+//*****************************************************************************/
+static bool
+accepted(bool bWrite)
+{
+    bool bAccepted = !g_bActive && nowNs() >= g_ui64BusyUntilNs && (!bWrite || g_bWriteEnabled);
+
+    if (!bAccepted && !g_bPowerLost) {
+        g_sCounts.ui32Errors++;
+    }
+    if (bWrite) {
+        g_bWriteEnabled = false;
+    }
+
+    return bAccepted;
+}
+
+//*****************************************************************************/
+// Bytes of the next program or erase of ui32Bytes that get done before the
+// power fails: all of them, a random part of them, or none once it has
+// failed
+//*****************************************************************************/
+static uint32_t
+powerForBytes(uint32_t ui32Bytes)
+{
+    if (g_bPowerLost) {
+        return 0;
+    }
+    if (g_i32PowerOperations == 0) {
+        g_bPowerLost = true;
+        return rand() % (ui32Bytes + 1);
+    }
+    if (g_i32PowerOperations > 0) {
+        g_i32PowerOperations--;
+    }
+
+    return ui32Bytes;
+}
+
+//*****************************************************************************/
+// Program the first ui32Done of ui32Count bytes at ui32Addr, wrapping within
+// the page
+//*****************************************************************************/
+static void
+programBytes(uint32_t ui32Addr, const uint8_t *pui8Data, uint32_t ui32Count, uint32_t ui32Done)
+{
+    uint32_t ui32Page = ui32Addr & ~(SPI_FLASH_MODEL_PAGE_SIZE - 1);
+    uint32_t ui32Index;
+
+    // Only the last 256 bytes of a longer program are kept, as on the part
+    if (ui32Count > SPI_FLASH_MODEL_PAGE_SIZE) {
+        pui8Data += ui32Count - SPI_FLASH_MODEL_PAGE_SIZE;
+        ui32Done -= (ui32Done > ui32Count - SPI_FLASH_MODEL_PAGE_SIZE) ? ui32Count - SPI_FLASH_MODEL_PAGE_SIZE : ui32Done;
+    }
+
+    for (ui32Index = 0; ui32Index < ui32Done; ui32Index++)
+    {
+        g_pui8Flash[ui32Page + ((ui32Addr + ui32Index) & (SPI_FLASH_MODEL_PAGE_SIZE - 1))] &= pui8Data[ui32Index];
+    }
+}
+
+//*****************************************************************************/
+// Start shifting a non-blocking transfer of ui32Bytes command and data bytes
+//*****************************************************************************/
+static void
+startTransfer(bool bProgram, uint32_t ui32Addr, const uint8_t *pui8Source, uint8_t *pui8Dest,
+              uint32_t ui32Count, uint32_t ui32Bytes)
+{
+    g_bProgram = bProgram;
+    g_ui32Addr = ui32Addr;
+    g_pui8Source = pui8Source;
+    g_pui8Dest = pui8Dest;
+    g_ui32Count = ui32Count;
+    g_ui64ShiftedNs = nowNs() + (uint64_t)ui32Bytes * 8 * 1000000000 / g_ui32BitRate / g_ui32SpeedUp;
+
+    __sync_synchronize();
+    g_bActive = true;
+}
+
+//*****************************************************************************/
+// spi_flash.h API over the model
+//*****************************************************************************/
+void
+SPIFlashInit(uint32_t ui32Base, uint32_t ui32Clock, uint32_t ui32BitRate)
+{
+    (void)ui32Base;
+    (void)ui32Clock;
+
+    // Resetting the SSI abandons any transfer; the part itself carries on
+    g_bActive = false;
+    g_ui32BitRate = ui32BitRate;
+}
+
+void
+SPIFlashReadID(uint32_t ui32Base, uint8_t *pui8ManufacturerID, uint16_t *pui16DeviceID)
+{
+    (void)ui32Base;
+
+    *pui8ManufacturerID = SPI_FLASH_MODEL_MANUFACTURER;
+    *pui16DeviceID = SPI_FLASH_MODEL_DEVICE;
+}
+
+uint8_t
+SPIFlashReadStatus(uint32_t ui32Base)
+{
+    (void)ui32Base;
+
+    return ((nowNs() < g_ui64BusyUntilNs) ? 0x01 : 0x00) | (g_bWriteEnabled ? 0x02 : 0x00);
+}
+
+void
+SPIFlashWriteEnable(uint32_t ui32Base)
+{
+    (void)ui32Base;
+
+    if (accepted(false)) {
+        g_bWriteEnabled = true;
+    }
+}
+
+void
+SPIFlashSectorErase(uint32_t ui32Base, uint32_t ui32Addr)
+{
+    uint32_t ui32Sector = (ui32Addr % g_ui32Size) & ~(SPI_FLASH_MODEL_SECTOR_SIZE - 1);
+
+    (void)ui32Base;
+
+    if (!accepted(true)) {
+        return;
+    }
+
+    if (!g_bPowerLost) {
+        g_sCounts.ui32Erases++;
+        g_ui64BusyUntilNs = nowNs() + (uint64_t)SPI_FLASH_MODEL_ERASE_US * 1000 / g_ui32SpeedUp;
+    }
+    memset(&g_pui8Flash[ui32Sector], 0xFF, powerForBytes(SPI_FLASH_MODEL_SECTOR_SIZE));
+}
+
+void
+SPIFlashRead(uint32_t ui32Base, uint32_t ui32Addr, uint8_t *pui8Data, uint32_t ui32Count)
+{
+    uint32_t ui32Index;
+
+    (void)ui32Base;
+
+    if (!accepted(false)) {
+        memset(pui8Data, 0xFF, ui32Count);
+        return;
+    }
+
+    g_sCounts.ui32Reads++;
+    for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+    {
+        pui8Data[ui32Index] = g_pui8Flash[(ui32Addr + ui32Index) % g_ui32Size];
+    }
+}
+
+void
+SPIFlashPageProgramNonBlocking(tSPIFlashState *pState, uint32_t ui32Base, uint32_t ui32Addr,
+                               const uint8_t *pui8Data, uint32_t ui32Count, bool bUseDMA,
+                               uint32_t ui32TxChannel)
+{
+    (void)pState;
+    (void)ui32Base;
+    (void)bUseDMA;
+    (void)ui32TxChannel;
+
+    // A refused command still shifts its bytes and interrupts
+    if (accepted(true)) {
+        g_sCounts.ui32Programs++;
+        startTransfer(true, ui32Addr % g_ui32Size, pui8Data, NULL, ui32Count, 4 + ui32Count);
+    }
+    else {
+        startTransfer(false, 0, NULL, NULL, 0, 4 + ui32Count);
+    }
+}
+
+void
+SPIFlashFastReadNonBlocking(tSPIFlashState *pState, uint32_t ui32Base, uint32_t ui32Addr,
+                            uint8_t *pui8Data, uint32_t ui32Count, bool bUseDMA,
+                            uint32_t ui32TxChannel, uint32_t ui32RxChannel)
+{
+    (void)pState;
+    (void)ui32Base;
+    (void)bUseDMA;
+    (void)ui32TxChannel;
+    (void)ui32RxChannel;
+
+    if (accepted(false)) {
+        g_sCounts.ui32Reads++;
+        startTransfer(false, ui32Addr, NULL, pui8Data, ui32Count, 5 + ui32Count);
+    }
+    else {
+        memset(pui8Data, 0xFF, ui32Count);
+        startTransfer(false, 0, NULL, NULL, 0, 5 + ui32Count);
+    }
+}
+
+//*****************************************************************************/
+// Finish the transfer in flight once it has been shifted.  The data of a
+// read arrives now; a page program is latched as chip select rises, and the
+// part then stays busy programming it.
+//*****************************************************************************/
+uint32_t
+SPIFlashIntHandler(tSPIFlashState *pState)
+{
+    uint32_t ui32Index;
+
+    (void)pState;
+
+    if (!g_bActive) {
+        return SPI_FLASH_IDLE;
+    }
+    if (nowNs() < g_ui64ShiftedNs) {
+        return SPI_FLASH_WORKING;
+    }
+
+    if (g_bProgram) {
+        programBytes(g_ui32Addr, g_pui8Source, g_ui32Count, powerForBytes(g_ui32Count));
+        g_ui64BusyUntilNs = nowNs() + (uint64_t)SPI_FLASH_MODEL_PAGE_US * 1000 / g_ui32SpeedUp;
+    }
+    else if (g_pui8Dest) {
+        for (ui32Index = 0; ui32Index < g_ui32Count; ui32Index++)
+        {
+            g_pui8Dest[ui32Index] = g_pui8Flash[(g_ui32Addr + ui32Index) % g_ui32Size];
+        }
+    }
+
+    g_bActive = false;
+    return SPI_FLASH_DONE;
+}
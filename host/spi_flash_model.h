@@ -0,0 +1,50 @@
+/*
+ * spi_flash_model.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host model of a W25Q16-class SPI NOR flash behind SSI0 for the test of
+ * flash_log.c.  Provides the spi_flash.h functions the log uses over a RAM
+ * array, with the part's page program and sector erase times on the host
+ * clock, and raises the SSI interrupt from a host timer signal once a
+ * non-blocking transfer has been shifted.
+ */
+
+#ifndef SPI_FLASH_MODEL_H_
+#define SPI_FLASH_MODEL_H_
+
+// W25Q16JV geometry and JEDEC ID
+#define SPI_FLASH_MODEL_PAGE_SIZE       256
+#define SPI_FLASH_MODEL_SECTOR_SIZE     4096
+#define SPI_FLASH_MODEL_MANUFACTURER    0xEF
+#define SPI_FLASH_MODEL_DEVICE          0x4015
+
+// Datasheet typical times
+#define SPI_FLASH_MODEL_PAGE_US         400     // One page program
+#define SPI_FLASH_MODEL_ERASE_US        45000   // One 4 KB sector
+
+// How often the SSI interrupt is checked for a finished transfer
+#define SPI_FLASH_MODEL_TICK_US         20
+
+// Operation counts since the last spiFlashModelResetCounts().  Errors are
+// commands the part would have ignored: a program or erase without a write
+// enable, or any command while it is busy.
+typedef struct
+{
+    uint32_t ui32Programs;
+    uint32_t ui32Erases;
+    uint32_t ui32Reads;
+    uint32_t ui32Errors;
+}
+tSPIFlashModelCounts;
+
+bool spiFlashModelInit(uint32_t ui32Size, void (*pfnIntHandler)(void));
+void spiFlashModelErase(void);
+void spiFlashModelSpeedUp(uint32_t ui32Factor);
+void spiFlashModelPowerLoss(int32_t i32Operations);
+bool spiFlashModelPowerLost(void);
+void spiFlashModelResetCounts(void);
+const tSPIFlashModelCounts *spiFlashModelCounts(void);
+
+#endif /* SPI_FLASH_MODEL_H_ */
@@ -0,0 +1,671 @@
+/*
+ * spi_flash_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the uDMA paths of the SPI flash driver's non-blocking
+ * fast read and page program.  SSI0, its 8-entry FIFOs, the uDMA channels
+ * that feed them and a flash part on the wire are modelled in software: the
+ * channels run basic transfers and walk peripheral scatter-gather task lists
+ * the way the controller does, taking each task's size, increments and mode
+ * from its control word, and a finished channel raises the SSI's uDMA done
+ * interrupt.  One byte is shifted per step, and the driver's interrupt
+ * handler runs whenever an unmasked interrupt is pending.
+ *
+ * For uDMA jobs of 1023, 1024 and 1025 bytes, of SPI_FLASH_SG_TASKS KB and
+ * one byte over, and of random sizes, every byte must reach the buffer or the
+ * part, each channel must move exactly the job's bytes, a job of up to
+ * SPI_FLASH_SG_TASKS KB must run as one scatter-gather job of one task per
+ * KB, and a longer job must fall back to re-arming a basic transfer every KB.
+ * The interrupts each job takes are reported per MB moved.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -Ihost/stubs -o spi_flash_test host/spi_flash_test.c spi_flash.c && ./spi_flash_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "spi_flash.h"
+
+// Tiva C Series libraries
+#include "driverlib/ssi.h"
+#include "driverlib/udma.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_ssi.h"
+#include "inc/hw_types.h"
+#include "inc/hw_udma.h"
+
+// spi_flash.c's default, unless the build overrides both
+#ifndef SPI_FLASH_SG_TASKS
+#define SPI_FLASH_SG_TASKS  16
+#endif
+
+#define MODEL_FIFO_DEPTH    8
+#define MODEL_CHANNELS      32
+#define MODEL_FLASH_SIZE    0x10000
+#define MODEL_STEP_LIMIT    1000000
+#define MODEL_DR            ((uintptr_t)(SSI0_BASE + SSI_O_DR))
+
+#define TX_CHANNEL          (UDMA_CH11_SSI0TX & 0x1f)
+#define RX_CHANNEL          (UDMA_CH10_SSI0RX & 0x1f)
+
+#define CMD_PP              0x02
+#define CMD_FREAD           0x0b
+
+#define TEST_ADDRESS        0x1000
+#define TEST_RANDOM_JOBS    200
+
+// One uDMA channel: its current basic transfer or task, the task list of a
+// scatter-gather job, and what it has done since the job was set up
+typedef struct
+{
+    bool bEnabled;
+    uint32_t ui32Control;
+    uint32_t ui32Mode;
+    uint8_t *pui8Src;
+    uint8_t *pui8Dst;
+    bool bSrcInc;
+    bool bDstInc;
+    uint32_t ui32Left;
+    const tDMAControlTable *psTasks;
+    uint32_t ui32TasksLeft;
+    uint32_t ui32Jobs;
+    uint32_t ui32Tasks;
+    uint32_t ui32Arms;
+    uint32_t ui32Bytes;
+}
+tModelChannel;
+
+// One transmit FIFO entry, with the mode it was written in
+typedef struct
+{
+    uint8_t ui8Data;
+    bool bFrameEnd;
+    uint32_t ui32Mode;
+}
+tModelEntry;
+
+// SSI0 and the flash part on its wire
+typedef struct
+{
+    uint32_t ui32IM;
+    uint32_t ui32RIS;
+    uint32_t ui32MIS;
+    uint32_t ui32ICR;
+    uint32_t ui32DMACtl;
+    uint32_t ui32Mode;
+    tModelEntry psTx[MODEL_FIFO_DEPTH];
+    uint32_t ui32TxHead;
+    uint32_t ui32TxCount;
+    uint8_t pui8Rx[MODEL_FIFO_DEPTH];
+    uint32_t ui32RxHead;
+    uint32_t ui32RxCount;
+    uint32_t ui32Overruns;
+    uint32_t ui32FrameBytes;
+    uint32_t ui32Frames;
+    uint8_t ui8Cmd;
+    uint32_t ui32Addr;
+}
+tModelSSI;
+
+// Expected work of one channel for a job
+typedef struct
+{
+    uint32_t ui32Jobs;
+    uint32_t ui32Tasks;
+    uint32_t ui32Arms;
+    uint32_t ui32Bytes;
+}
+tChannelWork;
+
+static tModelChannel g_psChannels[MODEL_CHANNELS];
+static tModelSSI g_sSSI;
+static uint32_t g_ui32EnaClr;
+static uint32_t g_ui32Scratch;
+static uint32_t g_ui32Unmodelled;
+static uint32_t g_ui32TaskErrors;
+
+static uint8_t g_pui8Flash[MODEL_FLASH_SIZE];
+static uint8_t g_pui8Programmed[MODEL_FLASH_SIZE];
+static uint8_t g_pui8Buffer[MODEL_FLASH_SIZE];
+
+static int g_iFailures;
+
+//*****************************************************************************/
+// Model of the register file
+//*****************************************************************************/
+// Carry out the write-to-act registers.  This runs on every register access
+// and uDMA call, so each write has acted before the next one lands, and after
+// each pass of the interrupt handler for the last one.
+static void
+applyRegisters(void)
+{
+    uint32_t ui32Channel;
+
+    for (ui32Channel = 0; ui32Channel < MODEL_CHANNELS; ui32Channel++) {
+        if (g_ui32EnaClr & (1u << ui32Channel)) {
+            g_psChannels[ui32Channel].bEnabled = false;
+        }
+    }
+    g_ui32EnaClr = 0;
+    g_sSSI.ui32RIS &= ~(g_sSSI.ui32ICR & (SSI_ICR_DMATXIC | SSI_ICR_DMARXIC | SSI_ICR_RTIC));
+    g_sSSI.ui32ICR = 0;
+}
+
+volatile uint32_t *
+hwRegister(uint32_t ui32Address)
+{
+    applyRegisters();
+    switch (ui32Address)
+    {
+        case SSI0_BASE + SSI_O_IM:
+            return &g_sSSI.ui32IM;
+        case SSI0_BASE + SSI_O_RIS:
+            return &g_sSSI.ui32RIS;
+        case SSI0_BASE + SSI_O_MIS:
+            return &g_sSSI.ui32MIS;
+        case SSI0_BASE + SSI_O_ICR:
+            return &g_sSSI.ui32ICR;
+        case UDMA_ENACLR:
+            return &g_ui32EnaClr;
+        case UDMA_USEBURSTSET:
+        case UDMA_REQMASKCLR:
+        case UDMA_ALTCLR:
+        case UDMA_PRIOSET:
+        case UDMA_PRIOCLR:
+            return &g_ui32Scratch;
+        default:
+            g_ui32Unmodelled++;
+            return &g_ui32Scratch;
+    }
+}
+
+// The FIFO level interrupts follow the FIFOs; the uDMA done ones latch
+static void
+updateInterrupts(void)
+{
+    g_sSSI.ui32RIS &= SSI_MIS_DMATXMIS | SSI_MIS_DMARXMIS;
+    if (g_sSSI.ui32TxCount <= MODEL_FIFO_DEPTH / 2) {
+        g_sSSI.ui32RIS |= SSI_MIS_TXMIS;
+    }
+    if (g_sSSI.ui32RxCount >= MODEL_FIFO_DEPTH / 2) {
+        g_sSSI.ui32RIS |= SSI_MIS_RXMIS;
+    }
+    if (g_sSSI.ui32RxCount && !g_sSSI.ui32TxCount) {
+        g_sSSI.ui32RIS |= SSI_MIS_RTMIS;
+    }
+    g_sSSI.ui32MIS = g_sSSI.ui32RIS & g_sSSI.ui32IM;
+}
+
+//*****************************************************************************/
+// Model of SSI0 and the flash part
+//*****************************************************************************/
+static bool
+pushTx(uint32_t ui32Data, bool bFrameEnd)
+{
+    tModelEntry *psEntry;
+
+    if (g_sSSI.ui32TxCount == MODEL_FIFO_DEPTH) {
+        return false;
+    }
+    psEntry = &g_sSSI.psTx[(g_sSSI.ui32TxHead + g_sSSI.ui32TxCount++) % MODEL_FIFO_DEPTH];
+    psEntry->ui8Data = ui32Data & 0xff;
+    psEntry->bFrameEnd = bFrameEnd;
+    psEntry->ui32Mode = g_sSSI.ui32Mode;
+    return true;
+}
+
+static bool
+popRx(uint8_t *pui8Data)
+{
+    if (!g_sSSI.ui32RxCount) {
+        return false;
+    }
+    *pui8Data = g_sSSI.pui8Rx[g_sSSI.ui32RxHead];
+    g_sSSI.ui32RxHead = (g_sSSI.ui32RxHead + 1) % MODEL_FIFO_DEPTH;
+    g_sSSI.ui32RxCount--;
+    return true;
+}
+
+// Shift the next transmit entry to the part.  The part takes a command and
+// three address bytes; a fast read then has a dummy byte and answers from its
+// array, and a page program stores what follows.  Entries written in a read
+// mode bring the answer back into the receive FIFO.
+static void
+shiftByte(void)
+{
+    tModelEntry sEntry;
+    uint32_t ui32Index;
+    uint8_t ui8Reply = 0xff;
+
+    if (!g_sSSI.ui32TxCount) {
+        return;
+    }
+    sEntry = g_sSSI.psTx[g_sSSI.ui32TxHead];
+    g_sSSI.ui32TxHead = (g_sSSI.ui32TxHead + 1) % MODEL_FIFO_DEPTH;
+    g_sSSI.ui32TxCount--;
+
+    ui32Index = g_sSSI.ui32FrameBytes++;
+    if (ui32Index == 0) {
+        g_sSSI.ui8Cmd = sEntry.ui8Data;
+        g_sSSI.ui32Addr = 0;
+    } else if (ui32Index < 4) {
+        g_sSSI.ui32Addr = (g_sSSI.ui32Addr << 8) | sEntry.ui8Data;
+    } else if (g_sSSI.ui8Cmd == CMD_FREAD && ui32Index > 4) {
+        ui8Reply = g_pui8Flash[(g_sSSI.ui32Addr + ui32Index - 5) % MODEL_FLASH_SIZE];
+    } else if (g_sSSI.ui8Cmd == CMD_PP) {
+        g_pui8Programmed[(g_sSSI.ui32Addr + ui32Index - 4) % MODEL_FLASH_SIZE] = sEntry.ui8Data;
+    }
+
+    if (sEntry.ui32Mode != SSI_ADV_MODE_WRITE) {
+        if (g_sSSI.ui32RxCount == MODEL_FIFO_DEPTH) {
+            g_sSSI.ui32Overruns++;
+        } else {
+            g_sSSI.pui8Rx[(g_sSSI.ui32RxHead + g_sSSI.ui32RxCount++) % MODEL_FIFO_DEPTH] = ui8Reply;
+        }
+    }
+
+    if (sEntry.bFrameEnd) {
+        g_sSSI.ui32FrameBytes = 0;
+        g_sSSI.ui32Frames++;
+    }
+}
+
+void
+SSIAdvModeSet(uint32_t ui32Base, uint32_t ui32Mode)
+{
+    (void)ui32Base;
+    g_sSSI.ui32Mode = ui32Mode;
+}
+
+int32_t
+SSIDataPutNonBlocking(uint32_t ui32Base, uint32_t ui32Data)
+{
+    (void)ui32Base;
+    return pushTx(ui32Data, false);
+}
+
+int32_t
+SSIAdvDataPutFrameEndNonBlocking(uint32_t ui32Base, uint32_t ui32Data)
+{
+    (void)ui32Base;
+    return pushTx(ui32Data, true);
+}
+
+int32_t
+SSIDataGetNonBlocking(uint32_t ui32Base, uint32_t *pui32Data)
+{
+    uint8_t ui8Data;
+
+    (void)ui32Base;
+    if (!popRx(&ui8Data)) {
+        return 0;
+    }
+    *pui32Data = ui8Data;
+    return 1;
+}
+
+void
+SSIDMAEnable(uint32_t ui32Base, uint32_t ui32DMAFlags)
+{
+    (void)ui32Base;
+    g_sSSI.ui32DMACtl |= ui32DMAFlags;
+}
+
+void
+SSIDMADisable(uint32_t ui32Base, uint32_t ui32DMAFlags)
+{
+    (void)ui32Base;
+    g_sSSI.ui32DMACtl &= ~ui32DMAFlags;
+}
+
+// The blocking calls are not under test
+void SSIConfigSetExpClk(uint32_t ui32Base, uint32_t ui32SSIClk, uint32_t ui32Protocol, uint32_t ui32Mode, uint32_t ui32BitRate, uint32_t ui32DataWidth) { (void)ui32Base; (void)ui32SSIClk; (void)ui32Protocol; (void)ui32Mode; (void)ui32BitRate; (void)ui32DataWidth; }
+void SSIEnable(uint32_t ui32Base) { (void)ui32Base; }
+void SSIAdvFrameHoldEnable(uint32_t ui32Base) { (void)ui32Base; }
+void SSIDataPut(uint32_t ui32Base, uint32_t ui32Data) { (void)ui32Base; (void)ui32Data; }
+void SSIAdvDataPutFrameEnd(uint32_t ui32Base, uint32_t ui32Data) { (void)ui32Base; (void)ui32Data; }
+void SSIDataGet(uint32_t ui32Base, uint32_t *pui32Data) { (void)ui32Base; *pui32Data = 0; }
+
+//*****************************************************************************/
+// Model of the uDMA channels
+//*****************************************************************************/
+// Start a transfer of ui32Count items with the given control word and end
+// pointers, as the controller does for a basic structure or a task
+static void
+loadTransfer(tModelChannel *psChannel, uint32_t ui32Control, volatile void *pvSrcEnd, volatile void *pvDstEnd,
+             uint32_t ui32Count)
+{
+    psChannel->bSrcInc = (ui32Control & UDMA_SRC_INC_NONE) != UDMA_SRC_INC_NONE;
+    psChannel->bDstInc = (ui32Control & UDMA_DST_INC_NONE) != UDMA_DST_INC_NONE;
+    psChannel->pui8Src = (uint8_t *)pvSrcEnd - (psChannel->bSrcInc ? ui32Count - 1 : 0);
+    psChannel->pui8Dst = (uint8_t *)pvDstEnd - (psChannel->bDstInc ? ui32Count - 1 : 0);
+    psChannel->ui32Left = ui32Count;
+}
+
+// Fetch the next task of a scatter-gather job into the alternate structure
+static void
+loadTask(tModelChannel *psChannel)
+{
+    const tDMAControlTable *psTask = psChannel->psTasks++;
+    uint32_t ui32Mode = psTask->ui32Control & UDMA_CHCTL_XFERMODE_M;
+
+    psChannel->ui32TasksLeft--;
+    if (ui32Mode != (psChannel->ui32TasksLeft ? (UDMA_MODE_PER_SCATTER_GATHER | UDMA_MODE_ALT_SELECT) :
+                     UDMA_MODE_BASIC)) {
+        g_ui32TaskErrors++;
+    }
+    psChannel->ui32Mode = ui32Mode;
+    psChannel->ui32Tasks++;
+    loadTransfer(psChannel, psTask->ui32Control, psTask->pvSrcEndAddr, psTask->pvDstEndAddr,
+                 ((psTask->ui32Control & UDMA_CHCTL_XFERSIZE_M) >> UDMA_CHCTL_XFERSIZE_S) + 1);
+}
+
+// Move one byte; a finished transfer moves to the next task, or stops the
+// channel and raises the SSI's uDMA done interrupt
+static void
+moveByte(tModelChannel *psChannel, uint32_t ui32DoneInt)
+{
+    uint8_t ui8Data = 0;
+
+    if ((uintptr_t)psChannel->pui8Src == MODEL_DR) {
+        popRx(&ui8Data);
+    } else {
+        ui8Data = *psChannel->pui8Src;
+    }
+    if ((uintptr_t)psChannel->pui8Dst == MODEL_DR) {
+        pushTx(ui8Data, false);
+    } else {
+        *psChannel->pui8Dst = ui8Data;
+    }
+    psChannel->pui8Src += psChannel->bSrcInc;
+    psChannel->pui8Dst += psChannel->bDstInc;
+    psChannel->ui32Bytes++;
+
+    if (--psChannel->ui32Left) {
+        return;
+    }
+    if (psChannel->ui32Mode == (UDMA_MODE_PER_SCATTER_GATHER | UDMA_MODE_ALT_SELECT) &&
+        psChannel->ui32TasksLeft) {
+        loadTask(psChannel);
+        return;
+    }
+    psChannel->ui32Mode = UDMA_MODE_STOP;
+    psChannel->bEnabled = false;
+    g_sSSI.ui32RIS |= ui32DoneInt;
+}
+
+// Serve the SSI's uDMA requests: transmit while the FIFO has room, receive
+// while it has data
+static void
+serveDMA(void)
+{
+    tModelChannel *psTx = &g_psChannels[TX_CHANNEL];
+    tModelChannel *psRx = &g_psChannels[RX_CHANNEL];
+
+    while ((g_sSSI.ui32DMACtl & SSI_DMA_TX) && psTx->bEnabled && g_sSSI.ui32TxCount < MODEL_FIFO_DEPTH) {
+        moveByte(psTx, SSI_MIS_DMATXMIS);
+    }
+    while ((g_sSSI.ui32DMACtl & SSI_DMA_RX) && psRx->bEnabled && g_sSSI.ui32RxCount) {
+        moveByte(psRx, SSI_MIS_DMARXMIS);
+    }
+}
+
+void
+uDMAChannelControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control)
+{
+    applyRegisters();
+    g_psChannels[ui32ChannelStructIndex & 0x1f].ui32Control = ui32Control;
+}
+
+void
+uDMAChannelTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode, void *pvSrcAddr, void *pvDstAddr,
+                       uint32_t ui32TransferSize)
+{
+    tModelChannel *psChannel = &g_psChannels[ui32ChannelStructIndex & 0x1f];
+
+    applyRegisters();
+    if ((ui32ChannelStructIndex & UDMA_ALT_SELECT) || ui32Mode != UDMA_MODE_BASIC || !ui32TransferSize ||
+        ui32TransferSize > 1024) {
+        g_ui32TaskErrors++;
+    }
+
+    // The library stores end pointers; the model starts from them as the
+    // controller does
+    psChannel->ui32Mode = ui32Mode;
+    psChannel->ui32TasksLeft = 0;
+    psChannel->ui32Arms++;
+    loadTransfer(psChannel, psChannel->ui32Control,
+                 (uint8_t *)pvSrcAddr + (((psChannel->ui32Control & UDMA_SRC_INC_NONE) != UDMA_SRC_INC_NONE) ?
+                                         ui32TransferSize - 1 : 0),
+                 (uint8_t *)pvDstAddr + (((psChannel->ui32Control & UDMA_DST_INC_NONE) != UDMA_DST_INC_NONE) ?
+                                         ui32TransferSize - 1 : 0),
+                 ui32TransferSize);
+}
+
+void
+uDMAChannelScatterGatherSet(uint32_t ui32ChannelNum, uint32_t ui32TaskCount, void *pvTaskList,
+                            uint32_t ui32IsPeriphSG)
+{
+    tModelChannel *psChannel = &g_psChannels[ui32ChannelNum & 0x1f];
+
+    applyRegisters();
+    if (!ui32IsPeriphSG || !ui32TaskCount || ui32TaskCount > SPI_FLASH_SG_TASKS) {
+        g_ui32TaskErrors++;
+    }
+    psChannel->psTasks = pvTaskList;
+    psChannel->ui32TasksLeft = ui32TaskCount;
+    psChannel->ui32Jobs++;
+    loadTask(psChannel);
+}
+
+void
+uDMAChannelEnable(uint32_t ui32ChannelNum)
+{
+    applyRegisters();
+    g_psChannels[ui32ChannelNum & 0x1f].bEnabled = true;
+}
+
+void
+uDMAChannelDisable(uint32_t ui32ChannelNum)
+{
+    applyRegisters();
+    g_psChannels[ui32ChannelNum & 0x1f].bEnabled = false;
+}
+
+//*****************************************************************************/
+// Jobs
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, uint32_t ui32Count)
+{
+    if (!bPass) {
+        printf("FAIL: %s, %u bytes\n", pcWhat, ui32Count);
+        g_iFailures++;
+    }
+}
+
+static void
+resetModel(void)
+{
+    memset(g_psChannels, 0, sizeof(g_psChannels));
+    memset(&g_sSSI, 0, sizeof(g_sSSI));
+    memset(g_pui8Programmed, 0xff, sizeof(g_pui8Programmed));
+    memset(g_pui8Buffer, 0, sizeof(g_pui8Buffer));
+    g_ui32EnaClr = 0;
+    g_ui32Unmodelled = 0;
+    g_ui32TaskErrors = 0;
+}
+
+// Step the wire until the driver reports the transfer done and the last byte
+// has gone out.  Returns the number of interrupts taken, or 0 on a stall.
+static uint32_t
+runTransfer(tSPIFlashState *psState)
+{
+    uint32_t ui32Step, ui32Interrupts = 0;
+    bool bDone = false;
+
+    for (ui32Step = 0; ui32Step < MODEL_STEP_LIMIT; ui32Step++) {
+        serveDMA();
+        updateInterrupts();
+        if (!bDone && g_sSSI.ui32MIS) {
+            ui32Interrupts++;
+            bDone = SPIFlashIntHandler(psState) == SPI_FLASH_DONE;
+            applyRegisters();
+        }
+        if (bDone && !g_sSSI.ui32TxCount) {
+            return ui32Interrupts;
+        }
+        shiftByte();
+    }
+    return 0;
+}
+
+static void
+checkChannel(uint32_t ui32Channel, const tChannelWork *psWork, const char *pcWhat, uint32_t ui32Count)
+{
+    const tModelChannel *psChannel = &g_psChannels[ui32Channel];
+    char pcLabel[80];
+
+    snprintf(pcLabel, sizeof(pcLabel), "%s: %u jobs, %u tasks, %u arms, %u bytes", pcWhat, psChannel->ui32Jobs,
+             psChannel->ui32Tasks, psChannel->ui32Arms, psChannel->ui32Bytes);
+    check(psChannel->ui32Jobs == psWork->ui32Jobs && psChannel->ui32Tasks == psWork->ui32Tasks &&
+          psChannel->ui32Arms == psWork->ui32Arms && psChannel->ui32Bytes == psWork->ui32Bytes, pcLabel,
+          ui32Count);
+}
+
+// Whether a uDMA job of ui32Count bytes fits one scatter-gather job
+static bool
+fitsTaskList(uint32_t ui32Count)
+{
+    return ui32Count > 1024 && (ui32Count + 1023) / 1024 <= SPI_FLASH_SG_TASKS;
+}
+
+// What a channel moving ui32Count bytes should do: one task per KB in a
+// single job, or else one basic transfer per KB
+static tChannelWork
+expectedWork(uint32_t ui32Count, bool bScatterGather)
+{
+    tChannelWork sWork;
+    uint32_t ui32KB = (ui32Count + 1023) / 1024;
+
+    bScatterGather = bScatterGather && ui32Count > 1024;
+    sWork.ui32Jobs = bScatterGather;
+    sWork.ui32Tasks = bScatterGather ? ui32KB : 0;
+    sWork.ui32Arms = bScatterGather ? 0 : ui32KB;
+    sWork.ui32Bytes = ui32Count;
+    return sWork;
+}
+
+// Fast read a uDMA job of ui32Count bytes; returns the interrupts taken
+static uint32_t
+runRead(uint32_t ui32Addr, uint32_t ui32Count)
+{
+    tSPIFlashState sState;
+    tChannelWork sTx, sRx;
+    uint32_t ui32Interrupts;
+
+    resetModel();
+    SPIFlashFastReadNonBlocking(&sState, SSI0_BASE, ui32Addr, g_pui8Buffer, ui32Count, true, UDMA_CH11_SSI0TX,
+                                UDMA_CH10_SSI0RX);
+    applyRegisters();
+    ui32Interrupts = runTransfer(&sState);
+
+    check(ui32Interrupts != 0, "read stalled", ui32Count);
+    check(memcmp(g_pui8Buffer, &g_pui8Flash[ui32Addr], ui32Count) == 0, "read data", ui32Count);
+    check(g_sSSI.ui32Frames == 1 && g_sSSI.ui32FrameBytes == 0, "read frame", ui32Count);
+    check(!g_sSSI.ui32Overruns && !g_ui32Unmodelled && !g_ui32TaskErrors, "read transfer", ui32Count);
+
+    // All but the last dummy byte go out by uDMA, in one job whenever the
+    // read is one
+    sRx = expectedWork(ui32Count, fitsTaskList(ui32Count));
+    sTx = expectedWork(ui32Count - 1, fitsTaskList(ui32Count));
+    checkChannel(RX_CHANNEL, &sRx, "read receive", ui32Count);
+    checkChannel(TX_CHANNEL, &sTx, "read transmit", ui32Count);
+    return ui32Interrupts;
+}
+
+// Page program a uDMA job of ui32Count bytes; the final byte of the program
+// goes out by PIO, so the program is one byte longer than the job
+static uint32_t
+runProgram(uint32_t ui32Addr, uint32_t ui32Count)
+{
+    tSPIFlashState sState;
+    tChannelWork sTx;
+    uint32_t ui32Interrupts;
+
+    resetModel();
+    SPIFlashPageProgramNonBlocking(&sState, SSI0_BASE, ui32Addr, g_pui8Flash, ui32Count + 1, true,
+                                   UDMA_CH11_SSI0TX);
+    applyRegisters();
+    ui32Interrupts = runTransfer(&sState);
+
+    check(ui32Interrupts != 0, "program stalled", ui32Count);
+    check(memcmp(&g_pui8Programmed[ui32Addr], g_pui8Flash, ui32Count + 1) == 0, "program data", ui32Count);
+    check(g_sSSI.ui32Frames == 1 && g_sSSI.ui32FrameBytes == 0, "program frame", ui32Count);
+    check(!g_ui32Unmodelled && !g_ui32TaskErrors, "program transfer", ui32Count);
+
+    sTx = expectedWork(ui32Count, fitsTaskList(ui32Count));
+    checkChannel(TX_CHANNEL, &sTx, "program transmit", ui32Count);
+    return ui32Interrupts;
+}
+
+static void
+report(const char *pcWhat, uint32_t ui32Count, uint32_t ui32Interrupts)
+{
+    printf("spi_flash: %s %5u bytes: %2u interrupts, %5u per MB\n", pcWhat, ui32Count, ui32Interrupts,
+           (uint32_t)(((uint64_t)ui32Interrupts << 20) / ui32Count));
+}
+
+int
+main(void)
+{
+    static const uint32_t pui32Sizes[] = {1023, 1024, 1025, SPI_FLASH_SG_TASKS * 1024,
+                                          SPI_FLASH_SG_TASKS * 1024 + 1};
+    uint32_t ui32Index, ui32Count, ui32Addr, ui32Read, ui32Program;
+    uint32_t ui32BasicRead = 0, ui32BasicProgram = 0;
+
+    srand(1);
+    for (ui32Index = 0; ui32Index < MODEL_FLASH_SIZE; ui32Index++) {
+        g_pui8Flash[ui32Index] = rand();
+    }
+
+    for (ui32Index = 0; ui32Index < sizeof(pui32Sizes) / sizeof(pui32Sizes[0]); ui32Index++) {
+        ui32Count = pui32Sizes[ui32Index];
+        ui32Read = runRead(TEST_ADDRESS, ui32Count);
+        ui32Program = runProgram(TEST_ADDRESS, ui32Count);
+        report("read   ", ui32Count, ui32Read);
+        report("program", ui32Count, ui32Program);
+
+        // A single job takes the interrupts of a single basic transfer
+        // however long it is; the fallback takes at least one per KB
+        if (ui32Count == 1024) {
+            ui32BasicRead = ui32Read;
+            ui32BasicProgram = ui32Program;
+        } else if (fitsTaskList(ui32Count)) {
+            check(ui32Read == ui32BasicRead, "read interrupts", ui32Count);
+            check(ui32Program == ui32BasicProgram, "program interrupts", ui32Count);
+        } else if (ui32Count > 1024) {
+            check(ui32Read >= (ui32Count + 1023) / 1024, "read re-arms per KB", ui32Count);
+            check(ui32Program >= (ui32Count + 1023) / 1024, "program re-arms per KB", ui32Count);
+        }
+    }
+
+    for (ui32Index = 0; ui32Index < TEST_RANDOM_JOBS; ui32Index++) {
+        ui32Count = 4 + rand() % (SPI_FLASH_SG_TASKS * 1024 + 4096);
+        ui32Addr = rand() % (MODEL_FLASH_SIZE - ui32Count);
+        runRead(ui32Addr, ui32Count);
+        runProgram(ui32Addr, ui32Count);
+    }
+
+    printf("spi_flash: %d failures\n", g_iFailures);
+    return g_iFailures != 0;
+}
@@ -0,0 +1,201 @@
+/*
+ * stats_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the streaming statistics.  Millions of 12-bit and 16-bit
+ * samples on two channels are fed through statsBlock() and the summaries
+ * compared with a two-pass double-precision reference: mean, standard
+ * deviation and RMS to 1e-9 relative, minimum, maximum, zero crossings and
+ * every histogram bin exactly.  The report must keep the pairs of the run
+ * after the caller's channel list changes.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -o stats_test host/stats_test.c stats.c -lm && ./stats_test
+ */
+
+// Standard C libraries
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "adc_functions.h"
+#include "sample_buffer.h"
+#include "stats.h"
+#include "uartstdio.h"
+
+#define TEST_SAMPLES        4000000
+#define TEST_CHANNELS       2
+
+static uint16_t *g_ppui16Samples[TEST_CHANNELS];
+static char g_pcReport[4096];
+static int g_iFailures;
+
+//*****************************************************************************/
+// Console output is collected for the report checks
+//*****************************************************************************/
+void
+UARTprintf(const char *pcString, ...)
+{
+    size_t nUsed = strlen(g_pcReport);
+    va_list vaArgP;
+
+    va_start(vaArgP, pcString);
+    vsnprintf(g_pcReport + nUsed, sizeof(g_pcReport) - nUsed, pcString, vaArgP);
+    va_end(vaArgP);
+}
+
+//*****************************************************************************/
+// Record a failed check
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, uint32_t ui32Shift, uint32_t ui32Channel)
+{
+    if (!bPass) {
+        printf("FAIL: %s, shift %u, channel %u\n", pcWhat, ui32Shift, ui32Channel);
+        g_iFailures++;
+    }
+}
+
+static bool
+closeTo(double dValue, double dReference)
+{
+    return fabs(dValue - dReference) <= 1e-9 * fmax(1.0, fabs(dReference));
+}
+
+//*****************************************************************************/
+// Compare one channel with the two-pass reference
+//*****************************************************************************/
+static void
+checkChannel(uint32_t ui32Channel, uint32_t ui32Shift)
+{
+    const uint16_t *pui16Samples = g_ppui16Samples[ui32Channel];
+    const uint32_t *pui32Histogram;
+    uint32_t pui32Bins[STATS_HIST_BINS] = { 0 };
+    tStatsSummary sSummary;
+    int32_t i32MidScale = 2048 << ui32Shift;
+    int32_t i32Band = STATS_CROSSING_HYSTERESIS << ui32Shift;
+    int32_t i32Side = 0;
+    uint32_t ui32Crossings = 0;
+    uint32_t ui32Min = 0xFFFF;
+    uint32_t ui32Max = 0;
+    uint32_t ui32Index;
+    double dMean = 0.0;
+    double dVariance = 0.0;
+    double dRMS = 0.0;
+    double dDiff;
+
+    for (ui32Index = 0; ui32Index < TEST_SAMPLES; ui32Index++)
+    {
+        dMean += pui16Samples[ui32Index];
+        ui32Min = (pui16Samples[ui32Index] < ui32Min) ? pui16Samples[ui32Index] : ui32Min;
+        ui32Max = (pui16Samples[ui32Index] > ui32Max) ? pui16Samples[ui32Index] : ui32Max;
+        pui32Bins[(uint32_t)pui16Samples[ui32Index] * STATS_HIST_BINS >> (12 + ui32Shift)]++;
+
+        if (pui16Samples[ui32Index] - i32MidScale > i32Band) {
+            ui32Crossings += (i32Side < 0);
+            i32Side = 1;
+        }
+        else if (pui16Samples[ui32Index] - i32MidScale < -i32Band) {
+            ui32Crossings += (i32Side > 0);
+            i32Side = -1;
+        }
+    }
+    dMean /= TEST_SAMPLES;
+
+    for (ui32Index = 0; ui32Index < TEST_SAMPLES; ui32Index++)
+    {
+        dDiff = pui16Samples[ui32Index] - dMean;
+        dVariance += dDiff * dDiff;
+        dDiff = pui16Samples[ui32Index] - (double)i32MidScale;
+        dRMS += dDiff * dDiff;
+    }
+    dVariance /= TEST_SAMPLES - 1;
+    dRMS = sqrt(dRMS / TEST_SAMPLES);
+
+    check(statsSummary(ui32Channel, &sSummary), "no summary", ui32Shift, ui32Channel);
+    check(sSummary.ui64Count == TEST_SAMPLES, "count", ui32Shift, ui32Channel);
+    check(closeTo(sSummary.dMean, dMean), "mean", ui32Shift, ui32Channel);
+    check(closeTo(sSummary.dStdDev, sqrt(dVariance)), "standard deviation", ui32Shift, ui32Channel);
+    check(closeTo(sSummary.dRMS, dRMS), "RMS", ui32Shift, ui32Channel);
+    check(sSummary.ui32Min == ui32Min && sSummary.ui32Max == ui32Max, "range", ui32Shift, ui32Channel);
+    check(sSummary.ui32Crossings == ui32Crossings, "crossings", ui32Shift, ui32Channel);
+
+    pui32Histogram = statsHistogram(ui32Channel);
+    check(memcmp(pui32Histogram, pui32Bins, sizeof(pui32Bins)) == 0, "histogram", ui32Shift, ui32Channel);
+
+    printf("shift %u channel %u: mean %.6f sd %.6f rms %.6f, %u crossings\n",
+           ui32Shift, ui32Channel, sSummary.dMean, sSummary.dStdDev, sSummary.dRMS, sSummary.ui32Crossings);
+}
+
+int
+main(void)
+{
+    static tSampleBlock sBlock;
+    uint8_t pui8Pairs[TEST_CHANNELS] = { 0, 3 };
+    uint32_t ui32Plane = SAMPLE_BLOCK_SIZE / TEST_CHANNELS;
+    uint32_t ui32Shift;
+    uint32_t ui32Channel;
+    uint32_t ui32Pos;
+    uint32_t ui32Count;
+    uint32_t ui32Index;
+
+    for (ui32Channel = 0; ui32Channel < TEST_CHANNELS; ui32Channel++)
+    {
+        g_ppui16Samples[ui32Channel] = malloc(TEST_SAMPLES * sizeof(uint16_t));
+    }
+
+    for (ui32Shift = 0; ui32Shift <= 4; ui32Shift += 4)
+    {
+        // A noisy sine about mid-scale, and a steady level near full scale
+        // where a large mean would cost a naive sum of squares its precision
+        srand(7);
+        for (ui32Index = 0; ui32Index < TEST_SAMPLES; ui32Index++)
+        {
+            g_ppui16Samples[0][ui32Index] = (uint16_t)((2048 + (int)(500 * sin(ui32Index * 0.01)) + rand() % 41 - 20) << ui32Shift);
+            g_ppui16Samples[1][ui32Index] = (uint16_t)(((4000 + rand() % 64) << ui32Shift) + (ui32Shift ? rand() % 16 : 0));
+        }
+
+        statsStart(pui8Pairs, TEST_CHANNELS, ui32Shift);
+
+        // Blocks hold one plane per channel; the last one is partly used
+        sBlock.ui32Count = ui32Plane * TEST_CHANNELS;
+        for (ui32Pos = 0; ui32Pos < TEST_SAMPLES; ui32Pos += ui32Count)
+        {
+            ui32Count = (TEST_SAMPLES - ui32Pos < ui32Plane) ? TEST_SAMPLES - ui32Pos : ui32Plane;
+            for (ui32Channel = 0; ui32Channel < TEST_CHANNELS; ui32Channel++)
+            {
+                memcpy(&sBlock.pui16Data[ui32Channel * ui32Plane], &g_ppui16Samples[ui32Channel][ui32Pos],
+                       ui32Count * sizeof(uint16_t));
+            }
+            statsBlock(&sBlock, ui32Count);
+        }
+
+        for (ui32Channel = 0; ui32Channel < TEST_CHANNELS; ui32Channel++)
+        {
+            checkChannel(ui32Channel, ui32Shift);
+        }
+    }
+
+    // The run keeps its own copy of the pairs
+    pui8Pairs[1] = 5;
+    check(statsChannelOfPair(3) == 1, "pair 3 lookup", 4, 1);
+    check(statsChannelOfPair(5) == ADC_MAX_CHANNELS, "pair 5 lookup", 4, 1);
+    g_pcReport[0] = '\0';
+    statsReport();
+    check(strstr(g_pcReport, "AIN6 - AIN7: mean") != NULL, "report label", 4, 1);
+    check(strstr(g_pcReport, "AIN10") == NULL, "report label of a changed list", 4, 1);
+    g_pcReport[0] = '\0';
+    statsReportHistogram(statsChannelOfPair(5));
+    check(strcmp(g_pcReport, "No such channel in the run.\n") == 0, "histogram of a pair not in the run", 4, 1);
+
+    printf("stats: %d failures\n", g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+/*
+ * adc.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the test that links
+ * the ADC code supplies these.
+ */
+
+#ifndef ADC_H_
+#define ADC_H_
+
+#include <stdint.h>
+
+void ADCIntClear(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCIntEnable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCIntDisable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCSequenceEnable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCSequenceDisable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCSequenceDMAEnable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCSequenceDMADisable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+int32_t ADCSequenceOverflow(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCSequenceOverflowClear(uint32_t ui32Base, uint32_t ui32SequenceNum);
+
+#endif /* ADC_H_ */
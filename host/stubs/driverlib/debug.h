@@ -0,0 +1,18 @@
+/*
+ * debug.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: ASSERT() maps to
+ * assert().
+ */
+
+#ifndef DEBUG_H_
+#define DEBUG_H_
+
+#include <assert.h>
+
+#define ASSERT(expr) assert(expr)
+
+#endif /* DEBUG_H_ */
@@ -0,0 +1,19 @@
+/*
+ * flash.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the test that links
+ * flash code supplies these over RAM.
+ */
+
+#ifndef FLASH_H_
+#define FLASH_H_
+
+#include <stdint.h>
+
+int32_t FlashErase(uint32_t ui32Address);
+int32_t FlashProgram(uint32_t *pui32Data, uint32_t ui32Address, uint32_t ui32Count);
+
+#endif /* FLASH_H_ */
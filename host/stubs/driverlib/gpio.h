@@ -0,0 +1,29 @@
+/*
+ * gpio.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the tests supply the
+ * functions they use.
+ */
+
+#ifndef GPIO_H_
+#define GPIO_H_
+
+#include <stdint.h>
+
+#define GPIO_PIN_0              0x00000001
+#define GPIO_PIN_1              0x00000002
+#define GPIO_PIN_2              0x00000004
+#define GPIO_PIN_3              0x00000008
+#define GPIO_PIN_4              0x00000010
+#define GPIO_PIN_5              0x00000020
+
+void GPIOPinConfigure(uint32_t ui32PinConfig);
+void GPIOPinTypeSSI(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeGPIOOutput(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val);
+
+#endif /* GPIO_H_ */
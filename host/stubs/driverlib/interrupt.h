@@ -0,0 +1,23 @@
+/*
+ * interrupt.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the tests supply the
+ * functions they use.
+ */
+
+#ifndef INTERRUPT_H_
+#define INTERRUPT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void IntEnable(uint32_t ui32Interrupt);
+void IntDisable(uint32_t ui32Interrupt);
+void IntPendSet(uint32_t ui32Interrupt);
+bool IntMasterEnable(void);
+bool IntMasterDisable(void);
+
+#endif /* INTERRUPT_H_ */
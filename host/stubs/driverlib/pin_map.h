@@ -0,0 +1,21 @@
+/*
+ * pin_map.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the TM4C123GH6PM
+ * pin mux values the project uses.
+ */
+
+#ifndef PIN_MAP_H_
+#define PIN_MAP_H_
+
+#define GPIO_PA0_U0RX           0x00000001
+#define GPIO_PA1_U0TX           0x00000401
+#define GPIO_PA2_SSI0CLK        0x00000802
+#define GPIO_PA3_SSI0FSS        0x00000C02
+#define GPIO_PA4_SSI0RX         0x00001002
+#define GPIO_PA5_SSI0TX         0x00001402
+
+#endif /* PIN_MAP_H_ */
@@ -0,0 +1,14 @@
+/*
+ * rom.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: nothing from it is
+ * used off the target.
+ */
+
+#ifndef ROM_H_
+#define ROM_H_
+
+#endif /* ROM_H_ */
@@ -0,0 +1,58 @@
+/*
+ * rom_map.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: there is no ROM, so
+ * MAP_ calls go to the library functions.
+ */
+
+#ifndef ROM_MAP_H_
+#define ROM_MAP_H_
+
+#define MAP_FlashErase                  FlashErase
+#define MAP_FlashProgram                FlashProgram
+#define MAP_SSIAdvDataPutFrameEnd       SSIAdvDataPutFrameEnd
+#define MAP_SSIAdvDataPutFrameEndNonBlocking SSIAdvDataPutFrameEndNonBlocking
+#define MAP_SSIAdvFrameHoldEnable       SSIAdvFrameHoldEnable
+#define MAP_SSIAdvModeSet               SSIAdvModeSet
+#define MAP_SSIConfigSetExpClk          SSIConfigSetExpClk
+#define MAP_SSIDataGet                  SSIDataGet
+#define MAP_SSIDataGetNonBlocking       SSIDataGetNonBlocking
+#define MAP_SSIDataPut                  SSIDataPut
+#define MAP_SSIDataPutNonBlocking       SSIDataPutNonBlocking
+#define MAP_SSIDMADisable               SSIDMADisable
+#define MAP_SSIDMAEnable                SSIDMAEnable
+#define MAP_SSIEnable                   SSIEnable
+#define MAP_SysCtlFlashSectorSizeGet    SysCtlFlashSectorSizeGet
+#define MAP_SysCtlPeripheralEnable      SysCtlPeripheralEnable
+#define MAP_SysCtlPeripheralPresent     SysCtlPeripheralPresent
+#define MAP_IntEnable                   IntEnable
+#define MAP_IntMasterDisable            IntMasterDisable
+#define MAP_IntMasterEnable             IntMasterEnable
+#define MAP_IntPendSet                  IntPendSet
+#define MAP_UARTCharGet                 UARTCharGet
+#define MAP_UARTCharGetNonBlocking      UARTCharGetNonBlocking
+#define MAP_UARTCharPut                 UARTCharPut
+#define MAP_UARTCharPutNonBlocking      UARTCharPutNonBlocking
+#define MAP_UARTCharsAvail              UARTCharsAvail
+#define MAP_UARTConfigSetExpClk         UARTConfigSetExpClk
+#define MAP_UARTDMAEnable               UARTDMAEnable
+#define MAP_UARTEnable                  UARTEnable
+#define MAP_UARTFIFOLevelSet            UARTFIFOLevelSet
+#define MAP_UARTIntClear                UARTIntClear
+#define MAP_UARTIntDisable              UARTIntDisable
+#define MAP_UARTIntEnable               UARTIntEnable
+#define MAP_UARTIntStatus               UARTIntStatus
+#define MAP_UARTSpaceAvail              UARTSpaceAvail
+#define MAP_uDMAChannelAssign           uDMAChannelAssign
+#define MAP_uDMAChannelAttributeDisable uDMAChannelAttributeDisable
+#define MAP_uDMAChannelAttributeEnable  uDMAChannelAttributeEnable
+#define MAP_uDMAChannelControlSet       uDMAChannelControlSet
+#define MAP_uDMAChannelDisable          uDMAChannelDisable
+#define MAP_uDMAChannelEnable           uDMAChannelEnable
+#define MAP_uDMAChannelModeGet          uDMAChannelModeGet
+#define MAP_uDMAChannelTransferSet      uDMAChannelTransferSet
+
+#endif /* ROM_MAP_H_ */
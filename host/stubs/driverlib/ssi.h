@@ -0,0 +1,46 @@
+/*
+ * ssi.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the SSI constants
+ * the SPI flash driver uses, with their TivaWare values; the test that links
+ * the driver supplies the functions.
+ */
+
+#ifndef SSI_H_
+#define SSI_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SSI_FRF_MOTO_MODE_0         0x00000000
+#define SSI_MODE_MASTER             0x00000000
+
+#define SSI_ADV_MODE_LEGACY         0x00000000
+#define SSI_ADV_MODE_WRITE          0x000000c0
+#define SSI_ADV_MODE_READ_WRITE     0x000001c0
+#define SSI_ADV_MODE_BI_READ        0x00000140
+#define SSI_ADV_MODE_BI_WRITE       0x00000040
+#define SSI_ADV_MODE_QUAD_READ      0x00000180
+#define SSI_ADV_MODE_QUAD_WRITE     0x00000080
+
+#define SSI_DMA_TX                  0x00000002
+#define SSI_DMA_RX                  0x00000001
+
+void SSIConfigSetExpClk(uint32_t ui32Base, uint32_t ui32SSIClk, uint32_t ui32Protocol, uint32_t ui32Mode,
+                        uint32_t ui32BitRate, uint32_t ui32DataWidth);
+void SSIEnable(uint32_t ui32Base);
+void SSIAdvModeSet(uint32_t ui32Base, uint32_t ui32Mode);
+void SSIAdvFrameHoldEnable(uint32_t ui32Base);
+void SSIDataPut(uint32_t ui32Base, uint32_t ui32Data);
+int32_t SSIDataPutNonBlocking(uint32_t ui32Base, uint32_t ui32Data);
+void SSIAdvDataPutFrameEnd(uint32_t ui32Base, uint32_t ui32Data);
+int32_t SSIAdvDataPutFrameEndNonBlocking(uint32_t ui32Base, uint32_t ui32Data);
+void SSIDataGet(uint32_t ui32Base, uint32_t *pui32Data);
+int32_t SSIDataGetNonBlocking(uint32_t ui32Base, uint32_t *pui32Data);
+void SSIDMAEnable(uint32_t ui32Base, uint32_t ui32DMAFlags);
+void SSIDMADisable(uint32_t ui32Base, uint32_t ui32DMAFlags);
+
+#endif /* SSI_H_ */
@@ -0,0 +1,32 @@
+/*
+ * sysctl.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the tests supply the
+ * functions they use.
+ */
+
+#ifndef SYSCTL_H_
+#define SYSCTL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SYSCTL_PERIPH_GPIOA     0xf0000800
+#define SYSCTL_PERIPH_GPIOF     0xf0000805
+#define SYSCTL_PERIPH_UDMA      0xf0000c00
+#define SYSCTL_PERIPH_UART0     0xf0001800
+#define SYSCTL_PERIPH_UART1     0xf0001801
+#define SYSCTL_PERIPH_UART2     0xf0001802
+#define SYSCTL_PERIPH_SSI0      0xf0001c00
+#define SYSCTL_PERIPH_WTIMER5   0xf0005c05
+
+uint32_t SysCtlClockGet(void);
+uint32_t SysCtlFlashSectorSizeGet(void);
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral);
+bool SysCtlPeripheralPresent(uint32_t ui32Peripheral);
+bool SysCtlPeripheralReady(uint32_t ui32Peripheral);
+
+#endif /* SYSCTL_H_ */
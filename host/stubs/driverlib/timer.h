@@ -0,0 +1,25 @@
+/*
+ * timer.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the timer constants
+ * the project uses, with their TivaWare values; the test that links the timer
+ * code supplies the functions.
+ */
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include <stdint.h>
+
+#define TIMER_CFG_PERIODIC_UP   0x00000032
+#define TIMER_A                 0x000000ff
+
+void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config);
+void TimerLoadSet64(uint32_t ui32Base, uint64_t ui64Value);
+void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer);
+uint64_t TimerValueGet64(uint32_t ui32Base);
+
+#endif /* TIMER_H_ */
@@ -0,0 +1,50 @@
+/*
+ * uart.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the UART constants
+ * the project uses, with their TivaWare values; the test that links the UART
+ * code supplies the functions.
+ */
+
+#ifndef UART_H_
+#define UART_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define UART_INT_RT             0x040
+#define UART_INT_TX             0x020
+#define UART_INT_RX             0x010
+
+#define UART_CONFIG_WLEN_8      0x00000060
+#define UART_CONFIG_STOP_ONE    0x00000000
+#define UART_CONFIG_PAR_NONE    0x00000000
+
+#define UART_FIFO_TX1_8         0x00000000
+#define UART_FIFO_TX4_8         0x00000002
+#define UART_FIFO_RX1_8         0x00000000
+
+#define UART_DMA_TX             0x00000002
+
+#define UART_CLOCK_PIOSC        0x00000005
+
+void UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk, uint32_t ui32Baud, uint32_t ui32Config);
+void UARTFIFOLevelSet(uint32_t ui32Base, uint32_t ui32TxLevel, uint32_t ui32RxLevel);
+void UARTEnable(uint32_t ui32Base);
+void UARTClockSourceSet(uint32_t ui32Base, uint32_t ui32Source);
+void UARTDMAEnable(uint32_t ui32Base, uint32_t ui32DMAFlags);
+bool UARTCharsAvail(uint32_t ui32Base);
+bool UARTSpaceAvail(uint32_t ui32Base);
+int32_t UARTCharGet(uint32_t ui32Base);
+int32_t UARTCharGetNonBlocking(uint32_t ui32Base);
+void UARTCharPut(uint32_t ui32Base, unsigned char ucData);
+bool UARTCharPutNonBlocking(uint32_t ui32Base, unsigned char ucData);
+void UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+void UARTIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags);
+uint32_t UARTIntStatus(uint32_t ui32Base, bool bMasked);
+void UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+
+#endif /* UART_H_ */
@@ -0,0 +1,82 @@
+/*
+ * udma.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the uDMA constants
+ * the project uses, with their TivaWare values; the test that links the uDMA
+ * code supplies the functions.
+ */
+
+#ifndef UDMA_H_
+#define UDMA_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define UDMA_ATTR_USEBURST          0x00000001
+#define UDMA_ATTR_ALTSELECT         0x00000002
+#define UDMA_ATTR_HIGH_PRIORITY     0x00000004
+#define UDMA_ATTR_REQMASK           0x00000008
+
+#define UDMA_MODE_STOP              0x00000000
+#define UDMA_MODE_BASIC             0x00000001
+#define UDMA_MODE_AUTO              0x00000002
+#define UDMA_MODE_PINGPONG          0x00000003
+#define UDMA_MODE_MEM_SCATTER_GATHER 0x00000004
+#define UDMA_MODE_PER_SCATTER_GATHER 0x00000006
+#define UDMA_MODE_ALT_SELECT        0x00000001
+
+#define UDMA_DST_INC_8              0x00000000
+#define UDMA_DST_INC_16             0x40000000
+#define UDMA_DST_INC_NONE           0xc0000000
+#define UDMA_SRC_INC_8              0x00000000
+#define UDMA_SRC_INC_NONE           0x0c000000
+#define UDMA_SIZE_8                 0x00000000
+#define UDMA_SIZE_16                0x11000000
+#define UDMA_ARB_1                  0x00000000
+#define UDMA_ARB_2                  0x00004000
+#define UDMA_ARB_4                  0x00008000
+
+#define UDMA_PRI_SELECT             0x00000000
+#define UDMA_ALT_SELECT             0x00000020
+
+// One channel control structure, or one scatter-gather task
+typedef struct
+{
+    volatile void *pvSrcEndAddr;
+    volatile void *pvDstEndAddr;
+    volatile uint32_t ui32Control;
+    volatile uint32_t ui32Spare;
+}
+tDMAControlTable;
+
+#define UDMA_CHANNEL_ADC0           14
+#define UDMA_SEC_CHANNEL_ADC10      24
+#define UDMA_CH9_UART0TX            0x00000009
+#define UDMA_CH10_SSI0RX            0x0000000A
+#define UDMA_CH11_SSI0TX            0x0000000B
+#define UDMA_CH13_UART2TX           0x0001000D
+#define UDMA_CH14_ADC0_0            0x0000000E
+#define UDMA_CH23_UART1TX           0x00000017
+#define UDMA_CH24_ADC1_0            0x00000018
+
+void uDMAEnable(void);
+void uDMAControlBaseSet(void *pControlTable);
+uint32_t uDMAErrorStatusGet(void);
+void uDMAErrorStatusClear(void);
+void uDMAChannelAssign(uint32_t ui32Mapping);
+void uDMAChannelAttributeEnable(uint32_t ui32ChannelNum, uint32_t ui32Attr);
+void uDMAChannelAttributeDisable(uint32_t ui32ChannelNum, uint32_t ui32Attr);
+void uDMAChannelControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control);
+void uDMAChannelTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode, void *pvSrcAddr,
+                            void *pvDstAddr, uint32_t ui32TransferSize);
+void uDMAChannelScatterGatherSet(uint32_t ui32ChannelNum, uint32_t ui32TaskCount, void *pvTaskList,
+                                 uint32_t ui32IsPeriphSG);
+void uDMAChannelEnable(uint32_t ui32ChannelNum);
+void uDMAChannelDisable(uint32_t ui32ChannelNum);
+bool uDMAChannelIsEnabled(uint32_t ui32ChannelNum);
+uint32_t uDMAChannelModeGet(uint32_t ui32ChannelStructIndex);
+
+#endif /* UDMA_H_ */
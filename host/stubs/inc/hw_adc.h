@@ -0,0 +1,16 @@
+/*
+ * hw_adc.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the ADC register
+ * offsets the project uses.
+ */
+
+#ifndef HW_ADC_H_
+#define HW_ADC_H_
+
+#define ADC_O_SSFIFO0           0x00000048
+
+#endif /* HW_ADC_H_ */
@@ -0,0 +1,14 @@
+/*
+ * hw_flash.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: nothing from it is
+ * used off the target.
+ */
+
+#ifndef HW_FLASH_H_
+#define HW_FLASH_H_
+
+#endif /* HW_FLASH_H_ */
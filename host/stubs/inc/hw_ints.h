@@ -0,0 +1,22 @@
+/*
+ * hw_ints.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the TM4C123
+ * interrupt numbers the project uses.
+ */
+
+#ifndef HW_INTS_H_
+#define HW_INTS_H_
+
+#define INT_UART0               21
+#define INT_UART1               22
+#define INT_SSI0                23
+#define INT_ADC0SS0             30
+#define INT_UART2               49
+#define INT_UDMAERR             63
+#define INT_ADC1SS0             64
+
+#endif /* HW_INTS_H_ */
@@ -0,0 +1,24 @@
+/*
+ * hw_memmap.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the peripheral base
+ * addresses the project uses.
+ */
+
+#ifndef HW_MEMMAP_H_
+#define HW_MEMMAP_H_
+
+#define GPIO_PORTA_BASE         0x40004000
+#define SSI0_BASE               0x40008000
+#define UART0_BASE              0x4000C000
+#define UART1_BASE              0x4000D000
+#define UART2_BASE              0x4000E000
+#define ADC0_BASE               0x40038000
+#define ADC1_BASE               0x40039000
+#define GPIO_PORTF_BASE         0x40025000
+#define WTIMER5_BASE            0x40067000
+
+#endif /* HW_MEMMAP_H_ */
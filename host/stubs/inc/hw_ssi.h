@@ -0,0 +1,36 @@
+/*
+ * hw_ssi.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the SSI register
+ * offsets and interrupt bits the SPI flash driver uses.
+ */
+
+#ifndef HW_SSI_H_
+#define HW_SSI_H_
+
+#define SSI_O_DR                0x00000008
+#define SSI_O_IM                0x00000014
+#define SSI_O_RIS               0x00000018
+#define SSI_O_MIS               0x0000001C
+#define SSI_O_ICR               0x00000020
+
+#define SSI_IM_DMATXIM          0x00000020
+#define SSI_IM_DMARXIM          0x00000010
+#define SSI_IM_TXIM             0x00000008
+#define SSI_IM_RXIM             0x00000004
+#define SSI_IM_RTIM             0x00000002
+
+#define SSI_MIS_DMATXMIS        0x00000020
+#define SSI_MIS_DMARXMIS        0x00000010
+#define SSI_MIS_TXMIS           0x00000008
+#define SSI_MIS_RXMIS           0x00000004
+#define SSI_MIS_RTMIS           0x00000002
+
+#define SSI_ICR_DMATXIC         0x00000020
+#define SSI_ICR_DMARXIC         0x00000010
+#define SSI_ICR_RTIC            0x00000002
+
+#endif /* HW_SSI_H_ */
@@ -0,0 +1,14 @@
+/*
+ * hw_sysctl.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: nothing from it is
+ * used off the target.
+ */
+
+#ifndef HW_SYSCTL_H_
+#define HW_SYSCTL_H_
+
+#endif /* HW_SYSCTL_H_ */
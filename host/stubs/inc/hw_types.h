@@ -0,0 +1,21 @@
+/*
+ * hw_types.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: register accesses
+ * go through hwRegister(), which the test that links register-level code
+ * supplies to map each address onto its model.
+ */
+
+#ifndef HW_TYPES_H_
+#define HW_TYPES_H_
+
+#include <stdint.h>
+
+#define HWREG(x)                (*hwRegister(x))
+
+volatile uint32_t *hwRegister(uint32_t ui32Address);
+
+#endif /* HW_TYPES_H_ */
@@ -0,0 +1,16 @@
+/*
+ * hw_uart.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the UART register
+ * offsets the project uses.
+ */
+
+#ifndef HW_UART_H_
+#define HW_UART_H_
+
+#define UART_O_DR               0x00000000
+
+#endif /* HW_UART_H_ */
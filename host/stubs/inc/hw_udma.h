@@ -0,0 +1,25 @@
+/*
+ * hw_udma.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the uDMA channel
+ * attribute registers and control word fields the SPI flash driver uses.
+ */
+
+#ifndef HW_UDMA_H_
+#define HW_UDMA_H_
+
+#define UDMA_USEBURSTSET        0x400FF018
+#define UDMA_REQMASKCLR         0x400FF024
+#define UDMA_ENACLR             0x400FF02C
+#define UDMA_ALTCLR             0x400FF034
+#define UDMA_PRIOSET            0x400FF038
+#define UDMA_PRIOCLR            0x400FF03C
+
+#define UDMA_CHCTL_XFERSIZE_M   0x00003FF0
+#define UDMA_CHCTL_XFERSIZE_S   4
+#define UDMA_CHCTL_XFERMODE_M   0x00000007
+
+#endif /* HW_UDMA_H_ */
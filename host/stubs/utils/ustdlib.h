@@ -0,0 +1,16 @@
+/*
+ * ustdlib.h
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host stand-in for the TivaWare header of the same name: the project carries
+ * its own copy of the library, so this is that copy's header.
+ */
+
+#ifndef UTILS_USTDLIB_H_
+#define UTILS_USTDLIB_H_
+
+#include "../../../ustdlib.h"
+
+#endif /* UTILS_USTDLIB_H_ */
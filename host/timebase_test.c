@@ -0,0 +1,379 @@
+/*
+ * timebase_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the 64-bit timebase and of the console line reader.
+ *
+ * WTIMER5 is modelled as a free-running 64-bit counter read through its two
+ * 32-bit halves, TAV and TBV, which advances by a few ticks on every register
+ * read and now and then by a long stretch, as if an interrupt ran between
+ * two reads.  Every few reads the counter is moved to just below a carry out
+ * of the low half.  timebaseNow() must never go backwards and must fall
+ * between the counter values before and after the call; a naive low-then-
+ * high read of the same model is counted as a check that the model does
+ * hit the carry.
+ *
+ * timebaseTicksToUs() must match an exact conversion for clocks that are and
+ * are not a whole number of MHz, over centuries of ticks, and
+ * timebaseDriftPpm() must report a clock set off its nominal rate.
+ *
+ * Then consoleGetLine() is fed scripted input through the buffered
+ * uartstdio calls: CR, LF and CR LF ends, CR LF split across calls, ESC
+ * abandoning a line, backspace, a partial line and an overlong one.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -DUART_BUFFERED -I. -Ihost/stubs -o timebase_test host/timebase_test.c timebase.c uart_functions.c && ./timebase_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "cmdline.h"
+#include "data_transfer_functions.h"
+#include "timebase.h"
+#include "uart_functions.h"
+#include "uartstdio.h"
+
+// Tiva C Series libraries
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/uart.h"
+
+#define TEST_READS          2000000
+#define TEST_CARRY_EVERY    64          // Reads between moves to a carry
+#define TEST_CONVERSIONS    1000000
+
+static int g_iFailures;
+
+// Model of the wide timer: its count, and the system clock it runs from
+static uint64_t g_ui64Counter;
+static uint32_t g_ui32Clock;
+
+// Scripted console input
+static char g_pcInput[256];
+static uint32_t g_ui32InputHead;
+static uint32_t g_ui32InputTail;
+
+//*****************************************************************************/
+// Record a failed check
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, uint32_t ui32Count)
+{
+    if (!bPass) {
+        printf("FAIL: %s, after %u\n", pcWhat, ui32Count);
+        g_iFailures++;
+    }
+}
+
+//*****************************************************************************/
+// 64-bit random value
+//*****************************************************************************/
+static uint64_t
+random64(void)
+{
+    return ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+}
+
+//*****************************************************************************/
+// Register reads of the timer halves.  The counter runs on between any two
+// reads: a few ticks for the instructions in between, or a long stretch now
+// and then for an interrupt.
+//*****************************************************************************/
+static void
+timerAdvance(void)
+{
+    g_ui64Counter += (rand() % 256 == 0) ? (uint64_t)(rand() % 100000) : (uint64_t)(rand() % 8);
+}
+
+static uint32_t
+timerReadTAV(void)
+{
+    timerAdvance();
+    return (uint32_t)g_ui64Counter;
+}
+
+static uint32_t
+timerReadTBV(void)
+{
+    timerAdvance();
+    return (uint32_t)(g_ui64Counter >> 32);
+}
+
+//*****************************************************************************/
+// TivaWare's TimerValueGet64() over the model: the upper half is read on both
+// sides of the lower half, and the lower half again if it carried in between
+//*****************************************************************************/
+uint64_t
+TimerValueGet64(uint32_t ui32Base)
+{
+    uint32_t ui32High1;
+    uint32_t ui32High2;
+    uint32_t ui32Low;
+
+    (void)ui32Base;
+
+    ui32High1 = timerReadTBV();
+    ui32Low = timerReadTAV();
+    ui32High2 = timerReadTBV();
+    if (ui32High1 != ui32High2) {
+        ui32Low = timerReadTAV();
+    }
+
+    return ((uint64_t)ui32High2 << 32) | ui32Low;
+}
+
+//*****************************************************************************/
+// Reading the halves in turn, which is wrong by a whole carry if the lower
+// half wraps between the two reads
+//*****************************************************************************/
+static uint64_t
+timerValueNaive(void)
+{
+    uint32_t ui32Low = timerReadTAV();
+
+    return ((uint64_t)timerReadTBV() << 32) | ui32Low;
+}
+
+// The rest of the TivaWare calls the timebase and console code make
+void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config) { (void)ui32Base; (void)ui32Config; }
+void TimerLoadSet64(uint32_t ui32Base, uint64_t ui64Value) { (void)ui32Base; (void)ui64Value; }
+void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer) { (void)ui32Base; (void)ui32Timer; }
+uint32_t SysCtlClockGet(void) { return g_ui32Clock; }
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral) { (void)ui32Peripheral; }
+bool SysCtlPeripheralReady(uint32_t ui32Peripheral) { (void)ui32Peripheral; return true; }
+void GPIOPinConfigure(uint32_t ui32PinConfig) { (void)ui32PinConfig; }
+void GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins) { (void)ui32Port; (void)ui8Pins; }
+void GPIOPinTypeGPIOOutput(uint32_t ui32Port, uint8_t ui8Pins) { (void)ui32Port; (void)ui8Pins; }
+void GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val) { (void)ui32Port; (void)ui8Pins; (void)ui8Val; }
+void UARTClockSourceSet(uint32_t ui32Base, uint32_t ui32Source) { (void)ui32Base; (void)ui32Source; }
+void configureDMA(void) { }
+void UARTStdioConfig(uint32_t ui32Port, uint32_t ui32Baud, uint32_t ui32SrcClock) { (void)ui32Port; (void)ui32Baud; (void)ui32SrcClock; }
+void UARTprintf(const char *pcString, ...) { (void)pcString; }
+int UARTgets(char *pcBuf, uint32_t ui32Len) { (void)ui32Len; pcBuf[0] = '\0'; return 0; }
+bool CmdLineArgUInt(const char *pcArg, uint32_t *pui32Value) { (void)pcArg; (void)pui32Value; return false; }
+
+//*****************************************************************************/
+// Buffered console input, from the script
+//*****************************************************************************/
+int
+UARTRxBytesAvail(void)
+{
+    return (int)(g_ui32InputTail - g_ui32InputHead);
+}
+
+unsigned char
+UARTgetc(void)
+{
+    return (unsigned char)g_pcInput[g_ui32InputHead++];
+}
+
+//*****************************************************************************/
+// timebaseNow() across carries out of the low half
+//*****************************************************************************/
+static void
+checkMonotonic(void)
+{
+    uint64_t ui64Before;
+    uint64_t ui64Now;
+    uint64_t ui64Last = 0;
+    uint32_t ui32Torn = 0;
+    uint32_t ui32Read;
+
+    g_ui64Counter = 0xFFFFFFFFULL - 100;
+    for (ui32Read = 0; ui32Read < TEST_READS; ui32Read++)
+    {
+        // Move up to just below the next carry
+        if (ui32Read % TEST_CARRY_EVERY == 0) {
+            ui64Before = (((g_ui64Counter >> 32) + 1) << 32) - (uint64_t)(rand() % 32);
+            if (ui64Before > g_ui64Counter) {
+                g_ui64Counter = ui64Before;
+            }
+        }
+
+        ui64Before = g_ui64Counter;
+        ui64Now = timebaseNow();
+        check(ui64Now >= ui64Last, "timebase went backwards", ui32Read);
+        check(ui64Now >= ui64Before && ui64Now <= g_ui64Counter, "timebase outside the call", ui32Read);
+        ui64Last = ui64Now;
+
+        // The same carry through the naive read
+        if (ui32Read % TEST_CARRY_EVERY == 1) {
+            ui64Before = g_ui64Counter;
+            ui64Now = timerValueNaive();
+            ui32Torn += (ui64Now < ui64Before || ui64Now > g_ui64Counter);
+        }
+    }
+
+    printf("timebase: %u reads monotonic, naive read torn %u times\n", TEST_READS, ui32Torn);
+    check(ui32Torn > 0, "model never carried between the naive reads", ui32Read);
+}
+
+//*****************************************************************************/
+// Tick conversion and drift against the nominal rate
+//*****************************************************************************/
+static void
+checkConversion(void)
+{
+    static const uint32_t pui32Clocks[] = { 12500000, 16000000, 20000000, 50000000, 66666666, 80000000 };
+    static const int32_t pi32Ppm[] = { -1000, -50, -1, 0, 1, 100, 2500 };
+    uint64_t ui64Ticks;
+    uint64_t ui64NominalUs;
+    unsigned __int128 ui128Exact;
+    uint32_t ui32Clock;
+    uint32_t ui32Index;
+    uint32_t ui32Count;
+    int32_t i32Ppm;
+
+    for (ui32Clock = 0; ui32Clock < sizeof(pui32Clocks) / sizeof(pui32Clocks[0]); ui32Clock++)
+    {
+        g_ui32Clock = pui32Clocks[ui32Clock];
+        configureTimebase();
+
+        // Random counts up to 2^60, about 450 years at 80 MHz, plus one full
+        // day, which must come out in whole microseconds
+        for (ui32Count = 0; ui32Count < TEST_CONVERSIONS; ui32Count++)
+        {
+            ui64Ticks = random64() >> (rand() % 64);
+            ui128Exact = (unsigned __int128)ui64Ticks * 1000000 / g_ui32Clock;
+            check(timebaseTicksToUs(ui64Ticks) == (uint64_t)ui128Exact, "tick conversion", ui32Count);
+        }
+        check(timebaseTicksToUs((uint64_t)g_ui32Clock * 86400) == 86400000000ULL, "one day of ticks",
+              g_ui32Clock);
+
+        // An hour-long run with the sample clock off by a known amount
+        ui64NominalUs = 3600000000ULL;
+        for (ui32Index = 0; ui32Index < sizeof(pi32Ppm) / sizeof(pi32Ppm[0]); ui32Index++)
+        {
+            ui64Ticks = (uint64_t)((unsigned __int128)g_ui32Clock * 3600 * (uint64_t)(1000000 + pi32Ppm[ui32Index]) /
+                                   1000000);
+            i32Ppm = timebaseDriftPpm(ui64Ticks, ui64NominalUs);
+            check(i32Ppm >= pi32Ppm[ui32Index] - 1 && i32Ppm <= pi32Ppm[ui32Index], "drift", g_ui32Clock);
+        }
+        check(timebaseDriftPpm(12345, 0) == 0, "drift of an empty interval", g_ui32Clock);
+    }
+
+    printf("timebase: conversions exact at %u clock rates\n", (uint32_t)(sizeof(pui32Clocks) / sizeof(pui32Clocks[0])));
+}
+
+//*****************************************************************************/
+// Append to the scripted console input
+//*****************************************************************************/
+static void
+type(const char *pcText)
+{
+    while (*pcText) {
+        g_pcInput[g_ui32InputTail++] = *pcText++;
+    }
+}
+
+//*****************************************************************************/
+// One call of consoleGetLine(), which must return pcExpected as a complete
+// line, or no line if pcExpected is NULL.  The partial line is kept in the
+// caller's buffer between calls, so the same one is passed every time, and
+// filled with junk once a line is taken to show up a missing terminator.
+//*****************************************************************************/
+static void
+expectLine(uint32_t ui32Size, const char *pcExpected, uint32_t ui32Case)
+{
+    static char pcLine[32];
+    bool bLine;
+
+    bLine = consoleGetLine(pcLine, ui32Size);
+    if (pcExpected) {
+        check(bLine, "line not complete", ui32Case);
+        if (bLine && strcmp(pcLine, pcExpected)) {
+            printf("line \"%s\", expected \"%s\"\n", pcLine, pcExpected);
+            check(false, "line content", ui32Case);
+        }
+        memset(pcLine, 'X', sizeof(pcLine));
+    }
+    else {
+        check(!bLine, "unexpected line", ui32Case);
+        check(UARTRxBytesAvail() == 0, "input left unread", ui32Case);
+    }
+}
+
+//*****************************************************************************/
+// consoleGetLine() terminators and editing
+//*****************************************************************************/
+static void
+checkConsoleLines(void)
+{
+    // Each line end on its own
+    type("ab\r");
+    expectLine(16, "ab", 1);
+    type("cd\n");
+    expectLine(16, "cd", 2);
+
+    // CR LF ends one line, not a second empty one, even split across calls
+    type("ef\r\ngh\r");
+    expectLine(16, "ef", 3);
+    expectLine(16, "gh", 3);
+    expectLine(16, NULL, 3);
+    type("\nij\r\n");
+    expectLine(16, "ij", 4);
+    expectLine(16, NULL, 4);
+
+    // Bare line ends give empty lines, which stop a running capture
+    type("\r\n\r\n\n");
+    expectLine(16, "", 5);
+    expectLine(16, "", 5);
+    expectLine(16, "", 5);
+    expectLine(16, NULL, 5);
+
+    // ESC abandons the partial line
+    type("xyz\x1b");
+    expectLine(16, "", 6);
+    type("k\r");
+    expectLine(16, "k", 6);
+
+    // Backspace deletes, and does nothing on an empty line
+    type("ab\bc\r");
+    expectLine(16, "ac", 7);
+    type("\b\bq\b\br\r");
+    expectLine(16, "r", 8);
+
+    // A line typed across several calls
+    type("par");
+    expectLine(16, NULL, 9);
+    type("t");
+    expectLine(16, NULL, 9);
+    type("\r");
+    expectLine(16, "part", 9);
+
+    // Characters past the buffer are dropped, but the line still ends
+    type("0123456789\r");
+    expectLine(8, "0123456", 10);
+    type("s\r");
+    expectLine(8, "s", 10);
+
+    printf("timebase: console line cases passed\n");
+}
+
+//*****************************************************************************/
+// Main
+//*****************************************************************************/
+int
+main(void)
+{
+    srand(1);
+
+    g_ui32Clock = 20000000;
+    configureTimebase();
+    checkMonotonic();
+    checkConversion();
+    checkConsoleLines();
+
+    printf("timebase: %d failures\n", g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
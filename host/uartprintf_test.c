@@ -0,0 +1,335 @@
+/*
+ * uartprintf_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side test of the uartstdio formatter.  uartstdio.c is built
+ * unbuffered, so every character reaches UARTCharPut(), which captures it
+ * with the CR inserted before each LF removed.  Random lines mixing literal
+ * text with %c, %d, %i, %s, %u and %x conversions, with and without widths
+ * and zero fill, and with edge values such as 0, INT32_MIN, INT32_MAX and
+ * UINT32_MAX, are printed through UARTprintf() and through
+ * UARTFormatCompile() and UARTFormatPrintf(), and both must match
+ * snprintf().  The formatter pads %s on the right, so the reference uses
+ * %-Ns for it.
+ *
+ * Then checks the cases snprintf() cannot stand for: a % at the end of the
+ * string prints ERROR and does not compile, %X prints lower case, widths
+ * over 255 print but do not compile, and a format compiles with
+ * UART_FORMAT_MAX_FIELDS conversions but not with one more.
+ *
+ * Then times a typical log line, in ns/line, through UARTprintf(),
+ * UARTFormatPrintf() and, for scale, snprintf() into a buffer.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -I. -Ihost/stubs -o uartprintf_test host/uartprintf_test.c uartstdio.c && ./uartprintf_test
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Custom project-specific headers
+#include "uartstdio.h"
+
+// Tiva C Series libraries
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+
+#define RANDOM_LINES        20000
+#define LINE_MAX_SPECS      UART_FORMAT_MAX_FIELDS
+#define WIRE_SIZE           4096
+#define BENCH_LINES         200000
+
+//*****************************************************************************/
+// Capture of the UART output
+//*****************************************************************************/
+static char g_pcWire[WIRE_SIZE];
+static uint32_t g_ui32WireLen;
+
+static int g_iFailures;
+
+void
+UARTCharPut(uint32_t ui32Base, unsigned char ucData)
+{
+    (void)ui32Base;
+    if (ucData != '\r' && g_ui32WireLen < WIRE_SIZE) {
+        g_pcWire[g_ui32WireLen++] = (char)ucData;
+    }
+}
+
+int32_t UARTCharGet(uint32_t ui32Base) { (void)ui32Base; return '\n'; }
+bool SysCtlPeripheralPresent(uint32_t ui32Peripheral) { (void)ui32Peripheral; return true; }
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral) { (void)ui32Peripheral; }
+void UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk, uint32_t ui32Baud, uint32_t ui32Config) { (void)ui32Base; (void)ui32UARTClk; (void)ui32Baud; (void)ui32Config; }
+void UARTEnable(uint32_t ui32Base) { (void)ui32Base; }
+
+//*****************************************************************************/
+// Checks
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat, const char *pcFormat)
+{
+    if (!bPass) {
+        printf("FAIL: %s, \"%s\"\n", pcWhat, pcFormat);
+        g_iFailures++;
+    }
+}
+
+static bool
+wireIs(const char *pcExpected, uint32_t ui32Len)
+{
+    return g_ui32WireLen == ui32Len && memcmp(g_pcWire, pcExpected, ui32Len) == 0;
+}
+
+static uint64_t
+nowNs(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (uint64_t)sNow.tv_sec * 1000000000 + sNow.tv_nsec;
+}
+
+//*****************************************************************************/
+// Random lines against snprintf().  Each conversion spec is paired with the
+// spec that gives the same output from snprintf().
+//*****************************************************************************/
+typedef struct {
+    const char *pcSpec;
+    const char *pcReference;
+} tSpec;
+
+static const tSpec g_psSpecs[] = {
+    {"%d", "%d"},     {"%i", "%i"},       {"%1d", "%1d"},       {"%5d", "%5d"},   {"%05d", "%05d"},
+    {"%11d", "%11d"}, {"%011d", "%011d"}, {"%14d", "%14d"},     {"%014d", "%014d"},
+    {"%u", "%u"},     {"%3u", "%3u"},     {"%010u", "%010u"},   {"%12u", "%12u"},
+    {"%x", "%x"},     {"%2x", "%2x"},     {"%08x", "%08x"},     {"%9x", "%9x"},
+    {"%c", "%c"},     {"%s", "%s"},       {"%6s", "%-6s"},      {"%20s", "%-20s"},
+    {"%%", "%%"},     {"%0d", "%0d"},     {"%150d", "%150d"},
+};
+
+#define NUM_SPECS           (sizeof(g_psSpecs) / sizeof(g_psSpecs[0]))
+
+static const uint32_t g_pui32Edges[] = {
+    0,          1,          9,          10,         99,         100,        999,        1000,
+    9999,       10000,      99999,      100000,     9999999,    10000000,   999999999,  1000000000,
+    0x7FFFFFFF, 0x80000000, 0x80000001, 0xFFFFFFFF, 0xFFFFFFFE, 0xFFFFFF9C, 0xFFFFFFF6, 0x0000FFFF,
+};
+
+#define NUM_EDGES           (sizeof(g_pui32Edges) / sizeof(g_pui32Edges[0]))
+
+static const char *const g_ppcStrings[] = {"", "a", "adc", "sample rate", "a string longer than twenty characters"};
+
+#define NUM_STRINGS         (sizeof(g_ppcStrings) / sizeof(g_ppcStrings[0]))
+
+static const char *const g_ppcLiterals[] = {"", " ", "x=", ", ", "\n", "value: ", "[", "] ", "a long literal run of text "};
+
+#define NUM_LITERALS        (sizeof(g_ppcLiterals) / sizeof(g_ppcLiterals[0]))
+
+static uint32_t
+randomValue(void)
+{
+    switch (rand() % 4) {
+    case 0:
+        return g_pui32Edges[rand() % NUM_EDGES];
+    case 1:
+        return (uint32_t)rand() % 1000 - 500;
+    default:
+        return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+}
+
+// Print one line through both formatter paths and check each against the
+// reference.  Every argument is passed as a uintptr_t: a string pointer for
+// %s and a 32-bit value otherwise, which on the 64-bit host is read back from
+// the low half of its argument slot.
+static void
+checkLine(const char *pcFormat, const char *pcReference, const uintptr_t *puiArgs)
+{
+    char pcExpected[WIRE_SIZE];
+    tUARTFormat sFormat;
+    int iLen;
+
+    iLen = snprintf(pcExpected, sizeof(pcExpected), pcReference, puiArgs[0], puiArgs[1], puiArgs[2], puiArgs[3],
+                    puiArgs[4], puiArgs[5], puiArgs[6], puiArgs[7]);
+
+    g_ui32WireLen = 0;
+    UARTprintf(pcFormat, puiArgs[0], puiArgs[1], puiArgs[2], puiArgs[3], puiArgs[4], puiArgs[5], puiArgs[6],
+               puiArgs[7]);
+    check(wireIs(pcExpected, iLen), "UARTprintf", pcFormat);
+
+    g_ui32WireLen = 0;
+    check(UARTFormatCompile(&sFormat, pcFormat), "UARTFormatCompile", pcFormat);
+    UARTFormatPrintf(&sFormat, puiArgs[0], puiArgs[1], puiArgs[2], puiArgs[3], puiArgs[4], puiArgs[5], puiArgs[6],
+                     puiArgs[7]);
+    check(wireIs(pcExpected, iLen), "UARTFormatPrintf", pcFormat);
+}
+
+static void
+checkRandomLines(void)
+{
+    char pcFormat[512];
+    char pcReference[512];
+    uintptr_t puiArgs[LINE_MAX_SPECS];
+    uint32_t ui32Line, ui32Specs, ui32Spec, ui32Args;
+    const tSpec *psSpec;
+    const char *pcLiteral;
+
+    for (ui32Line = 0; ui32Line < RANDOM_LINES; ui32Line++) {
+        // Build the line and its reference, and pick an argument for each
+        // conversion; unused arguments are 0
+        memset(puiArgs, 0, sizeof(puiArgs));
+        pcFormat[0] = pcReference[0] = '\0';
+        ui32Specs = rand() % (LINE_MAX_SPECS + 1);
+        for (ui32Spec = ui32Args = 0; ui32Spec < ui32Specs; ui32Spec++) {
+            pcLiteral = g_ppcLiterals[rand() % NUM_LITERALS];
+            psSpec = &g_psSpecs[rand() % NUM_SPECS];
+            strcat(strcat(pcFormat, pcLiteral), psSpec->pcSpec);
+            strcat(strcat(pcReference, pcLiteral), psSpec->pcReference);
+
+            switch (psSpec->pcSpec[strlen(psSpec->pcSpec) - 1]) {
+            case '%':
+                break;
+            case 's':
+                puiArgs[ui32Args++] = (uintptr_t)g_ppcStrings[rand() % NUM_STRINGS];
+                break;
+            case 'c':
+                puiArgs[ui32Args++] = ' ' + rand() % 95;
+                break;
+            default:
+                puiArgs[ui32Args++] = randomValue();
+                break;
+            }
+        }
+        pcLiteral = g_ppcLiterals[rand() % NUM_LITERALS];
+        strcat(pcFormat, pcLiteral);
+        strcat(pcReference, pcLiteral);
+
+        checkLine(pcFormat, pcReference, puiArgs);
+    }
+}
+
+//*****************************************************************************/
+// Fixed cases
+//*****************************************************************************/
+static void
+checkEdges(void)
+{
+    static const uintptr_t puiMin[LINE_MAX_SPECS] = {0x80000000, 0x80000000, 0x80000000, 0x80000000};
+    static const uintptr_t puiNeg[LINE_MAX_SPECS] = {(uint32_t)-42, (uint32_t)-42, (uint32_t)-42, (uint32_t)-7};
+    static const uintptr_t puiNone[LINE_MAX_SPECS];
+    char pcFormat[64];
+    uint32_t ui32Index;
+    tUARTFormat sFormat;
+
+    // Named cases, also covered at random above
+    checkLine("%d|%011d|%12d|%u", "%d|%011d|%12d|%u", puiMin);
+    g_ui32WireLen = 0;
+    UARTprintf("%d|%011d|%12d|%u", puiMin[0], puiMin[1], puiMin[2], puiMin[3]);
+    check(wireIs("-2147483648|-2147483648| -2147483648|2147483648", 47), "INT32_MIN", "%d|%011d|%12d|%u");
+    checkLine("%05d|%5d|%02d|%03d", "%05d|%5d|%02d|%03d", puiNeg);
+    g_ui32WireLen = 0;
+    UARTprintf("%05d|%5d|%02d|%03d", puiNeg[0], puiNeg[1], puiNeg[2], puiNeg[3]);
+    check(wireIs("-0042|  -42|-42|-07", 19), "zero fill with negatives", "%05d|%5d|%02d|%03d");
+
+    // A % at the end of the string prints ERROR and does not compile
+    g_ui32WireLen = 0;
+    UARTprintf("rate %");
+    check(wireIs("rate ERROR", 10), "% at end", "rate %");
+    g_ui32WireLen = 0;
+    UARTprintf("rate %08");
+    check(wireIs("rate ERROR", 10), "width at end", "rate %08");
+    check(!UARTFormatCompile(&sFormat, "rate %"), "% at end compiled", "rate %");
+    check(!UARTFormatCompile(&sFormat, "rate %08"), "width at end compiled", "rate %08");
+    check(!UARTFormatCompile(&sFormat, "%q"), "unknown conversion compiled", "%q");
+
+    // %X is printed in lower case
+    g_ui32WireLen = 0;
+    UARTprintf("%X", 0xABCDEF);
+    check(wireIs("abcdef", 6), "%X", "%X");
+
+    // Widths past the field's 8 bits print but do not compile
+    checkLine("[%255d]", "[%255d]", puiNone);
+    g_ui32WireLen = 0;
+    UARTprintf("[%300u]", 5);
+    check(g_ui32WireLen == 302 && g_pcWire[299] == ' ' && g_pcWire[300] == '5', "width 300", "[%300u]");
+    check(!UARTFormatCompile(&sFormat, "[%256d]"), "width 256 compiled", "[%256d]");
+
+    // UART_FORMAT_MAX_FIELDS conversions compile, one more does not, and the
+    // rejected format still prints through UARTprintf()
+    pcFormat[0] = '\0';
+    for (ui32Index = 0; ui32Index < UART_FORMAT_MAX_FIELDS; ui32Index++) {
+        strcat(pcFormat, "%u ");
+    }
+    check(UARTFormatCompile(&sFormat, pcFormat), "most fields", pcFormat);
+    check(sFormat.ui32NumFields == UART_FORMAT_MAX_FIELDS + 1, "field count", pcFormat);
+    strcat(pcFormat, "%u");
+    check(!UARTFormatCompile(&sFormat, pcFormat), "too many fields compiled", pcFormat);
+    strcpy(pcFormat, "%%%%%%%%%%%%%%%%%%");
+    check(!UARTFormatCompile(&sFormat, pcFormat), "too many %% compiled", pcFormat);
+    g_ui32WireLen = 0;
+    UARTprintf(pcFormat);
+    check(wireIs("%%%%%%%%%", 9), "%% past the field limit", pcFormat);
+    g_ui32WireLen = 0;
+    UARTprintf("%u %u %u %u %u %u %u %u %u", 1, 2, 3, 4, 5, 6, 7, 8, 9);
+    check(wireIs("1 2 3 4 5 6 7 8 9", 17), "fields past the limit", "%u x9");
+}
+
+//*****************************************************************************/
+// ns/line for a typical log line
+//*****************************************************************************/
+#define BENCH_FORMAT        "run %u t=%08x ch%d: %6d mV (%s)\n"
+
+static double
+benchmark(int iPath)
+{
+    char pcBuffer[128];
+    uint32_t ui32Line;
+    uint64_t ui64Start;
+    tUARTFormat sFormat;
+    volatile int iSink = 0;
+
+    UARTFormatCompile(&sFormat, BENCH_FORMAT);
+    ui64Start = nowNs();
+    for (ui32Line = 0; ui32Line < BENCH_LINES; ui32Line++) {
+        g_ui32WireLen = 0;
+        switch (iPath) {
+        case 0:
+            UARTprintf(BENCH_FORMAT, ui32Line, ui32Line * 1000, ui32Line & 7, (int)(ui32Line % 6000) - 3000, "ok");
+            break;
+        case 1:
+            UARTFormatPrintf(&sFormat, ui32Line, ui32Line * 1000, ui32Line & 7, (int)(ui32Line % 6000) - 3000,
+                             "ok");
+            break;
+        default:
+            iSink += snprintf(pcBuffer, sizeof(pcBuffer), BENCH_FORMAT, ui32Line, ui32Line * 1000, ui32Line & 7,
+                              (int)(ui32Line % 6000) - 3000, "ok    ");
+            break;
+        }
+    }
+    (void)iSink;
+    return (double)(nowNs() - ui64Start) / BENCH_LINES;
+}
+
+int
+main(void)
+{
+    srand(1);
+    UARTStdioConfig(0, 115200, 16000000);
+
+    checkRandomLines();
+    checkEdges();
+
+    printf("UARTprintf: %.0f ns/line, UARTFormatPrintf: %.0f ns/line, snprintf: %.0f ns/line\n", benchmark(0),
+           benchmark(1), benchmark(2));
+
+    printf("uartprintf: %d failures\n", g_iFailures);
+    return g_iFailures != 0;
+}
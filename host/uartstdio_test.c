@@ -0,0 +1,725 @@
+/*
+ * uartstdio_test.c
+ *
+ *  Created on: May 13, 2024
+ *      Author: Tyler
+ *
+ * Host-side stress test of the buffered uartstdio rings.  The UART is
+ * modelled behind the TivaWare calls: a 16-byte transmit FIFO that shifts out
+ * onto a captured "wire", a 16-byte receive FIFO, and an interrupt that runs
+ * UARTStdioIntHandler() when it is pended, when the transmit FIFO drains
+ * below its trigger level with the transmit interrupt enabled, or when a
+ * character is received.
+ *
+ * An application thread writes random binary frames, text lines and
+ * UARTprintf() output, while an interrupt thread runs the handler, shifts
+ * out a random number of bytes per pass, stalls now and then so the transmit
+ * ring fills, and feeds a byte stream into the receive FIFO, which the main
+ * thread reads back with UARTgetc().  The wire must carry exactly what was
+ * written, with LF sent as CRLF, nothing may be stranded in the ring once
+ * the writer stops, and every received byte must arrive in order.  Then a
+ * typed line with backspaces and each kind of line end is received with
+ * echo on and read back with UARTgets().
+ *
+ * Built once with UART_BUFFERED alone and once, as the project is, with
+ * UART_TX_DMA as well, where a model of the transmit uDMA channel moves each
+ * transfer into the FIFO as it drains and raises the UART interrupt when the
+ * transfer is done.
+ *
+ * Then times the write path, bytes/s into the transmit ring, against a copy
+ * of the previous implementation, which advanced its indices with a modulo
+ * and rechecked the fill level through volatile pointers for every byte.
+ *
+ * Build and run on the host from the project directory:
+ *
+ *     cc -DUART_BUFFERED -I. -Ihost/stubs -pthread -o uartstdio_test host/uartstdio_test.c uartstdio.c && ./uartstdio_test
+ *     cc -DUART_BUFFERED -DUART_TX_DMA -I. -Ihost/stubs -pthread -o uartstdio_dma_test host/uartstdio_test.c uartstdio.c && ./uartstdio_dma_test
+ */
+
+// Standard C libraries
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Custom project-specific headers
+#include "uartstdio.h"
+
+// Tiva C Series libraries
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+
+#define TX_STRESS_BYTES     2000000
+#define RX_STRESS_BYTES     500000
+#define BENCH_ROUNDS        20000
+#define TEST_TIMEOUT_S      120
+#define MODEL_FIFO_DEPTH    16
+
+#ifdef UART_TX_DMA
+#define TEST_NAME           "uartstdio with uDMA transmit"
+#else
+#define TEST_NAME           "uartstdio"
+#endif
+
+// The transmit interrupt fires at the UART_FIFO_TX1_8 level
+#define MODEL_TX_TRIGGER    (MODEL_FIFO_DEPTH / 8)
+
+//*****************************************************************************/
+// Model of the UART.  The FIFOs and the interrupt mask belong to the
+// interrupt thread; the application only pends the interrupt.
+//*****************************************************************************/
+static uint8_t g_pui8TxFIFO[MODEL_FIFO_DEPTH];
+static uint32_t g_ui32TxFIFOHead;
+static uint32_t g_ui32TxFIFOCount;
+static uint8_t g_pui8RxFIFO[MODEL_FIFO_DEPTH];
+static uint32_t g_ui32RxFIFOHead;
+static uint32_t g_ui32RxFIFOCount;
+static uint32_t g_ui32IntMask;
+static bool g_bPended;
+
+// Set while the threads run: a writer waiting on a full ring then yields
+// the CPU to the interrupt thread when it pends the interrupt
+static bool g_bThreaded;
+
+// What the application wrote, expanded as it must appear on the wire, and
+// what the transmitter shifted out
+static uint8_t *g_pui8Expected;
+static uint32_t g_ui32ExpectedLen;
+static uint8_t *g_pui8Wire;
+static volatile uint32_t g_ui32WireLen;
+static volatile bool g_bWriterDone;
+
+#ifdef UART_TX_DMA
+// Model of the transmit uDMA channel, also owned by the interrupt thread
+static const uint8_t *g_pui8DMASrc;
+static uint32_t g_ui32DMALeft;
+static uint32_t g_ui32DMAMode;
+static bool g_bDMAEnabled;
+static uint32_t g_ui32DMATransfers;
+#endif
+
+static int g_iFailures;
+
+// The UART interrupt handler, installed by startup_ccs.c on the target
+extern void UARTStdioIntHandler(void);
+
+//*****************************************************************************/
+// Record a failed check
+//*****************************************************************************/
+static void
+check(bool bPass, const char *pcWhat)
+{
+    if (!bPass) {
+        printf("FAIL: %s\n", pcWhat);
+        g_iFailures++;
+    }
+}
+
+static uint64_t
+nowNs(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (uint64_t)sNow.tv_sec * 1000000000 + sNow.tv_nsec;
+}
+
+// Byte n of the test streams
+static uint8_t
+streamByte(uint32_t ui32Index)
+{
+    return (uint8_t)((ui32Index * 2654435761u) >> 24);
+}
+
+//*****************************************************************************/
+// TivaWare UART, interrupt and system control API over the model
+//*****************************************************************************/
+bool
+UARTSpaceAvail(uint32_t ui32Base)
+{
+    (void)ui32Base;
+    return g_ui32TxFIFOCount < MODEL_FIFO_DEPTH;
+}
+
+bool
+UARTCharPutNonBlocking(uint32_t ui32Base, unsigned char ucData)
+{
+    (void)ui32Base;
+    if (g_ui32TxFIFOCount == MODEL_FIFO_DEPTH) {
+        return false;
+    }
+    g_pui8TxFIFO[(g_ui32TxFIFOHead + g_ui32TxFIFOCount++) % MODEL_FIFO_DEPTH] = ucData;
+    return true;
+}
+
+bool
+UARTCharsAvail(uint32_t ui32Base)
+{
+    (void)ui32Base;
+    return g_ui32RxFIFOCount != 0;
+}
+
+int32_t
+UARTCharGetNonBlocking(uint32_t ui32Base)
+{
+    int32_t i32Char;
+
+    (void)ui32Base;
+    if (g_ui32RxFIFOCount == 0) {
+        return -1;
+    }
+    i32Char = g_pui8RxFIFO[g_ui32RxFIFOHead];
+    g_ui32RxFIFOHead = (g_ui32RxFIFOHead + 1) % MODEL_FIFO_DEPTH;
+    g_ui32RxFIFOCount--;
+    return i32Char;
+}
+
+uint32_t
+UARTIntStatus(uint32_t ui32Base, bool bMasked)
+{
+    uint32_t ui32Status = 0;
+
+    (void)ui32Base;
+    if (g_ui32TxFIFOCount <= MODEL_TX_TRIGGER) {
+        ui32Status |= UART_INT_TX;
+    }
+    if (g_ui32RxFIFOCount) {
+        ui32Status |= UART_INT_RX;
+    }
+    return bMasked ? (ui32Status & g_ui32IntMask) : ui32Status;
+}
+
+void
+UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    (void)ui32Base;
+    g_ui32IntMask |= ui32IntFlags;
+}
+
+void
+UARTIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    (void)ui32Base;
+    g_ui32IntMask &= ~ui32IntFlags;
+}
+
+void
+IntPendSet(uint32_t ui32Interrupt)
+{
+    (void)ui32Interrupt;
+    __atomic_store_n(&g_bPended, true, __ATOMIC_RELEASE);
+    if (g_bThreaded) {
+        sched_yield();
+    }
+}
+
+bool
+IntMasterDisable(void)
+{
+    return false;
+}
+
+bool
+IntMasterEnable(void)
+{
+    return false;
+}
+
+bool
+SysCtlPeripheralPresent(uint32_t ui32Peripheral)
+{
+    (void)ui32Peripheral;
+    return true;
+}
+
+#ifdef UART_TX_DMA
+//*****************************************************************************/
+// TivaWare uDMA API over the model of the transmit channel
+//*****************************************************************************/
+void
+uDMAChannelTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode, void *pvSrcAddr, void *pvDstAddr,
+                       uint32_t ui32TransferSize)
+{
+    (void)ui32ChannelStructIndex;
+    (void)pvDstAddr;
+    g_ui32DMAMode = ui32Mode;
+    g_pui8DMASrc = pvSrcAddr;
+    g_ui32DMALeft = ui32TransferSize;
+    g_ui32DMATransfers++;
+}
+
+uint32_t
+uDMAChannelModeGet(uint32_t ui32ChannelStructIndex)
+{
+    (void)ui32ChannelStructIndex;
+    return g_ui32DMAMode;
+}
+
+void
+uDMAChannelEnable(uint32_t ui32ChannelNum)
+{
+    (void)ui32ChannelNum;
+    g_bDMAEnabled = true;
+}
+
+void
+uDMAChannelDisable(uint32_t ui32ChannelNum)
+{
+    (void)ui32ChannelNum;
+    g_bDMAEnabled = false;
+}
+
+// Move up to ui32Budget bytes of the transfer into the transmit FIFO.  The
+// end of the transfer stops the channel and raises the UART interrupt.
+static void
+serveDMA(uint32_t ui32Budget)
+{
+    while (g_bDMAEnabled && g_ui32DMALeft && ui32Budget-- && UARTSpaceAvail(0))
+    {
+        UARTCharPutNonBlocking(0, *g_pui8DMASrc++);
+        if (--g_ui32DMALeft == 0) {
+            g_ui32DMAMode = UDMA_MODE_STOP;
+            g_bDMAEnabled = false;
+            g_bPended = true;
+        }
+    }
+}
+
+void uDMAChannelAssign(uint32_t ui32Mapping) { (void)ui32Mapping; }
+void uDMAChannelAttributeEnable(uint32_t ui32ChannelNum, uint32_t ui32Attr) { (void)ui32ChannelNum; (void)ui32Attr; }
+void uDMAChannelAttributeDisable(uint32_t ui32ChannelNum, uint32_t ui32Attr) { (void)ui32ChannelNum; (void)ui32Attr; }
+void uDMAChannelControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control) { (void)ui32ChannelStructIndex; (void)ui32Control; }
+void UARTDMAEnable(uint32_t ui32Base, uint32_t ui32DMAFlags) { (void)ui32Base; (void)ui32DMAFlags; }
+#endif
+
+void UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags) { (void)ui32Base; (void)ui32IntFlags; }
+void UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk, uint32_t ui32Baud, uint32_t ui32Config) { (void)ui32Base; (void)ui32UARTClk; (void)ui32Baud; (void)ui32Config; }
+void UARTFIFOLevelSet(uint32_t ui32Base, uint32_t ui32TxLevel, uint32_t ui32RxLevel) { (void)ui32Base; (void)ui32TxLevel; (void)ui32RxLevel; }
+void UARTEnable(uint32_t ui32Base) { (void)ui32Base; }
+void IntEnable(uint32_t ui32Interrupt) { (void)ui32Interrupt; }
+void IntDisable(uint32_t ui32Interrupt) { (void)ui32Interrupt; }
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral) { (void)ui32Peripheral; }
+
+//*****************************************************************************/
+// The interrupt thread: run the handler when the interrupt is raised, shift
+// out a random number of bytes, and receive the next bytes of the receive
+// stream while the receive buffer has room for them.
+//*****************************************************************************/
+static void *
+interruptThread(void *pvArg)
+{
+    struct timespec sStall = { 0, 0 };
+    uint32_t ui32Received = 0;
+    uint32_t ui32Shift;
+    uint64_t ui64Progress = nowNs();
+    uint32_t ui32LastWire = 0;
+
+    (void)pvArg;
+
+    while (!g_bWriterDone || g_ui32WireLen < g_ui32ExpectedLen || g_ui32TxFIFOCount || ui32Received < RX_STRESS_BYTES)
+    {
+        if (__atomic_exchange_n(&g_bPended, false, __ATOMIC_ACQ_REL) || UARTIntStatus(0, true)) {
+            UARTStdioIntHandler();
+        }
+
+        for (ui32Shift = rand() % 24; ui32Shift; ui32Shift--)
+        {
+#ifdef UART_TX_DMA
+            serveDMA(4);
+#endif
+            if (g_ui32TxFIFOCount == 0) {
+                break;
+            }
+            g_pui8Wire[g_ui32WireLen++] = g_pui8TxFIFO[g_ui32TxFIFOHead];
+            g_ui32TxFIFOHead = (g_ui32TxFIFOHead + 1) % MODEL_FIFO_DEPTH;
+            g_ui32TxFIFOCount--;
+        }
+
+        // Only the interrupt produces into the receive buffer, so its fill
+        // level can only fall behind this check
+        while (ui32Received < RX_STRESS_BYTES && g_ui32RxFIFOCount < MODEL_FIFO_DEPTH &&
+               UARTRxBytesAvail() + g_ui32RxFIFOCount < UART_RX_BUFFER_SIZE && rand() % 4)
+        {
+            g_pui8RxFIFO[(g_ui32RxFIFOHead + g_ui32RxFIFOCount++) % MODEL_FIFO_DEPTH] = streamByte(ui32Received++);
+        }
+
+        // Data left behind once the writer has stopped must still go out
+        if (g_ui32WireLen != ui32LastWire) {
+            ui32LastWire = g_ui32WireLen;
+            ui64Progress = nowNs();
+        }
+        else if (g_bWriterDone && nowNs() - ui64Progress > 2000000000 && g_ui32WireLen < g_ui32ExpectedLen) {
+            printf("FAIL: %u of %u bytes stranded in the transmit ring\n", g_ui32ExpectedLen - g_ui32WireLen,
+                   g_ui32ExpectedLen);
+            g_iFailures++;
+            break;
+        }
+
+        sStall.tv_nsec = (rand() % 400 == 0) ? rand() % 300000 : 0;
+        if (sStall.tv_nsec) {
+            nanosleep(&sStall, NULL);
+        }
+        else {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+//*****************************************************************************/
+// The application thread: binary frames, which wait for space, and text and
+// UARTprintf() output written only when it fits, so none of it is dropped
+//*****************************************************************************/
+static void
+expectText(const char *pcText, uint32_t ui32Len)
+{
+    while (ui32Len--)
+    {
+        if (*pcText == '\n') {
+            g_pui8Expected[g_ui32ExpectedLen++] = '\r';
+        }
+        g_pui8Expected[g_ui32ExpectedLen++] = (uint8_t)*pcText++;
+    }
+}
+
+static void *
+writerThread(void *pvArg)
+{
+    uint8_t pui8Frame[300];
+    char pcText[100];
+    uint32_t ui32Stream = 0;
+    uint32_t ui32Len;
+    uint32_t ui32Index;
+    uint32_t ui32Lines = 0;
+    int iWritten;
+
+    (void)pvArg;
+
+    while (g_ui32ExpectedLen < TX_STRESS_BYTES)
+    {
+        switch (rand() % 3)
+        {
+        case 0:
+            ui32Len = 1 + rand() % sizeof(pui8Frame);
+            for (ui32Index = 0; ui32Index < ui32Len; ui32Index++)
+            {
+                pui8Frame[ui32Index] = streamByte(ui32Stream++);
+            }
+            memcpy(&g_pui8Expected[g_ui32ExpectedLen], pui8Frame, ui32Len);
+            g_ui32ExpectedLen += ui32Len;
+            iWritten = UARTwriteBinary(pui8Frame, ui32Len);
+            check(iWritten == (int)ui32Len, "binary frame truncated");
+            break;
+
+        case 1:
+            ui32Len = rand() % sizeof(pcText);
+            for (ui32Index = 0; ui32Index < ui32Len; ui32Index++)
+            {
+                pcText[ui32Index] = (rand() % 8 == 0) ? '\n' : (char)(' ' + rand() % 95);
+            }
+            if (UARTTxBytesFree() >= (int)(2 * ui32Len)) {
+                expectText(pcText, ui32Len);
+                iWritten = UARTwrite(pcText, ui32Len);
+                check(iWritten == (int)ui32Len, "text truncated with room in the buffer");
+            }
+            break;
+
+        default:
+            if (UARTTxBytesFree() >= 64) {
+                ui32Len = snprintf(pcText, sizeof(pcText), "line %u: %d 0x%08x %s\n", ui32Lines, -(int)ui32Lines,
+                                   ui32Lines * 2654435761u, "ok");
+                expectText(pcText, ui32Len);
+                UARTprintf("line %u: %d 0x%08x %s\n", ui32Lines, -(int)ui32Lines, ui32Lines * 2654435761u, "ok");
+                ui32Lines++;
+            }
+            break;
+        }
+    }
+
+    __atomic_store_n(&g_bWriterDone, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void
+runStress(void)
+{
+    pthread_t sWriter;
+    pthread_t sInterrupt;
+    uint32_t ui32Received = 0;
+    uint32_t ui32Index;
+    uint64_t ui64Start;
+    uint8_t ui8Char;
+    bool bRxOk = true;
+
+    g_pui8Expected = malloc(TX_STRESS_BYTES + 1024);
+    g_pui8Wire = malloc(TX_STRESS_BYTES + 1024);
+    g_bThreaded = true;
+
+    ui64Start = nowNs();
+    pthread_create(&sInterrupt, NULL, interruptThread, NULL);
+    pthread_create(&sWriter, NULL, writerThread, NULL);
+
+    // The receive side: read the stream back as the application would
+    while (ui32Received < RX_STRESS_BYTES)
+    {
+        if (UARTRxBytesAvail() == 0) {
+            sched_yield();
+            continue;
+        }
+        ui8Char = UARTgetc();
+        if (bRxOk && ui8Char != streamByte(ui32Received)) {
+            printf("FAIL: received byte %u is 0x%02X, expected 0x%02X\n", ui32Received, ui8Char,
+                   streamByte(ui32Received));
+            g_iFailures++;
+            bRxOk = false;
+        }
+        ui32Received++;
+    }
+
+    pthread_join(sWriter, NULL);
+    pthread_join(sInterrupt, NULL);
+    g_bThreaded = false;
+
+    for (ui32Index = 0; ui32Index < g_ui32ExpectedLen && ui32Index < g_ui32WireLen; ui32Index++)
+    {
+        if (g_pui8Wire[ui32Index] != g_pui8Expected[ui32Index]) {
+            break;
+        }
+    }
+    if (ui32Index != g_ui32ExpectedLen || g_ui32WireLen != g_ui32ExpectedLen) {
+        printf("FAIL: wire differs from what was written at byte %u (%u sent, %u written)\n", ui32Index,
+               g_ui32WireLen, g_ui32ExpectedLen);
+        g_iFailures++;
+    }
+    check(UARTTxBytesFree() == UART_TX_BUFFER_SIZE && UARTRxBytesAvail() == 0, "rings not empty at the end");
+
+    printf("stress: %u bytes sent and %u received in %.2f s", g_ui32WireLen, ui32Received,
+           (nowNs() - ui64Start) / 1e9);
+#ifdef UART_TX_DMA
+    printf(", %u uDMA transfers", g_ui32DMATransfers);
+    check(g_ui32DMATransfers != 0, "uDMA never used");
+#endif
+    printf("\n");
+
+    free(g_pui8Expected);
+    free(g_pui8Wire);
+}
+
+//*****************************************************************************/
+// Line editing with echo on: the interrupt stores every byte as received and
+// only rubs out on the terminal, while UARTgets() applies the backspaces and
+// takes CR, LF, CR LF and ESC as line ends
+//*****************************************************************************/
+static void
+receive(const char *pcText, char *pcEcho, uint32_t *pui32EchoLen)
+{
+    // One keystroke per interrupt, with the echo shifted out in between
+    while (*pcText)
+    {
+        g_pui8RxFIFO[(g_ui32RxFIFOHead + g_ui32RxFIFOCount++) % MODEL_FIFO_DEPTH] = (uint8_t)*pcText++;
+        UARTStdioIntHandler();
+
+        while (g_ui32TxFIFOCount)
+        {
+            pcEcho[(*pui32EchoLen)++] = (char)g_pui8TxFIFO[g_ui32TxFIFOHead];
+            g_ui32TxFIFOHead = (g_ui32TxFIFOHead + 1) % MODEL_FIFO_DEPTH;
+            g_ui32TxFIFOCount--;
+        }
+    }
+}
+
+static void
+checkLineEditing(void)
+{
+    static const char pcTyped[] = "ab\bc\r\nxy\x1bq\b\b\bz\n";
+    static const char pcEchoed[] = "ab\b \bc\r\nxy\r\nq\b \bz\r\n";
+    char pcEcho[64];
+    char pcLine[16];
+    uint32_t ui32EchoLen = 0;
+
+    UARTEchoSet(true);
+    receive(pcTyped, pcEcho, &ui32EchoLen);
+
+    // Nothing typed is taken back out of the receive buffer
+    check(UARTRxBytesAvail() == sizeof(pcTyped) - 1, "receive buffer edited by the interrupt");
+    check(ui32EchoLen == sizeof(pcEchoed) - 1 && memcmp(pcEcho, pcEchoed, ui32EchoLen) == 0, "echo");
+
+    check(UARTgets(pcLine, sizeof(pcLine)) == 2 && strcmp(pcLine, "ac") == 0, "backspace");
+    check(UARTgets(pcLine, sizeof(pcLine)) == 2 && strcmp(pcLine, "xy") == 0, "CR LF, ESC");
+    check(UARTgets(pcLine, sizeof(pcLine)) == 1 && strcmp(pcLine, "z") == 0, "backspace past the start, LF");
+    check(UARTRxBytesAvail() == 0, "line ends left behind");
+
+    UARTEchoSet(false);
+}
+
+//*****************************************************************************/
+// The previous transmit path, for the benchmark: indices advanced with a
+// modulo, and the fill level recomputed through volatile pointers for every
+// byte, with the UART interrupt masked while priming the FIFO
+//*****************************************************************************/
+static unsigned char g_pcRefBuffer[UART_TX_BUFFER_SIZE];
+static volatile uint32_t g_ui32RefWrite;
+static volatile uint32_t g_ui32RefRead;
+
+#define REF_ADVANCE(Index)  (Index) = ((Index) + 1) % UART_TX_BUFFER_SIZE
+
+static bool
+refIsFull(volatile uint32_t *pui32Read, volatile uint32_t *pui32Write, uint32_t ui32Size)
+{
+    uint32_t ui32Write = *pui32Write;
+    uint32_t ui32Read = *pui32Read;
+
+    return ((ui32Write + 1) % ui32Size) == ui32Read;
+}
+
+static bool
+refIsEmpty(volatile uint32_t *pui32Read, volatile uint32_t *pui32Write)
+{
+    return *pui32Write == *pui32Read;
+}
+
+static void
+refPrimeTransmit(void)
+{
+    if (!refIsEmpty(&g_ui32RefRead, &g_ui32RefWrite)) {
+        IntDisable(0);
+        while (UARTSpaceAvail(0) && !refIsEmpty(&g_ui32RefRead, &g_ui32RefWrite))
+        {
+            UARTCharPutNonBlocking(0, g_pcRefBuffer[g_ui32RefRead]);
+            REF_ADVANCE(g_ui32RefRead);
+        }
+        IntEnable(0);
+    }
+}
+
+static int
+refWrite(const char *pcBuf, uint32_t ui32Len)
+{
+    uint32_t uIdx;
+
+    for (uIdx = 0; uIdx < ui32Len; uIdx++)
+    {
+        if (pcBuf[uIdx] == '\n') {
+            if (refIsFull(&g_ui32RefRead, &g_ui32RefWrite, UART_TX_BUFFER_SIZE)) {
+                break;
+            }
+            g_pcRefBuffer[g_ui32RefWrite] = '\r';
+            REF_ADVANCE(g_ui32RefWrite);
+        }
+        if (refIsFull(&g_ui32RefRead, &g_ui32RefWrite, UART_TX_BUFFER_SIZE)) {
+            break;
+        }
+        g_pcRefBuffer[g_ui32RefWrite] = pcBuf[uIdx];
+        REF_ADVANCE(g_ui32RefWrite);
+    }
+
+    if (!refIsEmpty(&g_ui32RefRead, &g_ui32RefWrite)) {
+        refPrimeTransmit();
+        UARTIntEnable(0, UART_INT_TX);
+    }
+
+    return uIdx;
+}
+
+static int
+refWriteBinary(const uint8_t *pui8Buf, uint32_t ui32Len)
+{
+    uint32_t uIdx;
+
+    for (uIdx = 0; uIdx < ui32Len; uIdx++)
+    {
+        if (refIsFull(&g_ui32RefRead, &g_ui32RefWrite, UART_TX_BUFFER_SIZE)) {
+            break;
+        }
+        g_pcRefBuffer[g_ui32RefWrite] = (char)pui8Buf[uIdx];
+        REF_ADVANCE(g_ui32RefWrite);
+    }
+
+    if (!refIsEmpty(&g_ui32RefRead, &g_ui32RefWrite)) {
+        refPrimeTransmit();
+        UARTIntEnable(0, UART_INT_TX);
+    }
+
+    return uIdx;
+}
+
+//*****************************************************************************/
+// Bytes/s into the transmit ring: fill it with 64-byte writes, then discard
+// it untimed.  The FIFO is held full so neither version moves bytes out.
+//*****************************************************************************/
+static double
+benchmark(bool bReference, bool bBinary)
+{
+    char pcChunk[64];
+    uint64_t ui64Ns = 0;
+    uint64_t ui64Start;
+    uint64_t ui64Bytes = 0;
+    uint32_t ui32Round;
+    uint32_t ui32Index;
+
+    for (ui32Index = 0; ui32Index < sizeof(pcChunk); ui32Index++)
+    {
+        pcChunk[ui32Index] = (ui32Index % 32 == 31) ? '\n' : (char)('a' + ui32Index % 26);
+    }
+    g_ui32TxFIFOCount = MODEL_FIFO_DEPTH;
+
+    for (ui32Round = 0; ui32Round < BENCH_ROUNDS; ui32Round++)
+    {
+        ui64Start = nowNs();
+        for (ui32Index = 0; ui32Index < UART_TX_BUFFER_SIZE / 80; ui32Index++)
+        {
+            if (bReference) {
+                ui64Bytes += bBinary ? refWriteBinary((const uint8_t *)pcChunk, sizeof(pcChunk)) :
+                                       refWrite(pcChunk, sizeof(pcChunk));
+            }
+            else {
+                ui64Bytes += bBinary ? UARTwriteBinary((const uint8_t *)pcChunk, sizeof(pcChunk)) :
+                                       UARTwrite(pcChunk, sizeof(pcChunk));
+            }
+        }
+        ui64Ns += nowNs() - ui64Start;
+
+        g_ui32RefRead = g_ui32RefWrite;
+        UARTFlushTx(true);
+    }
+
+    g_ui32TxFIFOCount = 0;
+    g_bPended = false;
+    return ui64Bytes * 1e9 / ui64Ns;
+}
+
+int
+main(void)
+{
+    double dNew;
+    double dOld;
+
+    // A writer spinning on a ring that never drains fails the test rather
+    // than hanging it
+    alarm(TEST_TIMEOUT_S);
+
+    srand(21);
+    UARTStdioConfig(0, 115200, 16000000);
+    UARTEchoSet(false);
+
+    runStress();
+    checkLineEditing();
+
+    dNew = benchmark(false, false);
+    dOld = benchmark(true, false);
+    printf("UARTwrite: %.0f MB/s, previous implementation %.0f MB/s\n", dNew / 1e6, dOld / 1e6);
+    dNew = benchmark(false, true);
+    dOld = benchmark(true, true);
+    printf("UARTwriteBinary: %.0f MB/s, previous implementation %.0f MB/s\n", dNew / 1e6, dOld / 1e6);
+
+    printf(TEST_NAME ": %d failures\n", g_iFailures);
+    return g_iFailures ? 1 : 0;
+}
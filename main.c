@@ -16,14 +16,29 @@ The following UART signals are configured for displaying console messages:
     GPIO Port A peripheral (for UART0 pins)
     UART0RX - PA0
     UART0TX - PA1
+
+The following SSI signals are configured for the SPI flash sample log:
+    SSI0 peripheral
+    GPIO Port A peripheral (for SSI0 pins)
+    SSI0CLK - PA2
+    SSI0FSS - PA3
+    SSI0RX  - PA4
+    SSI0TX  - PA5
+
+The last 8 KB of internal flash hold the saved settings (config_store.h).
 */
 
 // Standard C libraries
+#include <stdbool.h>
 #include <stdint.h>
 
 // Custom project-specific headers
 #include "adc_functions.h"
+#include "commands.h"
+#include "config_store.h"
 #include "data_transfer_functions.h"
+#include "flash_log.h"
+#include "timebase.h"
 #include "uart_functions.h"
 
 int main(void)
@@ -31,9 +46,19 @@ int main(void)
     // Sets up UART0 to display information to console
     configureUART();
 
+    // Load the saved acquisition settings from internal flash
+    configStoreInit();
+    loadAcqConfig();
+
     // Configure ADC0 for differential sampling, Trigger Timer - 1 kHz
     configureADC1();
 
-    // Perform ADC sampling and data acquisition
-    startADC1();
+    // Start the 64-bit timebase once the system clock is set
+    configureTimebase();
+
+    // Bring up the SPI flash sample log and find where it left off
+    configureFlashLog();
+
+    // Take commands: sampling runs and flash readback
+    runConsole();
 }
@@ -58,8 +58,9 @@
 
 MEMORY
 {
-    /* Application stored in and executes from internal flash */
-    FLASH (RX) : origin = APP_BASE, length = 0x00040000
+    /* Application stored in and executes from internal flash.  The last    */
+    /* 8 KB are kept for the configuration store (config_store.h).          */
+    FLASH (RX) : origin = APP_BASE, length = 0x0003E000
     /* Application uses internal RAM for data */
     SRAM (RWX) : origin = 0x20000000, length = 0x00008000
 }
@@ -0,0 +1,199 @@
+/*
+ * sample_buffer.c
+ *
+ *  Created on: Feb 12, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "sample_buffer.h"
+#include "timebase.h"
+
+//*****************************************************************************/
+// Lock-free single-producer/single-consumer ring of sample blocks.
+//
+// The producer (ADC interrupt or uDMA completion interrupt) reserves a block,
+// fills it and commits it.  The consumer (main loop) peeks at the oldest
+// committed block and releases it when done.  Indices are free-running and
+// reduced with a mask, so no interrupt masking is needed on either side.
+//
+// Up to two blocks may be reserved but not yet committed at any time (the
+// uDMA ping-pong mode keeps a primary and an alternate buffer in flight).
+// When the ring is full the producer is handed a scratch block instead; its
+// contents are discarded on commit and counted as a dropped block.
+//*****************************************************************************/
+static tSampleBlock g_psBlocks[SAMPLE_BUFFER_BLOCKS];
+static tSampleBlock g_sScratchBlock;
+
+// Next block to hand to the producer (producer only)
+static uint32_t g_ui32Reserve;
+
+// Number of blocks committed (written by producer, read by consumer)
+static volatile uint32_t g_ui32Head;
+
+// Number of blocks released (written by consumer, read by producer)
+static volatile uint32_t g_ui32Tail;
+
+// Block sequence counter, including dropped blocks (producer only)
+static uint32_t g_ui32Seq;
+
+// Count of blocks discarded because the ring was full
+static volatile uint32_t g_ui32Dropped;
+
+// Largest number of committed blocks waiting for the consumer
+static volatile uint32_t g_ui32HighWater;
+
+//*****************************************************************************/
+// Reset the ring.  Must be called while the producer is stopped.
+//*****************************************************************************/
+void
+sampleBufferInit(void)
+{
+    g_ui32Reserve = 0;
+    g_ui32Head = 0;
+    g_ui32Tail = 0;
+    g_ui32Seq = 0;
+    g_ui32Dropped = 0;
+    g_ui32HighWater = 0;
+}
+
+//*****************************************************************************/
+// Producer: get the next block to fill.  Never fails; returns the scratch
+// block when the ring has no free slot.
+//*****************************************************************************/
+tSampleBlock *
+sampleBufferReserve(void)
+{
+    if ((g_ui32Reserve - g_ui32Tail) >= SAMPLE_BUFFER_BLOCKS) {
+        return &g_sScratchBlock;
+    }
+
+    return &g_psBlocks[g_ui32Reserve++ & (SAMPLE_BUFFER_BLOCKS - 1)];
+}
+
+//*****************************************************************************/
+// Producer: publish a filled block.  Blocks must be committed in the order
+// they were reserved.
+//*****************************************************************************/
+void
+sampleBufferCommit(tSampleBlock *psBlock)
+{
+    uint32_t ui32Level;
+
+    psBlock->ui32Seq = g_ui32Seq++;
+    psBlock->ui64Ticks = timebaseNow();
+
+    if (psBlock == &g_sScratchBlock) {
+        g_ui32Dropped++;
+        return;
+    }
+
+    // Make sure the block contents are visible before the consumer can see
+    // the new head index.
+    SAMPLE_BUFFER_BARRIER();
+    g_ui32Head++;
+
+    // Track the deepest backlog for the end-of-run report
+    ui32Level = g_ui32Head - g_ui32Tail;
+    if (ui32Level > g_ui32HighWater) {
+        g_ui32HighWater = ui32Level;
+    }
+}
+
+//*****************************************************************************/
+// Consumer: get the oldest committed block, or NULL if none is ready.
+//*****************************************************************************/
+tSampleBlock *
+sampleBufferPeek(void)
+{
+    uint32_t ui32Tail = g_ui32Tail;
+
+    if (g_ui32Head == ui32Tail) {
+        return NULL;
+    }
+
+    SAMPLE_BUFFER_BARRIER();
+    return &g_psBlocks[ui32Tail & (SAMPLE_BUFFER_BLOCKS - 1)];
+}
+
+//*****************************************************************************/
+// Consumer: hand the block returned by sampleBufferPeek() back to the producer.
+//*****************************************************************************/
+void
+sampleBufferRelease(void)
+{
+    // Finish reading the block before the producer may reuse it.
+    SAMPLE_BUFFER_BARRIER();
+    g_ui32Tail++;
+}
+
+//*****************************************************************************/
+// Number of committed blocks waiting for the consumer
+//*****************************************************************************/
+uint32_t
+sampleBufferCount(void)
+{
+    return g_ui32Head - g_ui32Tail;
+}
+
+//*****************************************************************************/
+// Number of blocks dropped because the consumer fell behind
+//*****************************************************************************/
+uint32_t
+sampleBufferDropped(void)
+{
+    return g_ui32Dropped;
+}
+
+//*****************************************************************************/
+// Largest number of blocks that were waiting for the consumer at once
+//*****************************************************************************/
+uint32_t
+sampleBufferHighWater(void)
+{
+    return g_ui32HighWater;
+}
+
+//*****************************************************************************/
+// Reorder a block of ui32Sets sample sets from conversion order into one
+// plane per channel.  Each ADC module writes its sample sets interleaved into
+// its own region of the block: ADC0's ui32Channels0 channels first, then
+// ADC1's ui32Channels1.
+//*****************************************************************************/
+static uint16_t g_pui16Planar[SAMPLE_BLOCK_SIZE];
+
+void
+sampleBlockPlanarize(tSampleBlock *psBlock, uint32_t ui32Sets, uint32_t ui32Channels0, uint32_t ui32Channels1)
+{
+    const uint16_t *pui16Src;
+    uint16_t *pui16Dst = g_pui16Planar;
+    uint32_t ui32Stride;
+    uint32_t ui32Channel;
+    uint32_t ui32Index;
+
+    for (ui32Channel = 0; ui32Channel < ui32Channels0 + ui32Channels1; ui32Channel++)
+    {
+        if (ui32Channel < ui32Channels0) {
+            pui16Src = psBlock->pui16Data + ui32Channel;
+            ui32Stride = ui32Channels0;
+        }
+        else {
+            pui16Src = psBlock->pui16Data + ui32Sets * ui32Channels0 + (ui32Channel - ui32Channels0);
+            ui32Stride = ui32Channels1;
+        }
+
+        for (ui32Index = 0; ui32Index < ui32Sets; ui32Index++)
+        {
+            *pui16Dst++ = *pui16Src;
+            pui16Src += ui32Stride;
+        }
+    }
+
+    memcpy(psBlock->pui16Data, g_pui16Planar, ui32Sets * (ui32Channels0 + ui32Channels1) * sizeof(uint16_t));
+}
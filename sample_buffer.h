@@ -0,0 +1,65 @@
+/*
+ * sample_buffer.h
+ *
+ *  Created on: Feb 12, 2024
+ *      Author: Tyler
+ */
+
+#ifndef SAMPLE_BUFFER_H_
+#define SAMPLE_BUFFER_H_
+
+// Number of ADC samples carried by one block.  The producer (ADC ISR or uDMA)
+// fills one block at a time and the consumer drains whole blocks.
+#ifndef SAMPLE_BLOCK_SIZE
+#define SAMPLE_BLOCK_SIZE       64
+#endif
+
+// Number of blocks in the ring.  Must be a power of two so that the
+// free-running indices can be reduced with a mask instead of a modulo.
+#ifndef SAMPLE_BUFFER_BLOCKS
+#define SAMPLE_BUFFER_BLOCKS    16
+#endif
+
+#if (SAMPLE_BUFFER_BLOCKS & (SAMPLE_BUFFER_BLOCKS - 1)) != 0
+#error "SAMPLE_BUFFER_BLOCKS must be a power of two"
+#endif
+
+// Orders the block contents against the index update that publishes them.
+// The producer runs in interrupt context, so a data memory barrier is enough
+// on the single-core Cortex-M4.
+#if defined(ccs)
+#define SAMPLE_BUFFER_BARRIER() __asm(" dmb")
+#else
+#define SAMPLE_BUFFER_BARRIER() __sync_synchronize()
+#endif
+
+// One block of consecutive samples
+typedef struct
+{
+    // Sequence number of the block since sampleBufferInit().  Dropped blocks
+    // still consume a sequence number so gaps are visible downstream.
+    uint32_t ui32Seq;
+
+    // Number of valid samples in pui16Data
+    uint32_t ui32Count;
+
+    // timebase.h ticks when the producer committed the block, shortly after
+    // its last sample was converted
+    uint64_t ui64Ticks;
+
+    // 12-bit ADC codes
+    uint16_t pui16Data[SAMPLE_BLOCK_SIZE];
+}
+tSampleBlock;
+
+void sampleBufferInit(void);
+tSampleBlock *sampleBufferReserve(void);
+void sampleBufferCommit(tSampleBlock *psBlock);
+tSampleBlock *sampleBufferPeek(void);
+void sampleBufferRelease(void);
+uint32_t sampleBufferCount(void);
+uint32_t sampleBufferDropped(void);
+uint32_t sampleBufferHighWater(void);
+void sampleBlockPlanarize(tSampleBlock *psBlock, uint32_t ui32Sets, uint32_t ui32Channels0, uint32_t ui32Channels1);
+
+#endif /* SAMPLE_BUFFER_H_ */
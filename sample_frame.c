@@ -0,0 +1,177 @@
+/*
+ * sample_frame.c
+ *
+ *  Created on: Feb 19, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <stdint.h>
+
+// Custom project-specific headers
+#include "crc.h"
+#include "sample_frame.h"
+
+//*****************************************************************************/
+// Little-endian field helpers.  Frames are built byte by byte so the layout
+// does not depend on structure packing or alignment on either end of the link.
+//*****************************************************************************/
+static void
+putU16(uint8_t *pui8Buf, uint16_t ui16Value)
+{
+    pui8Buf[0] = (uint8_t)ui16Value;
+    pui8Buf[1] = (uint8_t)(ui16Value >> 8);
+}
+
+static void
+putU32(uint8_t *pui8Buf, uint32_t ui32Value)
+{
+    putU16(pui8Buf, (uint16_t)ui32Value);
+    putU16(pui8Buf + 2, (uint16_t)(ui32Value >> 16));
+}
+
+static uint16_t
+getU16(const uint8_t *pui8Buf)
+{
+    return (uint16_t)(pui8Buf[0] | (pui8Buf[1] << 8));
+}
+
+static uint32_t
+getU32(const uint8_t *pui8Buf)
+{
+    return getU16(pui8Buf) | ((uint32_t)getU16(pui8Buf + 2) << 16);
+}
+
+//*****************************************************************************/
+// Number of channels set in a channel mask
+//*****************************************************************************/
+uint32_t
+sampleFrameChannels(uint16_t ui16ChannelMask)
+{
+    uint32_t ui32Channels = 0;
+
+    while (ui16ChannelMask) {
+        ui16ChannelMask &= ui16ChannelMask - 1;
+        ui32Channels++;
+    }
+
+    return ui32Channels;
+}
+
+//*****************************************************************************/
+// Build a frame from psHeader->ui16Count samples.  pui8Frame must hold
+// SAMPLE_FRAME_SIZE(psHeader->ui16Count, psHeader->ui8Flags) bytes.  Returns
+// the frame length.
+//*****************************************************************************/
+uint32_t
+sampleFrameEncode(uint8_t *pui8Frame, const tSampleFrameHeader *psHeader,
+                  const uint16_t *pui16Samples)
+{
+    uint32_t ui32Count = psHeader->ui16Count;
+    uint8_t *pui8Out = pui8Frame + SAMPLE_FRAME_HEADER_SIZE;
+    uint32_t ui32Len;
+
+    putU16(pui8Frame, SAMPLE_FRAME_SYNC);
+    pui8Frame[2] = SAMPLE_FRAME_VERSION;
+    pui8Frame[3] = psHeader->ui8Flags;
+    putU32(pui8Frame + 4, psHeader->ui32Seq);
+    putU32(pui8Frame + 8, (uint32_t)psHeader->ui64Timestamp);
+    putU32(pui8Frame + 12, (uint32_t)(psHeader->ui64Timestamp >> 32));
+    putU32(pui8Frame + 16, psHeader->ui32PeriodNs);
+    putU16(pui8Frame + 20, psHeader->ui16Count);
+    putU16(pui8Frame + 22, psHeader->ui16ChannelMask);
+
+    if (psHeader->ui8Flags & SAMPLE_FRAME_FLAG_16BIT) {
+        for (; ui32Count; ui32Count--, pui8Out += 2) {
+            putU16(pui8Out, *pui16Samples++);
+        }
+    }
+
+    // Pack pairs of 12-bit samples into three bytes:
+    //   byte 0 = s0[7:0], byte 1 = s1[3:0] s0[11:8], byte 2 = s1[11:4]
+    for (; ui32Count >= 2; ui32Count -= 2, pui16Samples += 2) {
+        *pui8Out++ = (uint8_t)pui16Samples[0];
+        *pui8Out++ = (uint8_t)(((pui16Samples[0] >> 8) & 0x0F) | (pui16Samples[1] << 4));
+        *pui8Out++ = (uint8_t)(pui16Samples[1] >> 4);
+    }
+
+    // An odd trailing sample takes two bytes with the upper nibble clear
+    if (ui32Count) {
+        *pui8Out++ = (uint8_t)pui16Samples[0];
+        *pui8Out++ = (uint8_t)((pui16Samples[0] >> 8) & 0x0F);
+    }
+
+    ui32Len = (uint32_t)(pui8Out - pui8Frame);
+    putU16(pui8Out, crc16Update(CRC16_INIT, pui8Frame + 2, ui32Len - 2));
+
+    return ui32Len + SAMPLE_FRAME_CRC_SIZE;
+}
+
+//*****************************************************************************/
+// Decode the frame at the start of pui8Buf.  On SAMPLE_FRAME_OK the header and
+// samples are filled in and *pui32Used is the frame length.  On
+// SAMPLE_FRAME_BAD the caller should skip one byte and try again to resync;
+// on SAMPLE_FRAME_NEED_MORE it should append more data first.  pui16Samples
+// must hold SAMPLE_FRAME_MAX_SAMPLES entries.
+//*****************************************************************************/
+uint32_t
+sampleFrameDecode(const uint8_t *pui8Buf, uint32_t ui32Len,
+                  tSampleFrameHeader *psHeader, uint16_t *pui16Samples,
+                  uint32_t *pui32Used)
+{
+    const uint8_t *pui8In;
+    uint32_t ui32Count;
+    uint32_t ui32Size;
+    uint8_t ui8Flags;
+
+    if (ui32Len < 2) {
+        return SAMPLE_FRAME_NEED_MORE;
+    }
+    if (getU16(pui8Buf) != SAMPLE_FRAME_SYNC) {
+        return SAMPLE_FRAME_BAD;
+    }
+    if (ui32Len < SAMPLE_FRAME_HEADER_SIZE) {
+        return SAMPLE_FRAME_NEED_MORE;
+    }
+    if (pui8Buf[2] != SAMPLE_FRAME_VERSION) {
+        return SAMPLE_FRAME_BAD;
+    }
+
+    ui8Flags = pui8Buf[3];
+    ui32Count = getU16(pui8Buf + 20);
+    if (ui32Count > SAMPLE_FRAME_MAX_SAMPLES) {
+        return SAMPLE_FRAME_BAD;
+    }
+
+    ui32Size = SAMPLE_FRAME_SIZE(ui32Count, ui8Flags);
+    if (ui32Len < ui32Size) {
+        return SAMPLE_FRAME_NEED_MORE;
+    }
+    if (crc16Update(CRC16_INIT, pui8Buf + 2, ui32Size - 4) != getU16(pui8Buf + ui32Size - 2)) {
+        return SAMPLE_FRAME_BAD;
+    }
+
+    psHeader->ui32Seq = getU32(pui8Buf + 4);
+    psHeader->ui64Timestamp = getU32(pui8Buf + 8) | ((uint64_t)getU32(pui8Buf + 12) << 32);
+    psHeader->ui32PeriodNs = getU32(pui8Buf + 16);
+    psHeader->ui16Count = (uint16_t)ui32Count;
+    psHeader->ui16ChannelMask = getU16(pui8Buf + 22);
+    psHeader->ui8Flags = ui8Flags;
+
+    pui8In = pui8Buf + SAMPLE_FRAME_HEADER_SIZE;
+    if (ui8Flags & SAMPLE_FRAME_FLAG_16BIT) {
+        for (; ui32Count; ui32Count--, pui8In += 2) {
+            *pui16Samples++ = getU16(pui8In);
+        }
+    }
+    for (; ui32Count >= 2; ui32Count -= 2, pui8In += 3) {
+        *pui16Samples++ = pui8In[0] | ((pui8In[1] & 0x0F) << 8);
+        *pui16Samples++ = (pui8In[1] >> 4) | (pui8In[2] << 4);
+    }
+    if (ui32Count) {
+        *pui16Samples = pui8In[0] | ((pui8In[1] & 0x0F) << 8);
+    }
+
+    *pui32Used = ui32Size;
+    return SAMPLE_FRAME_OK;
+}
@@ -0,0 +1,86 @@
+/*
+ * sample_frame.h
+ *
+ *  Created on: Feb 19, 2024
+ *      Author: Tyler
+ */
+
+#ifndef SAMPLE_FRAME_H_
+#define SAMPLE_FRAME_H_
+
+//*****************************************************************************/
+// Binary sample frame layout (all fields little-endian):
+//
+//   offset  size  field
+//        0     2  sync word, SAMPLE_FRAME_SYNC
+//        2     1  format version, SAMPLE_FRAME_VERSION
+//        3     1  flags, SAMPLE_FRAME_FLAG_*
+//        4     4  frame sequence number
+//        8     8  timestamp of the first sample in microseconds
+//       16     4  sample period in nanoseconds
+//       20     2  sample count (all channels)
+//       22     2  channel mask, bit n set = channel n present
+//       24     N  samples, channels interleaved in ascending channel order:
+//                 12-bit codes packed two per three bytes, or 16-bit words
+//                 when SAMPLE_FRAME_FLAG_16BIT is set
+//     24+N     2  CRC-16/CCITT-FALSE over bytes 2 .. 23+N
+//
+// Spectrum frames (SAMPLE_FRAME_FLAG_SPECTRUM, always with
+// SAMPLE_FRAME_FLAG_16BIT) reuse the layout for one averaged power spectrum
+// of the single channel in the mask: the samples are signed power spectral
+// densities in 0.01 dB (codes^2 / Hz) from DC up to the Nyquist frequency,
+// the period field is the bin spacing in millihertz, the timestamp is the
+// start of the averaging window and the sequence number counts spectra.
+//*****************************************************************************/
+#define SAMPLE_FRAME_SYNC           0xA55A
+#define SAMPLE_FRAME_VERSION        1
+#define SAMPLE_FRAME_HEADER_SIZE    24
+#define SAMPLE_FRAME_CRC_SIZE       2
+
+// Frame flags
+#define SAMPLE_FRAME_FLAG_16BIT     0x01    // 16-bit samples (decimated output)
+#define SAMPLE_FRAME_FLAG_SPECTRUM  0x02    // Averaged spectrum, see above
+
+// Largest number of samples one frame may carry
+#define SAMPLE_FRAME_MAX_SAMPLES    1024
+
+// Bytes needed for the payload of ui32Count samples
+#define SAMPLE_FRAME_PAYLOAD_SIZE(ui32Count, ui8Flags)                      \
+        (((ui8Flags) & SAMPLE_FRAME_FLAG_16BIT) ? ((ui32Count) * 2) :       \
+                                                  (((ui32Count) * 3 + 1) / 2))
+
+// Total frame size for ui32Count samples
+#define SAMPLE_FRAME_SIZE(ui32Count, ui8Flags)                              \
+        (SAMPLE_FRAME_HEADER_SIZE +                                         \
+         SAMPLE_FRAME_PAYLOAD_SIZE(ui32Count, ui8Flags) +                   \
+         SAMPLE_FRAME_CRC_SIZE)
+
+// Largest possible frame
+#define SAMPLE_FRAME_MAX_SIZE                                               \
+        SAMPLE_FRAME_SIZE(SAMPLE_FRAME_MAX_SAMPLES, SAMPLE_FRAME_FLAG_16BIT)
+
+// Return values of sampleFrameDecode()
+#define SAMPLE_FRAME_OK             0   // A valid frame was decoded
+#define SAMPLE_FRAME_NEED_MORE      1   // The buffer holds a partial frame
+#define SAMPLE_FRAME_BAD            2   // No valid frame at the buffer start
+
+// Decoded frame header
+typedef struct
+{
+    uint32_t ui32Seq;
+    uint64_t ui64Timestamp;
+    uint32_t ui32PeriodNs;
+    uint16_t ui16Count;
+    uint16_t ui16ChannelMask;
+    uint8_t ui8Flags;
+}
+tSampleFrameHeader;
+
+uint32_t sampleFrameEncode(uint8_t *pui8Frame, const tSampleFrameHeader *psHeader,
+                           const uint16_t *pui16Samples);
+uint32_t sampleFrameDecode(const uint8_t *pui8Buf, uint32_t ui32Len,
+                           tSampleFrameHeader *psHeader, uint16_t *pui16Samples,
+                           uint32_t *pui32Used);
+uint32_t sampleFrameChannels(uint16_t ui16ChannelMask);
+
+#endif /* SAMPLE_FRAME_H_ */
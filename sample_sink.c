@@ -0,0 +1,425 @@
+/*
+ * sample_sink.c
+ *
+ *  Created on: Feb 26, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Custom project-specific headers
+#include "adc_functions.h"
+#include "flash_log.h"
+#include "sample_buffer.h"
+#include "sample_frame.h"
+#include "sample_sink.h"
+#include "spectrum.h"
+#include "uartstdio.h"
+
+//*****************************************************************************/
+// First sample of channel plane ui32Channel in a processed block
+//*****************************************************************************/
+static const uint16_t *
+blockPlane(const tSampleBlock *psBlock, uint32_t ui32Channel)
+{
+    return psBlock->pui16Data + ui32Channel * (psBlock->ui32Count / g_sAcqConfig.ui32NumChannels);
+}
+
+//*****************************************************************************/
+// Shared no-op handlers
+//*****************************************************************************/
+static int
+openNone(const char *pcPath)
+{
+    return 0;
+}
+
+static void
+idleNone(void)
+{
+}
+
+static void
+closeNone(void)
+{
+}
+
+//*****************************************************************************/
+// SINK_NULL: drop everything
+//*****************************************************************************/
+static void
+writeNull(const tSampleBlock *psBlock, uint32_t ui32Count, uint64_t ui64FirstSample)
+{
+}
+
+//*****************************************************************************/
+// SINK_UART_TEXT: the original console line per sample set.  Buffered
+// UARTprintf() discards output that does not fit in the transmit buffer, so
+// each line first waits for room for the longest possible line.
+//*****************************************************************************/
+#define UART_TEXT_LINE_MAX  (48 + 24 * ADC_MAX_CHANNELS)
+
+// Line formats, parsed once per run rather than once per sample.  Timestamps
+// past 2^32 us (about 71 minutes) are printed as seconds followed by six
+// digits of microseconds, which reads as the same microsecond count.
+static tUARTFormat g_sTextLine;
+static tUARTFormat g_sTextLineLong;
+static tUARTFormat g_sTextChannel;
+
+static int
+openUARTText(const char *pcPath)
+{
+    if (!UARTFormatCompile(&g_sTextLine, "\nLoop # = %d, Timestamp = %u") ||
+        !UARTFormatCompile(&g_sTextLineLong, "\nLoop # = %d, Timestamp = %u%06u") ||
+        !UARTFormatCompile(&g_sTextChannel, ", AIN%d - AIN%d = %4d")) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static void
+writeUARTText(const tSampleBlock *psBlock, uint32_t ui32Count, uint64_t ui64FirstSample)
+{
+    uint64_t ui64Timestamp = getBlockTimestampUs(psBlock->ui32Seq);
+    uint64_t ui64SampleUs;
+    uint32_t ui32Period = 1000000 / getOutputRate();
+    uint32_t ui32Index;
+    uint32_t ui32Channel;
+    uint32_t ui32Pair;
+
+    for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+    {
+#ifdef UART_BUFFERED
+        while (UARTTxBytesFree() < UART_TEXT_LINE_MAX) {
+        }
+#endif
+
+        ui64SampleUs = ui64Timestamp + (uint64_t)ui32Index * ui32Period;
+        if (ui64SampleUs >> 32) {
+            UARTFormatPrintf(&g_sTextLineLong, (uint32_t)(ui64FirstSample + ui32Index + 1),
+                             (uint32_t)(ui64SampleUs / 1000000), (uint32_t)(ui64SampleUs % 1000000));
+        }
+        else {
+            UARTFormatPrintf(&g_sTextLine, (uint32_t)(ui64FirstSample + ui32Index + 1),
+                             (uint32_t)ui64SampleUs);
+        }
+
+        // Display the [AIN(2n) - AIN(2n+1)] digital value of each pair
+        for (ui32Channel = 0; ui32Channel < g_sAcqConfig.ui32NumChannels; ui32Channel++)
+        {
+            ui32Pair = g_sAcqConfig.pui8Channels[ui32Channel];
+            UARTFormatPrintf(&g_sTextChannel, ui32Pair * 2, ui32Pair * 2 + 1,
+                             blockPlane(psBlock, ui32Channel)[ui32Index]);
+        }
+        UARTwrite("\r", 1);
+    }
+}
+
+//*****************************************************************************/
+// Encode the first ui32Count sample sets of a block as one CRC-protected
+// frame in g_pui8Frame and return its length.  Frames carry the channels
+// interleaved, so multi-channel planes are merged back first.
+//*****************************************************************************/
+static uint8_t g_pui8Frame[SAMPLE_FRAME_SIZE(SAMPLE_BLOCK_SIZE, SAMPLE_FRAME_FLAG_16BIT)];
+static uint16_t g_pui16Interleaved[SAMPLE_BLOCK_SIZE];
+
+static uint32_t
+encodeFrame(const tSampleBlock *psBlock, uint32_t ui32Count)
+{
+    tSampleFrameHeader sHeader;
+    const uint16_t *pui16Samples = psBlock->pui16Data;
+    const uint16_t *pui16Plane;
+    uint32_t ui32NumChannels = g_sAcqConfig.ui32NumChannels;
+    uint32_t ui32Channel;
+    uint32_t ui32Index;
+
+    if (ui32NumChannels > 1) {
+        for (ui32Channel = 0; ui32Channel < ui32NumChannels; ui32Channel++)
+        {
+            pui16Plane = blockPlane(psBlock, ui32Channel);
+            for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+            {
+                g_pui16Interleaved[ui32Index * ui32NumChannels + ui32Channel] = pui16Plane[ui32Index];
+            }
+        }
+        pui16Samples = g_pui16Interleaved;
+    }
+
+    sHeader.ui32Seq = psBlock->ui32Seq;
+    sHeader.ui64Timestamp = getBlockTimestampUs(psBlock->ui32Seq);
+    sHeader.ui32PeriodNs = 1000000000 / getOutputRate();
+    sHeader.ui16Count = (uint16_t)(ui32Count * ui32NumChannels);
+    sHeader.ui16ChannelMask = (uint16_t)getChannelMask();
+    sHeader.ui8Flags = (g_sAcqConfig.ui32Decimation > 1) ? SAMPLE_FRAME_FLAG_16BIT : 0;
+
+    return sampleFrameEncode(g_pui8Frame, &sHeader, pui16Samples);
+}
+
+//*****************************************************************************/
+// Binary output on the console UART.  The receive interrupt echoes typed
+// characters straight into the transmit FIFO, where they would land inside a
+// frame, so echo is off while a binary sink is open.  Commands typed during
+// the run still work, just without echo.
+//*****************************************************************************/
+static void
+binaryEchoOff(void)
+{
+#ifdef UART_BUFFERED
+    UARTEchoSet(false);
+#endif
+}
+
+static void
+binaryEchoOn(void)
+{
+#ifdef UART_BUFFERED
+    // Let the last frame out before echo can reach the FIFO again
+    UARTFlushTx(false);
+    UARTEchoSet(true);
+#endif
+}
+
+//*****************************************************************************/
+// SINK_UART_BINARY: one frame per block on the console UART
+//*****************************************************************************/
+static int
+openUARTBinary(const char *pcPath)
+{
+    binaryEchoOff();
+    return 0;
+}
+
+static void
+writeUARTBinary(const tSampleBlock *psBlock, uint32_t ui32Count, uint64_t ui64FirstSample)
+{
+    UARTwriteBinary(g_pui8Frame, encodeFrame(psBlock, ui32Count));
+}
+
+static void
+closeUARTBinary(void)
+{
+    binaryEchoOn();
+}
+
+//*****************************************************************************/
+// SINK_FILE: TSV lines in the adc_data.txt format, staged in RAM and written
+// to the host file in whole buffers over semihosting.
+//*****************************************************************************/
+static FILE *g_psFile;
+static char g_pcFileBuffer[SINK_FILE_BUFFER_SIZE];
+static uint32_t g_ui32FileFill;
+static uint32_t g_ui32FileUnflushed;
+
+static void
+fileDrain(void)
+{
+    if (g_ui32FileFill) {
+        fwrite(g_pcFileBuffer, 1, g_ui32FileFill, g_psFile);
+        g_ui32FileUnflushed += g_ui32FileFill;
+        g_ui32FileFill = 0;
+    }
+
+    if (g_ui32FileUnflushed >= SINK_FILE_FLUSH_BYTES) {
+        fflush(g_psFile);
+        g_ui32FileUnflushed = 0;
+    }
+}
+
+static int
+openFile(const char *pcPath)
+{
+    g_psFile = fopen(pcPath, "w");
+    if (g_psFile == NULL) {
+        return 1;
+    }
+
+    // Lines are already batched in g_pcFileBuffer, so skip the C library's
+    // own buffer (which would otherwise come out of the small heap).
+    setvbuf(g_psFile, NULL, _IONBF, 0);
+
+    g_ui32FileFill = 0;
+    g_ui32FileUnflushed = 0;
+    return 0;
+}
+
+static void
+writeFile(const tSampleBlock *psBlock, uint32_t ui32Count, uint64_t ui64FirstSample)
+{
+    uint64_t ui64Timestamp = getBlockTimestampUs(psBlock->ui32Seq);
+    uint32_t ui32Period = 1000000 / getOutputRate();
+    uint32_t ui32Index;
+    uint32_t ui32Channel;
+    int iLen;
+
+    for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+    {
+        // Longest line: two 20-digit numbers, a 5-digit code per channel and
+        // separators
+        if (g_ui32FileFill > SINK_FILE_BUFFER_SIZE - (44 + 6 * ADC_MAX_CHANNELS)) {
+            fileDrain();
+        }
+
+        iLen = snprintf(&g_pcFileBuffer[g_ui32FileFill], SINK_FILE_BUFFER_SIZE - g_ui32FileFill,
+                        "%llu\t%llu",
+                        (unsigned long long)(ui64FirstSample + ui32Index + 1),
+                        (unsigned long long)(ui64Timestamp + (uint64_t)ui32Index * ui32Period));
+        g_ui32FileFill += iLen;
+
+        // One column per channel, in channel list order
+        for (ui32Channel = 0; ui32Channel < g_sAcqConfig.ui32NumChannels; ui32Channel++)
+        {
+            iLen = snprintf(&g_pcFileBuffer[g_ui32FileFill], SINK_FILE_BUFFER_SIZE - g_ui32FileFill,
+                            "\t%4d", blockPlane(psBlock, ui32Channel)[ui32Index]);
+            g_ui32FileFill += iLen;
+        }
+
+        g_pcFileBuffer[g_ui32FileFill++] = '\n';
+    }
+}
+
+static void
+closeFile(void)
+{
+    fileDrain();
+    fclose(g_psFile);
+    g_psFile = NULL;
+}
+
+//*****************************************************************************/
+// SINK_FLASH: the SINK_UART_BINARY frame stream, appended to the SPI flash
+// log as a new run
+//*****************************************************************************/
+static int
+openFlash(const char *pcPath)
+{
+    if (!flashLogPresent()) {
+        return 1;
+    }
+
+    UARTprintf("Flash run %u\n", flashLogStartRun());
+    return 0;
+}
+
+static void
+writeFlash(const tSampleBlock *psBlock, uint32_t ui32Count, uint64_t ui64FirstSample)
+{
+    flashLogAppend(g_pui8Frame, encodeFrame(psBlock, ui32Count), getBlockTimestampUs(psBlock->ui32Seq));
+}
+
+static void
+closeFlash(void)
+{
+    tFlashLogStats sStats;
+
+    flashLogFlush();
+    flashLogGetStats(&sStats);
+
+    UARTprintf("\nFlash Pages:    %u", sStats.ui32Pages);
+    UARTprintf("\nFlash Queue:    %d of %d pages", sStats.ui32QueueHighWater, FLASH_LOG_QUEUE_PAGES);
+    UARTprintf("\nFlash Stalls:   %d (%u us)", sStats.ui32Stalls, sStats.ui32StallUs);
+    UARTprintf("\nFlash Erases:   %d in line, min headroom %d of %d sectors", sStats.ui32EraseWaits,
+               sStats.ui32MinHeadroom, FLASH_LOG_ERASE_AHEAD);
+}
+
+//*****************************************************************************/
+// SINK_SPECTRUM: Welch-averaged power spectrum of the first channel, sent as
+// one spectrum frame on the console UART every ui32SpectrumSeconds.  The
+// averaging window is counted in output samples, so it follows the sample
+// clock rather than the UART.
+//*****************************************************************************/
+static uint8_t g_pui8SpectrumFrame[SAMPLE_FRAME_SIZE(SPECTRUM_BINS, SAMPLE_FRAME_FLAG_16BIT)];
+static int16_t g_pi16SpectrumDb[SPECTRUM_BINS];
+static uint32_t g_ui32SpectrumSeq;
+static uint32_t g_ui32SpectrumSamples;
+static uint64_t g_ui64SpectrumStartUs;
+
+static void
+sendSpectrum(void)
+{
+    tSampleFrameHeader sHeader;
+    uint32_t ui32Rate = getOutputRate();
+
+    spectrumGetDb(g_pi16SpectrumDb, (float)ui32Rate);
+
+    sHeader.ui32Seq = g_ui32SpectrumSeq++;
+    sHeader.ui64Timestamp = g_ui64SpectrumStartUs;
+    sHeader.ui32PeriodNs = (uint32_t)(((uint64_t)ui32Rate * 1000) / SPECTRUM_FFT_SIZE);
+    sHeader.ui16Count = SPECTRUM_BINS;
+    sHeader.ui16ChannelMask = (uint16_t)(1 << g_sAcqConfig.pui8Channels[0]);
+    sHeader.ui8Flags = SAMPLE_FRAME_FLAG_16BIT | SAMPLE_FRAME_FLAG_SPECTRUM;
+
+    UARTwriteBinary(g_pui8SpectrumFrame,
+                    sampleFrameEncode(g_pui8SpectrumFrame, &sHeader, (const uint16_t *)g_pi16SpectrumDb));
+}
+
+static int
+openSpectrum(const char *pcPath)
+{
+    spectrumInit();
+    g_ui32SpectrumSeq = 0;
+    g_ui32SpectrumSamples = 0;
+    g_ui64SpectrumStartUs = 0;
+    binaryEchoOff();
+    return 0;
+}
+
+static void
+writeSpectrum(const tSampleBlock *psBlock, uint32_t ui32Count, uint64_t ui64FirstSample)
+{
+    if (g_ui32SpectrumSamples == 0) {
+        g_ui64SpectrumStartUs = getBlockTimestampUs(psBlock->ui32Seq);
+    }
+
+    spectrumAddSamples(blockPlane(psBlock, 0), ui32Count);
+    g_ui32SpectrumSamples += ui32Count;
+
+    if (g_ui32SpectrumSamples >= g_sAcqConfig.ui32SpectrumSeconds * getOutputRate() &&
+        spectrumAverages()) {
+        sendSpectrum();
+        g_ui32SpectrumSamples = 0;
+    }
+}
+
+static void
+closeSpectrum(void)
+{
+    // Send whatever has been averaged since the last spectrum
+    if (spectrumAverages()) {
+        sendSpectrum();
+    }
+    binaryEchoOn();
+
+    UARTprintf("\nSpectra:        %d (%d-point FFT, %d us per transform)", g_ui32SpectrumSeq,
+               SPECTRUM_FFT_SIZE, spectrumTransformUs());
+}
+
+//*****************************************************************************/
+// Sink table, indexed by SINK_* identifier
+//*****************************************************************************/
+static const tSampleSink g_psSinks[SINK_COUNT] =
+{
+    { "null",        openNone,       writeNull,       idleNone,        closeNone },
+    { "uart-text",   openUARTText,   writeUARTText,   idleNone,        closeNone },
+    { "uart-binary", openUARTBinary, writeUARTBinary, idleNone,        closeUARTBinary },
+    { "file",        openFile,       writeFile,       idleNone,        closeFile },
+    { "flash",       openFlash,      writeFlash,      flashLogService, closeFlash },
+    { "spectrum",    openSpectrum,   writeSpectrum,   idleNone,        closeSpectrum },
+};
+
+//*****************************************************************************/
+// Look up a sink by identifier.  Returns NULL for an unknown identifier.
+//*****************************************************************************/
+const tSampleSink *
+sampleSinkGet(uint32_t ui32Sink)
+{
+    if (ui32Sink >= SINK_COUNT) {
+        return NULL;
+    }
+
+    return &g_psSinks[ui32Sink];
+}
@@ -0,0 +1,61 @@
+/*
+ * sample_sink.h
+ *
+ *  Created on: Feb 26, 2024
+ *      Author: Tyler
+ */
+
+#ifndef SAMPLE_SINK_H_
+#define SAMPLE_SINK_H_
+
+// Output sink identifiers, used as g_sAcqConfig.ui32Sink
+#define SINK_NULL           0   // Discard samples (throughput testing)
+#define SINK_UART_TEXT      1   // One UARTprintf line per sample
+#define SINK_UART_BINARY    2   // One sample_frame.h frame per block
+#define SINK_FILE           3   // Batched TSV over CCS semihosting
+#define SINK_FLASH          4   // sample_frame.h frames appended to flash_log.h
+#define SINK_SPECTRUM       5   // Averaged spectrum frames on the console UART
+#define SINK_COUNT          6
+
+// Semihosting file sink: size of the RAM staging buffer, and how much data
+// may be written before the file is flushed.  Every fwrite() and fflush()
+// halts the CPU while the debugger services it, so both happen per batch
+// rather than per sample.
+#ifndef SINK_FILE_BUFFER_SIZE
+#define SINK_FILE_BUFFER_SIZE   512
+#endif
+#ifndef SINK_FILE_FLUSH_BYTES
+#define SINK_FILE_FLUSH_BYTES   8192
+#endif
+
+// An output sink.  Blocks are delivered in order, holding one plane of
+// psBlock->ui32Count / ui32NumChannels samples per channel in channel list
+// order.  ui32Count is the number of sample sets (one sample per channel) to
+// consume and may be less than the plane length for the final block of a run.
+// ui64FirstSample is the zero-based number of the block's first delivered
+// sample set in the run.
+typedef struct
+{
+    // Short name shown on the console
+    const char *pcName;
+
+    // Prepare the sink for a new run.  pcPath is only used by SINK_FILE.
+    // Returns 0 on success.
+    int (*pfnOpen)(const char *pcPath);
+
+    // Consume the first ui32Count sample sets of a block
+    void (*pfnWrite)(const tSampleBlock *psBlock, uint32_t ui32Count,
+                     uint64_t ui64FirstSample);
+
+    // Background work (such as a flash program in flight), called while the
+    // acquisition loop waits for the next block
+    void (*pfnIdle)(void);
+
+    // Flush and release the sink at the end of a run
+    void (*pfnClose)(void);
+}
+tSampleSink;
+
+const tSampleSink *sampleSinkGet(uint32_t ui32Sink);
+
+#endif /* SAMPLE_SINK_H_ */
@@ -0,0 +1,302 @@
+/*
+ * spectrum.c
+ *
+ *  Created on: Apr 22, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "spectrum.h"
+#include "timebase.h"
+
+//*****************************************************************************/
+// Welch-averaged power spectrum of one sample stream.
+//
+// Samples are collected in a ring of SPECTRUM_FFT_SIZE.  Every half ring of
+// new samples (50% overlap), the latest SPECTRUM_FFT_SIZE samples have their
+// mean removed, are Hann windowed and transformed, and the squared
+// magnitudes are added to the accumulator.  spectrumGetDb() turns the
+// average into a one-sided power spectral density and starts a new average.
+//
+// The real transform packs the N real samples into N/2 complex points, runs
+// an N/2-point radix-2 FFT in single precision on the FPU, and separates the
+// even and odd halves afterwards.
+//*****************************************************************************/
+#define FFT_N       SPECTRUM_FFT_SIZE
+#define FFT_HALF    (SPECTRUM_FFT_SIZE / 2)
+
+// Hann window and its power sum, for the density scaling
+static float g_pfWindow[FFT_N];
+static float g_fWindowPower;
+
+// exp(-2 pi i k / N) for k < N/2
+static float g_pfCos[FFT_HALF];
+static float g_pfSin[FFT_HALF];
+
+// Input ring, index of the oldest sample, samples held and samples since the
+// last transform
+static uint16_t g_pui16Ring[FFT_N];
+static uint32_t g_ui32RingStart;
+static uint32_t g_ui32RingFill;
+static uint32_t g_ui32Pending;
+
+// Transform work area (N/2 complex points, interleaved re, im)
+static float g_pfWork[FFT_N];
+
+// Sum of |X[k]|^2 over the transforms in the current average
+static float g_pfPower[SPECTRUM_BINS];
+static uint32_t g_ui32Averages;
+
+// Transform timing for the end-of-run report
+static uint64_t g_ui64TransformTicks;
+static uint32_t g_ui32Transforms;
+
+//*****************************************************************************/
+// Build the window and twiddle tables and clear all state
+//*****************************************************************************/
+void
+spectrumInit(void)
+{
+    const float fPi = 3.14159265f;
+    uint32_t ui32Index;
+
+    g_fWindowPower = 0.0f;
+    for (ui32Index = 0; ui32Index < FFT_N; ui32Index++)
+    {
+        g_pfWindow[ui32Index] = 0.5f - 0.5f * cosf(2.0f * fPi * ui32Index / FFT_N);
+        g_fWindowPower += g_pfWindow[ui32Index] * g_pfWindow[ui32Index];
+    }
+
+    for (ui32Index = 0; ui32Index < FFT_HALF; ui32Index++)
+    {
+        g_pfCos[ui32Index] = cosf(2.0f * fPi * ui32Index / FFT_N);
+        g_pfSin[ui32Index] = -sinf(2.0f * fPi * ui32Index / FFT_N);
+    }
+
+    g_ui32RingStart = 0;
+    g_ui32RingFill = 0;
+    g_ui32Pending = 0;
+    memset(g_pfPower, 0, sizeof(g_pfPower));
+    g_ui32Averages = 0;
+    g_ui64TransformTicks = 0;
+    g_ui32Transforms = 0;
+}
+
+//*****************************************************************************/
+// In-place radix-2 decimation-in-time FFT of the FFT_HALF complex points in
+// g_pfWork.  Twiddles for the half-size transform are every other entry of
+// the N-point table.
+//*****************************************************************************/
+static void
+complexFFT(void)
+{
+    float *pfData = g_pfWork;
+    uint32_t ui32Rev = 0;
+    uint32_t ui32Index;
+    uint32_t ui32Bit;
+    uint32_t ui32Span;
+    uint32_t ui32Step;
+    uint32_t ui32Group;
+    uint32_t ui32Pair;
+    uint32_t ui32Twiddle;
+    float fTemp;
+    float fRe;
+    float fIm;
+    float fWr;
+    float fWi;
+
+    // Bit-reversed reordering
+    for (ui32Index = 0; ui32Index < FFT_HALF; ui32Index++)
+    {
+        if (ui32Index < ui32Rev) {
+            fTemp = pfData[2 * ui32Index];
+            pfData[2 * ui32Index] = pfData[2 * ui32Rev];
+            pfData[2 * ui32Rev] = fTemp;
+            fTemp = pfData[2 * ui32Index + 1];
+            pfData[2 * ui32Index + 1] = pfData[2 * ui32Rev + 1];
+            pfData[2 * ui32Rev + 1] = fTemp;
+        }
+
+        ui32Bit = FFT_HALF >> 1;
+        while (ui32Bit && (ui32Rev & ui32Bit)) {
+            ui32Rev ^= ui32Bit;
+            ui32Bit >>= 1;
+        }
+        ui32Rev |= ui32Bit;
+    }
+
+    // Butterflies, doubling the span each pass
+    for (ui32Span = 1, ui32Step = FFT_HALF; ui32Span < FFT_HALF; ui32Span <<= 1, ui32Step >>= 1)
+    {
+        for (ui32Pair = 0; ui32Pair < ui32Span; ui32Pair++)
+        {
+            ui32Twiddle = ui32Pair * ui32Step;
+            fWr = g_pfCos[ui32Twiddle];
+            fWi = g_pfSin[ui32Twiddle];
+
+            for (ui32Group = ui32Pair; ui32Group < FFT_HALF; ui32Group += 2 * ui32Span)
+            {
+                ui32Index = ui32Group + ui32Span;
+                fRe = fWr * pfData[2 * ui32Index] - fWi * pfData[2 * ui32Index + 1];
+                fIm = fWr * pfData[2 * ui32Index + 1] + fWi * pfData[2 * ui32Index];
+                pfData[2 * ui32Index] = pfData[2 * ui32Group] - fRe;
+                pfData[2 * ui32Index + 1] = pfData[2 * ui32Group + 1] - fIm;
+                pfData[2 * ui32Group] += fRe;
+                pfData[2 * ui32Group + 1] += fIm;
+            }
+        }
+    }
+}
+
+//*****************************************************************************/
+// Window and transform the ring, and add the squared magnitudes of bins 0 to
+// N/2 to the accumulator
+//*****************************************************************************/
+static void
+transformRing(void)
+{
+    uint64_t ui64Start = timebaseNow();
+    float fMean = 0.0f;
+    float fEvenRe, fEvenIm, fOddRe, fOddIm;
+    float fRe, fIm;
+    uint32_t ui32Index;
+    uint32_t ui32Mirror;
+
+    for (ui32Index = 0; ui32Index < FFT_N; ui32Index++)
+    {
+        fMean += g_pui16Ring[(g_ui32RingStart + ui32Index) % FFT_N];
+    }
+    fMean /= FFT_N;
+
+    // Pack even samples as real parts and odd samples as imaginary parts
+    for (ui32Index = 0; ui32Index < FFT_N; ui32Index++)
+    {
+        g_pfWork[ui32Index] = (g_pui16Ring[(g_ui32RingStart + ui32Index) % FFT_N] - fMean) * g_pfWindow[ui32Index];
+    }
+
+    complexFFT();
+
+    // Separate the spectra of the even (E) and odd (O) samples from Z, then
+    // X[k] = E[k] + exp(-2 pi i k / N) O[k].  Z[N/2] wraps to Z[0].
+    for (ui32Index = 0; ui32Index <= FFT_HALF; ui32Index++)
+    {
+        ui32Mirror = (FFT_HALF - ui32Index) % FFT_HALF;
+
+        fEvenRe = 0.5f * (g_pfWork[2 * (ui32Index % FFT_HALF)] + g_pfWork[2 * ui32Mirror]);
+        fEvenIm = 0.5f * (g_pfWork[2 * (ui32Index % FFT_HALF) + 1] - g_pfWork[2 * ui32Mirror + 1]);
+        fOddRe = 0.5f * (g_pfWork[2 * (ui32Index % FFT_HALF) + 1] + g_pfWork[2 * ui32Mirror + 1]);
+        fOddIm = -0.5f * (g_pfWork[2 * (ui32Index % FFT_HALF)] - g_pfWork[2 * ui32Mirror]);
+
+        if (ui32Index < FFT_HALF) {
+            fRe = fEvenRe + g_pfCos[ui32Index] * fOddRe - g_pfSin[ui32Index] * fOddIm;
+            fIm = fEvenIm + g_pfCos[ui32Index] * fOddIm + g_pfSin[ui32Index] * fOddRe;
+        }
+        else {
+            // exp(-i pi) = -1 at Nyquist
+            fRe = fEvenRe - fOddRe;
+            fIm = fEvenIm - fOddIm;
+        }
+
+        g_pfPower[ui32Index] += fRe * fRe + fIm * fIm;
+    }
+
+    g_ui32Averages++;
+    g_ui64TransformTicks += timebaseNow() - ui64Start;
+    g_ui32Transforms++;
+}
+
+//*****************************************************************************/
+// Add samples to the stream.  A transform runs each time half a ring of new
+// samples has arrived once the ring is full.
+//*****************************************************************************/
+void
+spectrumAddSamples(const uint16_t *pui16Samples, uint32_t ui32Count)
+{
+    uint32_t ui32Index;
+
+    for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+    {
+        if (g_ui32RingFill < FFT_N) {
+            g_pui16Ring[g_ui32RingFill++] = pui16Samples[ui32Index];
+        }
+        else {
+            g_pui16Ring[g_ui32RingStart] = pui16Samples[ui32Index];
+            g_ui32RingStart = (g_ui32RingStart + 1) % FFT_N;
+        }
+
+        if (++g_ui32Pending >= FFT_HALF && g_ui32RingFill == FFT_N) {
+            transformRing();
+            g_ui32Pending = 0;
+        }
+    }
+}
+
+//*****************************************************************************/
+// Number of transforms in the current average
+//*****************************************************************************/
+uint32_t
+spectrumAverages(void)
+{
+    return g_ui32Averages;
+}
+
+//*****************************************************************************/
+// Write the averaged one-sided power spectral density, in codes^2 / Hz, as
+// signed 0.01 dB steps for bins 0 to N/2, then start a new average.
+// fSampleRate is the rate of the samples passed to spectrumAddSamples().
+//*****************************************************************************/
+void
+spectrumGetDb(int16_t *pi16Db, float fSampleRate)
+{
+    float fScale;
+    float fDensity;
+    float fDb;
+    uint32_t ui32Index;
+
+    if (g_ui32Averages == 0) {
+        memset(pi16Db, 0, SPECTRUM_BINS * sizeof(int16_t));
+        return;
+    }
+
+    fScale = 1.0f / (g_ui32Averages * fSampleRate * g_fWindowPower);
+
+    for (ui32Index = 0; ui32Index < SPECTRUM_BINS; ui32Index++)
+    {
+        // Bins other than DC and Nyquist also carry the negative frequencies
+        fDensity = g_pfPower[ui32Index] * fScale;
+        if (ui32Index != 0 && ui32Index != FFT_HALF) {
+            fDensity *= 2.0f;
+        }
+
+        fDb = (fDensity > 1e-30f) ? 1000.0f * log10f(fDensity) : -32768.0f;
+        if (fDb < -32768.0f) {
+            fDb = -32768.0f;
+        }
+        else if (fDb > 32767.0f) {
+            fDb = 32767.0f;
+        }
+        pi16Db[ui32Index] = (int16_t)lroundf(fDb);
+    }
+
+    memset(g_pfPower, 0, sizeof(g_pfPower));
+    g_ui32Averages = 0;
+}
+
+//*****************************************************************************/
+// Mean time per transform since spectrumInit(), in microseconds
+//*****************************************************************************/
+uint32_t
+spectrumTransformUs(void)
+{
+    if (g_ui32Transforms == 0) {
+        return 0;
+    }
+
+    return (uint32_t)timebaseTicksToUs(g_ui64TransformTicks / g_ui32Transforms);
+}
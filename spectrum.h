@@ -0,0 +1,30 @@
+/*
+ * spectrum.h
+ *
+ *  Created on: Apr 22, 2024
+ *      Author: Tyler
+ */
+
+#ifndef SPECTRUM_H_
+#define SPECTRUM_H_
+
+// Points per transform.  Must be a power of two from 16 to 1024; the RAM
+// cost is about 16 bytes per point.
+#ifndef SPECTRUM_FFT_SIZE
+#define SPECTRUM_FFT_SIZE   256
+#endif
+
+#if (SPECTRUM_FFT_SIZE & (SPECTRUM_FFT_SIZE - 1)) != 0 || SPECTRUM_FFT_SIZE < 16 || SPECTRUM_FFT_SIZE > 1024
+#error "SPECTRUM_FFT_SIZE must be a power of two from 16 to 1024"
+#endif
+
+// One-sided spectrum bins, DC to Nyquist
+#define SPECTRUM_BINS       (SPECTRUM_FFT_SIZE / 2 + 1)
+
+void spectrumInit(void);
+void spectrumAddSamples(const uint16_t *pui16Samples, uint32_t ui32Count);
+uint32_t spectrumAverages(void);
+void spectrumGetDb(int16_t *pi16Db, float fSampleRate);
+uint32_t spectrumTransformUs(void);
+
+#endif /* SPECTRUM_H_ */
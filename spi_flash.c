@@ -33,7 +33,7 @@
 #include "driverlib/rom_map.h"
 #include "driverlib/ssi.h"
 #include "driverlib/udma.h"
-#include "utils/spi_flash.h"
+#include "spi_flash.h"
 
 //*****************************************************************************
 //
@@ -83,6 +83,99 @@
 #define STATE_WRITE_DATA_DMA    12
 #define STATE_WRITE_DATA_END    13
 
+//*****************************************************************************
+//
+// The maximum number of 1024-byte tasks in a scatter-gather uDMA transfer.
+// uDMA transfers longer than 1024 bytes and no longer than this many tasks are
+// run as a single job with one completion interrupt; longer transfers fall
+// back to re-arming a basic transfer every 1024 bytes.  Each task costs 16
+// bytes of SRAM per direction.
+//
+//*****************************************************************************
+#ifndef SPI_FLASH_SG_TASKS
+#define SPI_FLASH_SG_TASKS      16
+#endif
+
+//*****************************************************************************
+//
+// The scatter-gather task lists for the transmit and receive uDMA channels.
+// Only one non-blocking transfer can be in progress at a time, so these are
+// shared by all instances.
+//
+//*****************************************************************************
+static tDMAControlTable g_psSPIFlashTxTasks[SPI_FLASH_SG_TASKS];
+static tDMAControlTable g_psSPIFlashRxTasks[SPI_FLASH_SG_TASKS];
+
+//*****************************************************************************
+//
+// Fills in a peripheral scatter-gather task list that moves ui32Count bytes in
+// tasks of up to 1024 bytes.  Exactly one of the source and destination
+// advances (as given by ui32Control); the other is the SSI data register.  The
+// last task is a basic transfer so that the channel stops and raises its
+// completion interrupt when the whole job is done.
+//
+//*****************************************************************************
+static void
+SPIFlashTasksBuild(tDMAControlTable *psTasks, uint8_t *pui8Src,
+                   uint8_t *pui8Dst, uint32_t ui32Count, uint32_t ui32Control)
+{
+    uint32_t ui32Task;
+
+    //
+    // Loop while there is more data to describe.
+    //
+    while(ui32Count != 0)
+    {
+        //
+        // Determine the size of this task.
+        //
+        ui32Task = (ui32Count > 1024) ? 1024 : ui32Count;
+        ui32Count -= ui32Task;
+
+        //
+        // The end pointers address the last item of the task, or the fixed
+        // address for the side that does not advance.
+        //
+        psTasks->pvSrcEndAddr = ((ui32Control & UDMA_SRC_INC_NONE) ==
+                                 UDMA_SRC_INC_NONE) ?
+                                pui8Src : pui8Src + ui32Task - 1;
+        psTasks->pvDstEndAddr = ((ui32Control & UDMA_DST_INC_NONE) ==
+                                 UDMA_DST_INC_NONE) ?
+                                pui8Dst : pui8Dst + ui32Task - 1;
+        psTasks->ui32Control = (ui32Control | ((ui32Task - 1) << 4) |
+                                ((ui32Count != 0) ?
+                                 (UDMA_MODE_PER_SCATTER_GATHER |
+                                  UDMA_MODE_ALT_SELECT) : UDMA_MODE_BASIC));
+        psTasks->ui32Spare = 0;
+
+        //
+        // Advance whichever side moves.
+        //
+        if((ui32Control & UDMA_SRC_INC_NONE) != UDMA_SRC_INC_NONE)
+        {
+            pui8Src += ui32Task;
+        }
+        if((ui32Control & UDMA_DST_INC_NONE) != UDMA_DST_INC_NONE)
+        {
+            pui8Dst += ui32Task;
+        }
+
+        //
+        // Move to the next task.
+        //
+        psTasks++;
+    }
+}
+
+//*****************************************************************************
+//
+// Determines if a uDMA transfer of ui32Count bytes should be run as a single
+// scatter-gather job.
+//
+//*****************************************************************************
+#define SPIFlashUseScatterGather(ui32Count)                                   \
+        (((ui32Count) > 1024) && ((ui32Count) <= (SPI_FLASH_SG_TASKS * 1024)))
+
 //*****************************************************************************
 //
 //! Handles SSI module interrupts for the SPI flash driver.
@@ -126,9 +219,10 @@ SPIFlashIntHandler(tSPIFlashState *pState)
     {
         //
         // Determine the size of the uDMA transfer based on the number of bytes
-        // left to write.
+        // left to write.  A scatter-gather job covered everything but the final
+        // byte in one go.
         //
-        if(pState->ui32WriteCount > 1024)
+        if((pState->ui32WriteCount > 1024) && !pState->bScatterGather)
         {
             //
             // There are more than 1024 bytes left to transfer, so the uDMA
@@ -205,9 +299,9 @@ SPIFlashIntHandler(tSPIFlashState *pState)
     {
         //
         // Determine the size of the uDMA transfer based on the number of bytes
-        // left to read.
+        // left to read.  A scatter-gather job covered the whole read.
         //
-        if(pState->ui32ReadCount >= 1024)
+        if((pState->ui32ReadCount >= 1024) && !pState->bScatterGather)
         {
             //
             // There are 1024 or more bytes left to transfer, so the uDMA
@@ -653,13 +747,21 @@ SPIFlashIntHandler(tSPIFlashState *pState)
                 else
                 {
                     //
-                    // If the transfer is larger than 1024 bytes, enable the
-                    // uDMA receive complete interrupt which will be used to
-                    // move to the next block of the transfer.  Otherwise,
-                    // enable the uDMA transmit complete interrupt which will
-                    // be used to complete the transaction.
+                    // See if the whole read can be described by a single
+                    // scatter-gather job.
+                    //
+                    pState->bScatterGather =
+                        SPIFlashUseScatterGather(pState->ui32ReadCount);
+
+                    //
+                    // If the transfer is larger than 1024 bytes and is being
+                    // re-armed per block, enable the uDMA receive complete
+                    // interrupt which will be used to move to the next block
+                    // of the transfer.  Otherwise, enable the uDMA transmit
+                    // complete interrupt which will be used to complete the
+                    // transaction.
                     //
-                    if(pState->ui32ReadCount > 1024)
+                    if((pState->ui32ReadCount > 1024) && !pState->bScatterGather)
                     {
                         HWREG(pState->ui32Base + SSI_O_IM) = SSI_IM_DMARXIM;
                     }
@@ -699,16 +801,36 @@ SPIFlashIntHandler(tSPIFlashState *pState)
                                           UDMA_SIZE_8 | UDMA_ARB_4);
 
                     //
-                    // Configure the uDMA receive channel to transfer the first
+                    // Configure the uDMA receive channel to transfer the whole
+                    // buffer as one scatter-gather job, or else the first
                     // portion of the data buffer.
                     //
-                    uDMAChannelTransferSet(pState->ui32RxChannel,
-                                           UDMA_MODE_BASIC,
-                                           (void *)(pState->ui32Base +
-                                                    SSI_O_DR),
+                    if(pState->bScatterGather)
+                    {
+                        SPIFlashTasksBuild(g_psSPIFlashRxTasks,
+                                           (uint8_t *)(pState->ui32Base +
+                                                       SSI_O_DR),
                                            pState->pui8Buffer,
-                                           (pState->ui32ReadCount >= 1024) ?
-                                           1024 : pState->ui32ReadCount);
+                                           pState->ui32ReadCount,
+                                           UDMA_SRC_INC_NONE |
+                                           UDMA_DST_INC_8 |
+                                           UDMA_SIZE_8 | UDMA_ARB_4);
+                        uDMAChannelScatterGatherSet(pState->ui32RxChannel,
+                                                    (pState->ui32ReadCount +
+                                                     1023) / 1024,
+                                                    g_psSPIFlashRxTasks, 1);
+                    }
+                    else
+                    {
+                        uDMAChannelTransferSet(pState->ui32RxChannel,
+                                               UDMA_MODE_BASIC,
+                                               (void *)(pState->ui32Base +
+                                                        SSI_O_DR),
+                                               pState->pui8Buffer,
+                                               (pState->ui32ReadCount >=
+                                                1024) ?
+                                               1024 : pState->ui32ReadCount);
+                    }
 
                     //
                     // Enable the uDMA receive channel.
@@ -719,15 +841,37 @@ SPIFlashIntHandler(tSPIFlashState *pState)
                     // Configure the uDMA channel to transfer the dummy bytes
                     // for the first portion of the data buffer.  The last
                     // dummy byte will not be included since it must be treated
-                    // special.
+                    // special.  The dummy bytes go out of a single job
+                    // whenever the read does.
                     //
-                    uDMAChannelTransferSet(pState->ui32TxChannel,
-                                           UDMA_MODE_BASIC,
+                    if(pState->bScatterGather &&
+                       (pState->ui32WriteCount - 1 > 1024))
+                    {
+                        SPIFlashTasksBuild(g_psSPIFlashTxTasks,
                                            pState->pui8Buffer,
-                                           (void *)(pState->ui32Base +
-                                                    SSI_O_DR),
-                                           (pState->ui32WriteCount > 1024) ?
-                                           1024 : pState->ui32WriteCount - 1);
+                                           (uint8_t *)(pState->ui32Base +
+                                                       SSI_O_DR),
+                                           pState->ui32WriteCount - 1,
+                                           UDMA_SRC_INC_NONE |
+                                           UDMA_DST_INC_NONE |
+                                           UDMA_SIZE_8 | UDMA_ARB_2);
+                        uDMAChannelScatterGatherSet(pState->ui32TxChannel,
+                                                    (pState->ui32WriteCount +
+                                                     1022) / 1024,
+                                                    g_psSPIFlashTxTasks, 1);
+                    }
+                    else
+                    {
+                        uDMAChannelTransferSet(pState->ui32TxChannel,
+                                               UDMA_MODE_BASIC,
+                                               pState->pui8Buffer,
+                                               (void *)(pState->ui32Base +
+                                                        SSI_O_DR),
+                                               (pState->ui32WriteCount >
+                                                1024) ?
+                                               1024 :
+                                               pState->ui32WriteCount - 1);
+                    }
 
                     //
                     // Enable the uDMA transmit channel.
@@ -987,16 +1131,39 @@ SPIFlashIntHandler(tSPIFlashState *pState)
 
                     //
                     // Configure the uDMA channel to transfer the next portion
-                    // of the data buffer.  The last byte in the buffer will
+                    // of the data buffer, or all of it as a single
+                    // scatter-gather job.  The last byte in the buffer will
                     // not be included since it must be treated special.
                     //
-                    uDMAChannelTransferSet(pState->ui32TxChannel,
-                                           UDMA_MODE_BASIC,
+                    pState->bScatterGather =
+                        SPIFlashUseScatterGather(pState->ui32WriteCount - 1);
+                    if(pState->bScatterGather)
+                    {
+                        SPIFlashTasksBuild(g_psSPIFlashTxTasks,
                                            pState->pui8Buffer,
-                                           (void *)(pState->ui32Base +
-                                                    SSI_O_DR),
-                                           (pState->ui32WriteCount > 1024) ?
-                                           1024 : pState->ui32WriteCount - 1);
+                                           (uint8_t *)(pState->ui32Base +
+                                                       SSI_O_DR),
+                                           pState->ui32WriteCount - 1,
+                                           UDMA_SRC_INC_8 |
+                                           UDMA_DST_INC_NONE |
+                                           UDMA_SIZE_8 | UDMA_ARB_4);
+                        uDMAChannelScatterGatherSet(pState->ui32TxChannel,
+                                                    (pState->ui32WriteCount +
+                                                     1022) / 1024,
+                                                    g_psSPIFlashTxTasks, 1);
+                    }
+                    else
+                    {
+                        uDMAChannelTransferSet(pState->ui32TxChannel,
+                                               UDMA_MODE_BASIC,
+                                               pState->pui8Buffer,
+                                               (void *)(pState->ui32Base +
+                                                        SSI_O_DR),
+                                               (pState->ui32WriteCount >
+                                                1024) ?
+                                               1024 :
+                                               pState->ui32WriteCount - 1);
+                    }
 
                     //
                     // Enable the uDMA transmit channel.
@@ -89,6 +89,12 @@ typedef struct
     //! The uDMA channel to use for receiving when using uDMA for the transfer.
     //
     uint32_t ui32RxChannel;
+
+    //
+    //! A flag that is true if the uDMA portion of the transfer was set up as a
+    //! single scatter-gather job rather than 1024-byte basic transfers.
+    //
+    bool bScatterGather;
 }
 tSPIFlashState;
 
@@ -0,0 +1,317 @@
+/*
+ * stats.c
+ *
+ *  Created on: May 6, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Custom project-specific headers
+#include "adc_functions.h"
+#include "sample_buffer.h"
+#include "stats.h"
+#include "uartstdio.h"
+
+//*****************************************************************************/
+// Streaming statistics of every delivered sample, per channel.
+//
+// The per-sample work is integer only: minimum, maximum, histogram bin,
+// zero-crossing state, and the sum and sum of squares of the difference from
+// a reference sample.  The reference is the channel's first sample of the
+// run, so the sums stay small for a steady signal and the variance computed
+// from them at report time does not lose precision to a large mean (the
+// "shifted data" form of the running variance).  The sum of squares is kept
+// in 128 bits, so it cannot overflow in any run length.
+//*****************************************************************************/
+
+typedef struct
+{
+    // First sample of the run, subtracted before summing
+    int32_t i32Reference;
+
+    uint64_t ui64Count;
+    int64_t i64Sum;
+    uint64_t ui64SquaresLo;
+    uint64_t ui64SquaresHi;
+
+    uint32_t ui32Min;
+    uint32_t ui32Max;
+
+    // Side of mid-scale of the last excursion beyond the hysteresis band
+    // (-1, 0 before the first one, +1) and the crossings counted so far
+    int32_t i32Side;
+    uint32_t ui32Crossings;
+
+    uint32_t pui32Histogram[STATS_HIST_BINS];
+}
+tStatsChannel;
+
+static tStatsChannel g_psStats[ADC_MAX_CHANNELS];
+static uint32_t g_ui32NumChannels;
+
+// Differential pair of each channel, copied at the start of the run so the
+// labels stay right if the saved channel list changes afterwards
+static uint8_t g_pui8Pairs[ADC_MAX_CHANNELS];
+
+// Per-run code scaling: mid-scale, crossing band and histogram bin width of
+// the output codes
+static int32_t g_i32MidScale;
+static int32_t g_i32Hysteresis;
+static uint32_t g_ui32BinShift;
+
+//*****************************************************************************/
+// Clear the statistics for a run of the ui32NumChannels differential pairs in
+// pui8Pairs, whose output codes are 12-bit codes shifted up by ui32Shift bits
+//*****************************************************************************/
+void
+statsStart(const uint8_t *pui8Pairs, uint32_t ui32NumChannels, uint32_t ui32Shift)
+{
+    uint32_t ui32Bins;
+
+    memset(g_psStats, 0, sizeof(g_psStats));
+    memcpy(g_pui8Pairs, pui8Pairs, ui32NumChannels);
+    g_ui32NumChannels = ui32NumChannels;
+    g_i32MidScale = 2048 << ui32Shift;
+    g_i32Hysteresis = STATS_CROSSING_HYSTERESIS << ui32Shift;
+
+    // Bin index is the top bits of the code
+    g_ui32BinShift = 12 + ui32Shift;
+    for (ui32Bins = STATS_HIST_BINS; ui32Bins > 1; ui32Bins >>= 1)
+    {
+        g_ui32BinShift--;
+    }
+}
+
+//*****************************************************************************/
+// Add ui32Count samples of one channel plane
+//*****************************************************************************/
+static void
+addPlane(tStatsChannel *psChannel, const uint16_t *pui16Plane, uint32_t ui32Count)
+{
+    int32_t i32Reference;
+    int32_t i32Sum = 0;
+    uint64_t ui64Squares = 0;
+    int32_t i32Diff;
+    int32_t i32Sample;
+    uint32_t ui32Index;
+
+    if (ui32Count == 0) {
+        return;
+    }
+
+    if (psChannel->ui64Count == 0) {
+        psChannel->i32Reference = pui16Plane[0];
+        psChannel->ui32Min = pui16Plane[0];
+        psChannel->ui32Max = pui16Plane[0];
+    }
+    i32Reference = psChannel->i32Reference;
+
+    for (ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+    {
+        i32Sample = pui16Plane[ui32Index];
+
+        i32Diff = i32Sample - i32Reference;
+        i32Sum += i32Diff;
+        ui64Squares += (uint64_t)((int64_t)i32Diff * i32Diff);
+
+        if ((uint32_t)i32Sample < psChannel->ui32Min) {
+            psChannel->ui32Min = i32Sample;
+        }
+        if ((uint32_t)i32Sample > psChannel->ui32Max) {
+            psChannel->ui32Max = i32Sample;
+        }
+
+        psChannel->pui32Histogram[i32Sample >> g_ui32BinShift]++;
+
+        // A crossing is a move from beyond the band on one side to beyond
+        // it on the other
+        i32Diff = i32Sample - g_i32MidScale;
+        if (i32Diff > g_i32Hysteresis) {
+            if (psChannel->i32Side < 0) {
+                psChannel->ui32Crossings++;
+            }
+            psChannel->i32Side = 1;
+        }
+        else if (i32Diff < -g_i32Hysteresis) {
+            if (psChannel->i32Side > 0) {
+                psChannel->ui32Crossings++;
+            }
+            psChannel->i32Side = -1;
+        }
+    }
+
+    // A block of SAMPLE_BLOCK_SIZE 16-bit differences cannot overflow the
+    // block sums; the run sum of squares carries into the high word
+    psChannel->ui64Count += ui32Count;
+    psChannel->i64Sum += i32Sum;
+    psChannel->ui64SquaresLo += ui64Squares;
+    if (psChannel->ui64SquaresLo < ui64Squares) {
+        psChannel->ui64SquaresHi++;
+    }
+}
+
+//*****************************************************************************/
+// Add the first ui32Count sample sets of a processed block
+//*****************************************************************************/
+void
+statsBlock(const tSampleBlock *psBlock, uint32_t ui32Count)
+{
+    uint32_t ui32Plane = psBlock->ui32Count / g_ui32NumChannels;
+    uint32_t ui32Channel;
+
+    for (ui32Channel = 0; ui32Channel < g_ui32NumChannels; ui32Channel++)
+    {
+        addPlane(&g_psStats[ui32Channel], psBlock->pui16Data + ui32Channel * ui32Plane, ui32Count);
+    }
+}
+
+//*****************************************************************************/
+// Position in the channel list of differential pair ui32Pair.  Returns
+// ADC_MAX_CHANNELS if the pair is not in the run.
+//*****************************************************************************/
+uint32_t
+statsChannelOfPair(uint32_t ui32Pair)
+{
+    uint32_t ui32Channel;
+
+    for (ui32Channel = 0; ui32Channel < g_ui32NumChannels; ui32Channel++)
+    {
+        if (g_pui8Pairs[ui32Channel] == ui32Pair) {
+            return ui32Channel;
+        }
+    }
+
+    return ADC_MAX_CHANNELS;
+}
+
+//*****************************************************************************/
+// Summary of channel ui32Channel (position in the channel list).  Returns
+// false if the channel has no samples yet.
+//*****************************************************************************/
+bool
+statsSummary(uint32_t ui32Channel, tStatsSummary *psSummary)
+{
+    const tStatsChannel *psChannel;
+    double dCount;
+    double dSum;
+    double dSquares;
+    double dM2;
+    double dOffset;
+
+    if (ui32Channel >= g_ui32NumChannels || g_psStats[ui32Channel].ui64Count == 0) {
+        return false;
+    }
+    psChannel = &g_psStats[ui32Channel];
+
+    dCount = (double)psChannel->ui64Count;
+    dSum = (double)psChannel->i64Sum;
+    dSquares = (double)psChannel->ui64SquaresHi * 18446744073709551616.0 + (double)psChannel->ui64SquaresLo;
+
+    // Sum of squared deviations from the mean
+    dM2 = dSquares - dSum * dSum / dCount;
+    if (dM2 < 0.0) {
+        dM2 = 0.0;
+    }
+
+    psSummary->ui64Count = psChannel->ui64Count;
+    psSummary->dMean = psChannel->i32Reference + dSum / dCount;
+    psSummary->dStdDev = (psChannel->ui64Count > 1) ? sqrt(dM2 / (dCount - 1.0)) : 0.0;
+
+    // Mean square about mid-scale = variance + squared mean offset
+    dOffset = psSummary->dMean - g_i32MidScale;
+    psSummary->dRMS = sqrt(dM2 / dCount + dOffset * dOffset);
+
+    psSummary->ui32Min = psChannel->ui32Min;
+    psSummary->ui32Max = psChannel->ui32Max;
+    psSummary->ui32Crossings = psChannel->ui32Crossings;
+    return true;
+}
+
+//*****************************************************************************/
+// STATS_HIST_BINS counts of channel ui32Channel; bin n covers output codes
+// n << (code bits - log2(STATS_HIST_BINS)) upwards.  Returns NULL for a
+// channel that is not in the run.
+//*****************************************************************************/
+const uint32_t *
+statsHistogram(uint32_t ui32Channel)
+{
+    if (ui32Channel >= g_ui32NumChannels) {
+        return NULL;
+    }
+
+    return g_psStats[ui32Channel].pui32Histogram;
+}
+
+//*****************************************************************************/
+// Print a non-negative value with two decimals
+//*****************************************************************************/
+static void
+printHundredths(double dValue)
+{
+    uint32_t ui32Value = (uint32_t)(dValue * 100.0 + 0.5);
+
+    UARTprintf("%d.%02d", ui32Value / 100, ui32Value % 100);
+}
+
+//*****************************************************************************/
+// Console report: one line per channel
+//*****************************************************************************/
+void
+statsReport(void)
+{
+    tStatsSummary sSummary;
+    uint32_t ui32Channel;
+    uint32_t ui32Pair;
+
+    if (g_ui32NumChannels == 0) {
+        UARTprintf("No run yet.\n");
+        return;
+    }
+
+    for (ui32Channel = 0; ui32Channel < g_ui32NumChannels; ui32Channel++)
+    {
+        ui32Pair = g_pui8Pairs[ui32Channel];
+        UARTprintf("AIN%d - AIN%d: ", ui32Pair * 2, ui32Pair * 2 + 1);
+
+        if (!statsSummary(ui32Channel, &sSummary)) {
+            UARTprintf("no samples\n");
+            continue;
+        }
+
+        UARTprintf("mean ");
+        printHundredths(sSummary.dMean);
+        UARTprintf(", sd ");
+        printHundredths(sSummary.dStdDev);
+        UARTprintf(", rms ");
+        printHundredths(sSummary.dRMS);
+        UARTprintf(", min %d, max %d, %d crossings\n", sSummary.ui32Min, sSummary.ui32Max, sSummary.ui32Crossings);
+    }
+}
+
+//*****************************************************************************/
+// Console report: the non-empty histogram bins of one channel
+//*****************************************************************************/
+void
+statsReportHistogram(uint32_t ui32Channel)
+{
+    const uint32_t *pui32Histogram = statsHistogram(ui32Channel);
+    uint32_t ui32Bin;
+
+    if (pui32Histogram == NULL) {
+        UARTprintf("No such channel in the run.\n");
+        return;
+    }
+
+    for (ui32Bin = 0; ui32Bin < STATS_HIST_BINS; ui32Bin++)
+    {
+        if (pui32Histogram[ui32Bin]) {
+            UARTprintf("%6d - %6d: %u\n", ui32Bin << g_ui32BinShift,
+                       ((ui32Bin + 1) << g_ui32BinShift) - 1, pui32Histogram[ui32Bin]);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * stats.h
+ *
+ *  Created on: May 6, 2024
+ *      Author: Tyler
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+// Histogram bins per channel, spread evenly over the code range.  Must be a
+// power of two from 2 to 4096; each bin costs 4 bytes per channel.
+#ifndef STATS_HIST_BINS
+#define STATS_HIST_BINS         32
+#endif
+
+#if (STATS_HIST_BINS & (STATS_HIST_BINS - 1)) != 0 || STATS_HIST_BINS < 2 || STATS_HIST_BINS > 4096
+#error "STATS_HIST_BINS must be a power of two from 2 to 4096"
+#endif
+
+// Zero crossings are counted between excursions beyond this many 12-bit
+// codes either side of mid-scale, so noise around zero is not counted
+#ifndef STATS_CROSSING_HYSTERESIS
+#define STATS_CROSSING_HYSTERESIS   8
+#endif
+
+// Summary of one channel, in output codes
+typedef struct
+{
+    uint64_t ui64Count;
+    double dMean;
+    double dStdDev;     // Sample standard deviation
+    double dRMS;        // About mid-scale (0 V differential)
+    uint32_t ui32Min;
+    uint32_t ui32Max;
+    uint32_t ui32Crossings;
+}
+tStatsSummary;
+
+void statsStart(const uint8_t *pui8Pairs, uint32_t ui32NumChannels, uint32_t ui32Shift);
+void statsBlock(const tSampleBlock *psBlock, uint32_t ui32Count);
+uint32_t statsChannelOfPair(uint32_t ui32Pair);
+bool statsSummary(uint32_t ui32Channel, tStatsSummary *psSummary);
+const uint32_t *statsHistogram(uint32_t ui32Channel);
+void statsReport(void);
+void statsReportHistogram(uint32_t ui32Channel);
+
+#endif /* STATS_H_ */
@@ -0,0 +1,83 @@
+/*
+ * timebase.c
+ *
+ *  Created on: Apr 1, 2024
+ *      Author: Tyler
+ */
+
+// Standard C libraries
+#include <stdbool.h>
+#include <stdint.h>
+
+// Custom project-specific headers
+#include "timebase.h"
+
+// Tiva C Series libraries
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "inc/hw_memmap.h"
+
+// System clock rate in Hz, cached by configureTimebase()
+static uint32_t g_ui32ClockHz = 1000000;
+
+//*****************************************************************************/
+// Start the timebase as a 64-bit periodic up-counter.  Must be called after
+// the system clock is set, since it caches the tick rate.
+//*****************************************************************************/
+void
+configureTimebase(void)
+{
+    SysCtlPeripheralEnable(TIMEBASE_TIMER_PERIPH);
+    while (!SysCtlPeripheralReady(TIMEBASE_TIMER_PERIPH))
+    {
+    }
+
+    // A full-width wide timer concatenates both halves into one 64-bit
+    // counter, so no overflow interrupt is needed
+    TimerConfigure(TIMEBASE_TIMER_BASE, TIMER_CFG_PERIODIC_UP);
+    TimerLoadSet64(TIMEBASE_TIMER_BASE, 0xFFFFFFFFFFFFFFFFULL);
+    TimerEnable(TIMEBASE_TIMER_BASE, TIMER_A);
+
+    g_ui32ClockHz = SysCtlClockGet();
+}
+
+//*****************************************************************************/
+// Current timebase value in system clock ticks.  TimerValueGet64() re-reads
+// the upper half to get a consistent value if the lower half carries in
+// between, so this is safe from both thread and interrupt context.
+//*****************************************************************************/
+uint64_t
+timebaseNow(void)
+{
+    return TimerValueGet64(TIMEBASE_TIMER_BASE);
+}
+
+//*****************************************************************************/
+// Convert a number of timebase ticks to microseconds, rounded down.  Whole
+// seconds and the remainder are converted separately, so the result is exact
+// for clocks that are not a whole number of MHz and cannot overflow.
+//*****************************************************************************/
+uint64_t
+timebaseTicksToUs(uint64_t ui64Ticks)
+{
+    return (ui64Ticks / g_ui32ClockHz) * 1000000 +
+           (ui64Ticks % g_ui32ClockHz) * 1000000 / g_ui32ClockHz;
+}
+
+//*****************************************************************************/
+// Drift of an interval measured as ui64Ticks against its nominal length of
+// ui64NominalUs, in parts per million.  Positive when the measured interval
+// is the longer, i.e. the sample clock runs slow against the timebase.
+//*****************************************************************************/
+int32_t
+timebaseDriftPpm(uint64_t ui64Ticks, uint64_t ui64NominalUs)
+{
+    int64_t i64DiffUs;
+
+    if (ui64NominalUs == 0) {
+        return 0;
+    }
+
+    i64DiffUs = (int64_t)(timebaseTicksToUs(ui64Ticks) - ui64NominalUs);
+    return (int32_t)(i64DiffUs * 1000000 / (int64_t)ui64NominalUs);
+}
@@ -0,0 +1,21 @@
+/*
+ * timebase.h
+ *
+ *  Created on: Apr 1, 2024
+ *      Author: Tyler
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+// Wide timer used as the free-running 64-bit timebase.  It counts up at the
+// system clock and, at 20 MHz, takes about 29,000 years to wrap.
+#define TIMEBASE_TIMER_BASE     WTIMER5_BASE
+#define TIMEBASE_TIMER_PERIPH   SYSCTL_PERIPH_WTIMER5
+
+void configureTimebase(void);
+uint64_t timebaseNow(void);
+uint64_t timebaseTicksToUs(uint64_t ui64Ticks);
+int32_t timebaseDriftPpm(uint64_t ui64Ticks, uint64_t ui64NominalUs);
+
+#endif /* TIMEBASE_H_ */
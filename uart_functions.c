@@ -10,15 +10,23 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+// Custom project-specific headers
+#include "cmdline.h"
+#include "data_transfer_functions.h"
+#include "sample_buffer.h"
+#include "sample_sink.h"
+#include "uart_functions.h"
+#include "uartstdio.h"
+
 // Tiva C Series libraries
 #include "driverlib/gpio.h"
 #include "driverlib/pin_map.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/uart.h"
 #include "inc/hw_memmap.h"
-#include "utils/uartstdio.h"
 
 //*****************************************************************************/
 // Sets up UART0 to display information to console
@@ -42,8 +50,12 @@ configureUART(void)
         // Select the alternate (UART) function for these pins
         GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0 | GPIO_PIN_1);
 
+        // The console transmits through uDMA, so the controller and its
+        // channel control table must be set up first
+        configureDMA();
+
         // Initialize the UART for console I/O
-        UARTStdioConfig(0, 115200, 16000000);
+        UARTStdioConfig(0, CONSOLE_BAUD, 16000000);
 
         // Enable the GPIO port for the blue LED
         SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
@@ -56,26 +68,167 @@ configureUART(void)
 }
 
 //*****************************************************************************/
-// User input function
+// User input function.  Returns false if the reply is not a number; a reply
+// of 0 selects continuous capture.
 //*****************************************************************************/
-uint32_t
-getUserInput(void)
+bool
+getUserInput(uint32_t *pui32Samples)
 {
     // Buffer to store user input as a string
     char userInput[16];
 
-    // Variable to store the converted number of samples
-    uint32_t numSamples;
+    // End of the converted number within userInput
+    char *pcEnd;
 
     // Prompt the user to enter the number of samples
-    UARTprintf("Enter the number of samples: ");
+    UARTprintf("Enter the number of samples (0 = continuous): ");
 
     // Read user input as a string using UART
     UARTgets(userInput, sizeof(userInput));
 
-    // Convert the string to an integer
-    numSamples = atoi(userInput);
+    // Convert the string to an integer, rejecting empty or trailing input
+    *pui32Samples = strtoul(userInput, &pcEnd, 10);
+
+    return (pcEnd != userInput) && (*pcEnd == '\0') && (userInput[0] != '-');
+}
+
+//*****************************************************************************/
+// Next character the console has received, or -1 if none is waiting.  Never
+// blocks.  In buffered mode the console interrupt has already echoed it, and
+// it arrives as typed: backspace, CR, LF and ESC are left to the caller.
+//*****************************************************************************/
+static int32_t
+consoleGetChar(void)
+{
+#ifdef UART_BUFFERED
+    return UARTRxBytesAvail() ? (int32_t)UARTgetc() : -1;
+#else
+    return UARTCharGetNonBlocking(UART0_BASE);
+#endif
+}
+
+//*****************************************************************************/
+// Echo typed input on the unbuffered console; in buffered mode the console
+// interrupt does this
+//*****************************************************************************/
+static void
+consoleEcho(const char *pcText)
+{
+#ifdef UART_BUFFERED
+    (void)pcText;
+#else
+    UARTprintf("%s", pcText);
+#endif
+}
+
+//*****************************************************************************/
+// Non-blocking check for a stop request ('s', 'q', Enter or ESC) on the
+// console.  Enter arrives as CR, LF or both, depending on the terminal.
+//*****************************************************************************/
+bool
+userStopRequested(void)
+{
+    int32_t i32Char;
+
+    while ((i32Char = consoleGetChar()) >= 0) {
+        if (i32Char == 's' || i32Char == 'q' || i32Char == '\r' || i32Char == '\n' || i32Char == 0x1B) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//*****************************************************************************/
+// Non-blocking line input.  Moves whatever the console has received into
+// pcLine and returns true once a whole line is there, without its line
+// ending; otherwise returns false and keeps the partial line for the next
+// call.  A line ends on CR, LF or CR LF; backspace deletes the last
+// character, and ESC abandons the line, returning it empty.  Characters
+// beyond ui32Size - 1 are dropped.  Only ever reads what is already
+// received, so it can be polled from the acquisition loop.
+//*****************************************************************************/
+bool
+consoleGetLine(char *pcLine, uint32_t ui32Size)
+{
+    // Length of the partial line
+    static uint32_t ui32Len;
+
+    // Whether the last character ended a line, so that the LF of a CR LF
+    // pair does not end a second, empty one
+    static bool bLastWasCR;
+
+    char pcEcho[2] = { 0, 0 };
+    int32_t i32Char;
+
+    while ((i32Char = consoleGetChar()) >= 0) {
+        if (i32Char == '\n' && bLastWasCR) {
+            bLastWasCR = false;
+            continue;
+        }
+        bLastWasCR = (i32Char == '\r');
+
+        if (i32Char == '\r' || i32Char == '\n' || i32Char == 0x1B) {
+            consoleEcho("\n");
+            if (i32Char == 0x1B) {
+                ui32Len = 0;
+            }
+            pcLine[ui32Len] = '\0';
+            ui32Len = 0;
+            return true;
+        }
+        if (i32Char == '\b') {
+            if (ui32Len) {
+                consoleEcho("\b \b");
+                ui32Len--;
+            }
+        }
+        else if (ui32Len < ui32Size - 1) {
+            pcEcho[0] = (char)i32Char;
+            consoleEcho(pcEcho);
+            pcLine[ui32Len++] = (char)i32Char;
+        }
+    }
+
+    return false;
+}
+
+//*****************************************************************************/
+// User output selection.  Returns one of the SINK_* identifiers, asking again
+// until the reply is one; for the file sink, a non-empty reply to the path
+// prompt replaces pcPath.
+//*****************************************************************************/
+uint32_t
+getUserSink(char *pcPath, uint32_t ui32PathLen)
+{
+    // Buffer to store user input as a string
+    char userInput[16];
 
-    // Return the number of samples entered by the user
-    return numSamples;
+    // Host path reply, kept off the small stack
+    static char pathInput[64];
+
+    // Selected output
+    uint32_t sink;
+
+    // Prompt the user for the output.  A typo must not fall through to
+    // SINK_NULL and discard the run.
+    for (;;) {
+        UARTprintf("Output [0 = none, 1 = UART text, 2 = UART binary, 3 = file, 4 = flash, 5 = spectrum]: ");
+        UARTgets(userInput, sizeof(userInput));
+        if (CmdLineArgUInt(userInput, &sink) && sink < SINK_COUNT) {
+            break;
+        }
+        UARTprintf("Invalid output.\n");
+    }
+
+    // The file sink also needs a host path
+    if (sink == SINK_FILE) {
+        UARTprintf("File path [%s]: ", pcPath);
+        if (UARTgets(pathInput, sizeof(pathInput)) > 0 && ui32PathLen > 0) {
+            strncpy(pcPath, pathInput, ui32PathLen - 1);
+            pcPath[ui32PathLen - 1] = '\0';
+        }
+    }
+
+    return sink;
 }
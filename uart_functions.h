@@ -8,7 +8,18 @@
 #ifndef UART_FUNCTIONS_H_
 #define UART_FUNCTIONS_H_
 
+// Console baud rate.  The UART runs from the 16 MHz PIOSC, so 1 Mbaud is the
+// fastest rate with the normal /16 bit clock; up to 2 Mbaud is possible, with
+// the UART switching to its /8 high-speed mode, if the USB-serial bridge on
+// the host side can keep up.
+#ifndef CONSOLE_BAUD
+#define CONSOLE_BAUD    1000000
+#endif
+
 void configureUART(void);
-uint32_t getUserInput(void);
+bool getUserInput(uint32_t *pui32Samples);
+bool userStopRequested(void);
+bool consoleGetLine(char *pcLine, uint32_t ui32Size);
+uint32_t getUserSink(char *pcPath, uint32_t ui32PathLen);
 
 #endif /* UART_FUNCTIONS_H_ */
@@ -35,7 +35,17 @@
 #include "driverlib/rom_map.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/uart.h"
-#include "utils/uartstdio.h"
+#include "driverlib/udma.h"
+#include "uartstdio.h"
+
+//*****************************************************************************
+//
+// The uDMA transmit path drains the buffered-mode transmit buffer.
+//
+//*****************************************************************************
+#if defined(UART_TX_DMA) && !defined(UART_BUFFERED)
+#error "UART_TX_DMA requires UART_BUFFERED"
+#endif
 
 //*****************************************************************************
 //
@@ -65,8 +75,39 @@ static bool g_bDisableEcho;
 
 //*****************************************************************************
 //
-// Output ring buffer.  Buffer is full if g_ui32UARTTxReadIndex is one ahead of
-// g_ui32UARTTxWriteIndex.  Buffer is empty if the two indices are the same.
+// The ring buffers are single-producer/single-consumer queues with
+// free-running indices.  The write index is only ever changed by the
+// producer and the read index only by the consumer, so neither side needs to
+// mask interrupts.  An index is reduced to a buffer offset with a mask, which
+// requires the buffer sizes to be powers of two.
+//
+//*****************************************************************************
+#if (UART_TX_BUFFER_SIZE & (UART_TX_BUFFER_SIZE - 1)) != 0
+#error "UART_TX_BUFFER_SIZE must be a power of two"
+#endif
+#if (UART_RX_BUFFER_SIZE & (UART_RX_BUFFER_SIZE - 1)) != 0
+#error "UART_RX_BUFFER_SIZE must be a power of two"
+#endif
+
+//*****************************************************************************
+//
+// Orders the buffer contents against the index update that publishes (or
+// frees) them.  The other side of each ring runs in interrupt context on the
+// same core, so a data memory barrier is sufficient.
+//
+//*****************************************************************************
+#if defined(ccs)
+#define UART_BUFFER_BARRIER()   __asm(" dmb")
+#else
+#define UART_BUFFER_BARRIER()   __sync_synchronize()
+#endif
+
+//*****************************************************************************
+//
+// Output ring buffer.  The application is the producer and the UART interrupt
+// handler is the only consumer.  Buffer is full if the write index is
+// UART_TX_BUFFER_SIZE ahead of the read index.  Buffer is empty if the two
+// indices are the same.
 //
 //*****************************************************************************
 static unsigned char g_pcUARTTxBuffer[UART_TX_BUFFER_SIZE];
@@ -75,8 +116,10 @@ static volatile uint32_t g_ui32UARTTxReadIndex = 0;
 
 //*****************************************************************************
 //
-// Input ring buffer.  Buffer is full if g_ui32UARTTxReadIndex is one ahead of
-// g_ui32UARTTxWriteIndex.  Buffer is empty if the two indices are the same.
+// Input ring buffer.  The UART interrupt handler is the producer and the
+// application is the consumer.  Buffer is full if the write index is
+// UART_RX_BUFFER_SIZE ahead of the read index.  Buffer is empty if the two
+// indices are the same.
 //
 //*****************************************************************************
 static unsigned char g_pcUARTRxBuffer[UART_RX_BUFFER_SIZE];
@@ -89,16 +132,14 @@ static volatile uint32_t g_ui32UARTRxReadIndex = 0;
 //
 //*****************************************************************************
 #define TX_BUFFER_USED          (GetBufferCount(&g_ui32UARTTxReadIndex,  \
-                                                &g_ui32UARTTxWriteIndex, \
-                                                UART_TX_BUFFER_SIZE))
+                                                &g_ui32UARTTxWriteIndex))
 #define TX_BUFFER_FREE          (UART_TX_BUFFER_SIZE - TX_BUFFER_USED)
 #define TX_BUFFER_EMPTY         (IsBufferEmpty(&g_ui32UARTTxReadIndex,   \
                                                &g_ui32UARTTxWriteIndex))
 #define TX_BUFFER_FULL          (IsBufferFull(&g_ui32UARTTxReadIndex,  \
                                               &g_ui32UARTTxWriteIndex, \
                                               UART_TX_BUFFER_SIZE))
-#define ADVANCE_TX_BUFFER_INDEX(Index) \
-                                (Index) = ((Index) + 1) % UART_TX_BUFFER_SIZE
+#define TX_BUFFER_OFFSET(Index) ((Index) & (UART_TX_BUFFER_SIZE - 1))
 
 //*****************************************************************************
 //
@@ -106,16 +147,14 @@ static volatile uint32_t g_ui32UARTRxReadIndex = 0;
 //
 //*****************************************************************************
 #define RX_BUFFER_USED          (GetBufferCount(&g_ui32UARTRxReadIndex,  \
-                                                &g_ui32UARTRxWriteIndex, \
-                                                UART_RX_BUFFER_SIZE))
+                                                &g_ui32UARTRxWriteIndex))
 #define RX_BUFFER_FREE          (UART_RX_BUFFER_SIZE - RX_BUFFER_USED)
 #define RX_BUFFER_EMPTY         (IsBufferEmpty(&g_ui32UARTRxReadIndex,   \
                                                &g_ui32UARTRxWriteIndex))
 #define RX_BUFFER_FULL          (IsBufferFull(&g_ui32UARTRxReadIndex,  \
                                               &g_ui32UARTRxWriteIndex, \
                                               UART_RX_BUFFER_SIZE))
-#define ADVANCE_RX_BUFFER_INDEX(Index) \
-                                (Index) = ((Index) + 1) % UART_RX_BUFFER_SIZE
+#define RX_BUFFER_OFFSET(Index) ((Index) & (UART_RX_BUFFER_SIZE - 1))
 #endif
 
 //*****************************************************************************
@@ -162,6 +201,30 @@ static const uint32_t g_ui32UARTInt[3] =
 static uint32_t g_ui32PortNum;
 #endif
 
+#ifdef UART_TX_DMA
+//*****************************************************************************
+//
+// The list of uDMA channel assignments for the console UART transmitter.  The
+// low byte of each assignment is the channel number.
+//
+//*****************************************************************************
+static const uint32_t g_ui32UARTTxDMA[3] =
+{
+    UDMA_CH9_UART0TX, UDMA_CH23_UART1TX, UDMA_CH13_UART2TX
+};
+
+#define TX_DMA_CHANNEL          (g_ui32UARTTxDMA[g_ui32PortNum] & 0xFF)
+
+//*****************************************************************************
+//
+// Number of bytes of the transmit buffer, starting at the read index, that
+// the uDMA is currently moving to the UART.  Zero when no transfer is in
+// flight.  Only accessed by the interrupt handler and UARTFlushTx().
+//
+//*****************************************************************************
+static uint32_t g_ui32UARTTxDMALen;
+#endif
+
 //*****************************************************************************
 //
 // The list of UART peripherals.
@@ -200,7 +263,7 @@ IsBufferFull(volatile uint32_t *pui32Read,
     ui32Write = *pui32Write;
     ui32Read = *pui32Read;
 
-    return((((ui32Write + 1) % ui32Size) == ui32Read) ? true : false);
+    return(((ui32Write - ui32Read) >= ui32Size) ? true : false);
 }
 #endif
 
@@ -241,7 +304,6 @@ IsBufferEmpty(volatile uint32_t *pui32Read,
 //!
 //! \param pui32Read points to the read index for the buffer.
 //! \param pui32Write points to the write index for the buffer.
-//! \param ui32Size is the size of the buffer in bytes.
 //!
 //! This function is used to determine how many bytes of data a given ring
 //! buffer currently contains.  The structure of the code is specifically to
@@ -254,7 +316,7 @@ IsBufferEmpty(volatile uint32_t *pui32Read,
 #ifdef UART_BUFFERED
 static uint32_t
 GetBufferCount(volatile uint32_t *pui32Read,
-               volatile uint32_t *pui32Write, uint32_t ui32Size)
+               volatile uint32_t *pui32Write)
 {
     uint32_t ui32Write;
     uint32_t ui32Read;
@@ -262,47 +324,240 @@ GetBufferCount(volatile uint32_t *pui32Read,
     ui32Write = *pui32Write;
     ui32Read = *pui32Read;
 
-    return((ui32Write >= ui32Read) ? (ui32Write - ui32Read) :
-           (ui32Size - (ui32Read - ui32Write)));
+    return(ui32Write - ui32Read);
+}
+#endif
+
+//*****************************************************************************
+//
+//! Reserves a contiguous span of free space in the transmit buffer.
+//!
+//! \param ppcSpan is set to point at the start of the span.
+//!
+//! This function is used by the producer to obtain space that it can fill
+//! directly, without per-byte index updates.  The span stops at the end of the
+//! buffer, so a write that wraps needs a second reservation.  The data only
+//! becomes visible to the transmitter once TxBufferCommit() is called.
+//!
+//! \return Returns the number of bytes available at \e *ppcSpan, which may
+//! be zero if the buffer is full.
+//
+//*****************************************************************************
+#ifdef UART_BUFFERED
+static uint32_t
+TxBufferReserve(unsigned char **ppcSpan)
+{
+    uint32_t ui32Write;
+    uint32_t ui32Free;
+
+    ui32Write = g_ui32UARTTxWriteIndex;
+    ui32Free = UART_TX_BUFFER_SIZE - (ui32Write - g_ui32UARTTxReadIndex);
+
+    //
+    // Do not write into space the transmitter may still be reading from.
+    //
+    UART_BUFFER_BARRIER();
+
+    if(ui32Free > (UART_TX_BUFFER_SIZE - TX_BUFFER_OFFSET(ui32Write)))
+    {
+        ui32Free = UART_TX_BUFFER_SIZE - TX_BUFFER_OFFSET(ui32Write);
+    }
+
+    *ppcSpan = &g_pcUARTTxBuffer[TX_BUFFER_OFFSET(ui32Write)];
+
+    return(ui32Free);
+}
+#endif
+
+//*****************************************************************************
+//
+//! Publishes bytes written to a span returned by TxBufferReserve().
+//!
+//! \param ui32Len is the number of bytes written, starting at the span.
+//!
+//! \return None.
+//
+//*****************************************************************************
+#ifdef UART_BUFFERED
+static void
+TxBufferCommit(uint32_t ui32Len)
+{
+    //
+    // Make sure the data is visible before the transmitter can see the new
+    // write index.
+    //
+    UART_BUFFER_BARRIER();
+    g_ui32UARTTxWriteIndex += ui32Len;
+}
+#endif
+
+//*****************************************************************************
+//
+// Ask the UART interrupt handler, the only consumer of the transmit buffer,
+// to move newly committed data into the transmit FIFO.  Pending the interrupt
+// in the NVIC rather than priming the FIFO here keeps a single consumer, so
+// the interrupt never has to be disabled.
+//
+//*****************************************************************************
+#ifdef UART_BUFFERED
+static void
+UARTKickTransmit(void)
+{
+    MAP_IntPendSet(g_ui32UARTInt[g_ui32PortNum]);
+}
+#endif
+
+//*****************************************************************************
+//
+// Write characters straight into the transmit FIFO.  Used by the interrupt
+// handler to echo input, since it must not produce into the transmit buffer
+// the application is writing.  Characters are dropped if the FIFO is full.
+//
+//*****************************************************************************
+#ifdef UART_BUFFERED
+static void
+UARTEcho(const char *pcBuf, uint32_t ui32Len)
+{
+    while(ui32Len--)
+    {
+        MAP_UARTCharPutNonBlocking(g_ui32Base, *pcBuf++);
+    }
 }
 #endif
 
 //*****************************************************************************
 //
 // Take as many bytes from the transmit buffer as we have space for and move
-// them into the UART transmit FIFO.
+// them into the UART transmit FIFO.  Only called from the UART interrupt
+// handler, which is the sole consumer of the transmit buffer.
 //
 //*****************************************************************************
 #ifdef UART_BUFFERED
 static void
 UARTPrimeTransmit(uint32_t ui32Base)
 {
+    uint32_t ui32Read;
+    uint32_t ui32Write;
+
+    //
+    // Take a snapshot of the indices and make sure the data they cover is
+    // visible before reading it.
+    //
+    ui32Read = g_ui32UARTTxReadIndex;
+    ui32Write = g_ui32UARTTxWriteIndex;
+    UART_BUFFER_BARRIER();
+
     //
-    // Do we have any data to transmit?
+    // Take some characters out of the transmit buffer and feed them to the
+    // UART transmit FIFO.
     //
-    if(!TX_BUFFER_EMPTY)
+    while((ui32Read != ui32Write) && MAP_UARTSpaceAvail(ui32Base))
     {
-        //
-        // Disable the UART interrupt.  If we don't do this there is a race
-        // condition which can cause the read index to be corrupted.
-        //
-        MAP_IntDisable(g_ui32UARTInt[g_ui32PortNum]);
+        MAP_UARTCharPutNonBlocking(ui32Base,
+                                  g_pcUARTTxBuffer[TX_BUFFER_OFFSET(ui32Read)]);
+        ui32Read++;
+    }
+
+    //
+    // Finish reading before the producer may reuse the space.
+    //
+    UART_BUFFER_BARRIER();
+    g_ui32UARTTxReadIndex = ui32Read;
+}
+#endif
+
+//*****************************************************************************
+//
+// Keep the transmitter fed from the transmit buffer.  Only called from the
+// UART interrupt handler.
+//
+// In DMA mode, a completed transfer is retired first, then the next
+// contiguous span of the buffer is handed to the uDMA if it is at least
+// UART_DMA_MIN_SPAN bytes long.  The transfer runs without further CPU
+// involvement and its completion raises the UART interrupt again.  Shorter
+// spans are copied into the FIFO by UARTPrimeTransmit(), where setting up a
+// transfer would cost more than it saves.
+//
+//*****************************************************************************
+#ifdef UART_BUFFERED
+static void
+UARTServiceTransmit(void)
+{
+#ifdef UART_TX_DMA
+    uint32_t ui32Read;
+    uint32_t ui32Span;
 
+    if(g_ui32UARTTxDMALen)
+    {
         //
-        // Yes - take some characters out of the transmit buffer and feed
-        // them to the UART transmit FIFO.
+        // Leave the buffer alone until the transfer in flight is done.
         //
-        while(MAP_UARTSpaceAvail(ui32Base) && !TX_BUFFER_EMPTY)
+        if(MAP_uDMAChannelModeGet(TX_DMA_CHANNEL | UDMA_PRI_SELECT) !=
+           UDMA_MODE_STOP)
         {
-            MAP_UARTCharPutNonBlocking(ui32Base,
-                                      g_pcUARTTxBuffer[g_ui32UARTTxReadIndex]);
-            ADVANCE_TX_BUFFER_INDEX(g_ui32UARTTxReadIndex);
+            return;
         }
 
         //
-        // Reenable the UART interrupt.
+        // Release the transferred bytes to the producer.
+        //
+        UART_BUFFER_BARRIER();
+        g_ui32UARTTxReadIndex += g_ui32UARTTxDMALen;
+        g_ui32UARTTxDMALen = 0;
+    }
+
+    //
+    // Find the contiguous run of data starting at the read index.
+    //
+    ui32Read = g_ui32UARTTxReadIndex;
+    ui32Span = g_ui32UARTTxWriteIndex - ui32Read;
+    UART_BUFFER_BARRIER();
+
+    if(ui32Span > (UART_TX_BUFFER_SIZE - TX_BUFFER_OFFSET(ui32Read)))
+    {
+        ui32Span = UART_TX_BUFFER_SIZE - TX_BUFFER_OFFSET(ui32Read);
+    }
+    if(ui32Span > 1024)
+    {
+        ui32Span = 1024;
+    }
+
+    if(ui32Span >= UART_DMA_MIN_SPAN)
+    {
+        //
+        // The uDMA completion interrupt replaces the FIFO interrupt while
+        // the transfer runs.
         //
-        MAP_IntEnable(g_ui32UARTInt[g_ui32PortNum]);
+        MAP_UARTIntDisable(g_ui32Base, UART_INT_TX);
+
+        g_ui32UARTTxDMALen = ui32Span;
+        MAP_uDMAChannelTransferSet(TX_DMA_CHANNEL | UDMA_PRI_SELECT,
+                                   UDMA_MODE_BASIC,
+                                   &g_pcUARTTxBuffer[TX_BUFFER_OFFSET(ui32Read)],
+                                   (void *)(g_ui32Base + UART_O_DR),
+                                   ui32Span);
+        MAP_uDMAChannelEnable(TX_DMA_CHANNEL);
+        return;
+    }
+#endif
+
+    //
+    // Move as many bytes as we can into the transmit FIFO.
+    //
+    UARTPrimeTransmit(g_ui32Base);
+
+    //
+    // Keep the transmit interrupt enabled only while there is data left to
+    // send.  Data committed after this check pends the interrupt again, so
+    // it cannot be stranded.
+    //
+    if(TX_BUFFER_EMPTY)
+    {
+        MAP_UARTIntDisable(g_ui32Base, UART_INT_TX);
+    }
+    else
+    {
+        MAP_UARTIntEnable(g_ui32Base, UART_INT_TX);
     }
 }
 #endif
@@ -372,11 +627,41 @@ UARTStdioConfig(uint32_t ui32PortNum, uint32_t ui32Baud, uint32_t ui32SrcClock)
                              UART_CONFIG_WLEN_8));
 
 #ifdef UART_BUFFERED
+    //
+    // Remember which interrupt we are dealing with.
+    //
+    g_ui32PortNum = ui32PortNum;
+
+#ifdef UART_TX_DMA
+    //
+    // Set the UART to request a burst of 4 bytes whenever the TX FIFO is half
+    // empty, and to interrupt when any character is received.
+    //
+    MAP_UARTFIFOLevelSet(g_ui32Base, UART_FIFO_TX4_8, UART_FIFO_RX1_8);
+
+    //
+    // Route the transmitter's requests to its uDMA channel.  The uDMA
+    // controller itself, including the channel control table, must already
+    // have been enabled by the application.  Transfers move bytes from the
+    // transmit buffer into the fixed data register.
+    //
+    MAP_uDMAChannelAssign(g_ui32UARTTxDMA[ui32PortNum]);
+    MAP_uDMAChannelAttributeDisable(TX_DMA_CHANNEL,
+                                    UDMA_ATTR_ALTSELECT |
+                                    UDMA_ATTR_HIGH_PRIORITY |
+                                    UDMA_ATTR_REQMASK);
+    MAP_uDMAChannelAttributeEnable(TX_DMA_CHANNEL, UDMA_ATTR_USEBURST);
+    MAP_uDMAChannelControlSet(TX_DMA_CHANNEL | UDMA_PRI_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_8 |
+                              UDMA_DST_INC_NONE | UDMA_ARB_4);
+    MAP_UARTDMAEnable(g_ui32Base, UART_DMA_TX);
+#else
     //
     // Set the UART to interrupt whenever the TX FIFO is almost empty or
     // when any character is received.
     //
     MAP_UARTFIFOLevelSet(g_ui32Base, UART_FIFO_TX1_8, UART_FIFO_RX1_8);
+#endif
 
     //
     // Flush both the buffers.
@@ -384,11 +669,6 @@ UARTStdioConfig(uint32_t ui32PortNum, uint32_t ui32Baud, uint32_t ui32SrcClock)
     UARTFlushRx();
     UARTFlushTx(true);
 
-    //
-    // Remember which interrupt we are dealing with.
-    //
-    g_ui32PortNum = ui32PortNum;
-
     //
     // We are configured for buffered output so enable the master interrupt
     // for this UART and the receive interrupts.  We don't actually enable the
@@ -437,6 +717,10 @@ UARTwrite(const char *pcBuf, uint32_t ui32Len)
 {
 #ifdef UART_BUFFERED
     unsigned int uIdx;
+    unsigned char *pcSpan;
+    uint32_t ui32Span;
+    uint32_t ui32Used;
+    bool bCRSent;
 
     //
     // Check for valid arguments.
@@ -445,55 +729,53 @@ UARTwrite(const char *pcBuf, uint32_t ui32Len)
     ASSERT(g_ui32Base != 0);
 
     //
-    // Send the characters
+    // Copy the characters into contiguous spans of the transmit buffer,
+    // publishing each span with a single index update.
     //
-    for(uIdx = 0; uIdx < ui32Len; uIdx++)
+    uIdx = 0;
+    bCRSent = false;
+    while(uIdx < ui32Len)
     {
-        //
-        // If the character to the UART is \n, then add a \r before it so that
-        // \n is translated to \n\r in the output.
-        //
-        if(pcBuf[uIdx] == '\n')
+        ui32Span = TxBufferReserve(&pcSpan);
+        if(ui32Span == 0)
         {
-            if(!TX_BUFFER_FULL)
-            {
-                g_pcUARTTxBuffer[g_ui32UARTTxWriteIndex] = '\r';
-                ADVANCE_TX_BUFFER_INDEX(g_ui32UARTTxWriteIndex);
-            }
-            else
-            {
-                //
-                // Buffer is full - discard remaining characters and return.
-                //
-                break;
-            }
+            //
+            // Buffer is full - discard remaining characters and return.
+            //
+            break;
         }
 
-        //
-        // Send the character to the UART output.
-        //
-        if(!TX_BUFFER_FULL)
-        {
-            g_pcUARTTxBuffer[g_ui32UARTTxWriteIndex] = pcBuf[uIdx];
-            ADVANCE_TX_BUFFER_INDEX(g_ui32UARTTxWriteIndex);
-        }
-        else
+        for(ui32Used = 0; (ui32Used < ui32Span) && (uIdx < ui32Len); )
         {
             //
-            // Buffer is full - discard remaining characters and return.
+            // If the character to the UART is \n, then add a \r before it so
+            // that \n is translated to \n\r in the output.  The pair may be
+            // split across two spans.
             //
-            break;
+            if((pcBuf[uIdx] == '\n') && !bCRSent)
+            {
+                pcSpan[ui32Used++] = '\r';
+                bCRSent = true;
+                continue;
+            }
+
+            //
+            // Send the character to the UART output.
+            //
+            pcSpan[ui32Used++] = pcBuf[uIdx++];
+            bCRSent = false;
         }
+
+        TxBufferCommit(ui32Used);
     }
 
     //
     // If we have anything in the buffer, make sure that the UART is set
     // up to transmit it.
     //
-    if(!TX_BUFFER_EMPTY)
+    if(uIdx || bCRSent)
     {
-        UARTPrimeTransmit(g_ui32Base);
-        MAP_UARTIntEnable(g_ui32Base, UART_INT_TX);
+        UARTKickTransmit();
     }
 
     //
@@ -536,6 +818,86 @@ UARTwrite(const char *pcBuf, uint32_t ui32Len)
 #endif
 }
 
+//*****************************************************************************
+//
+//! Writes a block of binary data to the UART output.
+//!
+//! \param pui8Buf points to the data to transmit.
+//! \param ui32Len is the number of bytes to transmit.
+//!
+//! Unlike UARTwrite(), this function performs no LF to CRLF translation and
+//! does not stop at null bytes, so it is suitable for framed binary data.
+//!
+//! In buffered mode, this function waits for space in the transmit buffer
+//! rather than discarding data, so a frame is never truncated.
+//!
+//! \return Returns the count of bytes written.
+//
+//*****************************************************************************
+int
+UARTwriteBinary(const uint8_t *pui8Buf, uint32_t ui32Len)
+{
+    unsigned int uIdx;
+#ifdef UART_BUFFERED
+    unsigned char *pcSpan;
+    uint32_t ui32Span;
+    uint32_t ui32Used;
+#endif
+
+    //
+    // Check for valid UART base address, and valid arguments.
+    //
+    ASSERT(g_ui32Base != 0);
+    ASSERT(pui8Buf != 0);
+
+#ifdef UART_BUFFERED
+    uIdx = 0;
+    while(uIdx < ui32Len)
+    {
+        //
+        // If the buffer is full, make sure the transmitter is draining it
+        // and wait for a free span.
+        //
+        ui32Span = TxBufferReserve(&pcSpan);
+        if(ui32Span == 0)
+        {
+            UARTKickTransmit();
+            continue;
+        }
+
+        if(ui32Span > (ui32Len - uIdx))
+        {
+            ui32Span = ui32Len - uIdx;
+        }
+
+        for(ui32Used = 0; ui32Used < ui32Span; ui32Used++)
+        {
+            pcSpan[ui32Used] = pui8Buf[uIdx++];
+        }
+
+        TxBufferCommit(ui32Span);
+    }
+
+    //
+    // Make sure that the UART is set up to transmit the new data.
+    //
+    UARTKickTransmit();
+#else
+    //
+    // Send the bytes, blocking while the FIFO is full.
+    //
+    for(uIdx = 0; uIdx < ui32Len; uIdx++)
+    {
+        MAP_UARTCharPut(g_ui32Base, pui8Buf[uIdx]);
+    }
+#endif
+
+    //
+    // Return the number of bytes written.
+    //
+    return(uIdx);
+}
+
 //*****************************************************************************
 //
 //! A simple UART based get string function, with some line processing.
@@ -571,6 +933,7 @@ UARTgets(char *pcBuf, uint32_t ui32Len)
 #ifdef UART_BUFFERED
     uint32_t ui32Count = 0;
     int8_t cChar;
+    static int8_t bLastWasCR = 0;
 
     //
     // Check the arguments.
@@ -595,19 +958,67 @@ UARTgets(char *pcBuf, uint32_t ui32Len)
         //
         if(!RX_BUFFER_EMPTY)
         {
-            cChar = g_pcUARTRxBuffer[g_ui32UARTRxReadIndex];
-            ADVANCE_RX_BUFFER_INDEX(g_ui32UARTRxReadIndex);
+            UART_BUFFER_BARRIER();
+            cChar = g_pcUARTRxBuffer[RX_BUFFER_OFFSET(g_ui32UARTRxReadIndex)];
+            UART_BUFFER_BARRIER();
+            g_ui32UARTRxReadIndex++;
 
             //
-            // See if a newline or escape character was received.
+            // See if the backspace key was pressed.  The interrupt handler
+            // has already rubbed out the character on the terminal.
             //
-            if((cChar == '\r') || (cChar == '\n') || (cChar == 0x1b))
+            if(cChar == '\b')
             {
                 //
-                // Stop processing the input and end the line.
+                // If there are any characters already in the buffer, then
+                // delete the last.
                 //
-                break;
-            }
+                if(ui32Count)
+                {
+                    ui32Count--;
+                }
+
+                //
+                // Skip ahead to read the next character.
+                //
+                continue;
+            }
+
+            //
+            // If this character is LF and last was CR, then just gobble up
+            // the character because the CR already ended the line.
+            //
+            if((cChar == '\n') && bLastWasCR)
+            {
+                bLastWasCR = 0;
+                continue;
+            }
+
+            //
+            // See if a newline or escape character was received.
+            //
+            if((cChar == '\r') || (cChar == '\n') || (cChar == 0x1b))
+            {
+                //
+                // If the character is a CR, then it may be followed by an LF
+                // which should be paired with the CR.  So remember that a CR
+                // was received.
+                //
+                if(cChar == '\r')
+                {
+                    bLastWasCR = 1;
+                }
+
+                //
+                // Stop processing the input and end the line.
+                //
+                break;
+            }
+
+            //
+            // Clear the flag since this isn't a CR.
+            //
+            bLastWasCR = 0;
 
             //
             // Process the received character as long as we are not at the end
@@ -802,8 +1213,10 @@ UARTgetc(void)
     //
     // Read a character from the buffer.
     //
-    cChar = g_pcUARTRxBuffer[g_ui32UARTRxReadIndex];
-    ADVANCE_RX_BUFFER_INDEX(g_ui32UARTRxReadIndex);
+    UART_BUFFER_BARRIER();
+    cChar = g_pcUARTRxBuffer[RX_BUFFER_OFFSET(g_ui32UARTRxReadIndex)];
+    UART_BUFFER_BARRIER();
+    g_ui32UARTRxReadIndex++;
 
     //
     // Return the character to the caller.
@@ -818,6 +1231,293 @@ UARTgetc(void)
 #endif
 }
 
+//*****************************************************************************
+//
+// Formatted output is rendered into this buffer and passed to UARTwrite()
+// once per call, rather than once per literal run and once per field.  Only
+// output longer than the buffer needs more than one write.  The buffer is
+// static to keep it off the small stack, so, like the buffered transmit
+// path, the printf functions must only be called from one context.
+//
+//*****************************************************************************
+static char g_pcPrintBuf[UART_PRINTF_BUFFER_SIZE];
+static uint32_t g_ui32PrintPos;
+
+//*****************************************************************************
+//
+// Decimal digit pairs "00" to "99", used to convert two digits per step.
+//
+//*****************************************************************************
+static const char g_pcDecPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+//*****************************************************************************
+//
+// Send whatever has been rendered so far.
+//
+//*****************************************************************************
+static void
+PrintFlush(void)
+{
+    if(g_ui32PrintPos)
+    {
+        UARTwrite(g_pcPrintBuf, g_ui32PrintPos);
+        g_ui32PrintPos = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Append characters to the print buffer, sending it whenever it fills.
+//
+//*****************************************************************************
+static void
+PrintPut(const char *pcBuf, uint32_t ui32Len)
+{
+    while(ui32Len--)
+    {
+        g_pcPrintBuf[g_ui32PrintPos++] = *pcBuf++;
+        if(g_ui32PrintPos == UART_PRINTF_BUFFER_SIZE)
+        {
+            PrintFlush();
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Append ui32Count copies of a fill character to the print buffer.
+//
+//*****************************************************************************
+static void
+PrintFill(char cFill, uint32_t ui32Count)
+{
+    while(ui32Count--)
+    {
+        PrintPut(&cFill, 1);
+    }
+}
+
+//*****************************************************************************
+//
+// Append an unsigned value in base 10 or 16, padded to ui32Count characters
+// (including the minus sign if bNeg is set) with cFill.
+//
+// Decimal values are converted two digits at a time from g_pcDecPairs.  The
+// only division is by the constant 100, which the compiler turns into a
+// multiply, so no hardware divide is issued per digit.  Hexadecimal values
+// are converted with shifts and masks.
+//
+//*****************************************************************************
+static void
+PrintNumber(uint32_t ui32Value, uint32_t ui32Base, bool bNeg,
+            uint32_t ui32Count, char cFill)
+{
+    char pcDigits[10];
+    char *pcDigit;
+    uint32_t ui32Quot;
+    uint32_t ui32Len;
+
+    //
+    // Render the digits backwards from the end of the buffer.
+    //
+    pcDigit = pcDigits + sizeof(pcDigits);
+    if(ui32Base == 16)
+    {
+        do
+        {
+            *--pcDigit = g_pcHex[ui32Value & 15];
+            ui32Value >>= 4;
+        }
+        while(ui32Value);
+    }
+    else
+    {
+        while(ui32Value >= 100)
+        {
+            ui32Quot = ui32Value / 100;
+            ui32Value = (ui32Value - (ui32Quot * 100)) * 2;
+            pcDigit -= 2;
+            pcDigit[0] = g_pcDecPairs[ui32Value];
+            pcDigit[1] = g_pcDecPairs[ui32Value + 1];
+            ui32Value = ui32Quot;
+        }
+        if(ui32Value >= 10)
+        {
+            pcDigit -= 2;
+            pcDigit[0] = g_pcDecPairs[ui32Value * 2];
+            pcDigit[1] = g_pcDecPairs[(ui32Value * 2) + 1];
+        }
+        else
+        {
+            *--pcDigit = '0' + ui32Value;
+        }
+    }
+    ui32Len = (pcDigits + sizeof(pcDigits)) - pcDigit;
+
+    //
+    // Work out how much padding is needed, allowing for the minus sign.
+    //
+    ui32Len += bNeg ? 1 : 0;
+    ui32Count = (ui32Count > ui32Len) ? (ui32Count - ui32Len) : 0;
+
+    //
+    // If the value is negative and padded with zeros, then place the minus
+    // sign before the padding, otherwise after it.
+    //
+    if(bNeg && (cFill == '0'))
+    {
+        PrintPut("-", 1);
+        bNeg = false;
+    }
+    PrintFill(cFill, ui32Count);
+    if(bNeg)
+    {
+        PrintPut("-", 1);
+    }
+
+    PrintPut(pcDigit, (pcDigits + sizeof(pcDigits)) - pcDigit);
+}
+
+//*****************************************************************************
+//
+// Append one conversion.  ui32Value holds the argument for the numeric and
+// character conversions and pcStr the argument for \%s.
+//
+//*****************************************************************************
+static void
+PrintConversion(char cConversion, uint32_t ui32Count, char cFill,
+                uint32_t ui32Value, const char *pcStr)
+{
+    uint32_t ui32Idx;
+    char cChar;
+
+    switch(cConversion)
+    {
+        //
+        // Handle the %c command.
+        //
+        case 'c':
+        {
+            cChar = (char)ui32Value;
+            PrintPut(&cChar, 1);
+            break;
+        }
+
+        //
+        // Handle the %d and %i commands.
+        //
+        case 'd':
+        case 'i':
+        {
+            if((int32_t)ui32Value < 0)
+            {
+                PrintNumber(0 - ui32Value, 10, true, ui32Count, cFill);
+            }
+            else
+            {
+                PrintNumber(ui32Value, 10, false, ui32Count, cFill);
+            }
+            break;
+        }
+
+        //
+        // Handle the %u command.
+        //
+        case 'u':
+        {
+            PrintNumber(ui32Value, 10, false, ui32Count, cFill);
+            break;
+        }
+
+        //
+        // Handle the %x and %X commands.  Note that they are treated
+        // identically; in other words, %X will use lower case letters for a-f
+        // instead of the upper case letters it should use.  We also alias %p
+        // to %x.
+        //
+        case 'x':
+        case 'X':
+        case 'p':
+        {
+            PrintNumber(ui32Value, 16, false, ui32Count, cFill);
+            break;
+        }
+
+        //
+        // Handle the %s command, padding with spaces after the string.
+        //
+        case 's':
+        {
+            for(ui32Idx = 0; pcStr[ui32Idx] != '\0'; ui32Idx++)
+            {
+            }
+            PrintPut(pcStr, ui32Idx);
+            if(ui32Count > ui32Idx)
+            {
+                PrintFill(' ', ui32Count - ui32Idx);
+            }
+            break;
+        }
+
+        //
+        // Handle the %% command.
+        //
+        case '%':
+        {
+            PrintPut("%", 1);
+            break;
+        }
+
+        //
+        // Handle all other commands.
+        //
+        default:
+        {
+            PrintPut("ERROR", 5);
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Parse the width and fill of a conversion specification starting just after
+// the %.  Returns a pointer to the conversion character.
+//
+//*****************************************************************************
+static const char *
+ParseSpec(const char *pcString, uint32_t *pui32Count, char *pcFill)
+{
+    *pui32Count = 0;
+    *pcFill = ' ';
+
+    while((*pcString >= '0') && (*pcString <= '9'))
+    {
+        //
+        // If this is a zero, and it is the first digit, then the fill
+        // character is a zero instead of a space.
+        //
+        if((*pcString == '0') && (*pui32Count == 0))
+        {
+            *pcFill = '0';
+        }
+
+        *pui32Count = (*pui32Count * 10) + (*pcString++ - '0');
+    }
+
+    return(pcString);
+}
+
 //*****************************************************************************
 //
 //! A simple UART based vprintf function supporting \%c, \%d, \%p, \%s, \%u,
@@ -853,14 +1553,20 @@ UARTgetc(void)
 //! requirements of the format string.  For example, if an integer was passed
 //! where a string was expected, an error of some kind will most likely occur.
 //!
+//! The output is assembled in a buffer of \b UART_PRINTF_BUFFER_SIZE bytes
+//! and written with a single call to UARTwrite() if it fits.  For a format
+//! string that is printed many times, UARTFormatCompile() and
+//! UARTFormatPrintf() also skip the parsing step.
+//!
 //! \return None.
 //
 //*****************************************************************************
 void
 UARTvprintf(const char *pcString, va_list vaArgP)
 {
-    uint32_t ui32Idx, ui32Value, ui32Pos, ui32Count, ui32Base, ui32Neg;
-    char *pcStr, pcBuf[16], cFill;
+    uint32_t ui32Idx, ui32Value, ui32Count;
+    const char *pcStr;
+    char cFill, cConversion;
 
     //
     // Check the arguments.
@@ -882,13 +1588,9 @@ UARTvprintf(const char *pcString, va_list vaArgP)
         }
 
         //
-        // Write this portion of the string.
-        //
-        UARTwrite(pcString, ui32Idx);
-
-        //
-        // Skip the portion of the string that was written.
+        // Copy this portion of the string and skip it.
         //
+        PrintPut(pcString, ui32Idx);
         pcString += ui32Idx;
 
         //
@@ -897,359 +1599,189 @@ UARTvprintf(const char *pcString, va_list vaArgP)
         if(*pcString == '%')
         {
             //
-            // Skip the %.
+            // Read the width and fill, then the conversion character.  A %
+            // at the very end of the string is reported as an error.
             //
-            pcString++;
+            pcString = ParseSpec(pcString + 1, &ui32Count, &cFill);
+            cConversion = *pcString;
+            if(cConversion != '\0')
+            {
+                pcString++;
+            }
 
             //
-            // Set the digit count to zero, and the fill character to space
-            // (in other words, to the defaults).
+            // Fetch the argument the conversion needs from the varargs.
             //
-            ui32Count = 0;
-            cFill = ' ';
+            ui32Value = 0;
+            pcStr = 0;
+            if(cConversion == 's')
+            {
+                pcStr = va_arg(vaArgP, const char *);
+            }
+            else if((cConversion != '%') && (cConversion != '\0'))
+            {
+                ui32Value = va_arg(vaArgP, uint32_t);
+            }
 
-            //
-            // It may be necessary to get back here to process more characters.
-            // Goto's aren't pretty, but effective.  I feel extremely dirty for
-            // using not one but two of the beasts.
-            //
-again:
+            PrintConversion(cConversion, ui32Count, cFill, ui32Value, pcStr);
+        }
+    }
 
-            //
-            // Determine how to handle the next character.
-            //
-            switch(*pcString++)
-            {
-                //
-                // Handle the digit characters.
-                //
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                {
-                    //
-                    // If this is a zero, and it is the first digit, then the
-                    // fill character is a zero instead of a space.
-                    //
-                    if((pcString[-1] == '0') && (ui32Count == 0))
-                    {
-                        cFill = '0';
-                    }
-
-                    //
-                    // Update the digit count.
-                    //
-                    ui32Count *= 10;
-                    ui32Count += pcString[-1] - '0';
-
-                    //
-                    // Get the next character.
-                    //
-                    goto again;
-                }
+    //
+    // Send the whole line.
+    //
+    PrintFlush();
+}
 
-                //
-                // Handle the %c command.
-                //
-                case 'c':
-                {
-                    //
-                    // Get the value from the varargs.
-                    //
-                    ui32Value = va_arg(vaArgP, uint32_t);
-
-                    //
-                    // Print out the character.
-                    //
-                    UARTwrite((char *)&ui32Value, 1);
-
-                    //
-                    // This command has been handled.
-                    //
-                    break;
-                }
+//*****************************************************************************
+//
+//! Prepares a format string for repeated use with UARTFormatPrintf().
+//!
+//! \param psFormat points to the structure that receives the parsed format.
+//! \param pcString is the format string, using the same conversions as
+//! UARTprintf().  It must remain valid for as long as \e psFormat is used.
+//!
+//! This function splits the format string into literal runs and conversions
+//! once, so that printing it does not need to scan the string again.  It is
+//! intended for log lines that are printed at a high rate with a fixed
+//! format.
+//!
+//! \return Returns \b true on success, or \b false if the string contains an
+//! unsupported conversion or more than \b UART_FORMAT_MAX_FIELDS conversions.
+//
+//*****************************************************************************
+bool
+UARTFormatCompile(tUARTFormat *psFormat, const char *pcString)
+{
+    const char *pcStart;
+    const char *pcSpec;
+    tUARTField *psField;
+    uint32_t ui32Count;
+    char cFill;
 
-                //
-                // Handle the %d and %i commands.
-                //
-                case 'd':
-                case 'i':
-                {
-                    //
-                    // Get the value from the varargs.
-                    //
-                    ui32Value = va_arg(vaArgP, uint32_t);
-
-                    //
-                    // Reset the buffer position.
-                    //
-                    ui32Pos = 0;
-
-                    //
-                    // If the value is negative, make it positive and indicate
-                    // that a minus sign is needed.
-                    //
-                    if((int32_t)ui32Value < 0)
-                    {
-                        //
-                        // Make the value positive.
-                        //
-                        ui32Value = -(int32_t)ui32Value;
-
-                        //
-                        // Indicate that the value is negative.
-                        //
-                        ui32Neg = 1;
-                    }
-                    else
-                    {
-                        //
-                        // Indicate that the value is positive so that a minus
-                        // sign isn't inserted.
-                        //
-                        ui32Neg = 0;
-                    }
-
-                    //
-                    // Set the base to 10.
-                    //
-                    ui32Base = 10;
-
-                    //
-                    // Convert the value to ASCII.
-                    //
-                    goto convert;
-                }
+    ASSERT(psFormat != 0);
+    ASSERT(pcString != 0);
 
-                //
-                // Handle the %s command.
-                //
-                case 's':
-                {
-                    //
-                    // Get the string pointer from the varargs.
-                    //
-                    pcStr = va_arg(vaArgP, char *);
-
-                    //
-                    // Determine the length of the string.
-                    //
-                    for(ui32Idx = 0; pcStr[ui32Idx] != '\0'; ui32Idx++)
-                    {
-                    }
-
-                    //
-                    // Write the string.
-                    //
-                    UARTwrite(pcStr, ui32Idx);
-
-                    //
-                    // Write any required padding spaces
-                    //
-                    if(ui32Count > ui32Idx)
-                    {
-                        ui32Count -= ui32Idx;
-                        while(ui32Count--)
-                        {
-                            UARTwrite(" ", 1);
-                        }
-                    }
-
-                    //
-                    // This command has been handled.
-                    //
-                    break;
-                }
+    psFormat->pcFormat = pcString;
+    psFormat->ui32NumFields = 0;
 
-                //
-                // Handle the %u command.
-                //
-                case 'u':
-                {
-                    //
-                    // Get the value from the varargs.
-                    //
-                    ui32Value = va_arg(vaArgP, uint32_t);
-
-                    //
-                    // Reset the buffer position.
-                    //
-                    ui32Pos = 0;
-
-                    //
-                    // Set the base to 10.
-                    //
-                    ui32Base = 10;
-
-                    //
-                    // Indicate that the value is positive so that a minus sign
-                    // isn't inserted.
-                    //
-                    ui32Neg = 0;
-
-                    //
-                    // Convert the value to ASCII.
-                    //
-                    goto convert;
-                }
+    pcStart = pcString;
+    while(1)
+    {
+        psField = &psFormat->psFields[psFormat->ui32NumFields];
 
-                //
-                // Handle the %x and %X commands.  Note that they are treated
-                // identically; in other words, %X will use lower case letters
-                // for a-f instead of the upper case letters it should use.  We
-                // also alias %p to %x.
-                //
-                case 'x':
-                case 'X':
-                case 'p':
-                {
-                    //
-                    // Get the value from the varargs.
-                    //
-                    ui32Value = va_arg(vaArgP, uint32_t);
-
-                    //
-                    // Reset the buffer position.
-                    //
-                    ui32Pos = 0;
-
-                    //
-                    // Set the base to 16.
-                    //
-                    ui32Base = 16;
-
-                    //
-                    // Indicate that the value is positive so that a minus sign
-                    // isn't inserted.
-                    //
-                    ui32Neg = 0;
-
-                    //
-                    // Determine the number of digits in the string version of
-                    // the value.
-                    //
-convert:
-                    for(ui32Idx = 1;
-                        (((ui32Idx * ui32Base) <= ui32Value) &&
-                         (((ui32Idx * ui32Base) / ui32Base) == ui32Idx));
-                        ui32Idx *= ui32Base, ui32Count--)
-                    {
-                    }
-
-                    //
-                    // If the value is negative, reduce the count of padding
-                    // characters needed.
-                    //
-                    if(ui32Neg)
-                    {
-                        ui32Count--;
-                    }
-
-                    //
-                    // If the value is negative and the value is padded with
-                    // zeros, then place the minus sign before the padding.
-                    //
-                    if(ui32Neg && (cFill == '0'))
-                    {
-                        //
-                        // Place the minus sign in the output buffer.
-                        //
-                        pcBuf[ui32Pos++] = '-';
-
-                        //
-                        // The minus sign has been placed, so turn off the
-                        // negative flag.
-                        //
-                        ui32Neg = 0;
-                    }
-
-                    //
-                    // Provide additional padding at the beginning of the
-                    // string conversion if needed.
-                    //
-                    if((ui32Count > 1) && (ui32Count < 16))
-                    {
-                        for(ui32Count--; ui32Count; ui32Count--)
-                        {
-                            pcBuf[ui32Pos++] = cFill;
-                        }
-                    }
-
-                    //
-                    // If the value is negative, then place the minus sign
-                    // before the number.
-                    //
-                    if(ui32Neg)
-                    {
-                        //
-                        // Place the minus sign in the output buffer.
-                        //
-                        pcBuf[ui32Pos++] = '-';
-                    }
-
-                    //
-                    // Convert the value into a string.
-                    //
-                    for(; ui32Idx; ui32Idx /= ui32Base)
-                    {
-                        pcBuf[ui32Pos++] =
-                            g_pcHex[(ui32Value / ui32Idx) % ui32Base];
-                    }
-
-                    //
-                    // Write the string.
-                    //
-                    UARTwrite(pcBuf, ui32Pos);
-
-                    //
-                    // This command has been handled.
-                    //
-                    break;
-                }
+        //
+        // Record the literal run up to the next conversion or the end.
+        //
+        for(pcSpec = pcString; (*pcSpec != '%') && (*pcSpec != '\0'); pcSpec++)
+        {
+        }
+        psField->ui16Literal = (uint16_t)(pcString - pcStart);
+        psField->ui16LiteralLen = (uint16_t)(pcSpec - pcString);
+        psField->cConversion = 0;
+        psField->cFill = ' ';
+        psField->ui8Width = 0;
+        psFormat->ui32NumFields++;
+
+        if(*pcSpec == '\0')
+        {
+            return(true);
+        }
 
-                //
-                // Handle the %% command.
-                //
-                case '%':
-                {
-                    //
-                    // Simply write a single %.
-                    //
-                    UARTwrite(pcString - 1, 1);
-
-                    //
-                    // This command has been handled.
-                    //
-                    break;
-                }
+        //
+        // Parse and check the conversion that ends the run.
+        //
+        pcString = ParseSpec(pcSpec + 1, &ui32Count, &cFill);
+        switch(*pcString)
+        {
+            case 'c':
+            case 'd':
+            case 'i':
+            case 's':
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'p':
+            case '%':
+            {
+                break;
+            }
 
-                //
-                // Handle all other commands.
-                //
-                default:
-                {
-                    //
-                    // Indicate an error.
-                    //
-                    UARTwrite("ERROR", 5);
-
-                    //
-                    // This command has been handled.
-                    //
-                    break;
-                }
+            default:
+            {
+                return(false);
             }
         }
+
+        if((ui32Count > 255) ||
+           (psFormat->ui32NumFields > UART_FORMAT_MAX_FIELDS))
+        {
+            return(false);
+        }
+
+        psField->cConversion = *pcString++;
+        psField->cFill = cFill;
+        psField->ui8Width = (uint8_t)ui32Count;
     }
 }
 
+//*****************************************************************************
+//
+//! Prints a format prepared by UARTFormatCompile().
+//!
+//! \param psFormat points to the compiled format.
+//! \param ... are the arguments required by the format string.
+//!
+//! The output is identical to passing the original format string to
+//! UARTprintf().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+UARTFormatPrintf(const tUARTFormat *psFormat, ...)
+{
+    const tUARTField *psField;
+    uint32_t ui32Field, ui32Value;
+    const char *pcStr;
+    va_list vaArgP;
+
+    ASSERT(psFormat != 0);
+
+    va_start(vaArgP, psFormat);
+
+    for(ui32Field = 0; ui32Field < psFormat->ui32NumFields; ui32Field++)
+    {
+        psField = &psFormat->psFields[ui32Field];
+
+        PrintPut(psFormat->pcFormat + psField->ui16Literal,
+                 psField->ui16LiteralLen);
+
+        if(psField->cConversion == 0)
+        {
+            continue;
+        }
+
+        ui32Value = 0;
+        pcStr = 0;
+        if(psField->cConversion == 's')
+        {
+            pcStr = va_arg(vaArgP, const char *);
+        }
+        else if(psField->cConversion != '%')
+        {
+            ui32Value = va_arg(vaArgP, uint32_t);
+        }
+
+        PrintConversion(psField->cConversion, psField->ui8Width,
+                        psField->cFill, ui32Value, pcStr);
+    }
+
+    va_end(vaArgP);
+
+    PrintFlush();
+}
+
 //*****************************************************************************
 //
 //! A simple UART based printf function supporting \%c, \%d, \%p, \%s, \%u,
@@ -1376,13 +1908,14 @@ UARTPeek(unsigned char ucChar)
     //
     iAvail = (int)RX_BUFFER_USED;
     ui32ReadIndex = g_ui32UARTRxReadIndex;
+    UART_BUFFER_BARRIER();
 
     //
     // Check all the unread characters looking for the one passed.
     //
     for(iCount = 0; iCount < iAvail; iCount++)
     {
-        if(g_pcUARTRxBuffer[ui32ReadIndex] == ucChar)
+        if(g_pcUARTRxBuffer[RX_BUFFER_OFFSET(ui32ReadIndex)] == ucChar)
         {
             //
             // We found it so return the index
@@ -1394,7 +1927,7 @@ UARTPeek(unsigned char ucChar)
             //
             // This one didn't match so move on to the next character.
             //
-            ADVANCE_RX_BUFFER_INDEX(ui32ReadIndex);
+            ui32ReadIndex++;
         }
     }
 
@@ -1421,27 +1954,12 @@ UARTPeek(unsigned char ucChar)
 void
 UARTFlushRx(void)
 {
-    uint32_t ui32Int;
-
-    //
-    // Temporarily turn off interrupts.
-    //
-    ui32Int = MAP_IntMasterDisable();
-
-    //
-    // Flush the receive buffer.
-    //
-    g_ui32UARTRxReadIndex = 0;
-    g_ui32UARTRxWriteIndex = 0;
-
     //
-    // If interrupts were enabled when we turned them off, turn them
-    // back on again.
+    // Flush the receive buffer.  The application is the consumer, so
+    // catching the read index up with the write index needs no interrupt
+    // masking.
     //
-    if(!ui32Int)
-    {
-        MAP_IntMasterEnable();
-    }
+    g_ui32UARTRxReadIndex = g_ui32UARTRxWriteIndex;
 }
 #endif
 
@@ -1478,11 +1996,23 @@ UARTFlushTx(bool bDiscard)
         //
         ui32Int = MAP_IntMasterDisable();
 
+#ifdef UART_TX_DMA
         //
-        // Flush the transmit buffer.
+        // Abandon any transfer in flight; its bytes are discarded with the
+        // rest.
         //
-        g_ui32UARTTxReadIndex = 0;
-        g_ui32UARTTxWriteIndex = 0;
+        if(g_ui32UARTTxDMALen)
+        {
+            MAP_uDMAChannelDisable(TX_DMA_CHANNEL);
+            g_ui32UARTTxDMALen = 0;
+        }
+#endif
+
+        //
+        // Flush the transmit buffer.  This moves the consumer's read index,
+        // which is why the interrupt handler has to be kept out here.
+        //
+        g_ui32UARTTxReadIndex = g_ui32UARTTxWriteIndex;
 
         //
         // If interrupts were enabled when we turned them off, turn them
@@ -1542,6 +2072,9 @@ UARTEchoSet(bool bEnable)
 //! will copy data from the UART receive FIFO to the receive buffer if data is
 //! available.
 //!
+//! When built with \b UART_TX_DMA, longer runs of transmit data are moved by
+//! the uDMA instead, and this handler only runs to start each transfer.
+//!
 //! \return None.
 //
 //*****************************************************************************
@@ -1552,8 +2085,15 @@ UARTStdioIntHandler(void)
     uint32_t ui32Ints;
     int8_t cChar;
     int32_t i32Char;
+    bool bStored;
     static bool bLastWasCR = false;
 
+    //
+    // Characters echoed on the line being typed, which a backspace may rub
+    // out
+    //
+    static uint32_t ui32EchoLen = 0;
+
     //
     // Get and clear the current interrupt source(s)
     //
@@ -1561,23 +2101,12 @@ UARTStdioIntHandler(void)
     MAP_UARTIntClear(g_ui32Base, ui32Ints);
 
     //
-    // Are we being interrupted because the TX FIFO has space available?
+    // Feed the transmitter.  This is done on every entry rather than only
+    // for UART_INT_TX, since the application pends this interrupt after
+    // committing new data to the transmit buffer and uDMA completion raises
+    // it without a UART status bit.
     //
-    if(ui32Ints & UART_INT_TX)
-    {
-        //
-        // Move as many bytes as we can into the transmit FIFO.
-        //
-        UARTPrimeTransmit(g_ui32Base);
-
-        //
-        // If the output buffer is empty, turn off the transmit interrupt.
-        //
-        if(TX_BUFFER_EMPTY)
-        {
-            MAP_UARTIntDisable(g_ui32Base, UART_INT_TX);
-        }
-    }
+    UARTServiceTransmit();
 
     //
     // Are we being interrupted due to a received character?
@@ -1596,118 +2125,73 @@ UARTStdioIntHandler(void)
             cChar = (unsigned char)(i32Char & 0xFF);
 
             //
-            // If echo is disabled, we skip the various text filtering
-            // operations that would typically be required when supporting a
-            // command line.
+            // If there is space in the receive buffer, put the character
+            // there, otherwise throw it away.  Every character is stored as
+            // received; backspace, line endings and ESC are left to the
+            // reader, so this handler only ever advances the write index.
             //
-            if(!g_bDisableEcho)
+            bStored = !RX_BUFFER_FULL;
+            if(bStored)
             {
                 //
-                // Handle backspace by erasing the last character in the
-                // buffer.
+                // Store the new character in the receive buffer and publish
+                // it to the application.
                 //
-                if(cChar == '\b')
-                {
-                    //
-                    // If there are any characters already in the buffer, then
-                    // delete the last.
-                    //
-                    if(!RX_BUFFER_EMPTY)
-                    {
-                        //
-                        // Rub out the previous character on the users
-                        // terminal.
-                        //
-                        UARTwrite("\b \b", 3);
-
-                        //
-                        // Decrement the number of characters in the buffer.
-                        //
-                        if(g_ui32UARTRxWriteIndex == 0)
-                        {
-                            g_ui32UARTRxWriteIndex = UART_RX_BUFFER_SIZE - 1;
-                        }
-                        else
-                        {
-                            g_ui32UARTRxWriteIndex--;
-                        }
-                    }
-
-                    //
-                    // Skip ahead to read the next character.
-                    //
-                    continue;
-                }
+                g_pcUARTRxBuffer[RX_BUFFER_OFFSET(g_ui32UARTRxWriteIndex)] =
+                    (unsigned char)cChar;
+                UART_BUFFER_BARRIER();
+                g_ui32UARTRxWriteIndex++;
+            }
 
-                //
-                // If this character is LF and last was CR, then just gobble up
-                // the character since we already echoed the previous CR and we
-                // don't want to store 2 characters in the buffer if we don't
-                // need to.
-                //
-                if((cChar == '\n') && bLastWasCR)
-                {
-                    bLastWasCR = false;
-                    continue;
-                }
+            //
+            // If echo is disabled, we skip the echo handling that would
+            // typically be required when supporting a command line.
+            //
+            if(g_bDisableEcho)
+            {
+                continue;
+            }
 
-                //
-                // See if a newline or escape character was received.
-                //
-                if((cChar == '\r') || (cChar == '\n') || (cChar == 0x1b))
+            //
+            // Rub out the previous character on the users terminal if the
+            // line being typed has one.  The reader drops it from the line
+            // when it gets to the backspace.
+            //
+            if(cChar == '\b')
+            {
+                if(ui32EchoLen)
                 {
-                    //
-                    // If the character is a CR, then it may be followed by an
-                    // LF which should be paired with the CR.  So remember that
-                    // a CR was received.
-                    //
-                    if(cChar == '\r')
-                    {
-                        bLastWasCR = 1;
-                    }
-
-                    //
-                    // Regardless of the line termination character received,
-                    // put a CR in the receive buffer as a marker telling
-                    // UARTgets() where the line ends.  We also send an
-                    // additional LF to ensure that the local terminal echo
-                    // receives both CR and LF.
-                    //
-                    cChar = '\r';
-                    UARTwrite("\n", 1);
+                    UARTEcho("\b \b", 3);
+                    ui32EchoLen--;
                 }
             }
 
             //
-            // If there is space in the receive buffer, put the character
-            // there, otherwise throw it away.
+            // Any line termination character is echoed as CR LF so that the
+            // local terminal gets both, and starts a new line.  An LF right
+            // after a CR has already been echoed with it.
             //
-            if(!RX_BUFFER_FULL)
+            else if((cChar == '\r') || (cChar == '\n') || (cChar == 0x1b))
             {
-                //
-                // Store the new character in the receive buffer
-                //
-                g_pcUARTRxBuffer[g_ui32UARTRxWriteIndex] =
-                    (unsigned char)(i32Char & 0xFF);
-                ADVANCE_RX_BUFFER_INDEX(g_ui32UARTRxWriteIndex);
-
-                //
-                // If echo is enabled, write the character to the transmit
-                // buffer so that the user gets some immediate feedback.
-                //
-                if(!g_bDisableEcho)
+                if((cChar != '\n') || !bLastWasCR)
                 {
-                    UARTwrite((const char *)&cChar, 1);
+                    UARTEcho("\r\n", 2);
                 }
+                ui32EchoLen = 0;
             }
-        }
 
-        //
-        // If we wrote anything to the transmit buffer, make sure it actually
-        // gets transmitted.
-        //
-        UARTPrimeTransmit(g_ui32Base);
-        MAP_UARTIntEnable(g_ui32Base, UART_INT_TX);
+            //
+            // Otherwise write the character to the transmit FIFO so that the
+            // user gets some immediate feedback, if it was kept.
+            //
+            else if(bStored)
+            {
+                UARTEcho((const char *)&cChar, 1);
+                ui32EchoLen++;
+            }
+
+            bLastWasCR = (cChar == '\r');
+        }
     }
 }
 #endif
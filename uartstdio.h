@@ -53,6 +53,88 @@ extern "C"
 #endif
 #endif
 
+//*****************************************************************************
+//
+// If built with uDMA transmit (UART_TX_DMA, which requires UART_BUFFERED),
+// runs of at least this many bytes in the transmit buffer are sent by the
+// uDMA rather than copied into the FIFO by the interrupt handler.
+//
+//*****************************************************************************
+#ifdef UART_TX_DMA
+#ifndef UART_DMA_MIN_SPAN
+#define UART_DMA_MIN_SPAN       16
+#endif
+#endif
+
+//*****************************************************************************
+//
+// Size of the buffer UARTprintf() renders into before writing to the UART.
+// Longer output is written in several pieces.
+//
+//*****************************************************************************
+#ifndef UART_PRINTF_BUFFER_SIZE
+#define UART_PRINTF_BUFFER_SIZE 128
+#endif
+
+//*****************************************************************************
+//
+// The maximum number of conversions in a format prepared by
+// UARTFormatCompile().
+//
+//*****************************************************************************
+#ifndef UART_FORMAT_MAX_FIELDS
+#define UART_FORMAT_MAX_FIELDS  8
+#endif
+
+//*****************************************************************************
+//
+// One literal run of a compiled format string and the conversion that
+// follows it.  The last entry of a format carries the trailing literal run
+// and no conversion.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // Offset and length of the literal run within the format string.
+    //
+    uint16_t ui16Literal;
+    uint16_t ui16LiteralLen;
+
+    //
+    // The conversion character, or 0 if there is none.
+    //
+    char cConversion;
+
+    //
+    // The fill character and minimum width of the conversion.
+    //
+    char cFill;
+    uint8_t ui8Width;
+}
+tUARTField;
+
+//*****************************************************************************
+//
+// A format string prepared by UARTFormatCompile().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The original format string.
+    //
+    const char *pcFormat;
+
+    //
+    // The number of valid entries in psFields.
+    //
+    uint32_t ui32NumFields;
+
+    tUARTField psFields[UART_FORMAT_MAX_FIELDS + 1];
+}
+tUARTFormat;
+
 //*****************************************************************************
 //
 // Prototypes for the APIs.
@@ -64,7 +146,10 @@ extern int UARTgets(char *pcBuf, uint32_t ui32Len);
 extern unsigned char UARTgetc(void);
 extern void UARTprintf(const char *pcString, ...);
 extern void UARTvprintf(const char *pcString, va_list vaArgP);
+extern bool UARTFormatCompile(tUARTFormat *psFormat, const char *pcString);
+extern void UARTFormatPrintf(const tUARTFormat *psFormat, ...);
 extern int UARTwrite(const char *pcBuf, uint32_t ui32Len);
+extern int UARTwriteBinary(const uint8_t *pui8Buf, uint32_t ui32Len);
 #ifdef UART_BUFFERED
 extern int UARTPeek(unsigned char ucChar);
 extern void UARTFlushTx(bool bDiscard);
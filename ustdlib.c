@@ -1432,10 +1432,16 @@ ustrtof(const char *nptr, const char **endptr)
         while((*pcPtr >= '0') && (*pcPtr <= '9'))
         {
             //
-            // Add this digit to the converted value.
+            // Add this digit to the converted value, saturating at the largest
+            // exponent the table below can raise ten to; a float has
+            // overflowed or underflowed well before that.
             //
             ulExp *= 10;
             ulExp += *pcPtr++ - '0';
+            if(ulExp > 127)
+            {
+                ulExp = 127;
+            }
         }
 
         //